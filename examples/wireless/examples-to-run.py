@@ -76,6 +76,7 @@ cpp_examples = [
     ("wifi-backward-compatibility --apVersion=80211a --staVersion=80211n_5GHZ --apRaa=Ideal --staRaa=Ideal --simulationTime=1", "True", "False"),
     ("wifi-backward-compatibility --apVersion=80211a --staVersion=80211ac --simulationTime=1", "True", "False"),
     ("wifi-backward-compatibility --apVersion=80211a --staVersion=80211ac --apRaa=Ideal --staRaa=Ideal --simulationTime=1", "True", "False"),
+    ("wifi-coalesced-backoff --simulationTime=1", "True", "True"),
 ]
 
 # A list of Python examples to run in order to ensure that they remain
@@ -0,0 +1,166 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/config.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/on-off-helper.h"
+#include "ns3/packet-sink.h"
+
+// This example compares the ChannelAccessManager with and without its
+// "CoalescedBackoff" attribute. Adhoc QoS stations, all in range of each
+// other, send saturated UDP flows to their neighbour, so that the backoffs
+// are often interrupted by the transmissions of the other stations. The
+// same scenario is run with both settings: the throughput must be the
+// same, while fewer events are processed with coalesced access timeouts.
+// The program prints an error and returns a non-zero status if the
+// throughputs differ.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("WifiCoalescedBackoff");
+
+/**
+ * Run the scenario.
+ *
+ * \param coalesced whether the access timeouts are coalesced
+ * \param nStations the number of stations
+ * \param simulationTime the duration of the flows (s)
+ * \param nEvents the number of events processed by the simulator
+ * \return the number of bytes received
+ */
+uint64_t
+RunScenario (bool coalesced, uint32_t nStations, double simulationTime, uint64_t &nEvents)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  Config::SetDefault ("ns3::ChannelAccessManager::CoalescedBackoff", BooleanValue (coalesced));
+
+  NodeContainer nodes;
+  nodes.Create (nStations);
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac",
+               "QosSupported", BooleanValue (true));
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate54Mbps"));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (5.0),
+                                 "DeltaY", DoubleValue (5.0),
+                                 "GridWidth", UintegerValue (5),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+  // Both runs draw the same random numbers
+  int64_t stream = 1 + wifi.AssignStreams (devices, 1);
+  stream += stack.AssignStreams (nodes, stream);
+  Ipv4AddressHelper address;
+  address.SetBase ("192.168.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  // Each flow alone could fill the channel
+  uint16_t port = 9;
+  ApplicationContainer sourceApplications, sinkApplications;
+  OnOffHelper onOffHelper ("ns3::UdpSocketFactory", Address ());
+  onOffHelper.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
+  onOffHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
+  onOffHelper.SetAttribute ("DataRate", DataRateValue (DataRate ("50Mb/s")));
+  onOffHelper.SetAttribute ("PacketSize", UintegerValue (1472));
+  for (uint32_t i = 0; i < nStations; i++)
+    {
+      InetSocketAddress sinkSocket (interfaces.GetAddress ((i + 1) % nStations), port);
+      onOffHelper.SetAttribute ("Remote", AddressValue (sinkSocket));
+      sourceApplications.Add (onOffHelper.Install (nodes.Get (i)));
+      PacketSinkHelper packetSinkHelper ("ns3::UdpSocketFactory", sinkSocket);
+      sinkApplications.Add (packetSinkHelper.Install (nodes.Get ((i + 1) % nStations)));
+    }
+  onOffHelper.AssignStreams (nodes, stream);
+  sinkApplications.Start (Seconds (0.0));
+  sinkApplications.Stop (Seconds (simulationTime + 1));
+  sourceApplications.Start (Seconds (1.0));
+  sourceApplications.Stop (Seconds (simulationTime + 1));
+
+  Simulator::Stop (Seconds (simulationTime + 1));
+  Simulator::Run ();
+
+  uint64_t totalRx = 0;
+  for (uint32_t i = 0; i < sinkApplications.GetN (); i++)
+    {
+      totalRx += DynamicCast<PacketSink> (sinkApplications.Get (i))->GetTotalRx ();
+    }
+  nEvents = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  return totalRx;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t nStations = 10;
+  double simulationTime = 5; //seconds
+
+  CommandLine cmd;
+  cmd.AddValue ("nStations", "Number of stations", nStations);
+  cmd.AddValue ("simulationTime", "Simulation time in seconds", simulationTime);
+  cmd.Parse (argc, argv);
+
+  uint64_t totalRx[2];
+  uint64_t nEvents[2];
+  for (uint32_t coalesced = 0; coalesced < 2; coalesced++)
+    {
+      SystemWallClockMs clock;
+      clock.Start ();
+      totalRx[coalesced] = RunScenario (coalesced, nStations, simulationTime, nEvents[coalesced]);
+      int64_t elapsed = clock.End ();
+      std::cout << "CoalescedBackoff=" << (coalesced ? "true " : "false")
+                << "  throughput: " << totalRx[coalesced] * 8 / (simulationTime * 1000000.0) << " Mbit/s"
+                << "  events: " << nEvents[coalesced]
+                << "  wall clock: " << elapsed << " ms" << std::endl;
+    }
+  std::cout << "Events saved: " << 100.0 * (1.0 - double (nEvents[1]) / nEvents[0]) << "%" << std::endl;
+
+  if (totalRx[0] == 0 || totalRx[1] != totalRx[0])
+    {
+      std::cerr << "The throughput differs with coalesced access timeouts" << std::endl;
+      return 1;
+    }
+
+  return 0;
+}
@@ -93,6 +93,15 @@ public:
    * \param [in] path Context path which was used to connect the Callback.
    */
   void Disconnect (const CallbackBase & callback, std::string path);
+  /**
+   * Check whether any Callback is connected.
+   *
+   * This lets the code firing the trace source skip the work needed
+   * only to report it.
+   *
+   * \returns \c true if the chain of Callbacks is empty.
+   */
+  bool IsEmpty (void) const;
   /**
    * \name Functors taking various numbers of arguments.
    *
@@ -314,6 +323,15 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callba
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   DisconnectWithoutContext (realCb);
 }
+template<typename T1, typename T2,
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_callbackList.empty ();
+}
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
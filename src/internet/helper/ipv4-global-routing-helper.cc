@@ -22,6 +22,9 @@
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node-list.h"
+#include "routing-table-file.h"
 
 namespace ns3 {
 
@@ -66,9 +69,75 @@ Ipv4GlobalRoutingHelper::PopulateRoutingTables (void)
 void 
 Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
 {
+  GlobalRouteManager::RecomputeRoutingTables ();
+}
+
+void
+Ipv4GlobalRoutingHelper::PopulateRoutingTables (std::string filename)
+{
+  if (ReadRoutingTables (filename))
+    {
+      return;
+    }
+  PopulateRoutingTables ();
+  WriteRoutingTables (filename);
+}
+
+void
+Ipv4GlobalRoutingHelper::WriteRoutingTables (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  // Node id and routing table of each global router
+  uint32_t size = 4;
+  uint32_t nRouters = 0;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<GlobalRouter> router = (*i)->GetObject<GlobalRouter> ();
+      if (router)
+        {
+          size += 4 + router->GetRoutingProtocol ()->GetSerializedSize ();
+          nRouters++;
+        }
+    }
+  Buffer buffer;
+  buffer.AddAtStart (size);
+  Buffer::Iterator it = buffer.Begin ();
+  it.WriteU32 (nRouters);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<GlobalRouter> router = (*i)->GetObject<GlobalRouter> ();
+      if (router)
+        {
+          Ptr<Ipv4GlobalRouting> routing = router->GetRoutingProtocol ();
+          it.WriteU32 ((*i)->GetId ());
+          routing->Serialize (it);
+          it.Next (routing->GetSerializedSize ());
+        }
+    }
+  RoutingTableFile::Write (filename, "ipv4-global-routing", buffer);
+}
+
+bool
+Ipv4GlobalRoutingHelper::ReadRoutingTables (std::string filename)
+{
+  NS_LOG_FUNCTION (filename);
+  Buffer buffer;
+  if (!RoutingTableFile::Read (filename, "ipv4-global-routing", buffer))
+    {
+      return false;
+    }
   GlobalRouteManager::DeleteGlobalRoutes ();
-  GlobalRouteManager::BuildGlobalRoutingDatabase ();
-  GlobalRouteManager::InitializeRoutes ();
+  Buffer::Iterator it = buffer.Begin ();
+  uint32_t nRouters = it.ReadU32 ();
+  for (uint32_t r = 0; r < nRouters; r++)
+    {
+      uint32_t id = it.ReadU32 ();
+      NS_ABORT_MSG_UNLESS (id < NodeList::GetNNodes (), "No node " << id << " for the routes of " << filename);
+      Ptr<GlobalRouter> router = NodeList::GetNode (id)->GetObject<GlobalRouter> ();
+      NS_ABORT_MSG_UNLESS (router, "Node " << id << " is not a global router");
+      it.Next (router->GetRoutingProtocol ()->Deserialize (it));
+    }
+  return true;
 }
 
 
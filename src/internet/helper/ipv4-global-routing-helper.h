@@ -20,6 +20,7 @@
 #ifndef IPV4_GLOBAL_ROUTING_HELPER_H
 #define IPV4_GLOBAL_ROUTING_HELPER_H
 
+#include <string>
 #include "ns3/node-container.h"
 #include "ns3/ipv4-routing-helper.h"
 
@@ -84,6 +85,39 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Initialize the routing tables of the nodes from a file if it
+   * matches the topology, otherwise as PopulateRoutingTables (void) and
+   * write them to the file.
+   *
+   * A parameter sweep over the same topology then computes the routes in
+   * its first run only.
+   *
+   * \param filename the name of the routing table file
+   * \see RoutingTableFile
+   */
+  static void PopulateRoutingTables (std::string filename);
+  /**
+   * \brief Write the global routes of all the nodes to a file, tagged
+   * with a hash of the topology.
+   *
+   * \param filename the name of the routing table file
+   * \see RoutingTableFile
+   */
+  static void WriteRoutingTables (std::string filename);
+  /**
+   * \brief Replace the global routes of all the nodes by the routes
+   * written to a file by WriteRoutingTables ().
+   *
+   * The file is refused, and no route is changed, if it was written for
+   * another topology.  As with PopulateRoutingTables (), the routes can
+   * later be recomputed with RecomputeRoutingTables ().
+   *
+   * \param filename the name of the routing table file
+   * \returns true if the routes were read, false if the file does not
+   * exist, is corrupted or does not match the topology
+   */
+  static bool ReadRoutingTables (std::string filename);
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "routing-table-file.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/hash.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/bridge-net-device.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/global-router-interface.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RoutingTableFile");
+
+const uint32_t RoutingTableFile::MAGIC;
+const uint32_t RoutingTableFile::VERSION;
+
+uint64_t
+RoutingTableFile::GetTopologyHash (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::ostringstream os;
+  for (uint32_t n = 0; n < NodeList::GetNNodes (); n++)
+    {
+      Ptr<Node> node = NodeList::GetNode (n);
+      os << "node " << node->GetId () << " " << node->GetNDevices () << "\n";
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> device = node->GetDevice (i);
+          Ptr<Channel> channel = device->GetChannel ();
+          os << "device " << device->GetInstanceTypeId ().GetName ()
+             << " " << (channel ? int64_t (channel->GetId ()) : -1)
+             << " " << device->IsLinkUp () << " " << device->IsBridge ();
+          Ptr<BridgeNetDevice> bridge = device->GetObject<BridgeNetDevice> ();
+          if (bridge)
+            {
+              for (uint32_t j = 0; j < bridge->GetNBridgePorts (); j++)
+                {
+                  os << " " << bridge->GetBridgePort (j)->GetIfIndex ();
+                }
+            }
+          os << "\n";
+        }
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      if (ipv4)
+        {
+          for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+            {
+              os << "interface " << ipv4->GetNetDevice (i)->GetIfIndex ()
+                 << " " << ipv4->IsUp (i) << " " << ipv4->IsForwarding (i)
+                 << " " << ipv4->GetMetric (i);
+              for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+                {
+                  Ipv4InterfaceAddress address = ipv4->GetAddress (i, j);
+                  os << " " << address.GetLocal () << "/" << address.GetMask ().GetPrefixLength ();
+                }
+              os << "\n";
+            }
+        }
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router)
+        {
+          os << "router";
+          for (uint32_t i = 0; i < router->GetNInjectedRoutes (); i++)
+            {
+              Ipv4RoutingTableEntry *route = router->GetInjectedRoute (i);
+              os << " " << route->GetDestNetwork () << "/" << route->GetDestNetworkMask ().GetPrefixLength ()
+                 << " " << route->GetGateway () << " " << route->GetInterface ();
+            }
+          os << "\n";
+        }
+    }
+  std::string description = os.str ();
+  return Hash64 (description.data (), description.size ());
+}
+
+void
+RoutingTableFile::Write (std::string filename, std::string kind, const Buffer &payload)
+{
+  NS_LOG_FUNCTION (filename << kind << payload.GetSize ());
+  std::vector<uint8_t> data (payload.GetSize ());
+  if (!data.empty ())
+    {
+      payload.CopyData (&data[0], data.size ());
+    }
+
+  Buffer header;
+  header.AddAtStart (28 + kind.size ());
+  Buffer::Iterator i = header.Begin ();
+  i.WriteU32 (MAGIC);
+  i.WriteU32 (VERSION);
+  i.WriteU32 (kind.size ());
+  i.Write (reinterpret_cast<const uint8_t *> (kind.data ()), kind.size ());
+  i.WriteU64 (GetTopologyHash ());
+  i.WriteU32 (data.size ());
+  i.WriteU32 (Hash32 (reinterpret_cast<const char *> (data.data ()), data.size ()));
+
+  std::ofstream file (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS (file.is_open (), "Cannot open routing table file " << filename);
+  header.CopyData (&file, header.GetSize ());
+  file.write (reinterpret_cast<const char *> (data.data ()), data.size ());
+  NS_ABORT_MSG_UNLESS (file.good (), "Cannot write routing table file " << filename);
+}
+
+bool
+RoutingTableFile::Read (std::string filename, std::string kind, Buffer &payload)
+{
+  NS_LOG_FUNCTION (filename << kind);
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!file.is_open ())
+    {
+      NS_LOG_LOGIC ("No routing table file " << filename);
+      return false;
+    }
+
+  // The whole file is read at once, then checked before anything is
+  // handed over to the routing protocols
+  std::vector<uint8_t> data;
+  file.seekg (0, std::ios::end);
+  data.resize (file.tellg ());
+  file.seekg (0, std::ios::beg);
+  file.read (reinterpret_cast<char *> (data.data ()), data.size ());
+  if (!file.good () || data.size () < 12)
+    {
+      NS_LOG_WARN ("Cannot read routing table file " << filename);
+      return false;
+    }
+
+  Buffer buffer;
+  buffer.AddAtStart (data.size ());
+  buffer.Begin ().Write (data.data (), data.size ());
+  Buffer::Iterator i = buffer.Begin ();
+  if (i.ReadU32 () != MAGIC || i.ReadU32 () != VERSION)
+    {
+      NS_LOG_WARN ("Routing table file " << filename << " has an unknown format");
+      return false;
+    }
+  uint32_t kindSize = i.ReadU32 ();
+  if (i.GetRemainingSize () < uint64_t (kindSize) + 16)
+    {
+      NS_LOG_WARN ("Routing table file " << filename << " is truncated");
+      return false;
+    }
+  std::string fileKind (kindSize, ' ');
+  for (uint32_t k = 0; k < kindSize; k++)
+    {
+      fileKind[k] = i.ReadU8 ();
+    }
+  if (fileKind != kind)
+    {
+      NS_LOG_WARN ("Routing table file " << filename << " holds " << fileKind << " tables, not " << kind);
+      return false;
+    }
+  if (i.ReadU64 () != GetTopologyHash ())
+    {
+      NS_LOG_WARN ("Routing table file " << filename << " was written for another topology");
+      return false;
+    }
+  uint32_t size = i.ReadU32 ();
+  uint32_t checksum = i.ReadU32 ();
+  uint32_t offset = i.GetDistanceFrom (buffer.Begin ());
+  if (i.GetRemainingSize () != size
+      || Hash32 (reinterpret_cast<const char *> (data.data ()) + offset, size) != checksum)
+    {
+      NS_LOG_WARN ("Routing table file " << filename << " is corrupted");
+      return false;
+    }
+  buffer.RemoveAtStart (offset);
+  payload = buffer;
+  return true;
+}
+
+} // namespace ns3
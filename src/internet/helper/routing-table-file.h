@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ROUTING_TABLE_FILE_H
+#define ROUTING_TABLE_FILE_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Helpers
+ *
+ * \brief Files of precomputed routing tables.
+ *
+ * Computing the global routes or the nix-vector next hops of a large
+ * topology can take longer than the simulation itself, and is repeated
+ * identically by every run of a parameter sweep.  The routing helpers
+ * can instead write the tables they computed to a file, which later runs
+ * on the same topology load.
+ *
+ * A file holds one kind of table, tagged with a hash of the topology it
+ * was computed for: the nodes, their devices and channels, the IPv4
+ * interfaces with their addresses and state, and the routes injected in
+ * the global routers.  Reading the file fails if the topology has changed
+ * since, so that stale routes are never installed.  The payload is
+ * protected by a checksum.
+ */
+class RoutingTableFile
+{
+public:
+  /**
+   * \brief Compute the hash of the current topology.
+   * \returns the hash of the nodes, devices, channels and IPv4 interfaces
+   */
+  static uint64_t GetTopologyHash (void);
+
+  /**
+   * \brief Write a routing table to a file, tagged with the current topology hash.
+   *
+   * The file is overwritten if it exists.
+   *
+   * \param filename the name of the file
+   * \param kind the kind of routing table, checked when reading
+   * \param payload the serialized routing table
+   */
+  static void Write (std::string filename, std::string kind, const Buffer &payload);
+
+  /**
+   * \brief Read a routing table from a file.
+   * \param filename the name of the file
+   * \param kind the kind of routing table expected
+   * \param payload the serialized routing table
+   * \returns false if the file does not exist, is corrupted, holds another
+   * kind of table or was written for another topology
+   */
+  static bool Read (std::string filename, std::string kind, Buffer &payload);
+
+private:
+  /// Identification of the file format
+  static const uint32_t MAGIC = 0x4e335254;
+  /// Version of the file format
+  static const uint32_t VERSION = 1;
+};
+
+} // namespace ns3
+
+#endif /* ROUTING_TABLE_FILE_H */
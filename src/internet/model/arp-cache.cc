@@ -197,40 +197,38 @@ ArpCache::HandleWaitReplyTimeout (void)
   NS_LOG_FUNCTION (this);
   ArpCache::Entry* entry;
   bool restartWaitReplyTimer = false;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
+  std::list<ArpCache::Entry *>::iterator i = m_waitReplyEntries.begin ();
+  while (i != m_waitReplyEntries.end ())
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      // Marking the entry dead removes it from the list
+      entry = *i++;
+      if (entry->GetRetries () < m_maxRetries)
         {
-          if (entry->GetRetries () < m_maxRetries)
-            {
-              NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
-                            ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
-                            " expired -- retransmitting arp request since retries = " <<
-                            entry->GetRetries ());
-              m_arpRequestCallback (this, entry->GetIpv4Address ());
-              restartWaitReplyTimer = true;
-              entry->IncrementRetries ();
-            }
-          else
+          NS_LOG_LOGIC ("node="<< m_device->GetNode ()->GetId () <<
+                        ", ArpWaitTimeout for " << entry->GetIpv4Address () <<
+                        " expired -- retransmitting arp request since retries = " <<
+                        entry->GetRetries ());
+          m_arpRequestCallback (this, entry->GetIpv4Address ());
+          restartWaitReplyTimer = true;
+          entry->IncrementRetries ();
+        }
+      else
+        {
+          NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
+                        ", wait reply for " << entry->GetIpv4Address () <<
+                        " expired -- drop since max retries exceeded: " <<
+                        entry->GetRetries ());
+          entry->MarkDead ();
+          entry->ClearRetries ();
+          Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
+          while (pending.first != 0)
             {
-              NS_LOG_LOGIC ("node="<<m_device->GetNode ()->GetId () <<
-                            ", wait reply for " << entry->GetIpv4Address () <<
-                            " expired -- drop since max retries exceeded: " <<
-                            entry->GetRetries ());
-              entry->MarkDead ();
-              entry->ClearRetries ();
-              Ipv4PayloadHeaderPair pending = entry->DequeuePending ();
-              while (pending.first != 0)
-                {
-                  // add the Ipv4 header for tracing purposes
-                  pending.first->AddHeader (pending.second);
-                  m_dropTrace (pending.first);
-                  pending = entry->DequeuePending ();
-                }
+              // add the Ipv4 header for tracing purposes
+              pending.first->AddHeader (pending.second);
+              m_dropTrace (pending.first);
+              pending = entry->DequeuePending ();
             }
         }
-
     }
   if (restartWaitReplyTimer)
     {
@@ -244,11 +242,8 @@ void
 ArpCache::Flush (void)
 {
   NS_LOG_FUNCTION (this);
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
-    {
-      delete (*i).second;
-    }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_arpCache.Clear ();
+  m_waitReplyEntries.clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -262,9 +257,14 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
   NS_LOG_FUNCTION (this << stream);
   std::ostream* os = stream->GetStream ();
 
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  for (uint32_t i = 0; i < m_arpCache.GetNSlots (); i++)
     {
-      *os << i->first << " dev ";
+      ArpCache::Entry *entry = m_arpCache.GetSlot (i);
+      if (entry == 0)
+        {
+          continue;
+        }
+      *os << m_arpCache.GetKey (i) << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -275,17 +275,17 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << entry->GetMacAddress ();
 
-      if (i->second->IsAlive ())
+      if (entry->IsAlive ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsWaitReply ())
+      else if (entry->IsWaitReply ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (entry->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -301,16 +301,9 @@ ArpCache::LookupInverse (Address to)
 {
   NS_LOG_FUNCTION (this << to);
 
-  std::list<ArpCache::Entry *> entryList;
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
-    {
-      ArpCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == to)
-        {
-          entryList.push_back (entry);
-        }
-    }
-  return entryList;
+  std::vector<ArpCache::Entry *> entries;
+  m_arpCache.FindMac (to, entries);
+  return std::list<ArpCache::Entry *> (entries.begin (), entries.end ());
 }
 
 
@@ -318,22 +311,16 @@ ArpCache::Entry *
 ArpCache::Lookup (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  CacheI it = m_arpCache.find (to);
-  if (it != m_arpCache.end ())
-    {
-      return it->second;
-    }
-  return 0;
+  return m_arpCache.Find (to);
 }
 
 ArpCache::Entry *
 ArpCache::Add (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
+  NS_ASSERT (m_arpCache.Find (to) == 0);
 
-  ArpCache::Entry *entry = new ArpCache::Entry (this);
-  m_arpCache[to] = entry;
+  ArpCache::Entry *entry = m_arpCache.Insert (to, ArpCache::Entry (this));
   entry->SetIpv4Address (to);
   return entry;
 }
@@ -342,18 +329,18 @@ void
 ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
-  
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+
+  if (entry->m_arp != this)
     {
-      if ((*i).second == entry)
-        {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
-        }
+      NS_LOG_WARN ("Entry not found in this ARP Cache");
+      return;
+    }
+  entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
+  entry->SetState (Entry::DEAD);
+  if (!m_arpCache.Remove (entry->GetIpv4Address (), entry))
+    {
+      NS_LOG_WARN ("Entry not found in this ARP Cache");
     }
-  NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
 
 ArpCache::Entry::Entry (ArpCache *arp)
@@ -396,7 +383,7 @@ ArpCache::Entry::MarkDead (void)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_state == ALIVE || m_state == WAIT_REPLY || m_state == DEAD);
-  m_state = DEAD;
+  SetState (DEAD);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -405,8 +392,8 @@ ArpCache::Entry::MarkAlive (Address macAddress)
 {
   NS_LOG_FUNCTION (this << macAddress);
   NS_ASSERT (m_state == WAIT_REPLY);
-  m_macAddress = macAddress;
-  m_state = ALIVE;
+  SetMacAddress (macAddress);
+  SetState (ALIVE);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -416,7 +403,7 @@ ArpCache::Entry::MarkPermanent (void)
   NS_LOG_FUNCTION (this << m_macAddress);
   NS_ASSERT (!m_macAddress.IsInvalid ());
 
-  m_state = PERMANENT;
+  SetState (PERMANENT);
   ClearRetries ();
   UpdateSeen ();
 }
@@ -444,7 +431,7 @@ ArpCache::Entry::MarkWaitReply (Ipv4PayloadHeaderPair waiting)
   NS_ASSERT (m_pending.empty ());
   NS_ASSERT_MSG (waiting.first, "Can not add a null packet to the ARP queue");
 
-  m_state = WAIT_REPLY;
+  SetState (WAIT_REPLY);
   m_pending.push_back (waiting);
   UpdateSeen ();
   m_arp->StartWaitReplyTimer ();
@@ -460,8 +447,22 @@ void
 ArpCache::Entry::SetMacAddress (Address macAddress)
 {
   NS_LOG_FUNCTION (this);
+  m_arp->m_arpCache.ChangeMac (this, m_macAddress, macAddress);
   m_macAddress = macAddress;
 }
+void
+ArpCache::Entry::SetState (ArpCacheEntryState_e state)
+{
+  if (state == WAIT_REPLY && m_state != WAIT_REPLY)
+    {
+      m_waitReplyIt = m_arp->m_waitReplyEntries.insert (m_arp->m_waitReplyEntries.end (), this);
+    }
+  else if (state != WAIT_REPLY && m_state == WAIT_REPLY)
+    {
+      m_arp->m_waitReplyEntries.erase (m_waitReplyIt);
+    }
+  m_state = state;
+}
 Ipv4Address 
 ArpCache::Entry::GetIpv4Address (void) const
 {
@@ -32,7 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
-#include "ns3/sgi-hashmap.h"
+#include "ns3/neighbor-cache-table.h"
 #include "ns3/output-stream-wrapper.h"
 
 namespace ns3 {
@@ -47,6 +47,11 @@ class Ipv4Header;
  *
  * A cached lookup table for translating layer 3 addresses to layer 2.
  * This implementation does lookups from IPv4 to a MAC address
+ *
+ * The entries are indexed by IPv4 address and by MAC address, and the
+ * entries waiting for a reply are kept in a list, so that neither the
+ * lookups nor the periodic retransmission of the ARP requests scan the
+ * whole cache.
  */
 class ArpCache : public Object
 {
@@ -284,6 +289,8 @@ public:
     void UpdateSeen (void);
 
 private:
+    friend class ArpCache;
+
     /**
      * \brief ARP cache entry states
      */
@@ -299,6 +306,12 @@ private:
      * \returns the entry timeout
      */
     Time GetTimeout (void) const;
+    /**
+     * \brief Change the state of the entry, keeping the list of entries
+     * waiting for a reply up to date
+     * \param state the new state
+     */
+    void SetState (ArpCacheEntryState_e state);
 
     ArpCache *m_arp; //!< pointer to the ARP cache owning the entry
     ArpCacheEntryState_e m_state; //!< state of the entry
@@ -307,17 +320,14 @@ private:
     Ipv4Address m_ipv4Address; //!< entry's IP address
     std::list<Ipv4PayloadHeaderPair> m_pending; //!< list of pending packets for the entry's IP
     uint32_t m_retries; //!< rerty counter
+    std::list<Entry *>::iterator m_waitReplyIt; //!< position in the list of entries waiting for a reply
   };
 
 private:
   /**
    * \brief ARP Cache container
    */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash> Cache;
-  /**
-   * \brief ARP Cache container iterator
-   */
-  typedef sgi::hash_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  typedef NeighborCacheTable<ArpCache::Entry, Ipv4Address, Ipv4AddressHash> Cache;
 
   virtual void DoDispose (void);
 
@@ -338,6 +348,7 @@ private:
   void HandleWaitReplyTimeout (void);
   uint32_t m_pendingQueueSize; //!< number of packets waiting for a resolution
   Cache m_arpCache; //!< the ARP cache
+  std::list<ArpCache::Entry *> m_waitReplyEntries; //!< the entries in WAIT_REPLY state
   TracedCallback<Ptr<const Packet> > m_dropTrace; //!< trace for packets dropped by the ARP cache queue
 };
 
@@ -51,22 +51,24 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::IsBefore);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_seq (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +96,11 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c = { vNew, m_seq++ };
+  m_candidates.push_back (c);
+  m_vertices[vNew->GetVertexId ()] = vNew;
+  Place (m_candidates.size () - 1, c);
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +112,20 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().vertex;
+  m_positions.erase (v);
+  std::unordered_map<Ipv4Address, SPFVertex *, Ipv4AddressHash>::iterator i = m_vertices.find (v->GetVertexId ());
+  if (i != m_vertices.end () && i->second == v)
+    {
+      m_vertices.erase (i);
+    }
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -124,7 +138,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -145,18 +159,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::unordered_map<Ipv4Address, SPFVertex *, Ipv4AddressHash>::const_iterator i = m_vertices.find (addr);
+  if (i == m_vertices.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return i->second;
 }
 
 void
@@ -164,11 +172,94 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // A sorted array is a heap
+  std::sort (m_candidates.begin (), m_candidates.end (), &CandidateQueue::IsBefore);
+  for (uint32_t i = 0; i < m_candidates.size (); ++i)
+    {
+      m_positions[m_candidates[i].vertex] = i;
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Reorder (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  std::unordered_map<const SPFVertex *, uint32_t>::const_iterator i = m_positions.find (v);
+  NS_ASSERT_MSG (i != m_positions.end (), "Vertex " << v->GetVertexId () << " is not in the CandidateQueue");
+  uint32_t position = i->second;
+  m_candidates[position].seq = m_seq++;
+  SiftUp (position);
+  SiftDown (m_positions[v]);
+}
+
+void
+CandidateQueue::Place (uint32_t i, const Candidate &c)
+{
+  m_candidates[i] = c;
+  m_positions[c.vertex] = i;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  while (i > 0)
+    {
+      uint32_t parent = (i - 1) / 2;
+      if (!IsBefore (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (i, m_candidates[parent]);
+      i = parent;
+    }
+  Place (i, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  uint32_t n = m_candidates.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * i + 1;
+      if (child >= n)
+        {
+          break;
+        }
+      if (child + 1 < n && IsBefore (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!IsBefore (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (i, m_candidates[child]);
+      i = child;
+    }
+  Place (i, c);
+}
+
+bool
+CandidateQueue::IsBefore (const Candidate &c1, const Candidate &c2)
+{
+  if (CompareSPFVertex (c1.vertex, c2.vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.vertex, c1.vertex))
+    {
+      return false;
+    }
+  // Equal ranks are served in order of arrival, like in a sorted list
+  return c1.seq < c2.seq;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,13 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The vertices are kept in a binary heap, along with the position of each
+ * vertex in the heap and an index of the vertices by vertex ID, so that
+ * Push (), Pop () and Reorder (SPFVertex*) take a logarithmic time and
+ * Find () a constant time.  Vertices at the same distance are popped in the
+ * order in which they were pushed, or in which their distance last
+ * decreased, which is the order a sorted list would give.
  */
 class CandidateQueue
 {
@@ -154,6 +162,18 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restores the priority order of the Candidate Queue after the
+ * distance of one vertex decreased.
+ *
+ * The vertex is moved after the vertices already in the queue at its new
+ * distance, as if it had just been pushed.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance decreased.
+ */
+  void Reorder (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -184,8 +204,44 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /// A vertex in the heap, with its position in the order of arrival
+  struct Candidate
+  {
+    SPFVertex *vertex;  //!< the vertex
+    uint64_t seq;       //!< when the vertex was pushed, or its distance last decreased
+  };
+
+  /**
+   * \param c1 first candidate
+   * \param c2 second candidate
+   * \return true if c1 should be popped before c2
+   */
+  static bool IsBefore (const Candidate &c1, const Candidate &c2);
+
+  /**
+   * \brief Store a candidate at a given position of the heap.
+   * \param i the position
+   * \param c the candidate
+   */
+  void Place (uint32_t i, const Candidate &c);
+
+  /**
+   * \brief Move a candidate towards the top of the heap.
+   * \param i the position of the candidate
+   */
+  void SiftUp (uint32_t i);
+
+  /**
+   * \brief Move a candidate towards the bottom of the heap.
+   * \param i the position of the candidate
+   */
+  void SiftDown (uint32_t i);
+
+  typedef std::vector<Candidate> CandidateList_t; //!< container of SPFVertex pointers
+  CandidateList_t m_candidates;  //!< SPFVertex candidates, as a binary heap
+  std::unordered_map<const SPFVertex *, uint32_t> m_positions; //!< position of each vertex in the heap
+  std::unordered_map<Ipv4Address, SPFVertex *, Ipv4AddressHash> m_vertices; //!< vertices by vertex ID
+  uint64_t m_seq; //!< next arrival order
 
   /**
    * \brief Stream insertion operator.
@@ -26,24 +26,49 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <iostream>
+#include <thread>
+#include "ns3/core-config.h"
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/mpi-interface.h"
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
 #include "ipv4-global-routing.h"
 
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/// Number of threads computing the SPF trees
+static GlobalValue g_globalRoutingThreads = GlobalValue ("GlobalRoutingThreads",
+                                                         "The number of threads computing the global routing tables (0 to use one thread per processor)",
+                                                         UintegerValue (1),
+                                                         MakeUintegerChecker<uint32_t> ());
+
+/// Recompute only the routing tables affected by a topology change
+static GlobalValue g_globalRoutingIncremental = GlobalValue ("GlobalRoutingIncremental",
+                                                             "When the global routing tables are recomputed, only update the tables affected by the Link State Advertisements which changed",
+                                                             BooleanValue (false),
+                                                             MakeBooleanChecker ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -470,7 +495,34 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      std::pair<LSDBMap_t::iterator, bool> inserted = m_database.insert (LSDBPair_t (addr, lsa));
+      if (!inserted.second)
+        {
+          return;
+        }
+      lsa->SetLsdbIndex (m_database.size () - 1);
+//
+// Index the TransitNetwork link records.  When several LSAs have a record
+// with the same link data, keep the one with the lowest address, which is
+// the first one found when walking the database.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LinkDataMap_t::iterator k = m_linkData.find (lr->GetLinkData ());
+          if (k == m_linkData.end ())
+            {
+              m_linkData.insert (std::make_pair (lr->GetLinkData (), LSDBMap_t::const_iterator (inserted.first)));
+            }
+          else if (addr < k->second->first)
+            {
+              k->second = inserted.first;
+            }
+        }
     }
 }
 
@@ -488,6 +540,25 @@ GlobalRouteManagerLSDB::GetNumExtLSAs () const
   return m_extdatabase.size ();
 }
 
+uint32_t
+GlobalRouteManagerLSDB::GetNumLSAs () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_database.size ();
+}
+
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  lsas.clear ();
+  lsas.reserve (m_database.size ());
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
+    }
+}
+
 GlobalRoutingLSA*
 GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 {
@@ -495,13 +566,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -511,22 +579,12 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataMap_t::const_iterator i = m_linkData.find (addr);
+  if (i != m_linkData.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return i->second->second;
     }
   return 0;
 }
@@ -537,18 +595,46 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // ---------------------------------------------------------------------------
 
+/**
+ * \brief Roots of the SPF calculations shared by the worker threads.
+ */
+struct GlobalRouteManagerImpl::SPFRootQueue
+{
+  const std::vector<Ipv4Address> *roots; //!< the router IDs of the roots
+  uint32_t next;                         //!< index of the next root to process
+  std::set<Ipv4Address> stubRoots;       //!< roots which only got a default route
+#ifdef HAVE_PTHREAD_H
+  SystemMutex mutex;                     //!< protects next and stubRoots
+#endif /* HAVE_PTHREAD_H */
+};
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_ownsLsdb (true),
+    m_queue (0),
+    m_routesValid (false)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl (const GlobalRouteManagerImpl *parent, SPFRootQueue *queue)
+  :
+    m_spfroot (0),
+    m_lsdb (parent->m_lsdb),
+    m_ownsLsdb (false),
+    m_routers (parent->m_routers),
+    m_queue (queue),
+    m_routesValid (false)
+{
+  NS_LOG_FUNCTION (this << parent << queue);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl ()
 {
   NS_LOG_FUNCTION (this);
-  if (m_lsdb)
+  if (m_lsdb && m_ownsLsdb)
     {
       delete m_lsdb;
     }
@@ -572,25 +658,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
-      Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (*i);
     }
   if (m_lsdb)
     {
@@ -598,6 +666,33 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_spfRoots.clear ();
+  m_stubRoots.clear ();
+  m_routesValid = false;
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
 }
 
 //
@@ -613,6 +708,7 @@ void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase () 
 {
   NS_LOG_FUNCTION (this);
+  m_routesValid = false;
 //
 // Walk the list of nodes looking for the GlobalRouter Interface.  Nodes with
 // global router interfaces are, not too surprisingly, our routers.
@@ -696,38 +792,897 @@ void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
+  NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<Ipv4Address> roots;
+  FindRoots (roots);
+  m_stubRoots.clear ();
+  SPFCalculate (roots);
+  m_spfRoots = std::set<Ipv4Address> (roots.begin (), roots.end ());
+  m_routers.clear ();
+  m_routesValid = true;
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::RecomputeRoutingTables ()
+{
+  NS_LOG_FUNCTION (this);
+  BooleanValue incremental;
+  g_globalRoutingIncremental.GetValue (incremental);
+  if (!incremental.Get () || !m_routesValid)
+    {
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+//
+// Keep the LSDB the current routes were computed from, to compare it with
+// the new one.
+//
+  GlobalRouteManagerLSDB *oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  if (!UpdateRoutes (oldLsdb))
+    {
+      NS_LOG_LOGIC ("Recomputing all the routes");
+      NodeList::Iterator listEnd = NodeList::End ();
+      for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+        {
+          DeleteRoutes (*i);
+        }
+      InitializeRoutes ();
+    }
+  delete oldLsdb;
+}
+
+void
+GlobalRouteManagerImpl::FindRoots (std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (this);
+  roots.clear ();
+  m_routers.clear ();
+//
+// Walk the list of nodes in the system.
+//
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+//
+// Look for the GlobalRouter interface that indicates that the node is
+// participating in routing.
+//
+      Ptr<GlobalRouter> rtr = 
+        node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      m_routers.insert (std::make_pair (rtr->GetRouterId (), node));
+
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId) 
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr->GetNumLSAs ())
+        {
+          roots.push_back (rtr->GetRouterId ());
+        }
+    }
+}
+
+Ptr<Node>
+GlobalRouteManagerImpl::FindRouterNode (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+  RouterMap_t::const_iterator i = m_routers.find (routerId);
+  if (i != m_routers.end ())
+    {
+      return i->second;
+    }
+//
+// The routers were not looked up beforehand (e.g., DebugSPFCalculate ()):
+// walk the list of nodes looking for the one that has this router ID.
+//
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator j = NodeList::Begin (); j != listEnd; j++)
+    {
+      Ptr<GlobalRouter> rtr = (*j)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == routerId)
+        {
+          return *j;
+        }
+    }
+  return 0;
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculate (const std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  UintegerValue threads;
+  g_globalRoutingThreads.GetValue (threads);
+  uint32_t nThreads = threads.Get ();
+  if (nThreads == 0)
+    {
+      nThreads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  nThreads = std::min<uint32_t> (nThreads, roots.size ());
+#ifdef HAVE_PTHREAD_H
+  if (nThreads > 1)
+    {
+//
+// The calculations of the different roots only read the LSDB and write the
+// routing table of their own root, so they can run concurrently.  Each
+// worker picks the next root in the queue until none is left.
+//
+      NS_LOG_LOGIC ("Computing " << roots.size () << " SPF trees with " << nThreads << " threads");
+      SPFRootQueue queue;
+      queue.roots = &roots;
+      queue.next = 0;
+      std::vector<GlobalRouteManagerImpl *> workers;
+      std::vector<Ptr<SystemThread> > workerThreads;
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          workers.push_back (new GlobalRouteManagerImpl (this, &queue));
+          workerThreads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::SPFWorker, workers.back ())));
+          workerThreads.back ()->Start ();
+        }
+      for (uint32_t i = 0; i < nThreads; i++)
+        {
+          workerThreads[i]->Join ();
+          delete workers[i];
+        }
+      m_stubRoots.insert (queue.stubRoots.begin (), queue.stubRoots.end ());
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  for (std::vector<Ipv4Address>::const_iterator i = roots.begin (); i != roots.end (); i++)
+    {
+      SPFCalculate (*i);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFWorker (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  for (;;)
+    {
+      Ipv4Address root;
+      {
+        CriticalSection cs (m_queue->mutex);
+        if (m_queue->next == m_queue->roots->size ())
+          {
+            break;
+          }
+        root = (*m_queue->roots)[m_queue->next++];
+      }
+      SPFCalculate (root);
+    }
+  CriticalSection cs (m_queue->mutex);
+  m_queue->stubRoots.insert (m_stubRoots.begin (), m_stubRoots.end ());
+#endif /* HAVE_PTHREAD_H */
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus (const GlobalRoutingLSA *lsa) const
+{
+  NS_ASSERT (lsa->GetLsdbIndex () < m_status.size ());
+  return m_status[lsa->GetLsdbIndex ()];
+}
+
+void
+GlobalRouteManagerImpl::SetLSAStatus (const GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status)
+{
+  NS_ASSERT (lsa->GetLsdbIndex () < m_status.size ());
+  m_status[lsa->GetLsdbIndex ()] = status;
+}
+
+// ---------------------------------------------------------------------------
+//
+// Incremental update of the routes
+//
+// ---------------------------------------------------------------------------
+
+/// Distance of the vertices which cannot reach a vertex
+static const uint64_t SPF_UNREACHABLE = std::numeric_limits<uint64_t>::max ();
+
+/**
+ * \ingroup globalrouting
+ *
+ * \brief The graph of the routers and transit networks of an LSDB, with the
+ * edges GlobalRouteManagerImpl::SPFNext () follows.
+ *
+ * It is used to compare two LSDBs and to compute the distances which tell
+ * whether a change can alter the shortest path tree of a root.
+ */
+class SPFGraph
+{
+public:
+  /// An out edge: the Link State ID of the head vertex, and the cost
+  typedef std::pair<Ipv4Address, uint32_t> Edge_t;
+
+  /**
+   * \brief Build the graph of a database.
+   * \param lsdb the database
+   */
+  SPFGraph (const GlobalRouteManagerLSDB *lsdb);
+  /**
+   * \param id a Link State ID
+   * \returns the index of the vertex, or -1 if there is none
+   */
+  int32_t Find (Ipv4Address id) const;
+  /**
+   * \param v the index of a vertex
+   * \returns the LSA of the vertex
+   */
+  GlobalRoutingLSA *GetLSA (uint32_t v) const;
+  /**
+   * \param v the index of a vertex
+   * \returns the out edges of the vertex, in the order SPFNext () follows them
+   */
+  const std::vector<Edge_t> &GetEdges (uint32_t v) const;
+  /**
+   * \returns the number of vertices
+   */
+  uint32_t GetNVertices (void) const;
+  /**
+   * \brief Compute the distance of every vertex to a vertex.
+   * \param v the index of the destination vertex
+   * \param distances the distance of each vertex to v, or SPF_UNREACHABLE
+   */
+  void GetDistancesTo (uint32_t v, std::vector<uint64_t> &distances) const;
+
+private:
+  /// An in edge: the index of the tail vertex, and the cost
+  typedef std::pair<uint32_t, uint32_t> InEdge_t;
+
+  std::vector<GlobalRoutingLSA *> m_lsas;          //!< LSA of each vertex
+  std::map<Ipv4Address, uint32_t> m_index;         //!< index of each Link State ID
+  std::vector<std::vector<Edge_t> > m_edges;       //!< out edges of each vertex
+  std::vector<std::vector<InEdge_t> > m_inEdges;   //!< in edges of each vertex
+};
+
+SPFGraph::SPFGraph (const GlobalRouteManagerLSDB *lsdb)
+{
+  lsdb->GetLSAs (m_lsas);
+  m_edges.resize (m_lsas.size ());
+  m_inEdges.resize (m_lsas.size ());
+  for (uint32_t v = 0; v < m_lsas.size (); v++)
+    {
+      m_index.insert (std::make_pair (m_lsas[v]->GetLinkStateId (), v));
+    }
+  for (uint32_t v = 0; v < m_lsas.size (); v++)
+    {
+      GlobalRoutingLSA *lsa = m_lsas[v];
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+            {
+              GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+              if (l->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint
+                  && l->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  continue;
+                }
+              GlobalRoutingLSA *w = lsdb->GetLSA (l->GetLinkId ());
+              if (w)
+                {
+                  m_edges[v].push_back (Edge_t (w->GetLinkStateId (), l->GetMetric ()));
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          for (uint32_t i = 0; i < lsa->GetNAttachedRouters (); i++)
+            {
+              GlobalRoutingLSA *w = lsdb->GetLSAByLinkData (lsa->GetAttachedRouter (i));
+              if (w)
+                {
+                  m_edges[v].push_back (Edge_t (w->GetLinkStateId (), 0));
+                }
+            }
+        }
+      for (std::vector<Edge_t>::const_iterator e = m_edges[v].begin (); e != m_edges[v].end (); e++)
+        {
+          int32_t w = Find (e->first);
+          if (w >= 0)
+            {
+              m_inEdges[w].push_back (InEdge_t (v, e->second));
+            }
+        }
+    }
+}
+
+int32_t
+SPFGraph::Find (Ipv4Address id) const
+{
+  std::map<Ipv4Address, uint32_t>::const_iterator i = m_index.find (id);
+  return i == m_index.end () ? -1 : static_cast<int32_t> (i->second);
+}
+
+GlobalRoutingLSA *
+SPFGraph::GetLSA (uint32_t v) const
+{
+  return m_lsas[v];
+}
+
+const std::vector<SPFGraph::Edge_t> &
+SPFGraph::GetEdges (uint32_t v) const
+{
+  return m_edges[v];
+}
+
+uint32_t
+SPFGraph::GetNVertices (void) const
+{
+  return m_lsas.size ();
+}
+
+void
+SPFGraph::GetDistancesTo (uint32_t v, std::vector<uint64_t> &distances) const
+{
+  typedef std::pair<uint64_t, uint32_t> Entry_t;
+  std::priority_queue<Entry_t, std::vector<Entry_t>, std::greater<Entry_t> > queue;
+  distances.assign (m_lsas.size (), SPF_UNREACHABLE);
+  distances[v] = 0;
+  queue.push (Entry_t (0, v));
+  while (!queue.empty ())
+    {
+      Entry_t top = queue.top ();
+      queue.pop ();
+      if (top.first != distances[top.second])
+        {
+          continue;
+        }
+      const std::vector<InEdge_t> &in = m_inEdges[top.second];
+      for (std::vector<InEdge_t>::const_iterator e = in.begin (); e != in.end (); e++)
+        {
+          uint64_t distance = top.first + e->second;
+          if (distance < distances[e->first])
+            {
+              distances[e->first] = distance;
+              queue.push (Entry_t (distance, e->first));
+            }
+        }
+    }
+}
+
+/**
+ * \brief Compare two LSAs.
+ * \param a an LSA
+ * \param b another LSA
+ * \returns true if the LSAs have the same content
+ */
+static bool
+IsSameLSA (const GlobalRoutingLSA *a, const GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * \brief Compare two sequences.
+ * \param before the first sequence
+ * \param after the second sequence
+ * \param removed the elements of before missing in after
+ * \param added the elements of after missing in before
+ * \returns true if the elements found in both sequences are in the same order
+ */
+template <typename T>
+static bool
+DiffSequences (const std::vector<T> &before, const std::vector<T> &after,
+               std::vector<T> &removed, std::vector<T> &added)
+{
+  std::map<T, uint32_t> count;
+  for (typename std::vector<T>::const_iterator i = after.begin (); i != after.end (); i++)
+    {
+      count[*i]++;
+    }
+  std::vector<T> kept;
+  for (typename std::vector<T>::const_iterator i = before.begin (); i != before.end (); i++)
+    {
+      typename std::map<T, uint32_t>::iterator j = count.find (*i);
+      if (j != count.end () && j->second > 0)
+        {
+          j->second--;
+          kept.push_back (*i);
+        }
+      else
+        {
+          removed.push_back (*i);
+        }
+    }
+  count.clear ();
+  for (typename std::vector<T>::const_iterator i = before.begin (); i != before.end (); i++)
+    {
+      count[*i]++;
+    }
+  uint32_t k = 0;
+  bool sameOrder = true;
+  for (typename std::vector<T>::const_iterator i = after.begin (); i != after.end (); i++)
+    {
+      typename std::map<T, uint32_t>::iterator j = count.find (*i);
+      if (j != count.end () && j->second > 0)
+        {
+          j->second--;
+          sameOrder = sameOrder && kept[k++] == *i;
+        }
+      else
+        {
+          added.push_back (*i);
+        }
+    }
+  return sameOrder;
+}
+
+/// A network: address and mask, as addresses so that they can be sorted
+typedef std::pair<Ipv4Address, Ipv4Address> SPFPrefix_t;
+
+/**
+ * \brief Get the destinations a router LSA adds to the routing tables when
+ * its vertex is in the shortest path tree.
+ * \param lsa the router LSA
+ * \param hosts the addresses of the point-to-point link records
+ * \param stubs the networks of the stub network link records
+ */
+static void
+GetLeaves (const GlobalRoutingLSA *lsa, std::vector<Ipv4Address> &hosts, std::vector<SPFPrefix_t> &stubs)
+{
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (i);
+      if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+        {
+          hosts.push_back (l->GetLinkData ());
+        }
+      else if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+        {
+          Ipv4Mask mask (l->GetLinkData ().Get ());
+          stubs.push_back (SPFPrefix_t (l->GetLinkId ().CombineMask (mask), l->GetLinkData ()));
+        }
+    }
+}
+
+/**
+ * \param a a network
+ * \param b another network
+ * \returns true if an address can belong to both networks
+ */
+static bool
+IsOverlapping (const SPFPrefix_t &a, const SPFPrefix_t &b)
+{
+  uint32_t mask = a.second.Get () & b.second.Get ();
+  return (a.first.Get () & mask) == (b.first.Get () & mask);
+}
+
+/**
+ * \brief The changes of a vertex between two LSDBs.
+ */
+struct SPFVertexChange
+{
+  Ipv4Address id;                         //!< Link State ID
+  int32_t before;                         //!< index in the old graph, or -1 if the vertex is new
+  bool reordered;                         //!< edges or leaves kept were reordered
+  bool conflict;                          //!< an added leaf may be confused with other routes
+  bool hasHost;                           //!< true if the old LSA has a point-to-point link record
+  Ipv4Address firstHost;                  //!< address of the first point-to-point link record of the old LSA
+  std::vector<Ipv4Address> removedHosts;  //!< host leaves removed
+  std::vector<Ipv4Address> addedHosts;    //!< host leaves added
+  std::vector<SPFPrefix_t> removedStubs;  //!< stub leaves removed
+  std::vector<SPFPrefix_t> addedStubs;    //!< stub leaves added
+};
+
+/**
+ * \brief An edge added to or removed from the SPF graph.
+ */
+struct SPFEdgeChange
+{
+  Ipv4Address tail;  //!< Link State ID of the tail vertex
+  Ipv4Address head;  //!< Link State ID of the head vertex
+  uint32_t cost;     //!< cost of the edge
+};
+
+//
+// An SPF tree only depends on the LSAs its root can reach.  When the LSDB
+// changes, the tree of a root r stays the same unless a change touches an
+// edge on a shortest path from r, or brings a vertex at a distance from r
+// no larger than its current one.  With the distances of the old graph,
+// computed backwards from the few vertices touched by the changes:
+//
+// - an edge (x, y) of cost c which is removed matters if
+//   d(r, x) + c == d(r, y): it may carry a shortest path;
+// - an edge (x, y) of cost c which is added matters if
+//   d(r, x) + c <= d(r, y): it creates a new shortest or equal-cost path.
+//
+// When no edge change matters to r, the vertices of the tree, their
+// distances, parents and exits from r stay the same; only the host and
+// stub networks at the edge of the tree (the "leaves") can differ.  These
+// routes are patched in place, using the exits of the routes r already
+// has to the router.  Everything else (a change next to r, reordered
+// records which would change the order of the equal-cost candidates, or
+// added networks which overlap other ones, whose position in the routing
+// table matters for the lookups) triggers a new SPF calculation for r.
+//
+bool
+GlobalRouteManagerImpl::UpdateRoutes (const GlobalRouteManagerLSDB *oldLsdb)
+{
+  NS_LOG_FUNCTION (this << oldLsdb);
+
+  if (oldLsdb->GetNumExtLSAs () != m_lsdb->GetNumExtLSAs ())
+    {
+      NS_LOG_LOGIC ("External LSAs changed");
+      return false;
+    }
+  for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
+    {
+      if (!IsSameLSA (oldLsdb->GetExtLSA (i), m_lsdb->GetExtLSA (i)))
+        {
+          NS_LOG_LOGIC ("External LSAs changed");
+          return false;
+        }
+    }
+
+  SPFGraph before (oldLsdb);
+  SPFGraph after (m_lsdb);
+
+//
+// Compare the vertices of the two graphs.
+//
+  std::set<Ipv4Address> ids;
+  for (uint32_t v = 0; v < before.GetNVertices (); v++)
+    {
+      ids.insert (before.GetLSA (v)->GetLinkStateId ());
+    }
+  for (uint32_t v = 0; v < after.GetNVertices (); v++)
+    {
+      ids.insert (after.GetLSA (v)->GetLinkStateId ());
+    }
+  std::set<Ipv4Address> changed;
+  std::vector<SPFVertexChange> vertexChanges;
+  std::vector<SPFEdgeChange> removedEdges;
+  std::vector<SPFEdgeChange> addedEdges;
+  static const std::vector<SPFGraph::Edge_t> noEdges;
+  for (std::set<Ipv4Address>::const_iterator id = ids.begin (); id != ids.end (); id++)
+    {
+      int32_t o = before.Find (*id);
+      int32_t n = after.Find (*id);
+      const std::vector<SPFGraph::Edge_t> &oldEdges = o >= 0 ? before.GetEdges (o) : noEdges;
+      const std::vector<SPFGraph::Edge_t> &newEdges = n >= 0 ? after.GetEdges (n) : noEdges;
+      if (o >= 0 && n >= 0 && IsSameLSA (before.GetLSA (o), after.GetLSA (n)) && oldEdges == newEdges)
+        {
+          continue;
+        }
+      if (o >= 0 && n >= 0)
+        {
+          GlobalRoutingLSA *a = before.GetLSA (o);
+          GlobalRoutingLSA *b = after.GetLSA (n);
+          if (a->GetLSType () != b->GetLSType ()
+              || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+              || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ())
+            {
+              NS_LOG_LOGIC ("LSA " << *id << " changed its type, router or network");
+              return false;
+            }
+        }
+      changed.insert (*id);
+
+      SPFVertexChange change;
+      change.id = *id;
+      change.before = o;
+      change.conflict = false;
+      change.hasHost = false;
+      std::vector<SPFGraph::Edge_t> removed;
+      std::vector<SPFGraph::Edge_t> added;
+      change.reordered = !DiffSequences (oldEdges, newEdges, removed, added);
+      for (std::vector<SPFGraph::Edge_t>::const_iterator e = removed.begin (); e != removed.end (); e++)
+        {
+          SPFEdgeChange edge = { *id, e->first, e->second };
+          removedEdges.push_back (edge);
+        }
+      for (std::vector<SPFGraph::Edge_t>::const_iterator e = added.begin (); e != added.end (); e++)
+        {
+          SPFEdgeChange edge = { *id, e->first, e->second };
+          addedEdges.push_back (edge);
+        }
+      if (o >= 0 && n >= 0 && before.GetLSA (o)->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          std::vector<Ipv4Address> oldHosts, newHosts;
+          std::vector<SPFPrefix_t> oldStubs, newStubs;
+          GetLeaves (before.GetLSA (o), oldHosts, oldStubs);
+          GetLeaves (after.GetLSA (n), newHosts, newStubs);
+          change.reordered = !DiffSequences (oldHosts, newHosts, change.removedHosts, change.addedHosts)
+            || !DiffSequences (oldStubs, newStubs, change.removedStubs, change.addedStubs)
+            || change.reordered;
+          change.hasHost = !oldHosts.empty ();
+          change.firstHost = change.hasHost ? oldHosts.front () : Ipv4Address ();
+        }
+      vertexChanges.push_back (change);
+    }
+  NS_LOG_LOGIC (changed.size () << " LSAs changed, " << removedEdges.size () << " edges removed, "
+                                << addedEdges.size () << " edges added");
+
+//
+// The leaves which are added can only be appended to the routing tables
+// when they do not share addresses with other routes.
+//
+  std::vector<SPFPrefix_t> oldPrefixes;
+  std::set<Ipv4Address> oldHosts;
+  for (uint32_t v = 0; v < before.GetNVertices (); v++)
+    {
+      GlobalRoutingLSA *lsa = before.GetLSA (v);
+      if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          Ipv4Mask mask = lsa->GetNetworkLSANetworkMask ();
+          oldPrefixes.push_back (SPFPrefix_t (lsa->GetLinkStateId ().CombineMask (mask), Ipv4Address (mask.Get ())));
+        }
+      else
+        {
+          std::vector<Ipv4Address> hosts;
+          GetLeaves (lsa, hosts, oldPrefixes);
+          oldHosts.insert (hosts.begin (), hosts.end ());
+        }
+    }
+  std::set<Ipv4Address> addedHosts;
+  for (std::vector<SPFVertexChange>::iterator c = vertexChanges.begin (); c != vertexChanges.end (); c++)
+    {
+      for (std::vector<Ipv4Address>::const_iterator h = c->addedHosts.begin (); h != c->addedHosts.end (); h++)
+        {
+          c->conflict = c->conflict || oldHosts.count (*h) || !addedHosts.insert (*h).second;
+        }
+      for (std::vector<SPFPrefix_t>::const_iterator p = c->addedStubs.begin (); p != c->addedStubs.end (); p++)
+        {
+          for (std::vector<SPFPrefix_t>::const_iterator q = oldPrefixes.begin (); q != oldPrefixes.end () && !c->conflict; q++)
+            {
+              c->conflict = IsOverlapping (*p, *q);
+            }
+          for (std::vector<SPFVertexChange>::const_iterator d = vertexChanges.begin (); d != vertexChanges.end (); d++)
+            {
+              for (std::vector<SPFPrefix_t>::const_iterator q = d->addedStubs.begin (); q != d->addedStubs.end (); q++)
+                {
+                  c->conflict = c->conflict || (q != p && IsOverlapping (*p, *q));
+                }
+            }
+        }
+    }
+
+  std::vector<Ipv4Address> roots;
+  FindRoots (roots);
+
+//
+// Compute the distances to the vertices touched by the changes, unless
+// there are so many of them that recomputing everything is cheaper.
+//
+  std::map<uint32_t, std::vector<uint64_t> > distances;
+  std::set<uint32_t> targets;
+  for (std::vector<SPFEdgeChange>::const_iterator e = removedEdges.begin (); e != removedEdges.end (); e++)
+    {
+      targets.insert (before.Find (e->tail));
+      targets.insert (before.Find (e->head));
+    }
+  for (std::vector<SPFEdgeChange>::const_iterator e = addedEdges.begin (); e != addedEdges.end (); e++)
+    {
+      targets.insert (before.Find (e->tail));
+      targets.insert (before.Find (e->head));
+    }
+  for (std::vector<SPFVertexChange>::const_iterator c = vertexChanges.begin (); c != vertexChanges.end (); c++)
+    {
+      targets.insert (c->before);
+    }
+  targets.erase (-1);
+  if (targets.size () > std::max<std::size_t> (roots.size () / 4, 1))
+    {
+      NS_LOG_LOGIC ("Too many changes (" << targets.size () << " vertices) for " << roots.size () << " roots");
+      return false;
+    }
+  for (std::set<uint32_t>::const_iterator t = targets.begin (); t != targets.end (); t++)
+    {
+      before.GetDistancesTo (*t, distances[*t]);
+    }
+
+  std::vector<Ipv4Address> recompute;
+  uint32_t nPatched = 0;
+  for (std::vector<Ipv4Address>::const_iterator r = roots.begin (); r != roots.end (); r++)
+    {
+      int32_t ir = before.Find (*r);
+      bool full = !m_spfRoots.count (*r) || ir < 0 || changed.count (*r);
+      std::vector<const SPFVertexChange *> patches;
+      if (!full && m_stubRoots.count (*r))
+        {
 //
-// Walk the list of nodes in the system.
+// CheckForStubNode () only used the LSAs of the root and of its neighbor.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
-    {
-      Ptr<Node> node = *i;
+          GlobalRoutingLSA *rlsa = before.GetLSA (ir);
+          for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
+            {
+              GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+              full = full || (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint && changed.count (l->GetLinkId ()));
+            }
+          if (full)
+            {
+              recompute.push_back (*r);
+              DeleteRoutes (m_routers[*r]);
+              m_stubRoots.erase (*r);
+            }
+          continue;
+        }
+      if (!full)
+        {
 //
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
+// The exits from the root depend on the LSAs of its neighbors.
 //
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+          GlobalRoutingLSA *rlsa = before.GetLSA (ir);
+          for (uint32_t i = 0; i < rlsa->GetNLinkRecords () && !full; i++)
+            {
+              GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                {
+                  full = changed.count (l->GetLinkId ());
+                }
+              else if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  full = changed.count (l->GetLinkId ());
+                  const GlobalRouteManagerLSDB *lsdbs[] = { oldLsdb, m_lsdb };
+                  for (uint32_t k = 0; k < 2 && !full; k++)
+                    {
+                      GlobalRoutingLSA *network = lsdbs[k]->GetLSA (l->GetLinkId ());
+                      for (uint32_t j = 0; network && j < network->GetNAttachedRouters () && !full; j++)
+                        {
+                          GlobalRoutingLSA *w = lsdbs[k]->GetLSAByLinkData (network->GetAttachedRouter (j));
+                          full = w && changed.count (w->GetLinkStateId ());
+                        }
+                    }
+                }
+            }
+        }
+      for (std::vector<SPFEdgeChange>::const_iterator e = removedEdges.begin (); e != removedEdges.end () && !full; e++)
+        {
+          uint64_t dx = distances[before.Find (e->tail)][ir];
+          uint64_t dy = distances[before.Find (e->head)][ir];
+          full = dx != SPF_UNREACHABLE && dx + e->cost == dy;
+        }
+      for (std::vector<SPFEdgeChange>::const_iterator e = addedEdges.begin (); e != addedEdges.end () && !full; e++)
+        {
+          int32_t x = before.Find (e->tail);
+          int32_t y = before.Find (e->head);
+          uint64_t dx = x >= 0 ? distances[x][ir] : SPF_UNREACHABLE;
+          uint64_t dy = y >= 0 ? distances[y][ir] : SPF_UNREACHABLE;
+          full = dx != SPF_UNREACHABLE && dx + e->cost <= dy;
+        }
+      for (std::vector<SPFVertexChange>::const_iterator c = vertexChanges.begin (); c != vertexChanges.end () && !full; c++)
+        {
+          if (c->before < 0 || distances[c->before][ir] == SPF_UNREACHABLE)
+            {
+              continue;
+            }
+          bool leaves = !c->removedHosts.empty () || !c->addedHosts.empty ()
+            || !c->removedStubs.empty () || !c->addedStubs.empty ();
+          full = c->reordered || c->conflict || (leaves && !c->hasHost);
+          if (leaves)
+            {
+              patches.push_back (&*c);
+            }
+        }
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      Ptr<Node> node = m_routers[*r];
+      if (full)
+        {
+          NS_LOG_LOGIC ("Recomputing the routes of " << *r);
+          recompute.push_back (*r);
+          DeleteRoutes (node);
+          m_stubRoots.erase (*r);
+          continue;
+        }
+      if (patches.empty ())
         {
           continue;
         }
+      NS_LOG_LOGIC ("Patching the routes of " << *r);
+      nPatched++;
+      Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      for (std::vector<const SPFVertexChange *>::const_iterator c = patches.begin (); c != patches.end (); c++)
+        {
+//
+// The routes to a router go through the exits of the host routes to its
+// first point-to-point link.
+//
+          std::vector<Ipv4RoutingTableEntry *> routes;
+          gr->GetHostRoutesTo ((*c)->firstHost, routes);
+          std::vector<std::pair<Ipv4Address, uint32_t> > exits;
+          for (std::vector<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin (); i != routes.end (); i++)
+            {
+              exits.push_back (std::make_pair ((*i)->GetGateway (), (*i)->GetInterface ()));
+            }
+          for (uint32_t i = 0; i < exits.size (); i++)
+            {
+              for (std::vector<Ipv4Address>::const_iterator h = (*c)->removedHosts.begin (); h != (*c)->removedHosts.end (); h++)
+                {
+                  gr->RemoveHostRouteTo (*h, exits[i].first, exits[i].second);
+                }
+              for (std::vector<SPFPrefix_t>::const_iterator p = (*c)->removedStubs.begin (); p != (*c)->removedStubs.end (); p++)
+                {
+                  gr->RemoveNetworkRouteTo (p->first, Ipv4Mask (p->second.Get ()), exits[i].first, exits[i].second);
+                }
+            }
+          for (std::vector<Ipv4Address>::const_iterator h = (*c)->addedHosts.begin (); h != (*c)->addedHosts.end (); h++)
+            {
+              for (uint32_t i = 0; i < exits.size (); i++)
+                {
+                  gr->AddHostRouteTo (*h, exits[i].first, exits[i].second);
+                }
+            }
+          for (std::vector<SPFPrefix_t>::const_iterator p = (*c)->addedStubs.begin (); p != (*c)->addedStubs.end (); p++)
+            {
+              for (uint32_t i = 0; i < exits.size (); i++)
+                {
+                  gr->AddNetworkRouteTo (p->first, Ipv4Mask (p->second.Get ()), exits[i].first, exits[i].second);
+                }
+            }
+        }
+    }
+  NS_LOG_INFO ("Recomputing " << recompute.size () << " and patching " << nPatched << " of "
+                              << roots.size () << " routing tables");
 
 //
-// if the node has a global router interface, then run the global routing
-// algorithms.
+// The nodes which are no longer roots lose their routes, as they would
+// after DeleteGlobalRoutes ().
 //
-      if (rtr && rtr->GetNumLSAs () )
+  std::set<Ipv4Address> newRoots (roots.begin (), roots.end ());
+  for (std::set<Ipv4Address>::const_iterator r = m_spfRoots.begin (); r != m_spfRoots.end (); r++)
+    {
+      if (!newRoots.count (*r))
         {
-          SPFCalculate (rtr->GetRouterId ());
+          RouterMap_t::const_iterator i = m_routers.find (*r);
+          if (i != m_routers.end ())
+            {
+              DeleteRoutes (i->second);
+            }
+          m_stubRoots.erase (*r);
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+
+  SPFCalculate (recompute);
+  m_spfRoots = newRoots;
+  m_routers.clear ();
+  m_routesValid = true;
+  return true;
 }
 
 //
@@ -836,7 +1791,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +1816,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -873,7 +1828,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
           w = new SPFVertex (w_lsa);
           if (SPFNexthopCalculation (v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              SetLSAStatus (w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1843,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (GetLSAStatus (w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -960,7 +1915,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Reorder (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1320,7 +2275,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
+                  Ptr<GlobalRouter> router = m_spfrootNode->GetObject<GlobalRouter> ();
                   NS_ASSERT (router);
                   Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
                   NS_ASSERT (gr);
@@ -1345,9 +2300,16 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// Initialize the status of the Link State Advertisements.  It is kept in
+// this object rather than in the LSAs, which may be shared with other
+// calculations running concurrently, in a vector indexed by the position of
+// the LSAs in the LSDB.
+//
+  m_status.assign (m_lsdb->GetNumLSAs (), GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
 //
-  m_lsdb->Initialize ();
+// Look up the node of the root, whose routing table is going to be written.
+//
+  m_spfrootNode = FindRouterNode (root);
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1367,7 +2329,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   m_spfroot= v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1377,10 +2339,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (m_spfrootNode != 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      m_stubRoots.insert (root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
       return;
     }
 
@@ -1428,7 +2393,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      SetLSAStatus (v->GetLSA (), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1502,6 +2467,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootNode = 0;
+  m_status.clear ();
 }
 
 void
@@ -1560,58 +2527,38 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node with the router ID of the root vertex was looked up when the
+// calculation started.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1626,39 +2573,36 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1729,60 +2673,38 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node with the router ID of the root vertex was looked up when the
+// calculation started.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to QI
 // for that interface.  If the node is acting as an IP version 4 router, it
 // should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "QI for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1797,39 +2719,36 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1853,61 +2772,42 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// The node corresponding to the root of the SPF tree was looked up when the
+// calculation started.  This is the node for which we are building the
+// routing table.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfrootNode == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
 //
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
+// Couldn't find it.
 //
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
+      return -1;
+    }
 //
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
+// We're going to need the Ipv4 interface to look for the ipv4 interface
+// index.  Since this node is participating in routing IP version 4 packets,
+// it certainly must have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = m_spfrootNode->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+  int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1944,60 +2844,38 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node with the router ID of the root vertex was looked up when the
+// calculation started.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2884,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node->GetId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,45 +2909,42 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+      if (router == 0)
+        {
+          continue;
+        }
+      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+      NS_ASSERT (gr);
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
             }
+        } // for all routes from the root the vertex 'v'
+    }
 //
 // Done adding the routes for the selected node.
 //
-          return;
-        }
-    }
 }
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
@@ -2089,95 +2964,71 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node with the router ID of the root vertex was looked up when the
+// calculation started.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
 //
 // Routing information is updated using the Ipv4 interface.  We need to 
 // GetObject for that interface.  If the node is acting as an IP version 4 
 // router, it should absolutely have an Ipv4 interface.
 //
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (ipv4, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "GetObject for <Ipv4> interface failed");
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  NS_ASSERT (gr);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
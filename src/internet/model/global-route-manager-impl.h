@@ -26,9 +26,11 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/node.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
 
@@ -604,6 +606,9 @@ public:
  * The IPV4 address and the GlobalRoutingLSA given as parameters are converted
  * to an STL pair and are inserted into the database map.
  *
+ * The TransitNetwork link records of the LSA are indexed at the same time,
+ * for GetLSAByLinkData ().
+ *
  * @see GlobalRoutingLSA
  * @see Ipv4Address
  * @param addr The IP address associated with the LSA.  Typically the Router 
@@ -674,12 +679,31 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+/**
+ * @brief Get the number of LSAs, other than the External LSAs, in the
+ * database.
+ *
+ * These LSAs are numbered from 0 to this number minus one, in the order
+ * they were inserted (see GlobalRoutingLSA::GetLsdbIndex ()).
+ *
+ * @returns the number of LSAs
+ */
+  uint32_t GetNumLSAs () const;
+  /**
+   * @brief Get the Link State Advertisements which are not External ones.
+   *
+   * @param lsas the Link State Advertisements, in the order of their address
+   */
+  void GetLSAs (std::vector<GlobalRoutingLSA*> &lsas) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
+  typedef std::map<Ipv4Address, LSDBMap_t::const_iterator> LinkDataMap_t; //!< container of link data / database entries
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  LinkDataMap_t m_linkData; //!< entry with the lowest address having a TransitNetwork link record with each link data
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -708,6 +732,15 @@ private:
  * and finally configure each of the node's forwarding tables.
  *
  * The design is guided by OSPFv2 \RFC{2328} section 16.1.1 and quagga ospfd.
+ *
+ * The SPF calculations of the different roots only read the shared LSDB
+ * and write the routing table of their root, so they are spread over the
+ * number of threads given by the "GlobalRoutingThreads" global value.  When
+ * the "GlobalRoutingIncremental" global value is set, RecomputeRoutingTables
+ * () compares the new LSDB with the previous one and only recomputes the
+ * routing tables of the roots whose shortest path tree may have changed.
+ * The other roots get their routes to the networks and hosts added or
+ * removed at the edge of the tree patched in place.
  */
 class GlobalRouteManagerImpl
 {
@@ -735,6 +768,18 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Delete the routes, rebuild the routing database and compute the
+ * routes again, after a change of the topology.
+ *
+ * When the "GlobalRoutingIncremental" global value is set and the routes
+ * were computed before, only the routing tables which depend on the Link
+ * State Advertisements which changed are updated.  Otherwise, this is the
+ * same as calling DeleteGlobalRoutes (), BuildGlobalRoutingDatabase () and
+ * InitializeRoutes ().
+ */
+  virtual void RecomputeRoutingTables ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -766,8 +811,103 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /// Roots of the SPF calculations shared by the worker threads
+  struct SPFRootQueue;
+
+  /**
+   * \brief Create a worker calculating the SPF trees of a share of the roots.
+   *
+   * The worker uses the LSDB and the routers of the parent, which it does
+   * not own.
+   *
+   * \param parent the Global Route Manager running the calculation
+   * \param queue the roots left to process
+   */
+  GlobalRouteManagerImpl (const GlobalRouteManagerImpl *parent, SPFRootQueue *queue);
+
+  /// Container of the nodes of the routers, by router ID
+  typedef std::map<Ipv4Address, Ptr<Node> > RouterMap_t;
+  /// Container of the SPF status of the LSAs during a calculation, by LSDB index
+  typedef std::vector<GlobalRoutingLSA::SPFStatus> StatusVector_t;
+
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root router, whose routing table is being computed
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< true if the LSDB is deleted with this object
+  StatusVector_t m_status; //!< SPF status of the LSAs in the current calculation
+  RouterMap_t m_routers; //!< nodes of the routers, during a computation of the routes
+  SPFRootQueue *m_queue; //!< roots left to process, for a worker
+  std::set<Ipv4Address> m_spfRoots; //!< roots whose routes were computed
+  std::set<Ipv4Address> m_stubRoots; //!< roots which only got a default route from CheckForStubNode ()
+  bool m_routesValid; //!< true if the routes installed match the LSDB
+
+  /**
+   * \brief Delete the routes installed by global routing on a node.
+   *
+   * \param node the node
+   */
+  void DeleteRoutes (Ptr<Node> node);
+
+  /**
+   * \brief Look up the routers and the roots of the SPF calculations.
+   *
+   * Fills m_routers with the nodes having a GlobalRouter interface.
+   *
+   * \param roots the router IDs of the nodes whose routes must be computed,
+   * in the order of the NodeList
+   */
+  void FindRoots (std::vector<Ipv4Address> &roots);
+
+  /**
+   * \brief Find the node of a router.
+   *
+   * \param routerId the router ID
+   * \returns the node, or 0 if no node has this router ID
+   */
+  Ptr<Node> FindRouterNode (Ipv4Address routerId) const;
+
+  /**
+   * \brief Calculate the SPF trees of several roots.
+   *
+   * The calculations are spread over "GlobalRoutingThreads" threads.
+   *
+   * \param roots the router IDs of the roots
+   */
+  void SPFCalculate (const std::vector<Ipv4Address> &roots);
+
+  /**
+   * \brief Calculate the SPF trees of the roots of m_queue until none is left.
+   */
+  void SPFWorker (void);
+
+  /**
+   * \brief Update the routes after the LSDB was rebuilt.
+   *
+   * The differences between the old and the new LSDB tell which roots need
+   * a new SPF calculation.  The other routing tables are patched in place.
+   *
+   * \param oldLsdb the LSDB the current routes were computed from
+   * \returns false if the changes are too large to be processed
+   * incrementally; in this case, no route was changed
+   */
+  bool UpdateRoutes (const GlobalRouteManagerLSDB *oldLsdb);
+
+  /**
+   * \param lsa an LSA
+   * \returns the status of the LSA in the current calculation
+   */
+  GlobalRoutingLSA::SPFStatus GetLSAStatus (const GlobalRoutingLSA *lsa) const;
+
+  /**
+   * \brief Set the status of an LSA in the current calculation.
+   *
+   * The status is private to this object, so that several calculations can
+   * share the same LSDB.
+   *
+   * \param lsa an LSA
+   * \param status the status
+   */
+  void SetLSAStatus (const GlobalRoutingLSA *lsa, GlobalRoutingLSA::SPFStatus status);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -65,6 +65,17 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the routes after a
+ * change of the topology.
+ *
+ * This is equivalent to DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes (), except that with the "GlobalRoutingIncremental"
+ * global value set, only the routing tables the change may affect are
+ * recomputed.
+ */
+  static void RecomputeRoutingTables ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
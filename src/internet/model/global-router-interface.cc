@@ -143,7 +143,8 @@ GlobalRoutingLSA::GlobalRoutingLSA()
     m_networkLSANetworkMask ("0.0.0.0"),
     m_attachedRouters (),
     m_status (GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED),
-    m_node_id (0)
+    m_node_id (0),
+    m_lsdbIndex (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -160,7 +161,8 @@ GlobalRoutingLSA::GlobalRoutingLSA (
     m_networkLSANetworkMask ("0.0.0.0"),
     m_attachedRouters (),
     m_status (status),
-    m_node_id (0)
+    m_node_id (0),
+    m_lsdbIndex (0)
 {
   NS_LOG_FUNCTION (this << status << linkStateId << advertisingRtr);
 }
@@ -170,7 +172,8 @@ GlobalRoutingLSA::GlobalRoutingLSA (GlobalRoutingLSA& lsa)
     m_advertisingRtr (lsa.m_advertisingRtr),
     m_networkLSANetworkMask (lsa.m_networkLSANetworkMask),
     m_status (lsa.m_status),
-    m_node_id (lsa.m_node_id)
+    m_node_id (lsa.m_node_id),
+    m_lsdbIndex (0)
 {
   NS_LOG_FUNCTION (this << &lsa);
   NS_ASSERT_MSG (IsEmpty (),
@@ -386,6 +389,20 @@ GlobalRoutingLSA::SetStatus (GlobalRoutingLSA::SPFStatus status)
   m_status = status;
 }
 
+uint32_t
+GlobalRoutingLSA::GetLsdbIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_lsdbIndex;
+}
+
+void
+GlobalRoutingLSA::SetLsdbIndex (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  m_lsdbIndex = index;
+}
+
 Ptr<Node>
 GlobalRoutingLSA::GetNode (void) const
 {
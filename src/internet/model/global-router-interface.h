@@ -485,6 +485,24 @@ public:
  */
   void SetStatus (SPFStatus status);
 
+/**
+ * @brief Get the index of the advertisement in the Link State Database
+ * holding it.
+ *
+ * The LSAs of a database are numbered from 0 in the order they are
+ * inserted, so that the SPF calculations can keep per-LSA data in vectors.
+ *
+ * @returns The index of the LSA in its Link State Database.
+ */
+  uint32_t GetLsdbIndex (void) const;
+
+/**
+ * @brief Set the index of the advertisement in the Link State Database
+ * holding it.
+ * @param index the index
+ */
+  void SetLsdbIndex (uint32_t index);
+
 /**
  * @brief Get the Node pointer of the node that originated this LSA
  * @returns Node pointer
@@ -566,6 +584,7 @@ private:
  */
   SPFStatus m_status;
   uint32_t m_node_id; //!< node ID
+  uint32_t m_lsdbIndex; //!< index of the LSA in its Link State Database
 };
 
 /**
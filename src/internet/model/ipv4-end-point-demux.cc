@@ -22,6 +22,7 @@
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 
 namespace ns3 {
@@ -49,21 +50,19 @@ bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++) 
     {
       if ((*i)->GetLocalPort () == port &&
           (*i)->GetLocalAddress () == addr &&
@@ -86,7 +85,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -102,7 +101,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -125,7 +124,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -136,7 +135,26 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  // Only the end points with the same four-tuple may be duplicates.
+  EndPoints candidates;
+  if (IsConnected (localAddress, peerAddress, peerPort))
+    {
+      ConnectedKey key = { localAddress, localPort, peerAddress, peerPort };
+      std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+      for (ConnectedMapI i = range.first; i != range.second; ++i)
+        {
+          candidates.push_back (i->second);
+        }
+    }
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator it = m_listeners.find (localPort);
+      if (it != m_listeners.end ())
+        {
+          candidates = it->second;
+        }
+    }
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -150,7 +168,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -161,15 +179,15 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<Ipv4EndPoint *, Entry>::iterator it = m_entries.find (endPoint);
+  if (it == m_entries.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (it->second.all);
+  m_entries.erase (it);
+  delete endPoint;
 }
 
 /*
@@ -208,7 +226,42 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+
+  // The end points which may match: those of the local port with a wildcard
+  // address or port, and the connected ones bound to the destination address
+  // or to the net part of a subnet-directed broadcast destination.
+  EndPoints candidates;
+  std::unordered_map<uint16_t, EndPoints>::iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates = listeners->second;
+    }
+  if (!m_connected.empty ())
+    {
+      std::vector<Ipv4Address> localAddresses;
+      localAddresses.push_back (daddr);
+      for (uint32_t i = 0; incomingInterface != 0 && i < incomingInterface->GetNAddresses (); i++)
+        {
+          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+          Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+          if (daddr.CombineMask (addr.GetMask ()) == addrNetpart
+              && std::find (localAddresses.begin (), localAddresses.end (), addrNetpart) == localAddresses.end ())
+            {
+              localAddresses.push_back (addrNetpart);
+            }
+        }
+      for (std::vector<Ipv4Address>::const_iterator a = localAddresses.begin (); a != localAddresses.end (); a++)
+        {
+          ConnectedKey key = { *a, dport, saddr, sport };
+          std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+          for (ConnectedMapI i = range.first; i != range.second; ++i)
+            {
+              candidates.push_back (i->second);
+            }
+        }
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++) 
     {
       Ipv4EndPoint* endP = *i;
 
@@ -347,7 +400,12 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
+    {
+      return 0;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++) 
     {
       if ((*i)->GetLocalPort () != dport) 
         {
@@ -400,5 +458,92 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
   return port;
 }
 
-} // namespace ns3
+bool
+Ipv4EndPointDemux::ConnectedKey::operator== (const ConnectedKey &other) const
+{
+  return localAddress == other.localAddress && localPort == other.localPort
+         && peerAddress == other.peerAddress && peerPort == other.peerPort;
+}
+
+std::size_t
+Ipv4EndPointDemux::ConnectedKeyHash::operator() (const ConnectedKey &key) const
+{
+  uint32_t h = key.localAddress.Get ();
+  h = h * 0x9e3779b1U ^ key.peerAddress.Get ();
+  h = h * 0x9e3779b1U ^ ((static_cast<uint32_t> (key.localPort) << 16) | key.peerPort);
+  return h;
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4Address localAddress, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return localAddress != Ipv4Address::GetAny () && peerAddress != Ipv4Address::GetAny () && peerPort != 0;
+}
 
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  m_entries[endPoint].all = std::prev (m_endPoints.end ());
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t port = endPoint->GetLocalPort ();
+  EndPoints &endPoints = m_ports[port];
+  endPoints.push_back (endPoint);
+  m_entries[endPoint].port = std::prev (endPoints.end ());
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      ConnectedKey key = { endPoint->GetLocalAddress (), port, endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      m_connected.insert (std::make_pair (key, endPoint));
+    }
+  else
+    {
+      m_listeners[port].push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t port = endPoint->GetLocalPort ();
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (m_entries[endPoint].port);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
+    }
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      ConnectedKey key = { endPoint->GetLocalAddress (), port, endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+      for (ConnectedMapI i = range.first; i != range.second; ++i)
+        {
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              break;
+            }
+        }
+    }
+  else
+    {
+      it = m_listeners.find (port);
+      NS_ASSERT (it != m_listeners.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listeners.erase (it);
+        }
+    }
+}
+
+} // namespace ns3
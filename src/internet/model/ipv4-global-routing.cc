@@ -20,6 +20,7 @@
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/simulator.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
@@ -80,6 +81,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteIndex.Insert (dest, Ipv4Mask::GetOnes (), route);
 }
 
 void 
@@ -90,6 +92,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_hostRouteIndex.Insert (dest, Ipv4Mask::GetOnes (), route);
 }
 
 void 
@@ -105,6 +108,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteIndex.Insert (network, networkMask, route);
 }
 
 void 
@@ -118,6 +122,65 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_networkRouteIndex.Insert (network, networkMask, route);
+}
+
+void
+Ipv4GlobalRouting::GetHostRoutesTo (Ipv4Address dest,
+                                    std::vector<Ipv4RoutingTableEntry *> &routes) const
+{
+  NS_LOG_FUNCTION (this << dest);
+  std::vector<Ipv4RoutingTableEntry *> candidates;
+  m_hostRouteIndex.Lookup (dest, candidates);
+  routes.clear ();
+  for (std::vector<Ipv4RoutingTableEntry *>::const_iterator i = candidates.begin (); i != candidates.end (); i++)
+    {
+      if ((*i)->IsHost () && (*i)->GetDest () == dest)
+        {
+          routes.push_back (*i);
+        }
+    }
+}
+
+bool
+Ipv4GlobalRouting::RemoveHostRouteTo (Ipv4Address dest,
+                                      Ipv4Address nextHop,
+                                      uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << dest << nextHop << interface);
+  for (HostRoutesI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      if ((*i)->GetDest () == dest && (*i)->GetGateway () == nextHop
+          && (*i)->GetInterface () == interface)
+        {
+          m_hostRouteIndex.Remove (dest, Ipv4Mask::GetOnes (), *i);
+          delete *i;
+          m_hostRoutes.erase (i);
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+Ipv4GlobalRouting::RemoveNetworkRouteTo (Ipv4Address network,
+                                         Ipv4Mask networkMask,
+                                         Ipv4Address nextHop,
+                                         uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << network << networkMask << nextHop << interface);
+  for (NetworkRoutesI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      if ((*j)->GetDestNetwork () == network && (*j)->GetDestNetworkMask () == networkMask
+          && (*j)->GetGateway () == nextHop && (*j)->GetInterface () == interface)
+        {
+          m_networkRouteIndex.Remove (network, networkMask, *j);
+          delete *j;
+          m_networkRoutes.erase (j);
+          return true;
+        }
+    }
+  return false;
 }
 
 void 
@@ -143,12 +206,12 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
+  m_hostRouteIndex.Lookup (dest, m_candidates);
+  for (RouteVec_t::const_iterator i = m_candidates.begin (); 
+       i != m_candidates.end (); 
        i++) 
     {
       NS_ASSERT ((*i)->IsHost ());
@@ -169,8 +232,9 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
   if (allRoutes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
+      m_networkRouteIndex.Lookup (dest, m_candidates);
+      for (RouteVec_t::const_iterator j = m_candidates.begin (); 
+           j != m_candidates.end (); 
            j++) 
         {
           Ipv4Mask mask = (*j)->GetDestNetworkMask ();
@@ -319,6 +383,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           if (tmp  == index)
             {
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
+              m_hostRouteIndex.Remove ((*i)->GetDest (), Ipv4Mask::GetOnes (), *i);
               delete *i;
               m_hostRoutes.erase (i);
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
@@ -336,6 +401,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
       if (tmp == index)
         {
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
+          m_networkRouteIndex.Remove ((*j)->GetDestNetwork (), (*j)->GetDestNetworkMask (), *j);
           delete *j;
           m_networkRoutes.erase (j);
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
@@ -362,6 +428,81 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+uint32_t
+Ipv4GlobalRouting::GetSerializedSize (void) const
+{
+  // Counts of the three kinds of routes, then destination, mask (except
+  // for host routes), gateway and interface of each route
+  return 12 + m_hostRoutes.size () * 12
+         + (m_networkRoutes.size () + m_ASexternalRoutes.size ()) * 16;
+}
+
+void
+Ipv4GlobalRouting::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  i.WriteU32 (m_hostRoutes.size ());
+  i.WriteU32 (m_networkRoutes.size ());
+  i.WriteU32 (m_ASexternalRoutes.size ());
+  for (HostRoutesCI it = m_hostRoutes.begin (); it != m_hostRoutes.end (); it++)
+    {
+      i.WriteU32 ((*it)->GetDest ().Get ());
+      i.WriteU32 ((*it)->GetGateway ().Get ());
+      i.WriteU32 ((*it)->GetInterface ());
+    }
+  for (NetworkRoutesCI it = m_networkRoutes.begin (); it != m_networkRoutes.end (); it++)
+    {
+      i.WriteU32 ((*it)->GetDestNetwork ().Get ());
+      i.WriteU32 ((*it)->GetDestNetworkMask ().Get ());
+      i.WriteU32 ((*it)->GetGateway ().Get ());
+      i.WriteU32 ((*it)->GetInterface ());
+    }
+  for (ASExternalRoutesCI it = m_ASexternalRoutes.begin (); it != m_ASexternalRoutes.end (); it++)
+    {
+      i.WriteU32 ((*it)->GetDestNetwork ().Get ());
+      i.WriteU32 ((*it)->GetDestNetworkMask ().Get ());
+      i.WriteU32 ((*it)->GetGateway ().Get ());
+      i.WriteU32 ((*it)->GetInterface ());
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+  Buffer::Iterator i = start;
+  uint32_t nHostRoutes = i.ReadU32 ();
+  uint32_t nNetworkRoutes = i.ReadU32 ();
+  uint32_t nExternalRoutes = i.ReadU32 ();
+  NS_ABORT_MSG_IF (i.GetRemainingSize () < uint64_t (nHostRoutes) * 12 + (uint64_t (nNetworkRoutes) + nExternalRoutes) * 16,
+                   "Truncated routing table");
+  for (uint32_t n = 0; n < nHostRoutes; n++)
+    {
+      Ipv4Address dest (i.ReadU32 ());
+      Ipv4Address gateway (i.ReadU32 ());
+      uint32_t interface = i.ReadU32 ();
+      AddHostRouteTo (dest, gateway, interface);
+    }
+  for (uint32_t n = 0; n < nNetworkRoutes; n++)
+    {
+      Ipv4Address network (i.ReadU32 ());
+      Ipv4Mask mask (i.ReadU32 ());
+      Ipv4Address gateway (i.ReadU32 ());
+      uint32_t interface = i.ReadU32 ();
+      AddNetworkRouteTo (network, mask, gateway, interface);
+    }
+  for (uint32_t n = 0; n < nExternalRoutes; n++)
+    {
+      Ipv4Address network (i.ReadU32 ());
+      Ipv4Mask mask (i.ReadU32 ());
+      Ipv4Address gateway (i.ReadU32 ());
+      uint32_t interface = i.ReadU32 ();
+      AddASExternalRouteTo (network, mask, gateway, interface);
+    }
+  return i.GetDistanceFrom (start);
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -392,6 +533,8 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteIndex.Clear ();
+  m_networkRouteIndex.Clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -537,9 +680,7 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -549,9 +690,7 @@ Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
   NS_LOG_FUNCTION (this << i);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -561,9 +700,7 @@ Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress ad
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
@@ -573,9 +710,7 @@ Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
   NS_LOG_FUNCTION (this << interface << address);
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutingTables ();
     }
 }
 
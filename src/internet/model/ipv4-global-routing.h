@@ -28,6 +28,8 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-route-trie.h"
+#include "ns3/buffer.h"
 
 namespace ns3 {
 
@@ -155,6 +157,41 @@ public:
                           Ipv4Mask networkMask, 
                           uint32_t interface);
 
+  /**
+   * \brief Get the host routes to a destination.
+   *
+   * \param dest The Ipv4Address destination.
+   * \param routes The host routes to dest, in the order of the routing table.
+   */
+  void GetHostRoutesTo (Ipv4Address dest,
+                        std::vector<Ipv4RoutingTableEntry *> &routes) const;
+
+  /**
+   * \brief Remove a host route from the global routing table.
+   *
+   * \param dest The Ipv4Address destination of the route.
+   * \param nextHop The Ipv4Address of the next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a matching route was found and removed
+   */
+  bool RemoveHostRouteTo (Ipv4Address dest,
+                          Ipv4Address nextHop,
+                          uint32_t interface);
+
+  /**
+   * \brief Remove a network route from the global routing table.
+   *
+   * \param network The Ipv4Address network of the route.
+   * \param networkMask The Ipv4Mask of the route.
+   * \param nextHop The next hop of the route.
+   * \param interface The network interface index of the route.
+   * \returns true if a matching route was found and removed
+   */
+  bool RemoveNetworkRouteTo (Ipv4Address network,
+                             Ipv4Mask networkMask,
+                             Ipv4Address nextHop,
+                             uint32_t interface);
+
   /**
    * \brief Add an external route to the global routing table.
    *
@@ -218,6 +255,29 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Get the size of the routing table once serialized.
+   * \returns the number of bytes written by Serialize ()
+   */
+  uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Serialize the host, network and external routes.
+   *
+   * The routes are written in the order of the routing table, so that
+   * Deserialize () rebuilds an identical table.
+   *
+   * \param start the buffer iterator to write at
+   */
+  void Serialize (Buffer::Iterator start) const;
+
+  /**
+   * \brief Add the routes written by Serialize () to the routing table.
+   * \param start the buffer iterator to read from
+   * \returns the number of bytes read
+   */
+  uint32_t Deserialize (Buffer::Iterator start);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -260,6 +320,9 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// container of the routes matching a destination
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec_t;
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -272,6 +335,10 @@ private:
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  Ipv4RouteTrie<Ipv4RoutingTableEntry *> m_hostRouteIndex;    //!< Routes to hosts, by destination
+  Ipv4RouteTrie<Ipv4RoutingTableEntry *> m_networkRouteIndex; //!< Routes to networks, by prefix
+  RouteVec_t m_candidates;             //!< Routes found by the latest index lookup
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -708,11 +708,15 @@ Ipv4L3Protocol::SendWithHeader (Ptr<Packet> packet,
 
 void
 Ipv4L3Protocol::CallTxTrace (const Ipv4Header & ipHeader, Ptr<Packet> packet,
-                                    Ptr<Ipv4> ipv4, uint32_t interface)
+                             uint32_t interface)
 {
+  if (m_txTrace.IsEmpty ())
+    {
+      return;
+    }
   Ptr<Packet> packetCopy = packet->Copy ();
   packetCopy->AddHeader (ipHeader);
-  m_txTrace (packetCopy, ipv4, interface);
+  m_txTrace (packetCopy, m_node->GetObject<Ipv4> (), interface);
 }
 
 void 
@@ -778,7 +782,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
               NS_ASSERT (packetCopy->GetSize () <= outInterface->GetDevice ()->GetMtu ());
 
               m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
-              CallTxTrace (ipHeader, packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+              CallTxTrace (ipHeader, packetCopy, ifaceIndex);
               outInterface->Send (packetCopy, ipHeader, destination);
             }
         }
@@ -802,7 +806,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
               ipHeader = BuildHeader (source, destination, protocol, packet->GetSize (), ttl, tos, mayFragment);
               Ptr<Packet> packetCopy = packet->Copy ();
               m_sendOutgoingTrace (ipHeader, packetCopy, ifaceIndex);
-              CallTxTrace (ipHeader, packetCopy, m_node->GetObject<Ipv4> (), ifaceIndex);
+              CallTxTrace (ipHeader, packetCopy, ifaceIndex);
               outInterface->Send (packetCopy, ipHeader, destination);
               return;
             }
@@ -924,24 +928,28 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
-  if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
+  // Large segments are sent as a single frame, whatever their size
+  SocketLargeSendTag largeSendTag;
+  bool mayFragment = !packet->PeekPacketTag (largeSendTag);
+
+  if (!route->GetGateway ().IsAny ())
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (mayFragment && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
               for ( std::list<Ipv4PayloadHeaderPair>::iterator it = listFragments.begin (); it != listFragments.end (); it++ )
                 {
-                  CallTxTrace (it->second, it->first, m_node->GetObject<Ipv4> (), interface);
+                  CallTxTrace (it->second, it->first, interface);
                   outInterface->Send (it->first, it->second, route->GetGateway ());
                 }
             }
           else
             {
-              CallTxTrace (ipHeader, packet, m_node->GetObject<Ipv4> (), interface);
+              CallTxTrace (ipHeader, packet, interface);
               outInterface->Send (packet, ipHeader, route->GetGateway ());
             }
         }
@@ -956,20 +964,20 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (mayFragment && packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ())
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
               for ( std::list<Ipv4PayloadHeaderPair>::iterator it = listFragments.begin (); it != listFragments.end (); it++ )
                 {
                   NS_LOG_LOGIC ("Sending fragment " << *(it->first) );
-                  CallTxTrace (it->second, it->first, m_node->GetObject<Ipv4> (), interface);
+                  CallTxTrace (it->second, it->first, interface);
                   outInterface->Send (it->first, it->second, ipHeader.GetDestination ());
                 }
             }
           else
             {
-              CallTxTrace (ipHeader, packet, m_node->GetObject<Ipv4> (), interface);
+              CallTxTrace (ipHeader, packet, interface);
               outInterface->Send (packet, ipHeader, ipHeader.GetDestination ());
             }
         }
@@ -1040,15 +1048,20 @@ Ipv4L3Protocol::IpForward (Ptr<Ipv4Route> rtentry, Ptr<const Packet> p, const Ip
       m_dropTrace (header, packet, DROP_TTL_EXPIRED, m_node->GetObject<Ipv4> (), interface);
       return;
     }
-  // in case the packet still has a priority tag attached, remove it
+  // the packet must carry a priority tag only if the priority is not null.
+  // The tags of the packet are left untouched if it already carries the
+  // right one, e.g., if the previous hop sent it through a multi-queue device.
   SocketPriorityTag priorityTag;
-  packet->RemovePacketTag (priorityTag);
+  bool tagged = packet->PeekPacketTag (priorityTag);
   uint8_t priority = Socket::IpTos2Priority (ipHeader.GetTos ());
-  // add a priority tag if the priority is not null
-  if (priority)
+  if (tagged != (priority != 0) || (tagged && priorityTag.GetPriority () != priority))
     {
-      priorityTag.SetPriority (priority);
-      packet->AddPacketTag (priorityTag);
+      packet->RemovePacketTag (priorityTag);
+      if (priority)
+        {
+          priorityTag.SetPriority (priority);
+          packet->AddPacketTag (priorityTag);
+        }
     }
 
   m_unicastForwardTrace (ipHeader, packet, interface);
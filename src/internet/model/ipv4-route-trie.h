@@ -0,0 +1,399 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Longest prefix match index of IPv4 routes.
+ *
+ * Routes are stored in a path-compressed binary trie (a Patricia trie)
+ * keyed by their destination prefix, so that a lookup visits at most one
+ * node per distinct prefix on the path of the destination address instead
+ * of every route of the table.
+ *
+ * The index does not choose a route: Lookup () returns every route whose
+ * prefix matches the destination, in the order in which the routes were
+ * inserted.  The routing protocols then apply their own selection rules
+ * (longest prefix, metric, ECMP) on this much shorter list, which gives
+ * exactly the same result as a scan of the whole table.
+ *
+ * Routes with a non-contiguous mask cannot be placed in the trie; they
+ * are kept aside and matched one by one.
+ *
+ * \tparam T the type of the routes stored, which must be copyable and
+ * equality comparable (e.g., a pointer to a routing table entry)
+ */
+template <typename T>
+class Ipv4RouteTrie
+{
+public:
+  Ipv4RouteTrie ();
+  ~Ipv4RouteTrie ();
+
+  /**
+   * \brief Add a route.
+   * \param network the destination network
+   * \param mask the destination network mask
+   * \param route the route
+   */
+  void Insert (Ipv4Address network, Ipv4Mask mask, const T &route);
+  /**
+   * \brief Remove a route.
+   * \param network the destination network the route was inserted with
+   * \param mask the destination network mask the route was inserted with
+   * \param route the route
+   * \return true if the route was found and removed
+   */
+  bool Remove (Ipv4Address network, Ipv4Mask mask, const T &route);
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+  /**
+   * \brief Find the routes matching a destination.
+   * \param dest the destination address
+   * \param routes the routes whose prefix matches dest, in insertion order
+   */
+  void Lookup (Ipv4Address dest, std::vector<T> &routes) const;
+  /**
+   * \return the number of routes stored
+   */
+  uint32_t GetNRoutes (void) const;
+
+private:
+  /// A route and its insertion order
+  struct Route
+  {
+    uint64_t seq;   //!< insertion sequence number
+    T route;        //!< the route
+  };
+  /// A trie node, holding the routes of one prefix
+  struct Node
+  {
+    uint32_t prefix;            //!< prefix, with the bits beyond length cleared
+    uint32_t length;            //!< prefix length
+    Node *child[2];             //!< children, indexed by the bit following the prefix
+    std::vector<Route> routes;  //!< routes to this prefix (may be empty for branching nodes)
+  };
+  /// A route with a non-contiguous mask
+  struct IrregularRoute
+  {
+    uint32_t network;           //!< destination network, masked
+    uint32_t mask;              //!< destination mask
+    Route route;                //!< the route
+  };
+
+  /// Copying is not allowed
+  Ipv4RouteTrie (const Ipv4RouteTrie &);
+  /// Copying is not allowed \returns this
+  Ipv4RouteTrie &operator= (const Ipv4RouteTrie &);
+
+  /**
+   * \param length a prefix length
+   * \return the contiguous mask of this length
+   */
+  static uint32_t GetMask (uint32_t length);
+  /**
+   * \param address an address
+   * \param i a bit index, 0 being the most significant bit
+   * \return the bit of address at index i
+   */
+  static uint32_t GetBit (uint32_t address, uint32_t i);
+  /**
+   * \param prefix the node prefix
+   * \param length the node prefix length
+   * \return a new node without routes nor children
+   */
+  static Node *NewNode (uint32_t prefix, uint32_t length);
+  /**
+   * \brief Delete a node and all its descendants.
+   * \param node the node
+   */
+  static void DeleteTree (Node *node);
+  /**
+   * \brief Order routes by insertion.
+   * \param a a route
+   * \param b another route
+   * \return true if a was inserted before b
+   */
+  static bool IsBefore (const Route &a, const Route &b);
+
+  Node *m_root;                              //!< node of the 0.0.0.0/0 prefix, always present
+  std::vector<IrregularRoute> m_irregular;   //!< routes with a non-contiguous mask
+  uint64_t m_seq;                            //!< next insertion sequence number
+  uint32_t m_nRoutes;                        //!< number of routes stored
+  mutable std::vector<Route> m_found;        //!< scratch space for Lookup ()
+};
+
+template <typename T>
+Ipv4RouteTrie<T>::Ipv4RouteTrie ()
+  : m_root (NewNode (0, 0)),
+    m_seq (0),
+    m_nRoutes (0)
+{
+}
+
+template <typename T>
+Ipv4RouteTrie<T>::~Ipv4RouteTrie ()
+{
+  DeleteTree (m_root);
+}
+
+template <typename T>
+uint32_t
+Ipv4RouteTrie<T>::GetMask (uint32_t length)
+{
+  return length == 0 ? 0 : 0xffffffffU << (32 - length);
+}
+
+template <typename T>
+uint32_t
+Ipv4RouteTrie<T>::GetBit (uint32_t address, uint32_t i)
+{
+  return (address >> (31 - i)) & 1;
+}
+
+template <typename T>
+typename Ipv4RouteTrie<T>::Node *
+Ipv4RouteTrie<T>::NewNode (uint32_t prefix, uint32_t length)
+{
+  Node *node = new Node;
+  node->prefix = prefix;
+  node->length = length;
+  node->child[0] = 0;
+  node->child[1] = 0;
+  return node;
+}
+
+template <typename T>
+void
+Ipv4RouteTrie<T>::DeleteTree (Node *node)
+{
+  if (node != 0)
+    {
+      DeleteTree (node->child[0]);
+      DeleteTree (node->child[1]);
+      delete node;
+    }
+}
+
+template <typename T>
+bool
+Ipv4RouteTrie<T>::IsBefore (const Route &a, const Route &b)
+{
+  return a.seq < b.seq;
+}
+
+template <typename T>
+void
+Ipv4RouteTrie<T>::Insert (Ipv4Address network, Ipv4Mask mask, const T &route)
+{
+  uint32_t m = mask.Get ();
+  uint32_t length = mask.GetPrefixLength ();
+  Route r = { m_seq++, route };
+  ++m_nRoutes;
+  if (m != GetMask (length))
+    {
+      IrregularRoute irregular = { network.Get () & m, m, r };
+      m_irregular.push_back (irregular);
+      return;
+    }
+
+  uint32_t prefix = network.Get () & m;
+  // Invariant: the prefix of node is a prefix of the new one.
+  Node *node = m_root;
+  while (node->length < length)
+    {
+      Node **link = &node->child[GetBit (prefix, node->length)];
+      Node *child = *link;
+      if (child == 0)
+        {
+          *link = NewNode (prefix, length);
+          (*link)->routes.push_back (r);
+          return;
+        }
+      // Number of leading bits shared by the child and the new prefix
+      uint32_t diff = prefix ^ child->prefix;
+      uint32_t common = node->length + 1;
+      while (common < 32 && GetBit (diff, common) == 0)
+        {
+          ++common;
+        }
+      common = std::min (common, std::min (length, child->length));
+      if (common == child->length)
+        {
+          node = child;
+          continue;
+        }
+      Node *inserted = NewNode (prefix & GetMask (common), common);
+      inserted->child[GetBit (child->prefix, common)] = child;
+      *link = inserted;
+      if (common == length)
+        {
+          // The new prefix sits between node and child
+          inserted->routes.push_back (r);
+        }
+      else
+        {
+          // The new prefix and child branch off at common
+          Node *leaf = NewNode (prefix, length);
+          leaf->routes.push_back (r);
+          inserted->child[GetBit (prefix, common)] = leaf;
+        }
+      return;
+    }
+  node->routes.push_back (r);
+}
+
+template <typename T>
+bool
+Ipv4RouteTrie<T>::Remove (Ipv4Address network, Ipv4Mask mask, const T &route)
+{
+  uint32_t m = mask.Get ();
+  uint32_t length = mask.GetPrefixLength ();
+  if (m != GetMask (length))
+    {
+      for (typename std::vector<IrregularRoute>::iterator i = m_irregular.begin (); i != m_irregular.end (); ++i)
+        {
+          if (i->mask == m && i->network == (network.Get () & m) && i->route.route == route)
+            {
+              m_irregular.erase (i);
+              --m_nRoutes;
+              return true;
+            }
+        }
+      return false;
+    }
+
+  uint32_t prefix = network.Get () & m;
+  Node **parentLink = 0;
+  Node **link = &m_root;
+  Node *node = m_root;
+  while (node->length < length)
+    {
+      Node **next = &node->child[GetBit (prefix, node->length)];
+      Node *child = *next;
+      if (child == 0 || child->length > length || (prefix & GetMask (child->length)) != child->prefix)
+        {
+          return false;
+        }
+      parentLink = link;
+      link = next;
+      node = child;
+    }
+  typename std::vector<Route>::iterator i;
+  for (i = node->routes.begin (); i != node->routes.end (); ++i)
+    {
+      if (i->route == route)
+        {
+          break;
+        }
+    }
+  if (i == node->routes.end ())
+    {
+      return false;
+    }
+  node->routes.erase (i);
+  --m_nRoutes;
+
+  // Remove the nodes which are neither holding routes nor branching.
+  if (node == m_root || !node->routes.empty () || (node->child[0] != 0 && node->child[1] != 0))
+    {
+      return true;
+    }
+  Node *parent = *parentLink;
+  *link = node->child[0] != 0 ? node->child[0] : node->child[1];
+  bool leaf = (*link == 0);
+  delete node;
+  if (leaf && parent != m_root && parent->routes.empty ())
+    {
+      // The parent was branching and is left with a single child
+      *parentLink = parent->child[0] != 0 ? parent->child[0] : parent->child[1];
+      delete parent;
+    }
+  return true;
+}
+
+template <typename T>
+void
+Ipv4RouteTrie<T>::Clear (void)
+{
+  DeleteTree (m_root);
+  m_root = NewNode (0, 0);
+  m_irregular.clear ();
+  m_nRoutes = 0;
+}
+
+template <typename T>
+void
+Ipv4RouteTrie<T>::Lookup (Ipv4Address dest, std::vector<T> &routes) const
+{
+  uint32_t address = dest.Get ();
+  uint32_t nSets = 0;
+  m_found.clear ();
+  const Node *node = m_root;
+  while (node != 0 && (address & GetMask (node->length)) == node->prefix)
+    {
+      if (!node->routes.empty ())
+        {
+          m_found.insert (m_found.end (), node->routes.begin (), node->routes.end ());
+          ++nSets;
+        }
+      if (node->length == 32)
+        {
+          break;
+        }
+      node = node->child[GetBit (address, node->length)];
+    }
+  for (typename std::vector<IrregularRoute>::const_iterator i = m_irregular.begin (); i != m_irregular.end (); ++i)
+    {
+      if ((address & i->mask) == i->network)
+        {
+          m_found.push_back (i->route);
+          ++nSets;
+        }
+    }
+  if (nSets > 1)
+    {
+      std::sort (m_found.begin (), m_found.end (), &Ipv4RouteTrie<T>::IsBefore);
+    }
+  routes.clear ();
+  for (typename std::vector<Route>::const_iterator i = m_found.begin (); i != m_found.end (); ++i)
+    {
+      routes.push_back (i->route);
+    }
+}
+
+template <typename T>
+uint32_t
+Ipv4RouteTrie<T>::GetNRoutes (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
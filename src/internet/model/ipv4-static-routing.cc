@@ -31,6 +31,7 @@
 #include "ns3/simulator.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/unused.h"
 #include "ipv4-static-routing.h"
 #include "ipv4-routing-table-entry.h"
 
@@ -73,6 +74,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteIndex.Insert (network, networkMask, m_networkRoutes.back ());
 }
 
 void 
@@ -87,6 +89,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_networkRouteIndex.Insert (network, networkMask, m_networkRoutes.back ());
 }
 
 void 
@@ -144,6 +147,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_networkRouteIndex.Insert (network, networkMask, m_networkRoutes.back ());
 }
 
 uint32_t 
@@ -240,8 +244,10 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
     }
 
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // Only the routes matching dest are visited, in the order of the table
+  m_networkRouteIndex.Lookup (dest, m_candidates);
+  for (std::vector<NetworkRoute>::const_iterator i = m_candidates.begin (); 
+       i != m_candidates.end (); 
        i++) 
     {
       Ipv4RoutingTableEntry *j=i->first;
@@ -301,6 +307,14 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
   return rtentry;
 }
 
+void
+Ipv4StaticRouting::RemoveFromIndex (const NetworkRoute &route)
+{
+  bool found = m_networkRouteIndex.Remove (route.first->GetDestNetwork (), route.first->GetDestNetworkMask (), route);
+  NS_ASSERT_MSG (found, "Route " << *route.first << " missing from the index");
+  NS_UNUSED (found);
+}
+
 Ptr<Ipv4MulticastRoute>
 Ipv4StaticRouting::LookupStatic (
   Ipv4Address origin, 
@@ -447,6 +461,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
     {
       if (tmp == index)
         {
+          RemoveFromIndex (*j);
           delete j->first;
           m_networkRoutes.erase (j);
           return;
@@ -575,6 +590,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_networkRouteIndex.Clear ();
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -613,6 +629,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
     {
       if (it->first->GetInterface () == i)
         {
+          RemoveFromIndex (*it);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -660,6 +677,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
           && it->first->GetDestNetwork () == networkAddress
           && it->first->GetDestNetworkMask () == networkMask)
         {
+          RemoveFromIndex (*it);
           delete it->first;
           it = m_networkRoutes.erase (it);
         }
@@ -31,6 +31,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route-trie.h"
 
 namespace ns3 {
 
@@ -377,6 +378,9 @@ protected:
   virtual void DoDispose (void);
 
 private:
+  /// A network route and its metric
+  typedef std::pair <Ipv4RoutingTableEntry *, uint32_t> NetworkRoute;
+
   /// Container for the network routes
   typedef std::list<std::pair <Ipv4RoutingTableEntry *, uint32_t> > NetworkRoutes;
 
@@ -418,6 +422,22 @@ private:
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief Remove a network route from the longest prefix match index.
+   * \param route the route
+   */
+  void RemoveFromIndex (const NetworkRoute &route);
+
+  /**
+   * \brief the network routes, indexed by prefix.
+   */
+  Ipv4RouteTrie<NetworkRoute> m_networkRouteIndex;
+
+  /**
+   * \brief the routes found by the latest index lookup.
+   */
+  std::vector<NetworkRoute> m_candidates;
+
   /**
    * \brief the forwarding table for multicast.
    */
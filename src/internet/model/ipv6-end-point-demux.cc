@@ -48,20 +48,18 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ptr<NetDevice> boundNetDevice, Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  if (it == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
     {
       if ((*i)->GetLocalPort () == port &&
           (*i)->GetLocalAddress () == addr &&
@@ -83,7 +81,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -98,7 +96,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -119,7 +117,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv6Ad
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -129,7 +127,26 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << boundNetDevice << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  // Only the end points with the same four-tuple may be duplicates.
+  EndPoints candidates;
+  if (IsConnected (localAddress, peerAddress, peerPort))
+    {
+      ConnectedKey key = { localAddress, localPort, peerAddress, peerPort };
+      std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+      for (ConnectedMapI i = range.first; i != range.second; ++i)
+        {
+          candidates.push_back (i->second);
+        }
+    }
+  else
+    {
+      std::unordered_map<uint16_t, EndPoints>::iterator it = m_listeners.find (localPort);
+      if (it != m_listeners.end ())
+        {
+          candidates = it->second;
+        }
+    }
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -143,7 +160,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -153,15 +170,15 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
 void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<Ipv6EndPoint *, Entry>::iterator it = m_entries.find (endPoint);
+  if (it == m_entries.end ())
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
     }
+  Unindex (endPoint);
+  m_endPoints.erase (it->second.all);
+  m_entries.erase (it);
+  delete endPoint;
 }
 
 /*
@@ -181,7 +198,23 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+
+  /* The end points which may match: those of the local port with a wildcard
+     address or port, and the connected ones with the packet four-tuple */
+  EndPoints candidates;
+  std::unordered_map<uint16_t, EndPoints>::iterator listeners = m_listeners.find (dport);
+  if (listeners != m_listeners.end ())
+    {
+      candidates = listeners->second;
+    }
+  ConnectedKey key = { daddr, dport, saddr, sport };
+  std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+  for (ConnectedMapI i = range.first; i != range.second; ++i)
+    {
+      candidates.push_back (i->second);
+    }
+
+  for (EndPointsI i = candidates.begin (); i != candidates.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -293,7 +326,12 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (dport);
+  if (it == m_ports.end ())
+    {
+      return 0;
+    }
+  for (EndPointsI i = it->second.begin (); i != it->second.end (); i++)
     {
       uint32_t tmp = 0;
 
@@ -355,5 +393,87 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
   return m_endPoints;
 }
 
-} /* namespace ns3 */
+bool Ipv6EndPointDemux::ConnectedKey::operator== (const ConnectedKey &other) const
+{
+  return localAddress == other.localAddress && localPort == other.localPort
+         && peerAddress == other.peerAddress && peerPort == other.peerPort;
+}
+
+std::size_t Ipv6EndPointDemux::ConnectedKeyHash::operator() (const ConnectedKey &key) const
+{
+  Ipv6AddressHash hash;
+  std::size_t h = hash (key.localAddress);
+  h = h * 0x9e3779b1U ^ hash (key.peerAddress);
+  h = h * 0x9e3779b1U ^ ((static_cast<uint32_t> (key.localPort) << 16) | key.peerPort);
+  return h;
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6Address localAddress, Ipv6Address peerAddress, uint16_t peerPort)
+{
+  return localAddress != Ipv6Address::GetAny () && peerAddress != Ipv6Address::GetAny () && peerPort != 0;
+}
+
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  m_entries[endPoint].all = std::prev (m_endPoints.end ());
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t port = endPoint->GetLocalPort ();
+  EndPoints &endPoints = m_ports[port];
+  endPoints.push_back (endPoint);
+  m_entries[endPoint].port = std::prev (endPoints.end ());
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      ConnectedKey key = { endPoint->GetLocalAddress (), port, endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      m_connected.insert (std::make_pair (key, endPoint));
+    }
+  else
+    {
+      m_listeners[port].push_back (endPoint);
+    }
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  uint16_t port = endPoint->GetLocalPort ();
+  std::unordered_map<uint16_t, EndPoints>::iterator it = m_ports.find (port);
+  NS_ASSERT (it != m_ports.end ());
+  it->second.erase (m_entries[endPoint].port);
+  if (it->second.empty ())
+    {
+      m_ports.erase (it);
+    }
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      ConnectedKey key = { endPoint->GetLocalAddress (), port, endPoint->GetPeerAddress (), endPoint->GetPeerPort () };
+      std::pair<ConnectedMapI, ConnectedMapI> range = m_connected.equal_range (key);
+      for (ConnectedMapI i = range.first; i != range.second; ++i)
+        {
+          if (i->second == endPoint)
+            {
+              m_connected.erase (i);
+              break;
+            }
+        }
+    }
+  else
+    {
+      it = m_listeners.find (port);
+      NS_ASSERT (it != m_listeners.end ());
+      it->second.remove (endPoint);
+      if (it->second.empty ())
+        {
+          m_listeners.erase (it);
+        }
+    }
+}
 
+} /* namespace ns3 */
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
+#include <unordered_map>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -34,6 +36,10 @@ class Ipv6EndPoint;
  * \ingroup ipv6
  *
  * \brief Demultiplexer for end points.
+ *
+ * The endpoints are also indexed by local port, and the connected ones
+ * (with no wildcard address or port) by four-tuple, so that a lookup only
+ * examines the endpoints which can match the packet.
  */
 class Ipv6EndPointDemux
 {
@@ -178,6 +184,99 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The four-tuple of a connected end point.
+   */
+  struct ConnectedKey
+  {
+    Ipv6Address localAddress; //!< local address
+    uint16_t localPort;       //!< local port
+    Ipv6Address peerAddress;  //!< peer address
+    uint16_t peerPort;        //!< peer port
+
+    /**
+     * \param other another four-tuple
+     * \returns true if the four-tuples are equal
+     */
+    bool operator== (const ConnectedKey &other) const;
+  };
+
+  /**
+   * \brief Hash function of the four-tuples.
+   */
+  struct ConnectedKeyHash
+  {
+    /**
+     * \param key a four-tuple
+     * \returns the hash of the four-tuple
+     */
+    std::size_t operator() (const ConnectedKey &key) const;
+  };
+
+  /**
+   * \brief The positions of an end point in the lists.
+   */
+  struct Entry
+  {
+    EndPointsI all;  //!< position in m_endPoints
+    EndPointsI port; //!< position in the m_ports list of its local port
+  };
+
+  /**
+   * \brief Check whether an end point only matches one four-tuple.
+   * \param localAddress the local address
+   * \param peerAddress the peer address
+   * \param peerPort the peer port
+   * \returns true if none of the addresses and ports is a wildcard
+   */
+  static bool IsConnected (Ipv6Address localAddress, Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Add a new end point.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Index an end point by its current addresses and ports.
+   * \param endPoint the end point
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes, before its addresses or
+   * ports change or it is removed.
+   * \param endPoint the end point
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Positions of the end points in the lists.
+   */
+  std::unordered_map<Ipv6EndPoint *, Entry> m_entries;
+
+  /**
+   * \brief The end points, by local port.
+   */
+  std::unordered_map<uint16_t, EndPoints> m_ports;
+
+  /**
+   * \brief The end points with a wildcard address or port, by local port.
+   */
+  std::unordered_map<uint16_t, EndPoints> m_listeners;
+
+  /**
+   * \brief The connected end points, by four-tuple.
+   */
+  std::unordered_multimap<ConnectedKey, Ipv6EndPoint *, ConnectedKeyHash> m_connected;
+
+  /**
+   * \brief Iterator to the connected end points.
+   */
+  typedef std::unordered_multimap<ConnectedKey, Ipv6EndPoint *, ConnectedKeyHash>::iterator ConnectedMapI;
 };
 
 } /* namespace ns3 */
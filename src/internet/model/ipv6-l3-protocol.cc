@@ -31,6 +31,7 @@
 #include "ns3/mac16-address.h"
 #include "ns3/mac64-address.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/socket.h"
 
 #include "loopback-net-device.h"
 #include "ipv6-l3-protocol.h"
@@ -1124,7 +1125,11 @@ void Ipv6L3Protocol::SendRealOut (Ptr<Ipv6Route> route, Ptr<Packet> packet, Ipv6
       targetMtu = dev->GetMtu ();
     }
 
-  if (packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
+  // Large segments are sent as a single frame, whatever their size
+  SocketLargeSendTag largeSendTag;
+  bool mayFragment = !packet->PeekPacketTag (largeSendTag);
+
+  if (mayFragment && packet->GetSize () > targetMtu + 40) /* 40 => size of IPv6 header */
     {
       // Router => drop
 
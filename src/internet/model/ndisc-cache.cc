@@ -70,6 +70,50 @@ void NdiscCache::DoDispose ()
   Object::DoDispose ();
 }
 
+void NdiscCache::ScheduleNudTimer (NdiscCache::Entry* entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  NS_ASSERT (!entry->m_nudRunning);
+  Time expiration = Simulator::Now () + entry->m_nudDelay;
+  entry->m_nudIt = m_nudTimers.insert (std::make_pair (expiration, entry));
+  entry->m_nudRunning = true;
+  if (entry->m_nudIt == m_nudTimers.begin ())
+    {
+      /* earliest timer */
+      m_nudEvent.Cancel ();
+      m_nudEvent = Simulator::Schedule (entry->m_nudDelay, &NdiscCache::HandleNudTimeout, this);
+    }
+}
+
+void NdiscCache::CancelNudTimer (NdiscCache::Entry* entry)
+{
+  NS_LOG_FUNCTION (this << entry);
+  if (entry->m_nudRunning)
+    {
+      /* the event is left as is: it will find nothing to do, or reschedule itself */
+      m_nudTimers.erase (entry->m_nudIt);
+      entry->m_nudRunning = false;
+    }
+}
+
+void NdiscCache::HandleNudTimeout ()
+{
+  NS_LOG_FUNCTION (this);
+  /* the timer functions may start and cancel timers, or remove entries */
+  while (!m_nudTimers.empty () && m_nudTimers.begin ()->first <= Simulator::Now ())
+    {
+      NdiscCache::Entry* entry = m_nudTimers.begin ()->second;
+      m_nudTimers.erase (m_nudTimers.begin ());
+      entry->m_nudRunning = false;
+      entry->NudTimeout ();
+    }
+  if (!m_nudTimers.empty () && !m_nudEvent.IsRunning ())
+    {
+      m_nudEvent = Simulator::Schedule (m_nudTimers.begin ()->first - Simulator::Now (),
+                                        &NdiscCache::HandleNudTimeout, this);
+    }
+}
+
 void NdiscCache::SetDevice (Ptr<NetDevice> device, Ptr<Ipv6Interface> interface, Ptr<Icmpv6L4Protocol> icmpv6)
 {
   NS_LOG_FUNCTION (this << device << interface);
@@ -94,9 +138,9 @@ NdiscCache::Entry* NdiscCache::Lookup (Ipv6Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
 
-  if (m_ndCache.find (dst) != m_ndCache.end ())
+  NdiscCache::Entry* entry = m_ndCache.Find (dst);
+  if (entry != 0)
     {
-      NdiscCache::Entry* entry = m_ndCache[dst];
       NS_LOG_LOGIC ("Found an entry:" << dst << " to " << entry->GetMacAddress ());
       return entry;
     }
@@ -108,28 +152,23 @@ std::list<NdiscCache::Entry*> NdiscCache::LookupInverse (Address dst)
 {
   NS_LOG_FUNCTION (this << dst);
 
-  std::list<NdiscCache::Entry *> entryList;
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  std::vector<NdiscCache::Entry *> entries;
+  m_ndCache.FindMac (dst, entries);
+  for (std::vector<NdiscCache::Entry *>::iterator i = entries.begin (); i != entries.end (); i++)
     {
-      NdiscCache::Entry *entry = (*i).second;
-      if (entry->GetMacAddress () == dst)
-        {
-          NS_LOG_LOGIC ("Found an entry:" << (*i).first << " to " << (*i).second);
-          entryList.push_back (entry);
-        }
+      NS_LOG_LOGIC ("Found an entry:" << (*i)->m_ipv6Address << " to " << *i);
     }
-  return entryList;
+  return std::list<NdiscCache::Entry *> (entries.begin (), entries.end ());
 }
 
 
 NdiscCache::Entry* NdiscCache::Add (Ipv6Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_ndCache.find (to) == m_ndCache.end ());
+  NS_ASSERT (m_ndCache.Find (to) == 0);
 
-  NdiscCache::Entry* entry = new NdiscCache::Entry (this);
+  NdiscCache::Entry* entry = m_ndCache.Insert (to, NdiscCache::Entry (this));
   entry->SetIpv6Address (to);
-  m_ndCache[to] = entry;
   return entry;
 }
 
@@ -137,28 +176,22 @@ void NdiscCache::Remove (NdiscCache::Entry* entry)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  if (entry->m_ndCache != this)
     {
-      if ((*i).second == entry)
-        {
-          m_ndCache.erase (i);
-          entry->ClearWaitingPacket ();
-          delete entry;
-          return;
-        }
+      return;
     }
+  CancelNudTimer (entry);
+  entry->ClearWaitingPacket ();
+  m_ndCache.Remove (entry->m_ipv6Address, entry);
 }
 
 void NdiscCache::Flush ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
-    {
-      delete (*i).second; /* delete the pointer NdiscCache::Entry */
-    }
-
-  m_ndCache.erase (m_ndCache.begin (), m_ndCache.end ());
+  m_nudTimers.clear ();
+  m_nudEvent.Cancel ();
+  m_ndCache.Clear ();
 }
 
 void NdiscCache::SetUnresQlen (uint32_t unresQlen)
@@ -178,9 +211,14 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
   NS_LOG_FUNCTION (this << stream);
   std::ostream* os = stream->GetStream ();
 
-  for (CacheI i = m_ndCache.begin (); i != m_ndCache.end (); i++)
+  for (uint32_t i = 0; i < m_ndCache.GetNSlots (); i++)
     {
-      *os << i->first << " dev ";
+      NdiscCache::Entry* entry = m_ndCache.GetSlot (i);
+      if (entry == 0)
+        {
+          continue;
+        }
+      *os << m_ndCache.GetKey (i) << " dev ";
       std::string found = Names::FindName (m_device);
       if (Names::FindName (m_device) != "")
         {
@@ -191,29 +229,29 @@ void NdiscCache::PrintNdiscCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << entry->GetMacAddress ();
 
-      if (i->second->IsReachable ())
+      if (entry->IsReachable ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsDelay ())
+      else if (entry->IsDelay ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsIncomplete ())
+      else if (entry->IsIncomplete ())
         {
           *os << " INCOMPLETE\n";
         }
-      else if (i->second->IsProbe ())
+      else if (entry->IsProbe ())
         {
           *os << " PROBE\n";
         }
-      else if (i->second->IsStale ())
+      else if (entry->IsStale ())
         {
           *os << " STALE\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (entry->IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -228,7 +266,8 @@ NdiscCache::Entry::Entry (NdiscCache* nd)
   : m_ndCache (nd),
     m_waiting (),
     m_router (false),
-    m_nudTimer (Timer::CANCEL_ON_DESTROY),
+    m_nudFunction (NUD_NONE),
+    m_nudRunning (false),
     m_lastReachabilityConfirmation (Seconds (0.0)),
     m_nsRetransmit (0)
 {
@@ -414,18 +453,42 @@ Time NdiscCache::Entry::GetLastReachabilityConfirmation () const
   return m_lastReachabilityConfirmation;
 }
 
-void NdiscCache::Entry::StartReachableTimer ()
+void NdiscCache::Entry::StartNudTimer (NudFunction_e function, Time delay)
+{
+  NS_LOG_FUNCTION (this << function << delay);
+  m_ndCache->CancelNudTimer (this);
+  m_nudFunction = function;
+  m_nudDelay = delay;
+  m_ndCache->ScheduleNudTimer (this);
+}
+
+void NdiscCache::Entry::NudTimeout ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
+  switch (m_nudFunction)
     {
-      m_nudTimer.Cancel ();
+    case NUD_REACHABLE:
+      FunctionReachableTimeout ();
+      break;
+    case NUD_RETRANSMIT:
+      FunctionRetransmitTimeout ();
+      break;
+    case NUD_PROBE:
+      FunctionProbeTimeout ();
+      break;
+    case NUD_DELAY:
+      FunctionDelayTimeout ();
+      break;
+    default:
+      NS_FATAL_ERROR ("NUD timer expired without a function");
     }
+}
 
+void NdiscCache::Entry::StartReachableTimer ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
   m_lastReachabilityConfirmation = Simulator::Now ();
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionReachableTimeout, this);
-  m_nudTimer.SetDelay (m_ndCache->m_icmpv6->GetReachableTime ());
-  m_nudTimer.Schedule ();
+  StartNudTimer (NUD_REACHABLE, m_ndCache->m_icmpv6->GetReachableTime ());
 }
 
 void NdiscCache::Entry::UpdateReachableTimer ()
@@ -435,57 +498,36 @@ void NdiscCache::Entry::UpdateReachableTimer ()
   if (m_state == REACHABLE)
     {
       m_lastReachabilityConfirmation = Simulator::Now ();
-      if (m_nudTimer.IsRunning ())
+      m_ndCache->CancelNudTimer (this);
+      if (m_nudFunction != NUD_NONE)
         {
-          m_nudTimer.Cancel ();
+          m_ndCache->ScheduleNudTimer (this);
         }
-      m_nudTimer.Schedule ();
     }
 }
 
 void NdiscCache::Entry::StartProbeTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionProbeTimeout, this);
-  m_nudTimer.SetDelay (m_ndCache->m_icmpv6->GetRetransmissionTime ());
-  m_nudTimer.Schedule ();
+  StartNudTimer (NUD_PROBE, m_ndCache->m_icmpv6->GetRetransmissionTime ());
 }
 
 void NdiscCache::Entry::StartDelayTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionDelayTimeout, this);
-  m_nudTimer.SetDelay (m_ndCache->m_icmpv6->GetDelayFirstProbe ());
-  m_nudTimer.Schedule ();
+  StartNudTimer (NUD_DELAY, m_ndCache->m_icmpv6->GetDelayFirstProbe ());
 }
 
 void NdiscCache::Entry::StartRetransmitTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  if (m_nudTimer.IsRunning ())
-    {
-      m_nudTimer.Cancel ();
-    }
-
-  m_nudTimer.SetFunction (&NdiscCache::Entry::FunctionRetransmitTimeout, this);
-  m_nudTimer.SetDelay (m_ndCache->m_icmpv6->GetRetransmissionTime ());
-  m_nudTimer.Schedule ();
+  StartNudTimer (NUD_RETRANSMIT, m_ndCache->m_icmpv6->GetRetransmissionTime ());
 }
 
 void NdiscCache::Entry::StopNudTimer ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  m_nudTimer.Cancel ();
+  m_ndCache->CancelNudTimer (this);
   m_nsRetransmit = 0;
 }
 
@@ -504,7 +546,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkReachable (A
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = REACHABLE;
-  m_macAddress = mac;
+  SetMacAddress (mac);
   return m_waiting;
 }
 
@@ -530,7 +572,7 @@ std::list<NdiscCache::Ipv6PayloadHeaderPair> NdiscCache::Entry::MarkStale (Addre
 {
   NS_LOG_FUNCTION (this << mac);
   m_state = STALE;
-  m_macAddress = mac;
+  SetMacAddress (mac);
   return m_waiting;
 }
 
@@ -592,6 +634,7 @@ Address NdiscCache::Entry::GetMacAddress () const
 void NdiscCache::Entry::SetMacAddress (Address mac)
 {
   NS_LOG_FUNCTION (this << mac << int(m_state));
+  m_ndCache->m_ndCache.ChangeMac (this, m_macAddress, mac);
   m_macAddress = mac;
 }
 
@@ -23,14 +23,15 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
 
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
 #include "ns3/net-device.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/ptr.h"
-#include "ns3/timer.h"
-#include "ns3/sgi-hashmap.h"
+#include "ns3/simulator.h"
+#include "ns3/neighbor-cache-table.h"
 #include "ns3/output-stream-wrapper.h"
 
 namespace ns3
@@ -45,6 +46,10 @@ class Icmpv6L4Protocol;
  * \ingroup ipv6
  *
  * \brief IPv6 Neighbor Discovery cache.
+ *
+ * The entries are indexed by IPv6 address and by MAC address. The NUD
+ * timers of the entries are kept sorted by expiration time in the
+ * cache, which schedules a single event at the earliest one.
  */
 class NdiscCache : public Object
 {
@@ -343,6 +348,8 @@ public:
     void SetIpv6Address (Ipv6Address ipv6Address);
 
 private:
+    friend class NdiscCache;
+
     /**
      * \brief The IPv6 address.
      */
@@ -387,9 +394,48 @@ private:
     bool m_router;
 
     /**
-     * \brief Timer (used for NUD).
+     * \brief The function invoked when the NUD timer expires.
+     */
+    enum NudFunction_e
+    {
+      NUD_NONE, /**< No function set yet */
+      NUD_REACHABLE, /**< FunctionReachableTimeout */
+      NUD_RETRANSMIT, /**< FunctionRetransmitTimeout */
+      NUD_PROBE, /**< FunctionProbeTimeout */
+      NUD_DELAY /**< FunctionDelayTimeout */
+    };
+
+    /**
+     * \brief Set the function and the delay of the NUD timer, and schedule it.
+     * \param function the function
+     * \param delay the delay
+     */
+    void StartNudTimer (NudFunction_e function, Time delay);
+
+    /**
+     * \brief Invoke the function of the NUD timer.
      */
-    Timer m_nudTimer;
+    void NudTimeout ();
+
+    /**
+     * \brief Function of the NUD timer.
+     */
+    NudFunction_e m_nudFunction;
+
+    /**
+     * \brief Delay of the NUD timer.
+     */
+    Time m_nudDelay;
+
+    /**
+     * \brief True if the NUD timer is running.
+     */
+    bool m_nudRunning;
+
+    /**
+     * \brief Position of the NUD timer in the timers of the cache.
+     */
+    std::multimap<Time, Entry *>::iterator m_nudIt;
 
     /**
      * \brief Last time we see a reachability confirmation.
@@ -406,11 +452,7 @@ private:
   /**
    * \brief Neighbor Discovery Cache container
    */
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash> Cache;
-  /**
-   * \brief Neighbor Discovery Cache container iterator
-   */
-  typedef sgi::hash_map<Ipv6Address, NdiscCache::Entry *, Ipv6AddressHash>::iterator CacheI;
+  typedef NeighborCacheTable<NdiscCache::Entry, Ipv6Address, Ipv6AddressHash> Cache;
 
   /**
    * \brief Copy constructor.
@@ -432,6 +474,23 @@ private:
    */
   void DoDispose ();
 
+  /**
+   * \brief Schedule the NUD timer of an entry.
+   * \param entry the entry, whose NUD timer is not running
+   */
+  void ScheduleNudTimer (NdiscCache::Entry* entry);
+
+  /**
+   * \brief Cancel the NUD timer of an entry, if it is running.
+   * \param entry the entry
+   */
+  void CancelNudTimer (NdiscCache::Entry* entry);
+
+  /**
+   * \brief Invoke the NUD timers which expire now.
+   */
+  void HandleNudTimeout ();
+
   /**
    * \brief The NetDevice.
    */
@@ -452,6 +511,16 @@ private:
    */
   Cache m_ndCache;
 
+  /**
+   * \brief The running NUD timers of the entries, by expiration time.
+   */
+  std::multimap<Time, NdiscCache::Entry *> m_nudTimers;
+
+  /**
+   * \brief The event of the earliest NUD timer.
+   */
+  EventId m_nudEvent;
+
   /**
    * \brief Max number of packet stored in m_waiting.
    */
@@ -0,0 +1,417 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NEIGHBOR_CACHE_TABLE_H
+#define NEIGHBOR_CACHE_TABLE_H
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <stdint.h>
+#include "ns3/address.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief Storage of the entries of a neighbor cache (ArpCache, NdiscCache).
+ *
+ * The entries are stored by value in a slab whose slots are reused once
+ * removed, so that a pointer to an entry stays valid until the entry is
+ * removed. An open-addressing hash table with linear probing indexes
+ * them by network address, and a hash table indexes them by link-layer
+ * address, so that neither lookup scans the cache.
+ *
+ * The link-layer addresses are compared as Address::operator== does,
+ * i.e., ignoring the address type when one of the two is untyped (as
+ * the addresses read from an ARP header).
+ *
+ * \tparam Entry the type of the entries, which must be copyable and
+ * provide GetMacAddress ()
+ * \tparam Key the type of the network addresses
+ * \tparam KeyHash the hash function of the network addresses
+ */
+template <typename Entry, typename Key, typename KeyHash>
+class NeighborCacheTable
+{
+public:
+  NeighborCacheTable ();
+
+  /**
+   * \brief Find an entry by network address.
+   * \param key the network address
+   * \return the entry, or 0 if not found
+   */
+  Entry *Find (const Key &key);
+  /**
+   * \brief Add an entry, which must not exist yet.
+   * \param key the network address
+   * \param entry the initial value of the entry, with an unset link-layer address
+   * \return the entry stored in the table
+   */
+  Entry *Insert (const Key &key, const Entry &entry);
+  /**
+   * \brief Remove an entry.
+   * \param key the network address of the entry
+   * \param entry the entry
+   * \return true if the entry was found and removed
+   */
+  bool Remove (const Key &key, Entry *entry);
+  /**
+   * \brief Remove all the entries.
+   */
+  void Clear (void);
+  /**
+   * \brief Update the index of link-layer addresses when an entry's address changes.
+   * \param entry the entry
+   * \param oldMac the previous link-layer address of the entry
+   * \param newMac the new link-layer address of the entry
+   */
+  void ChangeMac (Entry *entry, const Address &oldMac, const Address &newMac);
+  /**
+   * \brief Find the entries with a link-layer address.
+   * \param mac the link-layer address
+   * \param entries the entries found, in no particular order
+   */
+  void FindMac (const Address &mac, std::vector<Entry *> &entries) const;
+  /**
+   * \return the number of entries
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return the number of slots, to iterate over the entries with GetSlot ()
+   */
+  uint32_t GetNSlots (void) const;
+  /**
+   * \param i a slot index, lower than GetNSlots ()
+   * \return the entry in the slot, or 0 if the slot is free
+   */
+  Entry *GetSlot (uint32_t i);
+  /**
+   * \param i a slot index of an entry
+   * \return the network address the entry was added with
+   */
+  const Key &GetKey (uint32_t i) const;
+
+private:
+  /// A slot of the slab
+  struct Slot
+  {
+    Key key;       //!< network address of the entry
+    Entry entry;   //!< the entry
+    bool used;     //!< true if the slot holds an entry
+  };
+
+  /// Hash function of the link-layer addresses
+  struct MacHash
+  {
+    /**
+     * \param mac a link-layer address
+     * \return the hash of its bytes
+     */
+    std::size_t operator() (const Address &mac) const
+    {
+      uint8_t buffer[Address::MAX_SIZE];
+      uint32_t length = mac.CopyTo (buffer);
+      std::size_t h = length;
+      for (uint32_t i = 0; i < length; ++i)
+        {
+          h = h * 31 + buffer[i];
+        }
+      return h;
+    }
+  };
+
+  /// Equality of the bytes of the link-layer addresses
+  struct MacEqual
+  {
+    /**
+     * \param a a link-layer address
+     * \param b another link-layer address
+     * \return true if the addresses have the same bytes, whatever their type
+     */
+    bool operator() (const Address &a, const Address &b) const
+    {
+      uint8_t bufferA[Address::MAX_SIZE];
+      uint8_t bufferB[Address::MAX_SIZE];
+      uint32_t length = a.CopyTo (bufferA);
+      return b.CopyTo (bufferB) == length && std::memcmp (bufferA, bufferB, length) == 0;
+    }
+  };
+
+  /// Index of the link-layer addresses
+  typedef std::unordered_multimap<Address, Entry *, MacHash, MacEqual> MacIndex;
+
+  /// Marks an empty bucket of the hash table
+  static const uint32_t EMPTY = 0xffffffff;
+
+  /**
+   * \param key a network address
+   * \return the bucket where the search for key starts
+   */
+  uint32_t GetBucket (const Key &key) const;
+  /**
+   * \param key a network address
+   * \return the bucket holding key, or the empty bucket where it would be inserted
+   */
+  uint32_t Probe (const Key &key) const;
+  /**
+   * \brief Double the number of buckets of the hash table.
+   */
+  void Grow (void);
+  /**
+   * \brief Remove an entry from the index of link-layer addresses.
+   * \param entry the entry
+   * \param mac the link-layer address of the entry
+   */
+  void RemoveMac (Entry *entry, const Address &mac);
+
+  std::deque<Slot> m_slots;          //!< the slab of entries
+  std::vector<uint32_t> m_free;      //!< free slots
+  std::vector<uint32_t> m_buckets;   //!< hash table of slot indexes, by network address
+  uint32_t m_bits;                   //!< log2 of the number of buckets
+  uint32_t m_size;                   //!< number of entries
+  MacIndex m_macs;                   //!< entries by link-layer address
+};
+
+template <typename Entry, typename Key, typename KeyHash>
+const uint32_t NeighborCacheTable<Entry, Key, KeyHash>::EMPTY;
+
+template <typename Entry, typename Key, typename KeyHash>
+NeighborCacheTable<Entry, Key, KeyHash>::NeighborCacheTable ()
+  : m_buckets (16, EMPTY),
+    m_bits (4),
+    m_size (0)
+{
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+uint32_t
+NeighborCacheTable<Entry, Key, KeyHash>::GetBucket (const Key &key) const
+{
+  // Fibonacci hashing, as some address hashes are the address itself
+  uint64_t h = static_cast<uint64_t> (KeyHash () (key)) * 0x9e3779b97f4a7c15ULL;
+  return static_cast<uint32_t> (h >> (64 - m_bits));
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+uint32_t
+NeighborCacheTable<Entry, Key, KeyHash>::Probe (const Key &key) const
+{
+  uint32_t mask = m_buckets.size () - 1;
+  uint32_t b = GetBucket (key);
+  while (m_buckets[b] != EMPTY && !(m_slots[m_buckets[b]].key == key))
+    {
+      b = (b + 1) & mask;
+    }
+  return b;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+Entry *
+NeighborCacheTable<Entry, Key, KeyHash>::Find (const Key &key)
+{
+  uint32_t b = Probe (key);
+  if (m_buckets[b] == EMPTY)
+    {
+      return 0;
+    }
+  return &m_slots[m_buckets[b]].entry;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+void
+NeighborCacheTable<Entry, Key, KeyHash>::Grow (void)
+{
+  std::vector<uint32_t> old;
+  old.swap (m_buckets);
+  ++m_bits;
+  m_buckets.assign (old.size () * 2, EMPTY);
+  for (std::vector<uint32_t>::const_iterator i = old.begin (); i != old.end (); ++i)
+    {
+      if (*i != EMPTY)
+        {
+          m_buckets[Probe (m_slots[*i].key)] = *i;
+        }
+    }
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+Entry *
+NeighborCacheTable<Entry, Key, KeyHash>::Insert (const Key &key, const Entry &entry)
+{
+  // Keep the load factor below one half
+  if (2 * (m_size + 1) > m_buckets.size ())
+    {
+      Grow ();
+    }
+  uint32_t b = Probe (key);
+  NS_ASSERT_MSG (m_buckets[b] == EMPTY, "Entry already in the cache");
+  uint32_t index;
+  if (m_free.empty ())
+    {
+      index = m_slots.size ();
+      Slot slot = { key, entry, true };
+      m_slots.push_back (slot);
+    }
+  else
+    {
+      index = m_free.back ();
+      m_free.pop_back ();
+      m_slots[index].key = key;
+      m_slots[index].entry = entry;
+      m_slots[index].used = true;
+    }
+  m_buckets[b] = index;
+  ++m_size;
+  Entry *stored = &m_slots[index].entry;
+  m_macs.insert (std::make_pair (stored->GetMacAddress (), stored));
+  return stored;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+bool
+NeighborCacheTable<Entry, Key, KeyHash>::Remove (const Key &key, Entry *entry)
+{
+  uint32_t mask = m_buckets.size () - 1;
+  uint32_t b = Probe (key);
+  if (m_buckets[b] == EMPTY || &m_slots[m_buckets[b]].entry != entry)
+    {
+      // The network address of the entry was changed after it was added
+      b = EMPTY;
+      for (uint32_t i = 0; i < m_slots.size (); ++i)
+        {
+          if (m_slots[i].used && &m_slots[i].entry == entry)
+            {
+              b = Probe (m_slots[i].key);
+              break;
+            }
+        }
+      if (b == EMPTY)
+        {
+          return false;
+        }
+    }
+  uint32_t index = m_buckets[b];
+  RemoveMac (entry, entry->GetMacAddress ());
+  m_slots[index].used = false;
+  m_free.push_back (index);
+  --m_size;
+
+  // Backward shift deletion: move up the entries which would not be
+  // found anymore across the emptied bucket.
+  uint32_t hole = b;
+  uint32_t next = (hole + 1) & mask;
+  while (m_buckets[next] != EMPTY)
+    {
+      uint32_t home = GetBucket (m_slots[m_buckets[next]].key);
+      if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+          m_buckets[hole] = m_buckets[next];
+          hole = next;
+        }
+      next = (next + 1) & mask;
+    }
+  m_buckets[hole] = EMPTY;
+  return true;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+void
+NeighborCacheTable<Entry, Key, KeyHash>::Clear (void)
+{
+  m_slots.clear ();
+  m_free.clear ();
+  m_buckets.assign (16, EMPTY);
+  m_bits = 4;
+  m_size = 0;
+  m_macs.clear ();
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+void
+NeighborCacheTable<Entry, Key, KeyHash>::RemoveMac (Entry *entry, const Address &mac)
+{
+  std::pair<typename MacIndex::iterator, typename MacIndex::iterator> range = m_macs.equal_range (mac);
+  for (typename MacIndex::iterator i = range.first; i != range.second; ++i)
+    {
+      if (i->second == entry)
+        {
+          m_macs.erase (i);
+          return;
+        }
+    }
+  NS_ASSERT_MSG (false, "Entry not indexed by its link-layer address");
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+void
+NeighborCacheTable<Entry, Key, KeyHash>::ChangeMac (Entry *entry, const Address &oldMac, const Address &newMac)
+{
+  RemoveMac (entry, oldMac);
+  m_macs.insert (std::make_pair (newMac, entry));
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+void
+NeighborCacheTable<Entry, Key, KeyHash>::FindMac (const Address &mac, std::vector<Entry *> &entries) const
+{
+  entries.clear ();
+  std::pair<typename MacIndex::const_iterator, typename MacIndex::const_iterator> range = m_macs.equal_range (mac);
+  for (typename MacIndex::const_iterator i = range.first; i != range.second; ++i)
+    {
+      // The hash table matches the bytes: check the address types too
+      if (i->second->GetMacAddress () == mac)
+        {
+          entries.push_back (i->second);
+        }
+    }
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+uint32_t
+NeighborCacheTable<Entry, Key, KeyHash>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+uint32_t
+NeighborCacheTable<Entry, Key, KeyHash>::GetNSlots (void) const
+{
+  return m_slots.size ();
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+Entry *
+NeighborCacheTable<Entry, Key, KeyHash>::GetSlot (uint32_t i)
+{
+  return m_slots[i].used ? &m_slots[i].entry : 0;
+}
+
+template <typename Entry, typename Key, typename KeyHash>
+const Key &
+NeighborCacheTable<Entry, Key, KeyHash>::GetKey (uint32_t i) const
+{
+  return m_slots[i].key;
+}
+
+} // namespace ns3
+
+#endif /* NEIGHBOR_CACHE_TABLE_H */
@@ -41,6 +41,7 @@
 #include "ipv6-routing-protocol.h"
 #include "tcp-socket-factory-impl.h"
 #include "tcp-socket-base.h"
+#include "tcp-timer-wheel.h"
 #include "tcp-congestion-ops.h"
 #include "tcp-recovery-ops.h"
 #include "rtt-estimator.h"
@@ -90,6 +91,14 @@ TcpL4Protocol::GetTypeId (void)
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&TcpL4Protocol::m_sockets),
                    MakeObjectVectorChecker<TcpSocketBase> ())
+    .AddAttribute ("TimerWheelTick",
+                   "Tick of the timer wheel keeping the retransmission, delayed ACK, "
+                   "persist, LAST_ACK and TIME_WAIT timers of the sockets, which are "
+                   "then handed over to the simulator only in the tick they expire in. "
+                   "Zero to schedule them directly in the simulator.",
+                   TimeValue (Time (0)),
+                   MakeTimeAccessor (&TcpL4Protocol::m_timerWheelTick),
+                   MakeTimeChecker (Time (0)))
   ;
   return tid;
 }
@@ -174,6 +183,12 @@ TcpL4Protocol::DoDispose (void)
       m_endPoints6 = 0;
     }
 
+  if (m_timerWheel != 0)
+    {
+      m_timerWheel->Clear ();
+      m_timerWheel = 0;
+    }
+
   m_node = 0;
   m_downTarget.Nullify ();
   m_downTarget6.Nullify ();
@@ -212,6 +227,16 @@ TcpL4Protocol::CreateSocket (TypeId congestionTypeId, TypeId recoveryTypeId)
   return socket;
 }
 
+Ptr<TcpTimerWheel>
+TcpL4Protocol::GetTimerWheel (void)
+{
+  if (m_timerWheel == 0 && m_timerWheelTick.IsStrictlyPositive ())
+    {
+      m_timerWheel = Create<TcpTimerWheel> (m_timerWheelTick);
+    }
+  return m_timerWheel;
+}
+
 Ptr<Socket>
 TcpL4Protocol::CreateSocket (void)
 {
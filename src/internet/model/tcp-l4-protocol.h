@@ -26,6 +26,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
 #include "ns3/sequence-number.h"
+#include "ns3/nstime.h"
 #include "ip-l4-protocol.h"
 
 
@@ -38,6 +39,7 @@ class Ipv4EndPointDemux;
 class Ipv6EndPointDemux;
 class Ipv4Interface;
 class TcpSocketBase;
+class TcpTimerWheel;
 class Ipv4EndPoint;
 class Ipv6EndPoint;
 class NetDevice;
@@ -128,6 +130,17 @@ public:
     */
   Ptr<Socket> CreateSocket (TypeId congestionTypeId);
 
+  /**
+   * \brief Get the timer wheel keeping the timers of the sockets
+   *
+   * The wheel is created on the first call if the TimerWheelTick
+   * attribute is positive.
+   *
+   * \return the timer wheel, or 0 if the sockets schedule their timers
+   * in the simulator
+   */
+  Ptr<TcpTimerWheel> GetTimerWheel (void);
+
   /**
    * \brief Allocate an IPv4 Endpoint
    * \return the Endpoint
@@ -323,6 +336,8 @@ private:
   std::vector<Ptr<TcpSocketBase> > m_sockets;      //!< list of sockets
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
+  Time m_timerWheelTick;                             //!< Tick of the timer wheel, or zero if none
+  Ptr<TcpTimerWheel> m_timerWheel;                   //!< Timer wheel of the socket timers
 
   /**
    * \brief Copy constructor
@@ -155,8 +155,14 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The stored blocks are disjoint and
+  // sorted, so only the last block starting at or before headSeq and the
+  // following ones may overlap it.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -205,13 +211,9 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (i = m_data.begin (); i != m_data.end (); ++i)
+  for (i = m_data.lower_bound (m_nextRxSeq); i != m_data.end (); ++i)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
+      if (i->first > m_nextRxSeq)
         {
           break;
         };
@@ -53,6 +53,13 @@ class Packet;
  * To store data, use Add; for retrieving a certain amount of ordered data, use
  * the method Extract.
  *
+ * The data is stored as disjoint blocks, ordered by their first sequence
+ * number: the bytes of an incoming segment which are already in the buffer
+ * are trimmed away before storing it. Therefore, Add looks up only the blocks
+ * which may overlap the segment (the last block starting before it, and the
+ * following ones) instead of scanning the whole buffer, which keeps the cost
+ * of out-of-order arrivals logarithmic in the number of stored blocks.
+ *
  * SACK list
  * ---------
  *
@@ -141,6 +141,16 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("TsoMaxSegments",
+                   "Maximum number of full segments of new data sent as a single "
+                   "large segment (TCP segmentation offload); 1 disables it. "
+                   "Large segments are not fragmented by IP and are serialized "
+                   "as one frame, so the devices on the path must accept frames "
+                   "larger than their MTU, as PointToPointNetDevice and "
+                   "SimpleNetDevice do.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&TcpSocketBase::m_tsoMaxSegments),
+                   MakeUintegerChecker<uint32_t> (1, 65535))
     .AddAttribute ("EcnMode", "Determines the mode of ECN",
                    EnumValue (EcnMode_t::NoEcn),
                    MakeEnumAccessor (&TcpSocketBase::m_ecnMode),
@@ -289,6 +299,11 @@ TcpSocketBase::TcpSocketBase (void)
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   : TcpSocket (sock),
     //copy object::m_tid and socket::callbacks
+    m_retxEvent (sock.m_retxEvent),
+    m_lastAckEvent (sock.m_lastAckEvent),
+    m_delAckEvent (sock.m_delAckEvent),
+    m_persistEvent (sock.m_persistEvent),
+    m_timewaitEvent (sock.m_timewaitEvent),
     m_dupAckCount (sock.m_dupAckCount),
     m_delAckCount (0),
     m_delAckMaxCount (sock.m_delAckMaxCount),
@@ -329,6 +344,7 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
+    m_tsoMaxSegments (sock.m_tsoMaxSegments),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
@@ -450,6 +466,12 @@ void
 TcpSocketBase::SetTcp (Ptr<TcpL4Protocol> tcp)
 {
   m_tcp = tcp;
+  Ptr<TcpTimerWheel> wheel = tcp->GetTimerWheel ();
+  m_retxEvent.SetWheel (wheel);
+  m_lastAckEvent.SetWheel (wheel);
+  m_delAckEvent.SetWheel (wheel);
+  m_persistEvent.SetWheel (wheel);
+  m_timewaitEvent.SetWheel (wheel);
 }
 
 /* Set an RTT estimator with this socket */
@@ -1335,13 +1357,13 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
     { // Zero window: Enter persist state to send 1 byte to probe
       NS_LOG_LOGIC (this << " Enter zerowindow persist state");
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       NS_LOG_LOGIC ("Schedule persist timeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_persistTimeout).GetSeconds ());
-      m_persistEvent = Simulator::Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
-      NS_ASSERT (m_persistTimeout == Simulator::GetDelayLeft (m_persistEvent));
+      m_persistEvent.Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+      NS_ASSERT (m_persistTimeout == m_persistEvent.GetDelayLeft ());
     }
 
   // TCP state machine code in different process functions
@@ -2424,7 +2446,7 @@ TcpSocketBase::DoPeerClose (void)
     {
       NS_LOG_LOGIC ("TcpSocketBase " << this << " scheduling LATO1");
       Time lastRto = m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation () * 4);
-      m_lastAckEvent = Simulator::Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
+      m_lastAckEvent.Schedule (lastRto, &TcpSocketBase::LastAckTimeout, this);
     }
 }
 
@@ -2440,7 +2462,7 @@ TcpSocketBase::Destroy (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2456,7 +2478,7 @@ TcpSocketBase::Destroy6 (void)
       m_tcp->RemoveSocket (this);
     }
   NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
   CancelAllTimers ();
 }
 
@@ -2582,7 +2604,7 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
       NS_LOG_LOGIC ("Schedule retransmission timeout at time "
                     << Simulator::Now ().GetSeconds () << " to expire at time "
                     << (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::SendEmptyPacket, this, flags);
+      m_retxEvent.Schedule (m_rto, &TcpSocketBase::SendEmptyPacket, this, flags);
     }
 }
 
@@ -2892,6 +2914,14 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
 
   AddSocketTags (p);
 
+  if (sz > m_tcb->m_segmentSize)
+    {
+      // A large segment, see m_tsoMaxSegments
+      SocketLargeSendTag largeSendTag;
+      largeSendTag.SetSegmentSize (m_tcb->m_segmentSize);
+      p->AddPacketTag (largeSendTag);
+    }
+
   if (m_closeOnEmpty && (remainingData == 0))
     {
       flags |= TcpHeader::FIN;
@@ -2930,7 +2960,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
       NS_LOG_LOGIC (this << " SendDataPacket Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds () );
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
 
   m_txTrace (p, header, this);
@@ -3081,6 +3111,17 @@ TcpSocketBase::SendPendingData (bool withAck)
 
           uint32_t s = std::min (availableWindow, m_tcb->m_segmentSize);
 
+          // Segmentation offload: hand down the new data which the window
+          // allows, up to m_tsoMaxSegments full segments, in a single packet.
+          // Retransmissions are always sent one segment at a time.
+          if (m_tsoMaxSegments > 1 && next == m_tcb->m_highTxMark
+              && availableWindow >= 2 * m_tcb->m_segmentSize)
+            {
+              s = static_cast<uint32_t> (std::min<uint64_t> (availableWindow,
+                                                             uint64_t (m_tsoMaxSegments) * m_tcb->m_segmentSize));
+              s -= s % m_tcb->m_segmentSize;
+            }
+
           // (C.2) If any of the data octets sent in (C.1) are below HighData,
           //       HighRxt MUST be set to the highest sequence number of the
           //       retransmitted segment unless NextSeg () rule (4) was
@@ -3234,6 +3275,15 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
   NS_LOG_DEBUG ("Data segment, seq=" << tcpHeader.GetSequenceNumber () <<
                 " pkt size=" << p->GetSize () );
 
+  // A large segment stands for several segments, each of which would have
+  // counted for the delayed ACK: acknowledge it as a whole
+  uint32_t nSegments = 1;
+  SocketLargeSendTag largeSendTag;
+  if (p->PeekPacketTag (largeSendTag) && largeSendTag.GetSegmentSize () > 0)
+    {
+      nSegments = (p->GetSize () + largeSendTag.GetSegmentSize () - 1) / largeSendTag.GetSegmentSize ();
+    }
+
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -3287,7 +3337,8 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     }
   else
     { // In-sequence packet: ACK if delayed ack count allows
-      if (++m_delAckCount >= m_delAckMaxCount)
+      m_delAckCount += nSegments;
+      if (m_delAckCount >= m_delAckMaxCount)
         {
           m_delAckEvent.Cancel ();
           m_delAckCount = 0;
@@ -3306,10 +3357,10 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
         }
       else if (m_delAckEvent.IsExpired ())
         {
-          m_delAckEvent = Simulator::Schedule (m_delAckTimeout,
-                                               &TcpSocketBase::DelAckTimeout, this);
+          m_delAckEvent.Schedule (m_delAckTimeout,
+                                  &TcpSocketBase::DelAckTimeout, this);
           NS_LOG_LOGIC (this << " scheduled delayed ACK at " <<
-                        (Simulator::Now () + Simulator::GetDelayLeft (m_delAckEvent)).GetSeconds ());
+                        (Simulator::Now () + m_delAckEvent.GetDelayLeft ()).GetSeconds ());
         }
     }
 }
@@ -3384,7 +3435,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_state != SYN_RCVD && resetRTO)
     { // Set RTO unless the ACK is received in SYN_RCVD state
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
       // On receiving a "New" ack we restart retransmission timer .. RFC 6298
       // RFC 6298, clause 2.4
@@ -3393,7 +3444,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
       NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time " <<
                     Simulator::Now ().GetSeconds () << " to expire at time " <<
                     (Simulator::Now () + m_rto.Get ()).GetSeconds ());
-      m_retxEvent = Simulator::Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
+      m_retxEvent.Schedule (m_rto, &TcpSocketBase::ReTxTimeout, this);
     }
 
   // Note the highest ACK and tell app to send more
@@ -3411,7 +3462,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   if (m_txBuffer->Size () == 0 && m_state != FIN_WAIT_1 && m_state != CLOSING)
     { // No retransmit timer if no data to retransmit
       NS_LOG_LOGIC (this << " Cancelled ReTxTimeout event which was set to expire at " <<
-                    (Simulator::Now () + Simulator::GetDelayLeft (m_retxEvent)).GetSeconds ());
+                    (Simulator::Now () + m_retxEvent.GetDelayLeft ()).GetSeconds ());
       m_retxEvent.Cancel ();
     }
 }
@@ -3636,7 +3687,7 @@ TcpSocketBase::PersistTimeout ()
   NS_LOG_LOGIC ("Schedule persist timeout at time "
                 << Simulator::Now ().GetSeconds () << " to expire at time "
                 << (Simulator::Now () + m_persistTimeout).GetSeconds ());
-  m_persistEvent = Simulator::Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
+  m_persistEvent.Schedule (m_persistTimeout, &TcpSocketBase::PersistTimeout, this);
 }
 
 void
@@ -3695,8 +3746,8 @@ TcpSocketBase::TimeWait ()
     }
   // Move from TIME_WAIT to CLOSED after 2*MSL. Max segment lifetime is 2 min
   // according to RFC793, p.28
-  m_timewaitEvent = Simulator::Schedule (Seconds (2 * m_msl),
-                                         &TcpSocketBase::CloseAndNotify, this);
+  m_timewaitEvent.Schedule (Seconds (2 * m_msl),
+                            &TcpSocketBase::CloseAndNotify, this);
 }
 
 /* Below are the attribute get/set functions */
@@ -32,6 +32,7 @@
 #include "ns3/data-rate.h"
 #include "ns3/node.h"
 #include "ns3/tcp-socket-state.h"
+#include "ns3/tcp-timer-wheel.h"
 
 namespace ns3 {
 
@@ -1170,11 +1171,11 @@ protected:
 
 protected:
   // Counters and events
-  EventId           m_retxEvent     {}; //!< Retransmission event
-  EventId           m_lastAckEvent  {}; //!< Last ACK timeout event
-  EventId           m_delAckEvent   {}; //!< Delayed ACK timeout event
-  EventId           m_persistEvent  {}; //!< Persist event: Send 1 byte to probe for a non-zero Rx window
-  EventId           m_timewaitEvent {}; //!< TIME_WAIT expiration event: Move this socket to CLOSED state
+  TcpTimer          m_retxEvent     {}; //!< Retransmission event
+  TcpTimer          m_lastAckEvent  {}; //!< Last ACK timeout event
+  TcpTimer          m_delAckEvent   {}; //!< Delayed ACK timeout event
+  TcpTimer          m_persistEvent  {}; //!< Persist event: Send 1 byte to probe for a non-zero Rx window
+  TcpTimer          m_timewaitEvent {}; //!< TIME_WAIT expiration event: Move this socket to CLOSED state
 
   // ACK management
   uint32_t          m_dupAckCount {0};     //!< Dupack counter
@@ -1249,6 +1250,9 @@ protected:
   uint32_t               m_retxThresh {3};   //!< Fast Retransmit threshold
   bool                   m_limitedTx  {true}; //!< perform limited transmit
 
+  // Segmentation offload
+  uint32_t               m_tsoMaxSegments {1}; //!< Maximum number of segments sent as one large segment
+
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control information
   Ptr<TcpCongestionOps>  m_congestionControl; //!< Congestion control
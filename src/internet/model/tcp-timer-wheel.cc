@@ -0,0 +1,381 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "tcp-timer-wheel.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTimerWheel");
+
+TcpTimer::TcpTimer ()
+  : m_expiration (0),
+    m_tick (0),
+    m_prev (0),
+    m_next (0),
+    m_level (0),
+    m_linked (false)
+{
+}
+
+TcpTimer::TcpTimer (const TcpTimer &timer)
+  : m_wheel (timer.m_wheel),
+    m_expiration (0),
+    m_tick (0),
+    m_prev (0),
+    m_next (0),
+    m_level (0),
+    m_linked (false)
+{
+}
+
+TcpTimer::~TcpTimer ()
+{
+  Cancel ();
+}
+
+void
+TcpTimer::SetWheel (Ptr<TcpTimerWheel> wheel)
+{
+  NS_ASSERT_MSG (!m_linked, "Cannot change the wheel of a scheduled timer");
+  m_wheel = wheel;
+}
+
+void
+TcpTimer::Schedule (const Time &delay, EventImpl *event)
+{
+  Ptr<EventImpl> impl = Ptr<EventImpl> (event, false);
+  if (m_linked)
+    {
+      m_wheel->Remove (this);
+      m_wheel->Commit (this);
+    }
+  m_event = EventId ();
+  if (m_wheel == 0)
+    {
+      m_event = Simulator::Schedule (delay, impl);
+      return;
+    }
+  m_impl = impl;
+  m_expiration = (Simulator::Now () + delay).GetTimeStep ();
+  m_wheel->Add (this);
+}
+
+void
+TcpTimer::Cancel (void)
+{
+  if (m_linked)
+    {
+      m_wheel->Remove (this);
+      m_impl = 0;
+    }
+  else
+    {
+      m_event.Cancel ();
+    }
+}
+
+bool
+TcpTimer::IsExpired (void) const
+{
+  return !IsRunning ();
+}
+
+bool
+TcpTimer::IsRunning (void) const
+{
+  return m_linked || m_event.IsRunning ();
+}
+
+Time
+TcpTimer::GetDelayLeft (void) const
+{
+  if (m_linked)
+    {
+      return TimeStep (m_expiration) - Simulator::Now ();
+    }
+  return Simulator::GetDelayLeft (m_event);
+}
+
+TcpTimerWheel::TcpTimerWheel (Time tick)
+  : m_tick (tick.GetTimeStep ()),
+    m_nextTick (0),
+    m_eventTick (0)
+{
+  NS_LOG_FUNCTION (this << tick);
+  NS_ABORT_MSG_UNLESS (m_tick > 0, "The tick of the timer wheel must be positive");
+  for (uint32_t level = 0; level < N_LEVELS; ++level)
+    {
+      m_nTimers[level] = 0;
+      for (uint32_t slot = 0; slot < N_SLOTS; ++slot)
+        {
+          m_slots[level][slot] = 0;
+        }
+    }
+}
+
+TcpTimerWheel::~TcpTimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+Time
+TcpTimerWheel::GetTick (void) const
+{
+  return TimeStep (m_tick);
+}
+
+uint32_t
+TcpTimerWheel::GetNTimers (void) const
+{
+  uint32_t n = 0;
+  for (uint32_t level = 0; level < N_LEVELS; ++level)
+    {
+      n += m_nTimers[level];
+    }
+  return n;
+}
+
+void
+TcpTimerWheel::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t level = 0; level < N_LEVELS; ++level)
+    {
+      for (uint32_t slot = 0; slot < N_SLOTS; ++slot)
+        {
+          while (m_slots[level][slot] != 0)
+            {
+              TcpTimer *timer = m_slots[level][slot];
+              Remove (timer);
+              timer->m_impl = 0;
+            }
+        }
+    }
+  m_event.Cancel ();
+}
+
+void
+TcpTimerWheel::Add (TcpTimer *timer)
+{
+  int64_t nowTick = Simulator::Now ().GetTimeStep () / m_tick;
+  if (timer->m_expiration / m_tick <= nowTick)
+    {
+      // Expires in the current tick
+      Commit (timer);
+      return;
+    }
+  if (m_nextTick <= nowTick)
+    {
+      // Catch up with the current tick, so that the timer is placed
+      // relative to it. There is only something to process if the
+      // simulator event is due now and has not been invoked yet.
+      if (m_event.IsRunning () && m_eventTick <= nowTick)
+        {
+          m_event.Cancel ();
+          ProcessUntil (nowTick);
+        }
+      else
+        {
+          m_nextTick = nowTick + 1;
+        }
+    }
+  Wake (Place (timer));
+}
+
+void
+TcpTimerWheel::Remove (TcpTimer *timer)
+{
+  NS_ASSERT (timer->m_linked);
+  uint32_t level = timer->m_level;
+  uint32_t slot = (timer->m_tick >> (SLOT_BITS * level)) & (N_SLOTS - 1);
+  if (timer->m_prev != 0)
+    {
+      timer->m_prev->m_next = timer->m_next;
+    }
+  else
+    {
+      m_slots[level][slot] = timer->m_next;
+    }
+  if (timer->m_next != 0)
+    {
+      timer->m_next->m_prev = timer->m_prev;
+    }
+  timer->m_prev = 0;
+  timer->m_next = 0;
+  timer->m_linked = false;
+  --m_nTimers[level];
+}
+
+int64_t
+TcpTimerWheel::Place (TcpTimer *timer)
+{
+  // Timers beyond the span of the wheel are placed at its end, and placed
+  // again when their slot is cascaded.
+  int64_t tick = std::min (timer->m_expiration / m_tick,
+                           m_nextTick + (int64_t (1) << (SLOT_BITS * N_LEVELS)) - 1);
+  NS_ASSERT (tick >= m_nextTick);
+  int64_t delta = tick - m_nextTick;
+  uint32_t level = 0;
+  while (level + 1 < N_LEVELS && delta >= (int64_t (1) << (SLOT_BITS * (level + 1))))
+    {
+      ++level;
+    }
+  uint32_t slot = (tick >> (SLOT_BITS * level)) & (N_SLOTS - 1);
+  timer->m_tick = tick;
+  timer->m_level = level;
+  timer->m_prev = 0;
+  timer->m_next = m_slots[level][slot];
+  if (timer->m_next != 0)
+    {
+      timer->m_next->m_prev = timer;
+    }
+  m_slots[level][slot] = timer;
+  timer->m_linked = true;
+  ++m_nTimers[level];
+  // The slot is processed at the first tick it spans
+  return (tick >> (SLOT_BITS * level)) << (SLOT_BITS * level);
+}
+
+void
+TcpTimerWheel::Commit (TcpTimer *timer)
+{
+  NS_ASSERT (!timer->m_linked);
+  timer->m_event = Simulator::Schedule (TimeStep (timer->m_expiration) - Simulator::Now (),
+                                        timer->m_impl);
+  timer->m_impl = 0;
+}
+
+bool
+TcpTimerWheel::Cascades (int64_t tick) const
+{
+  if ((tick & (N_SLOTS - 1)) != 0)
+    {
+      return false;
+    }
+  for (uint32_t level = 1; level < N_LEVELS; ++level)
+    {
+      uint32_t slot = (tick >> (SLOT_BITS * level)) & (N_SLOTS - 1);
+      if (m_slots[level][slot] != 0)
+        {
+          return true;
+        }
+      if (slot != 0)
+        {
+          return false;
+        }
+    }
+  return false;
+}
+
+int64_t
+TcpTimerWheel::GetNextWorkTick (void) const
+{
+  if (GetNTimers () == 0)
+    {
+      return -1;
+    }
+  int64_t tick = m_nextTick;
+  while (m_slots[0][tick & (N_SLOTS - 1)] == 0 && !Cascades (tick))
+    {
+      // Nothing can happen before the next slot of the lowest non-empty level
+      uint32_t level = 0;
+      while (m_nTimers[level] == 0)
+        {
+          ++level;
+        }
+      int64_t span = int64_t (1) << (SLOT_BITS * level);
+      tick = (tick / span + 1) * span;
+    }
+  return tick;
+}
+
+void
+TcpTimerWheel::ProcessTick (int64_t tick)
+{
+  NS_LOG_FUNCTION (this << tick);
+  NS_ASSERT (tick >= m_nextTick);
+  m_nextTick = tick;
+  if ((tick & (N_SLOTS - 1)) == 0)
+    {
+      for (uint32_t level = 1; level < N_LEVELS; ++level)
+        {
+          uint32_t slot = (tick >> (SLOT_BITS * level)) & (N_SLOTS - 1);
+          while (m_slots[level][slot] != 0)
+            {
+              TcpTimer *timer = m_slots[level][slot];
+              Remove (timer);
+              Place (timer);
+            }
+          if (slot != 0)
+            {
+              break;
+            }
+        }
+    }
+  TcpTimer **slot = &m_slots[0][tick & (N_SLOTS - 1)];
+  while (*slot != 0)
+    {
+      TcpTimer *timer = *slot;
+      NS_ASSERT (timer->m_tick == tick);
+      Remove (timer);
+      Commit (timer);
+    }
+  m_nextTick = tick + 1;
+}
+
+void
+TcpTimerWheel::Wake (int64_t tick)
+{
+  if (m_event.IsRunning () && m_eventTick <= tick)
+    {
+      return;
+    }
+  m_event.Cancel ();
+  m_eventTick = tick;
+  m_event = Simulator::Schedule (TimeStep (tick * m_tick) - Simulator::Now (),
+                                 &TcpTimerWheel::Expire, this);
+}
+
+void
+TcpTimerWheel::ProcessUntil (int64_t last)
+{
+  int64_t tick = GetNextWorkTick ();
+  while (tick != -1 && tick <= last)
+    {
+      ProcessTick (tick);
+      tick = GetNextWorkTick ();
+    }
+  m_nextTick = std::max (m_nextTick, last + 1);
+  if (tick != -1)
+    {
+      Wake (tick);
+    }
+}
+
+void
+TcpTimerWheel::Expire (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessUntil (Simulator::Now ().GetTimeStep () / m_tick);
+}
+
+} // namespace ns3
@@ -0,0 +1,238 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_TIMER_WHEEL_H
+#define TCP_TIMER_WHEEL_H
+
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+
+namespace ns3 {
+
+class TcpTimerWheel;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief A TCP timer, kept in a TcpTimerWheel or in the simulator.
+ *
+ * The timer offers the interface of an EventId.  Without a wheel, it
+ * simply holds a simulator event.  With a wheel, a scheduled timer is
+ * only linked in one of its slots, so that cancelling or rescheduling it
+ * does not touch the simulator; when the tick of its expiration comes,
+ * the wheel hands it over to the simulator, which fires it at its exact
+ * expiration time.
+ *
+ * A timer is cancelled when destroyed. Copying a timer gives a timer
+ * using the same wheel, which is not scheduled.
+ */
+class TcpTimer
+{
+public:
+  TcpTimer ();
+  /**
+   * \brief Copy constructor: the timer is not scheduled.
+   * \param timer the timer to copy the wheel from
+   */
+  TcpTimer (const TcpTimer &timer);
+  ~TcpTimer ();
+
+  /**
+   * \brief Set the wheel the timer is kept in.
+   *
+   * The timer must not be scheduled.
+   *
+   * \param wheel the wheel, or 0 to schedule the timer in the simulator
+   */
+  void SetWheel (Ptr<TcpTimerWheel> wheel);
+  /**
+   * \brief Schedule the timer.
+   *
+   * As when a new event is assigned to an EventId, a running timer is not
+   * cancelled: it only stops being tracked.
+   *
+   * \param delay the delay after which the event expires
+   * \param event the event to invoke
+   */
+  void Schedule (const Time &delay, EventImpl *event);
+  /**
+   * \brief Schedule the timer to invoke a method, as Simulator::Schedule.
+   * \param delay the delay after which the event expires
+   * \param mem_ptr the method to invoke
+   * \param obj the object on which to invoke the method
+   * \param args the arguments of the method
+   */
+  template <typename MEM, typename OBJ, typename... Ts>
+  void Schedule (const Time &delay, MEM mem_ptr, OBJ obj, Ts... args);
+  /**
+   * \brief Cancel the timer, if it is running.
+   */
+  void Cancel (void);
+  /**
+   * \return true if the timer is not scheduled, has fired or was cancelled
+   */
+  bool IsExpired (void) const;
+  /**
+   * \return true if the timer is scheduled and neither fired nor cancelled
+   */
+  bool IsRunning (void) const;
+  /**
+   * \return the time left until the timer expires, or zero if it is not running
+   */
+  Time GetDelayLeft (void) const;
+
+private:
+  friend class TcpTimerWheel;
+
+  /// Assignment is not allowed \returns this
+  TcpTimer &operator= (const TcpTimer &);
+
+  Ptr<TcpTimerWheel> m_wheel;  //!< the wheel, if any
+  EventId m_event;             //!< the simulator event, once handed over to the simulator
+  Ptr<EventImpl> m_impl;       //!< the event to invoke, while in the wheel
+  int64_t m_expiration;        //!< expiration time, in time steps, while in the wheel
+  int64_t m_tick;              //!< expiration tick used to place the timer in the wheel
+  TcpTimer *m_prev;            //!< previous timer in the slot
+  TcpTimer *m_next;            //!< next timer in the slot
+  uint8_t m_level;             //!< level of the slot
+  bool m_linked;               //!< true if the timer is in the wheel
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Hierarchical timer wheel for the TCP timers of a node.
+ *
+ * The retransmission, delayed ACK, persist, LAST_ACK and TIME_WAIT timers
+ * of a socket are cancelled and rescheduled on nearly every segment, and
+ * with many connections these simulator events dominate the scheduler.
+ * The wheel keeps them instead in slots of a few levels of 64 slots each,
+ * the slots of level L spanning 64^L ticks (Varghese and Lauck, 1987), so
+ * that adding and cancelling a timer costs a constant time and no
+ * simulator event.
+ *
+ * The wheel schedules a single simulator event, at the start of the next
+ * tick in which a timer expires or a slot of an upper level must be
+ * cascaded to the lower levels.  The timers which expire in that tick are
+ * then scheduled in the simulator at their exact expiration time, so that
+ * the timer semantics is unchanged: only the simulator events are fewer.
+ */
+class TcpTimerWheel : public SimpleRefCount<TcpTimerWheel>
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param tick the duration of a tick of the wheel
+   */
+  TcpTimerWheel (Time tick);
+  ~TcpTimerWheel ();
+
+  /**
+   * \return the duration of a tick of the wheel
+   */
+  Time GetTick (void) const;
+  /**
+   * \return the number of timers in the wheel, not yet handed over to the simulator
+   */
+  uint32_t GetNTimers (void) const;
+  /**
+   * \brief Remove all the timers, which are cancelled, and the simulator event.
+   */
+  void Clear (void);
+
+private:
+  friend class TcpTimer;
+
+  /// Number of bits of the slot index in each level
+  static const uint32_t SLOT_BITS = 6;
+  /// Number of slots in each level
+  static const uint32_t N_SLOTS = 1 << SLOT_BITS;
+  /// Number of levels
+  static const uint32_t N_LEVELS = 4;
+
+  /**
+   * \brief Add a timer.
+   * \param timer the timer, whose expiration and event are set
+   */
+  void Add (TcpTimer *timer);
+  /**
+   * \brief Remove a timer from its slot.
+   * \param timer the timer
+   */
+  void Remove (TcpTimer *timer);
+  /**
+   * \brief Place a timer in the slot matching its tick.
+   * \param timer the timer
+   * \return the tick at which the slot will be processed
+   */
+  int64_t Place (TcpTimer *timer);
+  /**
+   * \brief Hand a timer over to the simulator.
+   * \param timer the timer, which is not in a slot anymore
+   */
+  void Commit (TcpTimer *timer);
+  /**
+   * \param tick a tick, not earlier than m_nextTick
+   * \return true if processing tick moves timers from an upper level
+   */
+  bool Cascades (int64_t tick) const;
+  /**
+   * \return the first tick, not earlier than m_nextTick, in which there is
+   * something to do, or -1 if the wheel is empty
+   */
+  int64_t GetNextWorkTick (void) const;
+  /**
+   * \brief Process a tick: cascade the upper levels and hand over the timers expiring.
+   * \param tick the tick, not earlier than m_nextTick
+   */
+  void ProcessTick (int64_t tick);
+  /**
+   * \brief Schedule the simulator event at the start of a tick, unless it is scheduled earlier.
+   * \param tick the tick
+   */
+  void Wake (int64_t tick);
+  /**
+   * \brief Process the ticks in which there is something to do, and wake up for the next one.
+   * \param last the last tick to process
+   */
+  void ProcessUntil (int64_t last);
+  /**
+   * \brief Process the ticks up to the current one (simulator event).
+   */
+  void Expire (void);
+
+  int64_t m_tick;                                //!< duration of a tick, in time steps
+  int64_t m_nextTick;                            //!< first tick not processed yet
+  TcpTimer *m_slots[N_LEVELS][N_SLOTS];          //!< the slots, as lists of timers
+  uint32_t m_nTimers[N_LEVELS];                  //!< number of timers in each level
+  EventId m_event;                               //!< the simulator event
+  int64_t m_eventTick;                           //!< tick of the simulator event
+};
+
+template <typename MEM, typename OBJ, typename... Ts>
+void
+TcpTimer::Schedule (const Time &delay, MEM mem_ptr, OBJ obj, Ts... args)
+{
+  Schedule (delay, MakeEvent (mem_ptr, obj, args...));
+}
+
+} // namespace ns3
+
+#endif /* TCP_TIMER_WHEEL_H */
@@ -21,6 +21,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 
 #include "ns3/packet.h"
 #include "ns3/log.h"
@@ -96,27 +97,12 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
+  : m_head (0), m_maxBuffer (32768), m_size (0), m_sentSize (0), m_firstByteSeq (n)
 {
 }
 
 TcpTxBuffer::~TcpTxBuffer (void)
 {
-  PacketList::iterator it;
-
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      TcpTxItem *item = *it;
-      m_sentSize -= item->m_packet->GetSize ();
-      delete item;
-    }
-
-  for (it = m_appList.begin (); it != m_appList.end (); ++it)
-    {
-      TcpTxItem *item = *it;
-      m_size -= item->m_packet->GetSize ();
-      delete item;
-    }
 }
 
 SequenceNumber32
@@ -163,12 +149,13 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 
   if (m_sentList.size () > 0)
     {
-      m_sentList.front ()->m_startSeq = seq;
+      m_sentList.begin ()->second.m_startSeq = seq;
     }
 
   // if you change the head with data already sent, something bad will happen
   NS_ASSERT (m_sentList.size () == 0);
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_highestSackValid = false;
+  m_highestSack = SequenceNumber32 (0);
 }
 
 bool
@@ -181,9 +168,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          TcpTxItem *item = new TcpTxItem ();
-          item->m_packet = p->Copy ();
-          m_appList.insert (m_appList.end (), item);
+          Chunk chunk;
+          chunk.offset = m_head + m_size;
+          chunk.packet = p->Copy ();
+          m_data.push_back (chunk);
           m_size += p->GetSize ();
 
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" <<
@@ -229,16 +217,15 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return Create<Packet> ();
     }
 
-  TcpTxItem *outItem = nullptr;
+  SentList::iterator outItem;
 
   if (m_firstByteSeq + m_sentSize >= seq + s)
     {
       // already sent this block completely
       outItem = GetTransmittedSegment (s, seq);
-      NS_ASSERT (outItem != nullptr);
-      NS_ASSERT (!outItem->m_sacked);
+      NS_ASSERT (!outItem->second.m_sacked);
 
-      NS_LOG_DEBUG ("Returning already sent item " << *outItem << " from " << *this);
+      NS_LOG_DEBUG ("Returning already sent item " << outItem->second << " from " << *this);
     }
   else if (m_firstByteSeq + m_sentSize <= seq)
     {
@@ -247,13 +234,11 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 
       // this is the first time we transmit this block
       outItem = GetNewSegment (s);
-      NS_ASSERT (outItem != nullptr);
-      NS_ASSERT (outItem->m_retrans == false);
+      NS_ASSERT (outItem->second.m_retrans == false);
 
-      NS_LOG_DEBUG ("Returning new item " << *outItem << " from " << *this);
+      NS_LOG_DEBUG ("Returning new item " << outItem->second << " from " << *this);
     }
-  else if (m_firstByteSeq.Get ().GetValue () + m_sentSize > seq.GetValue ()
-           && m_firstByteSeq.Get ().GetValue () + m_sentSize < seq.GetValue () + s)
+  else
     {
       // Partial: a part is retransmission, the remaining data is new
       // Just return the old segment, without taking new data. Hopefully
@@ -264,18 +249,72 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
       return CopyFromSequence (amount, seq);
     }
 
-  outItem->m_lastSent = Simulator::Now ();
-  Ptr<Packet> toRet = outItem->m_packet->Copy ();
+  outItem->second.m_lastSent = Simulator::Now ();
+  Ptr<Packet> toRet = CopyData (outItem->first, outItem->second.m_size);
 
   NS_ASSERT (toRet->GetSize () <= s);
-  NS_ASSERT_MSG (outItem->m_startSeq >= m_firstByteSeq,
-                 "Returning an item " << *outItem << " with SND.UNA as " <<
+  NS_ASSERT_MSG (outItem->second.m_startSeq >= m_firstByteSeq,
+                 "Returning an item " << outItem->second << " with SND.UNA as " <<
                  m_firstByteSeq);
   ConsistencyCheck ();
   return toRet;
 }
 
-TcpTxItem*
+uint64_t
+TcpTxBuffer::GetOffset (const SequenceNumber32 &seq) const
+{
+  NS_ASSERT (seq >= m_firstByteSeq);
+  return m_head + static_cast<uint32_t> (seq - m_firstByteSeq);
+}
+
+Ptr<Packet>
+TcpTxBuffer::CopyData (uint64_t offset, uint32_t size) const
+{
+  NS_LOG_FUNCTION (this << offset << size);
+  NS_ASSERT (offset >= m_head && offset + size <= m_head + m_size);
+
+  // Binary search of the last chunk starting at or before offset
+  std::size_t first = 0;
+  std::size_t last = m_data.size ();
+  while (last - first > 1)
+    {
+      std::size_t middle = first + (last - first) / 2;
+      if (m_data[middle].offset <= offset)
+        {
+          first = middle;
+        }
+      else
+        {
+          last = middle;
+        }
+    }
+
+  Ptr<Packet> p = nullptr;
+  for (std::size_t i = first; size > 0; ++i)
+    {
+      NS_ASSERT (i < m_data.size ());
+      const Chunk &chunk = m_data[i];
+      uint32_t chunkSize = chunk.packet->GetSize ();
+      uint32_t start = static_cast<uint32_t> (offset - chunk.offset);
+      uint32_t length = std::min (size, chunkSize - start);
+      // PacketTags are preserved when fragmenting
+      Ptr<Packet> fragment = (start == 0 && length == chunkSize) ?
+        chunk.packet->Copy () : chunk.packet->CreateFragment (start, length);
+      if (p == nullptr)
+        {
+          p = fragment;
+        }
+      else
+        {
+          p->AddAtEnd (fragment);
+        }
+      offset += length;
+      size -= length;
+    }
+  return p != nullptr ? p : Create<Packet> ();
+}
+
+TcpTxBuffer::SentList::iterator
 TcpTxBuffer::GetNewSegment (uint32_t numBytes)
 {
   NS_LOG_FUNCTION (this << numBytes);
@@ -284,23 +323,21 @@ TcpTxBuffer::GetNewSegment (uint32_t numBytes)
 
   NS_LOG_INFO ("AppList start at " << startOfAppList << ", sentSize = " <<
                m_sentSize << " firstByte: " << m_firstByteSeq);
+  NS_ASSERT (numBytes <= m_size - m_sentSize);
 
-  TcpTxItem *item = GetPacketFromList (m_appList, startOfAppList,
-                                       numBytes, startOfAppList);
-  item->m_startSeq = startOfAppList;
-
-  // Move item from AppList to SentList (should be the first, not too complex)
-  auto it = std::find (m_appList.begin (), m_appList.end (), item);
-  NS_ASSERT (it != m_appList.end ());
+  TcpTxItem item;
+  item.m_startSeq = startOfAppList;
+  item.m_size = numBytes;
 
-  m_appList.erase (it);
-  m_sentList.insert (m_sentList.end (), item);
-  m_sentSize += item->m_packet->GetSize ();
+  SentList::iterator it = m_sentList.insert (m_sentList.end (),
+                                             std::make_pair (m_head + m_sentSize, item));
+  IndexItem (it, true);
+  m_sentSize += numBytes;
 
-  return item;
+  return it;
 }
 
-TcpTxItem*
+TcpTxBuffer::SentList::iterator
 TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &seq)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
@@ -308,276 +345,109 @@ TcpTxBuffer::GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &s
   NS_ASSERT (numBytes <= m_sentSize);
   NS_ASSERT (m_sentList.size () >= 1);
 
-  auto it = m_sentList.begin ();
-  bool listEdited = false;
   uint32_t s = numBytes;
 
   // Avoid to merge different packet for this retransmission if flags are
   // different.
-  for (; it != m_sentList.end(); ++it)
+  SentList::iterator it = m_sentList.find (GetOffset (seq));
+  if (it != m_sentList.end ())
     {
-      if ((*it)->m_startSeq == seq)
+      SentList::iterator next = std::next (it);
+      if (next != m_sentList.end ())
         {
-          auto next = it;
-          next++;
-          if (next != m_sentList.end ())
+          // Next is not sacked... there is the possibility to merge
+          if (!next->second.m_sacked)
             {
-              // Next is not sacked... there is the possibility to merge
-              if (! (*next)->m_sacked)
-                {
-                  s = std::min(s, (*it)->m_packet->GetSize () + (*next)->m_packet->GetSize ());
-                }
-              else
-                {
-                  // Next is sacked... better to retransmit only the first segment
-                  s = std::min(s, (*it)->m_packet->GetSize ());
-                }
+              s = std::min (s, it->second.m_size + next->second.m_size);
             }
           else
             {
-              s = std::min(s, (*it)->m_packet->GetSize ());
+              // Next is sacked... better to retransmit only the first segment
+              s = std::min (s, it->second.m_size);
             }
-          break;
+        }
+      else
+        {
+          s = std::min (s, it->second.m_size);
         }
     }
 
-  TcpTxItem *item = GetPacketFromList (m_sentList, m_firstByteSeq, s, seq, &listEdited);
+  SentList::iterator item = GetSegment (s, seq);
 
-  if (! item->m_retrans)
+  if (!item->second.m_retrans)
     {
-      m_retrans += item->m_packet->GetSize ();
-      item->m_retrans = true;
+      SetFlags (item, item->second.m_lost, true, item->second.m_sacked);
     }
 
   return item;
 }
 
-std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
-TcpTxBuffer::FindHighestSacked () const
+TcpTxBuffer::SentList::iterator
+TcpTxBuffer::FindItem (uint64_t offset)
 {
-  NS_LOG_FUNCTION (this);
-
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
-  auto ret = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
-
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
-    {
-      const TcpTxItem *item = *it;
-      if (item->m_sacked)
-        {
-          ret = std::make_pair (it, beginOfCurrentPacket);
-        }
-      beginOfCurrentPacket += item->m_packet->GetSize ();
-    }
-
-  return ret;
+  SentList::iterator it = m_sentList.upper_bound (offset);
+  NS_ASSERT_MSG (it != m_sentList.begin (), "Offset " << offset << " before the sent list");
+  return --it;
 }
 
-
 void
-TcpTxBuffer::SplitItems (TcpTxItem *t1, TcpTxItem *t2, uint32_t size) const
+TcpTxBuffer::SplitItems (SentList::iterator t1, uint32_t size)
 {
-  NS_ASSERT (t1 != nullptr && t2 != nullptr);
-  NS_LOG_FUNCTION (this << *t2 << size);
+  NS_LOG_FUNCTION (this << t1->second << size);
+  NS_ASSERT (size > 0 && size < t1->second.m_size);
 
-  t1->m_packet = t2->m_packet->CreateFragment (0, size);
-  t2->m_packet->RemoveAtStart (size);
+  TcpTxItem t2 = t1->second;
+  t2.m_startSeq += size;
+  t2.m_size -= size;
+  t1->second.m_size = size;
 
-  t1->m_startSeq = t2->m_startSeq;
-  t1->m_sacked = t2->m_sacked;
-  t1->m_lastSent = t2->m_lastSent;
-  t1->m_retrans = t2->m_retrans;
-  t1->m_lost = t2->m_lost;
+  // The counts are in bytes, and both parts have the same flags
+  SentList::iterator next = m_sentList.insert (std::next (t1), std::make_pair (t1->first + size, t2));
+  IndexItem (next, true);
 
-  t2->m_startSeq += size;
-
-  NS_LOG_INFO ("Split of size " << size << " result: t1 " << *t1 << " t2 " << *t2);
+  NS_LOG_INFO ("Split of size " << size << " result: t1 " << t1->second << " t2 " << next->second);
 }
 
-TcpTxItem*
-TcpTxBuffer::GetPacketFromList (PacketList &list, const SequenceNumber32 &listStartFrom,
-                                uint32_t numBytes, const SequenceNumber32 &seq,
-                                bool *listEdited) const
+TcpTxBuffer::SentList::iterator
+TcpTxBuffer::GetSegment (uint32_t numBytes, const SequenceNumber32 &seq)
 {
   NS_LOG_FUNCTION (this << numBytes << seq);
 
-  /*
-   * Our possibilities are sketched out in the following:
-   *
-   *                    |------|     |----|     |----|
-   * GetList (m_data) = |      | --> |    | --> |    |
-   *                    |------|     |----|     |----|
-   *
-   *                    ^ ^ ^  ^
-   *                    | | |  |         (1)
-   *                  seq | |  numBytes
-   *                      | |
-   *                      | |
-   *                    seq numBytes     (2)
-   *
-   * (1) seq and numBytes are the boundary of some packet
-   * (2) seq and numBytes are not the boundary of some packet
-   *
-   * We can have mixed case (e.g. seq over the boundary while numBytes not).
-   *
-   * If we discover that we are in (2) or in a mixed case, we split
-   * packets accordingly to the requested bounds and re-run the function.
-   *
-   * In (1), things are pretty easy, it's just a matter of walking the list and
-   * defragment packets, if needed (e.g. seq is the beginning of the first packet
-   * while maxBytes is the end of some packet next in the list).
-   */
-
-  Ptr<Packet> currentPacket = nullptr;
-  TcpTxItem *currentItem = nullptr;
-  TcpTxItem *outItem = nullptr;
-  PacketList::iterator it = list.begin ();
-  SequenceNumber32 beginOfCurrentPacket = listStartFrom;
+  uint64_t offset = GetOffset (seq);
+  SentList::iterator it = FindItem (offset);
+  NS_ASSERT_MSG (offset < it->first + it->second.m_size, "Sequence " << seq << " not sent");
 
-  while (it != list.end ())
+  if (it->first < offset)
     {
-      currentItem = *it;
-      currentPacket = currentItem->m_packet;
-      NS_ASSERT_MSG (list != m_sentList || currentItem->m_startSeq >= m_firstByteSeq,
-                     "start: " << m_firstByteSeq << " currentItem start: " <<
-                     currentItem->m_startSeq);
-
-      // The objective of this snippet is to find (or to create) the packet
-      // that begin with the sequence seq
-
-      if (seq < beginOfCurrentPacket + currentPacket->GetSize ())
-        {
-          // seq is inside the current packet
-          if (seq == beginOfCurrentPacket)
-            {
-              // seq is the beginning of the current packet. Hurray!
-              outItem = currentItem;
-              NS_LOG_INFO ("Current packet starts at seq " << seq <<
-                           " ends at " << seq + currentPacket->GetSize ());
-            }
-          else if (seq > beginOfCurrentPacket)
-            {
-              // seq is inside the current packet but seq is not the beginning,
-              // it's somewhere in the middle. Just fragment the beginning and
-              // start again.
-              NS_LOG_INFO ("we are at " << beginOfCurrentPacket <<
-                           " searching for " << seq <<
-                           " and now we recurse because packet ends at "
-                                        << beginOfCurrentPacket + currentPacket->GetSize ());
-              TcpTxItem *firstPart = new TcpTxItem ();
-              SplitItems (firstPart, currentItem, seq - beginOfCurrentPacket);
-
-              // insert firstPart before currentItem
-              list.insert (it, firstPart);
-              if (listEdited)
-                {
-                  *listEdited = true;
-                }
+      // seq is inside the segment but it is not the beginning, it's somewhere
+      // in the middle. Split the beginning, and go on with the second part.
+      NS_LOG_INFO ("we are at " << it->second.m_startSeq << " searching for " << seq);
+      SplitItems (it, static_cast<uint32_t> (offset - it->first));
+      ++it;
+    }
 
-              return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
-            }
-          else
-            {
-              NS_FATAL_ERROR ("seq < beginOfCurrentPacket: our data is before");
-            }
-        }
-      else
+  // The segment starts at seq. Merge the following segments into it until it
+  // covers the requested block, then split what exceeds.
+  while (it->second.m_size < numBytes)
+    {
+      if (std::next (it) == m_sentList.end ())
         {
-          // Walk the list, the current packet does not contain seq
-          beginOfCurrentPacket += currentPacket->GetSize ();
-          it++;
-          continue;
+          // ...current is the last segment we sent. We have not more data;
+          // Go for this one.
+          NS_LOG_WARN ("Cannot reach the end, but this case is covered "
+                       "with conditional statements inside CopyFromSequence."
+                       "Something has gone wrong, report a bug");
+          return it;
         }
+      MergeItems (it);
+    }
 
-      NS_ASSERT (outItem != nullptr);
-
-      // The objective of this snippet is to find (or to create) the packet
-      // that ends after numBytes bytes. We are sure that outPacket starts
-      // at seq.
-
-      if (seq + numBytes <= beginOfCurrentPacket + currentPacket->GetSize ())
-        {
-          // the end boundary is inside the current packet
-          if (numBytes == currentPacket->GetSize ())
-            {
-              // the end boundary is exactly the end of the current packet. Hurray!
-              if (currentItem->m_packet == outItem->m_packet)
-                {
-                  // A perfect match!
-                  return outItem;
-                }
-              else
-                {
-                  // the end is exactly the end of current packet, but
-                  // current > outPacket in the list. Merge current with the
-                  // previous, and recurse.
-                  NS_ASSERT (it != list.begin ());
-                  TcpTxItem *previous = *(--it);
-
-                  list.erase (it);
-
-                  MergeItems (previous, currentItem);
-                  delete currentItem;
-                  if (listEdited)
-                    {
-                      *listEdited = true;
-                    }
-
-                  return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
-                }
-            }
-          else if (numBytes < currentPacket->GetSize ())
-            {
-              // the end is inside the current packet, but it isn't exactly
-              // the packet end. Just fragment, fix the list, and return.
-              TcpTxItem *firstPart = new TcpTxItem ();
-              SplitItems (firstPart, currentItem, numBytes);
-
-              // insert firstPart before currentItem
-              list.insert (it, firstPart);
-              if (listEdited)
-                {
-                  *listEdited = true;
-                }
-
-              return firstPart;
-            }
-        }
-      else
-        {
-          // The end isn't inside current packet, but there is an exception for
-          // the merge and recurse strategy...
-          if (++it == list.end ())
-            {
-              // ...current is the last packet we sent. We have not more data;
-              // Go for this one.
-              NS_LOG_WARN ("Cannot reach the end, but this case is covered "
-                           "with conditional statements inside CopyFromSequence."
-                           "Something has gone wrong, report a bug");
-              return outItem;
-            }
-
-          // The current packet does not contain the requested end. Merge current
-          // with the packet that follows, and recurse
-          TcpTxItem *next = (*it); // Please remember we have incremented it
-                                   // in the previous if
-
-          MergeItems (currentItem, next);
-          list.erase (it);
-
-          delete next;
-
-          if (listEdited)
-            {
-              *listEdited = true;
-            }
-
-          return GetPacketFromList (list, listStartFrom, numBytes, seq, listEdited);
-        }
+  if (it->second.m_size > numBytes)
+    {
+      SplitItems (it, numBytes);
     }
 
-  NS_FATAL_ERROR ("This point is not reachable");
+  return it;
 }
 
 static bool AreEquals (const bool &first, const bool &second)
@@ -586,68 +456,137 @@ static bool AreEquals (const bool &first, const bool &second)
 }
 
 void
-TcpTxBuffer::MergeItems (TcpTxItem *t1, TcpTxItem *t2) const
+TcpTxBuffer::MergeItems (SentList::iterator t1)
 {
-  NS_ASSERT (t1 != nullptr && t2 != nullptr);
-  NS_LOG_FUNCTION (this << *t1 << *t2);
-  NS_LOG_INFO ("Merging " << *t2 << " into " << *t1);
+  SentList::iterator t2 = std::next (t1);
+  NS_ASSERT (t2 != m_sentList.end ());
+  NS_LOG_FUNCTION (this << t1->second << t2->second);
+  NS_LOG_INFO ("Merging " << t2->second << " into " << t1->second);
 
-  NS_ASSERT_MSG (AreEquals (t1->m_sacked, t2->m_sacked),
+  NS_ASSERT_MSG (AreEquals (t1->second.m_sacked, t2->second.m_sacked),
                  "Merging one sacked and another not sacked. Impossible");
-  NS_ASSERT_MSG (AreEquals (t1->m_lost, t2->m_lost),
+  NS_ASSERT_MSG (AreEquals (t1->second.m_lost, t2->second.m_lost),
                  "Merging one lost and another not lost. Impossible");
 
   // If one is retrans and the other is not, cancel the retransmitted flag.
   // We are merging this segment for the retransmit, so the count will
   // be updated in GetTransmittedSegment.
-  if (! AreEquals (t1->m_retrans, t2->m_retrans))
+  if (! AreEquals (t1->second.m_retrans, t2->second.m_retrans))
     {
-      if (t1->m_retrans)
+      if (t1->second.m_retrans)
         {
-          TcpTxBuffer *self = const_cast<TcpTxBuffer*> (this);
-          self->m_retrans -= t1->m_packet->GetSize ();
-          t1->m_retrans = false;
+          SetFlags (t1, t1->second.m_lost, false, t1->second.m_sacked);
         }
       else
         {
-          NS_ASSERT (t2->m_retrans);
-          TcpTxBuffer *self = const_cast<TcpTxBuffer*> (this);
-          self->m_retrans -= t2->m_packet->GetSize ();
-          t2->m_retrans = false;
+          NS_ASSERT (t2->second.m_retrans);
+          SetFlags (t2, t2->second.m_lost, false, t2->second.m_sacked);
         }
     }
 
-  if (t1->m_lastSent < t2->m_lastSent)
+  if (t1->second.m_lastSent < t2->second.m_lastSent)
     {
-      t1->m_lastSent = t2->m_lastSent;
+      t1->second.m_lastSent = t2->second.m_lastSent;
     }
 
-  t1->m_packet->AddAtEnd (t2->m_packet);
+  // The counts are in bytes, and both segments have the same flags
+  t1->second.m_size += t2->second.m_size;
+  IndexItem (t2, false);
+  m_sentList.erase (t2);
 
-  NS_LOG_INFO ("Situation after the merge: " << *t1);
+  NS_LOG_INFO ("Situation after the merge: " << t1->second);
+}
+
+/**
+ * \brief Add or remove a key from an index
+ * \param index the index
+ * \param key the key
+ * \param member true if the key must be in the index
+ */
+static void
+UpdateIndex (std::set<uint64_t> &index, uint64_t key, bool member)
+{
+  if (member)
+    {
+      index.insert (key);
+    }
+  else
+    {
+      index.erase (key);
+    }
+}
+
+void
+TcpTxBuffer::IndexItem (SentList::const_iterator it, bool add)
+{
+  const TcpTxItem &item = it->second;
+  UpdateIndex (m_sackedItems, it->first, add && item.m_sacked);
+  UpdateIndex (m_leftOutItems, it->first, add && (item.m_lost || item.m_sacked));
+  UpdateIndex (m_rtxItems, it->first, add && item.m_lost && !item.m_retrans && !item.m_sacked);
+  UpdateIndex (m_pendingItems, it->first, add && !item.m_retrans && !item.m_sacked);
 }
 
 void
-TcpTxBuffer::RemoveFromCounts (TcpTxItem *item, uint32_t size)
+TcpTxBuffer::SetFlags (SentList::iterator it, bool lost, bool retrans, bool sacked)
 {
-  NS_LOG_FUNCTION (this << *item << size);
-  if (item->m_sacked)
+  TcpTxItem &item = it->second;
+  if (item.m_lost != lost)
+    {
+      NS_ASSERT_MSG (lost || m_lostOut >= item.m_size, "Trying to remove " << item.m_size <<
+                     " bytes from " << m_lostOut);
+      m_lostOut = lost ? m_lostOut + item.m_size : m_lostOut - item.m_size;
+      item.m_lost = lost;
+    }
+  if (item.m_retrans != retrans)
+    {
+      NS_ASSERT (retrans || m_retrans >= item.m_size);
+      m_retrans = retrans ? m_retrans + item.m_size : m_retrans - item.m_size;
+      item.m_retrans = retrans;
+    }
+  if (item.m_sacked != sacked)
+    {
+      NS_ASSERT (sacked || m_sackedOut >= item.m_size);
+      m_sackedOut = sacked ? m_sackedOut + item.m_size : m_sackedOut - item.m_size;
+      item.m_sacked = sacked;
+    }
+  IndexItem (it, true);
+
+  if (!lost && !sacked && it->first < m_lostMark)
+    {
+      m_lostMark = it->first;
+    }
+}
+
+void
+TcpTxBuffer::RemoveFromCounts (const TcpTxItem &item, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << item << size);
+  if (item.m_sacked)
     {
       NS_ASSERT (m_sackedOut >= size);
       m_sackedOut -= size;
     }
-  if (item->m_retrans)
+  if (item.m_retrans)
     {
       NS_ASSERT (m_retrans >= size);
       m_retrans -= size;
     }
-  if (item->m_lost)
+  if (item.m_lost)
     {
       NS_ASSERT_MSG (m_lostOut >= size, "Trying to remove " << size <<
                      " bytes from " << m_lostOut);
       m_lostOut -= size;
     }
 }
+
+void
+TcpTxBuffer::RemoveItem (SentList::iterator it)
+{
+  RemoveFromCounts (it->second, it->second.m_size);
+  IndexItem (it, false);
+  m_sentList.erase (it);
+}
+
 void
 TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 {
@@ -662,62 +601,70 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   NS_LOG_DEBUG ("Remove up to " << seq << " lost: " << m_lostOut <<
                 " retrans: " << m_retrans << " sacked: " << m_sackedOut);
 
-  // Scan the buffer and discard packets
+  // Discard the segments from the head of the sent list
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
   uint32_t pktSize;
-  PacketList::iterator i = m_sentList.begin ();
   while (m_size > 0 && offset > 0)
     {
-      if (i == m_sentList.end ())
+      if (m_sentList.empty ())
         {
-          // Move data from app list to sent list, so we can delete the item
-          Ptr<Packet> p = CopyFromSequence (offset, m_firstByteSeq);
-          NS_ASSERT (p != nullptr);
-          NS_UNUSED (p);
-          i = m_sentList.begin ();
-          NS_ASSERT (i != m_sentList.end ());
+          // The data has not been sent as a segment: just discard it
+          pktSize = std::min (offset, m_size);
+          m_size -= pktSize;
+          offset -= pktSize;
+          m_firstByteSeq += pktSize;
+          m_head += pktSize;
+          continue;
         }
-      TcpTxItem *item = *i;
-      Ptr<Packet> p = item->m_packet;
-      pktSize = p->GetSize ();
-      NS_ASSERT_MSG (item->m_startSeq == m_firstByteSeq,
-                     "Item starts at " << item->m_startSeq <<
+      SentList::iterator i = m_sentList.begin ();
+      TcpTxItem item = i->second;
+      pktSize = item.m_size;
+      NS_ASSERT_MSG (item.m_startSeq == m_firstByteSeq,
+                     "Item starts at " << item.m_startSeq <<
                      " while SND.UNA is " << m_firstByteSeq << " from " << *this);
 
       if (offset >= pktSize)
-        { // This packet is behind the seqnum. Remove this packet from the buffer
+        { // This segment is behind the seqnum. Remove it from the buffer
           m_size -= pktSize;
           m_sentSize -= pktSize;
           offset -= pktSize;
           m_firstByteSeq += pktSize;
+          m_head += pktSize;
 
-          RemoveFromCounts (item, pktSize);
-
-          i = m_sentList.erase (i);
-          NS_LOG_INFO ("Removed " << *item << " lost: " << m_lostOut <<
+          RemoveItem (i);
+          NS_LOG_INFO ("Removed " << item << " lost: " << m_lostOut <<
                        " retrans: " << m_retrans << " sacked: " << m_sackedOut <<
                        ". Remaining data " << m_size);
-          delete item;
         }
       else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
+        { // Part of the segment is behind the seqnum. Move its start
           pktSize -= offset;
-          NS_LOG_INFO (*item);
-          // PacketTags are preserved when fragmenting
-          item->m_packet = item->m_packet->CreateFragment (offset, pktSize);
-          item->m_startSeq += offset;
+          NS_LOG_INFO (item);
+          RemoveFromCounts (item, offset);
+          IndexItem (i, false);
+          m_sentList.erase (i);
+
+          item.m_startSeq += offset;
+          item.m_size = pktSize;
           m_size -= offset;
           m_sentSize -= offset;
           m_firstByteSeq += offset;
-
-          RemoveFromCounts (item, offset);
+          m_head += offset;
+          IndexItem (m_sentList.insert (m_sentList.begin (), std::make_pair (m_head, item)), true);
 
           NS_LOG_INFO ("Fragmented one packet by size " << offset <<
                        ", new size=" << pktSize << " resulting item is " <<
-                       *item << " status: " << *this);
+                       item << " status: " << *this);
           break;
         }
     }
+
+  // Release the application packets which are acknowledged entirely
+  while (!m_data.empty () && m_data.front ().offset + m_data.front ().packet->GetSize () <= m_head)
+    {
+      m_data.pop_front ();
+    }
+
   // Catching the case of ACKing a FIN
   if (m_size == 0)
     {
@@ -726,28 +673,28 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 
   if (!m_sentList.empty ())
     {
-      TcpTxItem *head = m_sentList.front ();
-      if (head->m_sacked)
+      SentList::iterator head = m_sentList.begin ();
+      if (head->second.m_sacked)
         {
-          NS_ASSERT (!head->m_lost);
+          NS_ASSERT (!head->second.m_lost);
           // It is not possible to have the UNA sacked; otherwise, it would
           // have been ACKed. This is, most likely, our wrong guessing
           // when adding Reno dupacks in the count.
-          head->m_sacked = false;
-          m_sackedOut -= head->m_packet->GetSize ();
+          SetFlags (head, false, head->second.m_retrans, false);
           NS_LOG_INFO ("Moving the SACK flag from the HEAD to another segment");
           AddRenoSack ();
           MarkHeadAsLost ();
         }
 
-      NS_ASSERT_MSG (head->m_startSeq == seq,
+      NS_ASSERT_MSG (head->second.m_startSeq == seq,
                      "While removing up to " << seq << " we get SND.UNA to " <<
                      m_firstByteSeq << " this is the result: " << *this);
     }
 
-  if (m_highestSack.second <= m_firstByteSeq)
+  if (m_highestSack <= m_firstByteSeq)
     {
-      m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+      m_highestSackValid = false;
+      m_highestSack = SequenceNumber32 (0);
     }
 
   NS_LOG_DEBUG ("Discarded up to " << seq << " lost: " << m_lostOut <<
@@ -768,18 +715,24 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
 
   for (auto option_it = list.begin (); option_it != list.end (); ++option_it)
     {
-      PacketList::iterator item_it = m_sentList.begin ();
-      SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-
       if (m_firstByteSeq + m_sentSize < (*option_it).first && !modified)
         {
           NS_LOG_INFO ("Not updating scoreboard, the option block is outside the sent list");
           return false;
         }
 
+      // Start from the first segment which may be covered by the block
+      SentList::iterator item_it = m_sentList.begin ();
+      if ((*option_it).first > m_firstByteSeq)
+        {
+          item_it = m_sentList.lower_bound (GetOffset ((*option_it).first));
+        }
+
       while (item_it != m_sentList.end ())
         {
-          uint32_t pktSize = (*item_it)->m_packet->GetSize ();
+          TcpTxItem &item = item_it->second;
+          SequenceNumber32 beginOfCurrentPacket = item.m_startSeq;
+          uint32_t pktSize = item.m_size;
 
           // Check the boundary of this packet ... only mark as sacked if
           // it is precisely mapped over the option. It means that if the receiver
@@ -789,34 +742,29 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
           if (beginOfCurrentPacket >= (*option_it).first
               && beginOfCurrentPacket + pktSize <= (*option_it).second)
             {
-              if ((*item_it)->m_sacked)
+              if (item.m_sacked)
                 {
-                  NS_ASSERT (!(*item_it)->m_lost);
+                  NS_ASSERT (!item.m_lost);
                   NS_LOG_INFO ("Received block " << *option_it <<
-                               ", checking sentList for block " << *(*item_it) <<
+                               ", checking sentList for block " << item <<
                                ", found in the sackboard already sacked");
                 }
               else
                 {
-                  if ((*item_it)->m_lost)
-                    {
-                      (*item_it)->m_lost = false;
-                      m_lostOut -= (*item_it)->m_packet->GetSize ();
-                    }
-
-                  (*item_it)->m_sacked = true;
-                  m_sackedOut += (*item_it)->m_packet->GetSize ();
+                  SetFlags (item_it, false, item.m_retrans, true);
 
-                  if (m_highestSack.first == m_sentList.end()
-                      || m_highestSack.second <= beginOfCurrentPacket + pktSize)
+                  if (!m_highestSackValid
+                      || m_highestSack <= beginOfCurrentPacket + pktSize)
                     {
-                      m_highestSack = std::make_pair (item_it, beginOfCurrentPacket);
+                      m_highestSackValid = true;
+                      m_highestSackOffset = item_it->first;
+                      m_highestSack = beginOfCurrentPacket;
                     }
 
                   NS_LOG_INFO ("Received block " << *option_it <<
-                               ", checking sentList for block " << *(*item_it) <<
+                               ", checking sentList for block " << item <<
                                ", found in the sackboard, sacking, current highSack: " <<
-                               m_highestSack.second);
+                               m_highestSack);
                 }
               modified = true;
             }
@@ -824,23 +772,22 @@ TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
             {
               // We already passed the received block end. Exit from the loop
               NS_LOG_INFO ("Received block [" << *option_it <<
-                           ", checking sentList for block " << *(*item_it) <<
+                           ", checking sentList for block " << item <<
                            "], not found, breaking loop");
               break;
             }
 
-          beginOfCurrentPacket += pktSize;
           ++item_it;
         }
     }
 
   if (modified)
     {
-      NS_ASSERT_MSG (modified && m_highestSack.first != m_sentList.end(), "Buffer status: " << *this);
+      NS_ASSERT_MSG (modified && m_highestSackValid, "Buffer status: " << *this);
       UpdateLostCount ();
     }
 
-  NS_ASSERT ((*(m_sentList.begin ()))->m_sacked == false);
+  NS_ASSERT (m_sentList.empty () || m_sentList.begin ()->second.m_sacked == false);
   NS_ASSERT_MSG (m_sentSize >= m_sackedOut + m_lostOut, *this);
   //NS_ASSERT (list.size () == 0 || modified);   // Assert for duplicated SACK or
                                                  // impossiblity to map the option into the sent blocks
@@ -852,46 +799,59 @@ void
 TcpTxBuffer::UpdateLostCount ()
 {
   NS_LOG_FUNCTION (this);
-  uint32_t sacked = 0;
-  SequenceNumber32 beginOfCurrentPacket = m_highestSack.second;
-  if (m_highestSack.first == m_sentList.end ())
+  SentList::iterator highest = FindItem (m_highestSackOffset);
+  NS_LOG_INFO ("Status before the update: " << *this <<
+               ", will start from item " << highest->second);
+
+  // Walking down from the highest sacked segment, find the segment at which
+  // dupAckThresh sacked segments (the head excluded) have been counted: the
+  // segments below it are lost, unless sacked.
+  uint64_t head = m_sentList.begin ()->first;
+  uint64_t limit = 0;
+  bool reached = false;
+  if (m_dupAckThresh == 0)
     {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from the latest sent item");
+      reached = true;
+      limit = highest->first + 1;
     }
   else
     {
-      NS_LOG_INFO ("Status before the update: " << *this <<
-                   ", will start from item " << *(*m_highestSack.first));
-    }
-
-  for (auto it = m_highestSack.first; it != m_sentList.begin(); --it)
-    {
-      TcpTxItem *item = *it;
-      if (item->m_sacked)
+      uint32_t sacked = 0;
+      ItemIndex::const_iterator it = m_sackedItems.upper_bound (highest->first);
+      while (it != m_sackedItems.begin ())
         {
-          sacked++;
+          --it;
+          if (*it <= head)
+            {
+              break;
+            }
+          if (++sacked >= m_dupAckThresh)
+            {
+              reached = true;
+              limit = *it;
+              break;
+            }
         }
+    }
 
-      if (sacked >= m_dupAckThresh)
+  if (reached)
+    {
+      // The segments below m_lostMark are already lost or sacked
+      for (SentList::iterator it = m_sentList.lower_bound (std::max (m_lostMark, head + 1));
+           it != m_sentList.end () && it->first < limit; ++it)
         {
-          if (!item->m_sacked && !item->m_lost)
+          if (!it->second.m_sacked && !it->second.m_lost)
             {
-              item->m_lost = true;
-              m_lostOut += item->m_packet->GetSize ();
+              SetFlags (it, true, it->second.m_retrans, false);
             }
         }
-      beginOfCurrentPacket -= item->m_packet->GetSize ();
-    }
 
-  if (sacked >= m_dupAckThresh)
-    {
-      TcpTxItem *item = *m_sentList.begin ();
-      if (!item->m_lost)
+      SentList::iterator first = m_sentList.begin ();
+      if (!first->second.m_lost)
         {
-          item->m_lost = true;
-          m_lostOut += item->m_packet->GetSize ();
+          SetFlags (first, true, first->second.m_retrans, first->second.m_sacked);
         }
+      m_lostMark = std::max (m_lostMark, limit);
     }
   NS_LOG_INFO ("Status after the update: " << *this);
   ConsistencyCheck ();
@@ -902,37 +862,29 @@ TcpTxBuffer::IsLost (const SequenceNumber32 &seq) const
 {
   NS_LOG_FUNCTION (this << seq);
 
-  SequenceNumber32 beginOfCurrentPacket = m_firstByteSeq;
-  PacketList::const_iterator it;
-
-  if (seq >= m_highestSack.second)
+  if (seq >= m_highestSack)
     {
       return false;
     }
 
-  // In theory, using a map and hints when inserting elements can improve
-  // performance
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  // The first segment starting at or after seq which is lost or sacked
+  // gives the answer
+  uint64_t offset = seq > m_firstByteSeq ? GetOffset (seq) : m_head;
+  ItemIndex::const_iterator it = m_leftOutItems.lower_bound (offset);
+  if (it == m_leftOutItems.end ())
     {
-      // Search for the right iterator before calling IsLost()
-      if (beginOfCurrentPacket >= seq)
-        {
-          if ((*it)->m_lost == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
-              return true;
-            }
-
-          if ((*it)->m_sacked == true)
-            {
-              NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
-              return false;
-            }
-        }
+      return false;
+    }
 
-      beginOfCurrentPacket += (*it)->m_packet->GetSize ();
+  const TcpTxItem &item = m_sentList.find (*it)->second;
+  if (item.m_lost)
+    {
+      NS_LOG_INFO ("seq=" << seq << " is lost because of lost flag");
+      return true;
     }
 
+  NS_ASSERT (item.m_sacked);
+  NS_LOG_INFO ("seq=" << seq << " is not lost because of sacked flag");
   return false;
 }
 
@@ -954,35 +906,11 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *
    *     (1.c) IsLost (S2) returns true.
    */
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  SequenceNumber32 seqPerRule3;
-  bool isSeqPerRule3Valid = false;
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
-
-  for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  if (!m_rtxItems.empty ())
     {
-      item = *it;
-
-      // Condition 1.a , 1.b , and 1.c
-      if (item->m_retrans == false && item->m_sacked == false)
-        {
-          if (item->m_lost)
-            {
-              NS_LOG_INFO("IsLost, returning" << beginOfCurrentPkt);
-              *seq = beginOfCurrentPkt;
-              return true;
-            }
-          else if (seqPerRule3.GetValue () == 0 && isRecovery)
-            {
-              NS_LOG_INFO ("Saving for rule 3 the seq " << beginOfCurrentPkt);
-              isSeqPerRule3Valid = true;
-              seqPerRule3 = beginOfCurrentPkt;
-            }
-        }
-
-      // Nothing found, iterate
-      beginOfCurrentPkt += item->m_packet->GetSize ();
+      *seq = m_sentList.find (*m_rtxItems.begin ())->second.m_startSeq;
+      NS_LOG_INFO ("IsLost, returning" << *seq);
+      return true;
     }
 
   /* (2) If no sequence number 'S2' per rule (1) exists but there
@@ -1008,6 +936,15 @@ TcpTxBuffer::NextSeg (SequenceNumber32 *seq, bool isRecovery) const
    *     (specifically excluding step (1.c)), then one segment of up to
    *     SMSS octets starting with S3 SHOULD be returned.
    */
+  SequenceNumber32 seqPerRule3;
+  bool isSeqPerRule3Valid = false;
+  for (ItemIndex::const_iterator it = m_pendingItems.begin ();
+       isRecovery && it != m_pendingItems.end () && seqPerRule3.GetValue () == 0; ++it)
+    {
+      isSeqPerRule3Valid = true;
+      seqPerRule3 = m_sentList.find (*it)->second.m_startSeq;
+    }
+
   if (isSeqPerRule3Valid)
     {
       NS_LOG_INFO ("Rule3 valid. " << seqPerRule3);
@@ -1056,10 +993,8 @@ TcpTxBuffer::BytesInFlight () const
 uint32_t
 TcpTxBuffer::BytesInFlightRFC () const
 {
-  PacketList::const_iterator it;
-  TcpTxItem *item;
+  SentList::const_iterator it;
   uint32_t size = 0; // "pipe" in RFC
-  SequenceNumber32 beginOfCurrentPkt = m_firstByteSeq;
   uint32_t sackedOut = 0;
   uint32_t lostOut = 0;
   uint32_t retrans = 0;
@@ -1070,39 +1005,38 @@ TcpTxBuffer::BytesInFlightRFC () const
   // been SACKed:
   for (it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
-      item = *it;
-      totalSize += item->m_packet->GetSize();
-      if (!item->m_sacked)
+      const TcpTxItem &item = it->second;
+      totalSize += item.m_size;
+      if (!item.m_sacked)
         {
-          bool isLost = IsLostRFC (beginOfCurrentPkt, it);
+          bool isLost = IsLostRFC (item.m_startSeq, it);
           // (a) If IsLost (S1) returns false: Pipe is incremented by 1 octet.
           if (!isLost)
             {
-              size += item->m_packet->GetSize ();
+              size += item.m_size;
             }
           // (b) If S1 <= HighRxt: Pipe is incremented by 1 octet.
           // (NOTE: we use the m_retrans flag instead of keeping and updating
           // another variable). Only if the item is not marked as lost
-          else if (item->m_retrans)
+          else if (item.m_retrans)
             {
-              size += item->m_packet->GetSize ();
+              size += item.m_size;
             }
 
           if (isLost)
             {
-              lostOut += item->m_packet->GetSize ();
+              lostOut += item.m_size;
             }
         }
       else
         {
-          sackedOut += item->m_packet->GetSize ();
+          sackedOut += item.m_size;
         }
 
-      if (item->m_retrans)
+      if (item.m_retrans)
         {
-          retrans += item->m_packet->GetSize ();
+          retrans += item.m_size;
         }
-      beginOfCurrentPkt += item->m_packet->GetSize ();
     }
 
   NS_ASSERT_MSG(lostOut == m_lostOut, "Lost counted: " << lostOut << " " <<
@@ -1118,17 +1052,15 @@ TcpTxBuffer::BytesInFlightRFC () const
 }
 
 bool
-TcpTxBuffer::IsLostRFC (const SequenceNumber32 &seq, const PacketList::const_iterator &segment) const
+TcpTxBuffer::IsLostRFC (const SequenceNumber32 &seq, const SentList::const_iterator &segment) const
 {
   NS_LOG_FUNCTION (this << seq);
   uint32_t count = 0;
   uint32_t bytes = 0;
-  PacketList::const_iterator it;
-  TcpTxItem *item;
-  Ptr<const Packet> current;
+  SentList::const_iterator it;
   SequenceNumber32 beginOfCurrentPacket = seq;
 
-  if ((*segment)->m_sacked == true)
+  if (segment->second.m_sacked == true)
     {
       return false;
     }
@@ -1140,15 +1072,14 @@ TcpTxBuffer::IsLostRFC (const SequenceNumber32 &seq, const PacketList::const_ite
   // > routine returns false.
   for (it = segment; it != m_sentList.end (); ++it)
     {
-      item = *it;
-      current = item->m_packet;
+      const TcpTxItem &item = it->second;
 
-      if (item->m_sacked)
+      if (item.m_sacked)
         {
-          NS_LOG_INFO ("Segment " << *item <<
+          NS_LOG_INFO ("Segment " << item <<
                        " found to be SACKed while checking for " << seq);
           ++count;
-          bytes += current->GetSize ();
+          bytes += item.m_size;
           if ((count >= m_dupAckThresh) || (bytes > (m_dupAckThresh-1) * m_segmentSize))
             {
               NS_LOG_INFO ("seq=" << seq << " is lost because of 3 sacked blocks ahead");
@@ -1156,20 +1087,20 @@ TcpTxBuffer::IsLostRFC (const SequenceNumber32 &seq, const PacketList::const_ite
             }
         }
 
-      if (beginOfCurrentPacket >= m_highestSack.second)
+      if (beginOfCurrentPacket >= m_highestSack)
         {
-          if (item->m_lost && !item->m_retrans)
+          if (item.m_lost && !item.m_retrans)
             return true;
 
           NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead");
           return false;
         }
 
-      beginOfCurrentPacket += current->GetSize ();
+      beginOfCurrentPacket += item.m_size;
     }
-  if (it == m_highestSack.first)
+  if (!m_highestSackValid)
     {
-      NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead " << m_highestSack.second);
+      NS_LOG_INFO ("seq=" << seq << " is not lost because there are no sacked segment ahead " << m_highestSack);
     }
   return false;
 }
@@ -1179,35 +1110,37 @@ TcpTxBuffer::ResetRenoSack ()
 {
   NS_LOG_FUNCTION (this);
 
-  m_sackedOut = 0;
-  for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
+  while (!m_sackedItems.empty ())
     {
-      (*it)->m_sacked = false;
+      SentList::iterator it = m_sentList.find (*m_sackedItems.begin ());
+      SetFlags (it, it->second.m_lost, it->second.m_retrans, false);
     }
+  NS_ASSERT (m_sackedOut == 0);
 
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_highestSackValid = false;
+  m_highestSack = SequenceNumber32 (0);
 }
 
 void
 TcpTxBuffer::ResetSentList ()
 {
   NS_LOG_FUNCTION (this);
-  TcpTxItem *item;
 
-  // Keep the head items; they will then marked as lost
-  while (m_sentList.size () > 0)
-    {
-      item = m_sentList.back ();
-      item->m_retrans = item->m_sacked = item->m_lost = false;
-      m_appList.push_front (item);
-      m_sentList.pop_back ();
-    }
+  // The data stays in the payload store; it will be sent again as new
+  // segments
+  m_sentList.clear ();
+  m_sackedItems.clear ();
+  m_leftOutItems.clear ();
+  m_rtxItems.clear ();
+  m_pendingItems.clear ();
 
   m_sentSize = 0;
   m_lostOut = 0;
   m_retrans = 0;
   m_sackedOut = 0;
-  m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
+  m_lostMark = 0;
+  m_highestSackValid = false;
+  m_highestSack = SequenceNumber32 (0);
 }
 
 void
@@ -1216,15 +1149,9 @@ TcpTxBuffer::ResetLastSegmentSent ()
   NS_LOG_FUNCTION (this);
   if (!m_sentList.empty ())
     {
-      TcpTxItem *item = m_sentList.back ();
-
-      m_sentList.pop_back ();
-      m_sentSize -= item->m_packet->GetSize ();
-      if (item->m_retrans)
-        {
-          m_retrans -= item->m_packet->GetSize ();
-        }
-      m_appList.insert (m_appList.begin (), item);
+      SentList::iterator it = std::prev (m_sentList.end ());
+      m_sentSize -= it->second.m_size;
+      RemoveItem (it);
     }
   ConsistencyCheck ();
 }
@@ -1233,42 +1160,25 @@ void
 TcpTxBuffer::SetSentListLost (bool resetSack)
 {
   NS_LOG_FUNCTION (this);
-  m_retrans = 0;
 
   if (resetSack)
     {
-      m_sackedOut = 0;
-      m_lostOut = m_sentSize;
-      m_highestSack = std::make_pair (m_sentList.end (), SequenceNumber32 (0));
-    }
-  else
-    {
-      m_lostOut = 0;
+      m_highestSackValid = false;
+      m_highestSack = SequenceNumber32 (0);
     }
 
   for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
+      const TcpTxItem &item = it->second;
       if (resetSack)
         {
-          (*it)->m_sacked = false;
-          (*it)->m_lost = true;
+          SetFlags (it, true, false, false);
         }
       else
         {
-          if ((*it)->m_lost)
-            {
-              // Have to increment it because we set it to 0 at line 1133
-              m_lostOut += (*it)->m_packet->GetSize ();
-            }
-          else if (!(*it)->m_sacked)
-            {
-              // Packet is not marked lost, nor is sacked. Then it becomes lost.
-              (*it)->m_lost = true;
-              m_lostOut += (*it)->m_packet->GetSize ();
-            }
+          // A segment not marked lost, nor sacked, becomes lost.
+          SetFlags (it, item.m_lost || !item.m_sacked, false, item.m_sacked);
         }
-
-      (*it)->m_retrans = false;
     }
 
   NS_LOG_INFO ("Set sent list lost, status: " << *this);
@@ -1286,7 +1196,7 @@ TcpTxBuffer::IsHeadRetransmitted () const
       return false;
     }
 
-  return m_sentList.front ()->m_retrans;
+  return m_sentList.begin ()->second.m_retrans;
 }
 
 void
@@ -1299,11 +1209,8 @@ TcpTxBuffer::DeleteRetransmittedFlagFromHead ()
       return;
     }
 
-  if (m_sentList.front ()->m_retrans)
-    {
-      m_sentList.front ()->m_retrans = false;
-      m_retrans -= m_sentList.front ()->m_packet->GetSize ();
-    }
+  SentList::iterator head = m_sentList.begin ();
+  SetFlags (head, head->second.m_lost, false, head->second.m_sacked);
   ConsistencyCheck ();
 }
 
@@ -1315,23 +1222,8 @@ TcpTxBuffer::MarkHeadAsLost ()
       // If the head is sacked (reneging by the receiver the previously sent
       // information) we revert the sacked flag.
       // A sacked head means that we should advance SND.UNA.. so it's an error.
-      if (m_sentList.front ()->m_sacked)
-        {
-          m_sentList.front ()->m_sacked = false;
-          m_sackedOut -= m_sentList.front ()->m_packet->GetSize ();
-        }
-
-      if (m_sentList.front ()->m_retrans)
-        {
-          m_sentList.front ()->m_retrans = false;
-          m_retrans -= m_sentList.front ()->m_packet->GetSize ();
-        }
-
-      if (! m_sentList.front()->m_lost)
-        {
-          m_sentList.front()->m_lost = true;
-          m_lostOut += m_sentList.front ()->m_packet->GetSize ();
-        }
+      // The retransmitted flag is cleared as well.
+      SetFlags (m_sentList.begin (), true, false, false);
     }
   ConsistencyCheck ();
 }
@@ -1345,10 +1237,10 @@ TcpTxBuffer::AddRenoSack (void)
   m_renoSack = true;
 
   // We can _never_ SACK the head, so start from the second segment sent
-  auto it = ++m_sentList.begin ();
+  auto it = std::next (m_sentList.begin ());
 
   // Find the "highest sacked" point, that is SND.UNA + m_sackedOut
-  while (it != m_sentList.end () && (*it)->m_sacked)
+  while (it != m_sentList.end () && it->second.m_sacked)
     {
       ++it;
     }
@@ -1356,9 +1248,10 @@ TcpTxBuffer::AddRenoSack (void)
   // Add to the sacked size the size of the first "not sacked" segment
   if (it != m_sentList.end ())
     {
-      (*it)->m_sacked = true;
-      m_sackedOut += (*it)->m_packet->GetSize ();
-      m_highestSack = std::make_pair (it, (*it)->m_startSeq);
+      SetFlags (it, it->second.m_lost, it->second.m_retrans, true);
+      m_highestSackValid = true;
+      m_highestSackOffset = it->first;
+      m_highestSack = it->second.m_startSeq;
       NS_LOG_INFO ("Added a Reno SACK, status: " << *this);
     }
   else
@@ -1386,18 +1279,26 @@ TcpTxBuffer::ConsistencyCheck () const
 
   for (auto it = m_sentList.begin (); it != m_sentList.end (); ++it)
     {
-      if ((*it)->m_sacked)
+      const TcpTxItem &item = it->second;
+      if (item.m_sacked)
         {
-          sacked += (*it)->m_packet->GetSize ();
+          sacked += item.m_size;
         }
-      if ((*it)->m_lost)
+      if (item.m_lost)
         {
-          lost += (*it)->m_packet->GetSize ();
+          lost += item.m_size;
         }
-      if ((*it)->m_retrans)
+      if (item.m_retrans)
         {
-          retrans += (*it)->m_packet->GetSize ();
+          retrans += item.m_size;
         }
+      NS_ASSERT_MSG (item.m_sacked == (m_sackedItems.count (it->first) == 1)
+                     && (item.m_lost || item.m_sacked) == (m_leftOutItems.count (it->first) == 1)
+                     && (item.m_lost && !item.m_retrans && !item.m_sacked) == (m_rtxItems.count (it->first) == 1)
+                     && (!item.m_retrans && !item.m_sacked) == (m_pendingItems.count (it->first) == 1),
+                     "Index out of sync for " << item);
+      NS_ASSERT_MSG (it->first >= m_lostMark || item.m_lost || item.m_sacked,
+                     "Item " << item << " below the lost mark");
     }
 
   NS_ASSERT_MSG (sacked == m_sackedOut, "Counted SACK: " << sacked <<
@@ -1418,25 +1319,15 @@ operator<< (std::ostream & os, TcpTxItem const & item)
 std::ostream &
 operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf)
 {
-  TcpTxBuffer::PacketList::const_iterator it;
   std::stringstream ss;
-  SequenceNumber32 beginOfCurrentPacket = tcpTxBuf.m_firstByteSeq;
-  uint32_t sentSize = 0, appSize = 0;
+  uint32_t sentSize = 0;
 
-  Ptr<Packet> p;
-  for (it = tcpTxBuf.m_sentList.begin (); it != tcpTxBuf.m_sentList.end (); ++it)
+  for (auto it = tcpTxBuf.m_sentList.begin (); it != tcpTxBuf.m_sentList.end (); ++it)
     {
-      p = (*it)->m_packet;
       ss << "{";
-      (*it)->Print (ss);
+      it->second.Print (ss);
       ss << "}";
-      sentSize += p->GetSize ();
-      beginOfCurrentPacket += p->GetSize ();
-    }
-
-  for (it = tcpTxBuf.m_appList.begin (); it != tcpTxBuf.m_appList.end (); ++it)
-    {
-      appSize += (*it)->m_packet->GetSize ();
+      sentSize += it->second.m_size;
     }
 
   os << "Sent list: " << ss.str () << ", size = " << tcpTxBuf.m_sentList.size () <<
@@ -1448,7 +1339,9 @@ operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf)
     " m_sackedOut = " << tcpTxBuf.m_sackedOut;
 
   NS_ASSERT (sentSize == tcpTxBuf.m_sentSize);
-  NS_ASSERT (tcpTxBuf.m_size - tcpTxBuf.m_sentSize == appSize);
+  NS_ASSERT (tcpTxBuf.m_data.empty ()
+             || tcpTxBuf.m_data.back ().offset + tcpTxBuf.m_data.back ().packet->GetSize ()
+             == tcpTxBuf.m_head + tcpTxBuf.m_size);
   return os;
 }
 
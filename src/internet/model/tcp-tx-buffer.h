@@ -22,6 +22,9 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
+#include <map>
+#include <set>
+#include <deque>
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
 #include "ns3/sequence-number.h"
@@ -35,7 +38,7 @@ class Packet;
 /**
  * \ingroup tcp
  *
- * \brief Item that encloses the application packet and some flags for it
+ * \brief Scoreboard entry of a segment sent, with its flags
  */
 class TcpTxItem
 {
@@ -51,12 +54,12 @@ public:
   /**
    * \brief Get the size in the sequence number space
    *
-   * \return 1 if the packet size is 0 or there's no packet, otherwise the size of the packet
+   * \return 1 if the segment size is 0, otherwise the size of the segment
    */
-  uint32_t GetSeqSize (void) const { return m_packet && m_packet->GetSize () > 0 ? m_packet->GetSize () : 1; }
+  uint32_t GetSeqSize (void) const { return m_size > 0 ? m_size : 1; }
 
   SequenceNumber32 m_startSeq {0};     //!< Sequence number of the item (if transmitted)
-  Ptr<Packet> m_packet {nullptr};    //!< Application packet (can be null)
+  uint32_t m_size      {0};          //!< Size of the segment, in bytes
   bool m_lost          {false};      //!< Indicates if the segment has been lost (RTO)
   bool m_retrans       {false};      //!< Indicates if the segment is retransmitted
   Time m_lastSent      {Time::Min()};//!< Timestamp of the time at which the segment has been sent last time
@@ -80,12 +83,16 @@ public:
  * class is allowed to return only ordered (using "<" as operator) subsets
  * (e.g. 1,2 or 2,3 or 1,2,3).
  *
- * The data structure underlying this is composed by two distinct packet lists.
- * The first (SentList) is initially empty, and it contains the packets
- * returned by the method CopyFromSequence. The second (AppList) is initially
- * empty, and it contains the packets coming from the applications, but that
- * are not transmitted yet as segments. To discover how the chunks are managed
- * and retrieved from these lists, check CopyFromSequence documentation.
+ * The data structure underlying this is composed by two distinct parts.
+ * The payload store keeps the packets coming from the application, in order,
+ * as a ring of chunks indexed by their offset in the byte stream; segments
+ * are cut from it on demand, and chunks are released as soon as they are
+ * acknowledged. The scoreboard (SentList) is initially empty, and it contains
+ * one TcpTxItem, without any payload, for each segment returned by the method
+ * CopyFromSequence, ordered by stream offset. Looking up the segment holding a
+ * sequence number is therefore logarithmic in the number of segments in
+ * flight. To discover how the segments are managed, check CopyFromSequence
+ * documentation.
  *
  * The head of the data is represented by m_firstByteSeq, and it is returned by
  * HeadSequence(). The last byte is returned by TailSequence(). In this class,
@@ -96,14 +103,14 @@ public:
  * ---------------
  *
  * The SACK information is usually saved in a data structure referred as
- * scoreboard. In this implementation, the scoreboard is developed on top of
- * the existing classes. In particular, instead of keeping raw pointers to
- * packets in TcpTxBuffer we added the capability to store some flags
- * associated with every segment sent. This is done through the use of the
- * class TcpTxItem: instead of storing a list of packets, we store a list of
- * TcpTxItem. Each item has different flags (check the corresponding
- * documentation) and maintaining the scoreboard is a matter of travelling the
- * list and set the SACK flag on the corresponding segment sent.
+ * scoreboard. In this implementation, the scoreboard stores the flags
+ * associated with every segment sent in a TcpTxItem (check the corresponding
+ * documentation). Besides the items, the scoreboard keeps ordered indexes of
+ * the segments which are sacked, lost or sacked, waiting for a
+ * retransmission, and neither sacked nor retransmitted. Processing a SACK
+ * block only visits the segments it covers; the lost segments, the next
+ * segment to retransmit (NextSeg) and the loss of a sequence (IsLost) are
+ * found through the indexes, without walking the whole sent list.
  *
  * Item properties
  * ---------------
@@ -409,7 +416,17 @@ public:
 private:
   friend std::ostream & operator<< (std::ostream & os, TcpTxBuffer const & tcpTxBuf);
 
-  typedef std::list<TcpTxItem*> PacketList; //!< container for data stored in the buffer
+  /// Scoreboard: the segments sent, by stream offset of their first byte
+  typedef std::map<uint64_t, TcpTxItem> SentList;
+  /// Index of segments, by stream offset of their first byte
+  typedef std::set<uint64_t> ItemIndex;
+
+  /// A packet coming from the application
+  struct Chunk
+  {
+    uint64_t offset;     //!< stream offset of the first byte of the packet
+    Ptr<Packet> packet;  //!< the packet
+  };
 
   /**
    * \brief Update the lost count
@@ -426,21 +443,66 @@ private:
    * The {New}Reno cases, for now, are managed in TcpSocketBase through the
    * call to MarkHeadAsLost.
    * This function is, therefore, called after a SACK option has been received,
-   * and updates the lost count. It can be probably optimized by not walking
-   * the entire list, but a subset.
+   * and updates the lost count. The segments below m_lostMark are known to be
+   * lost or sacked already, so that only the segments between the mark and
+   * the threshold found in the SACK index are visited.
    *
    */
   void UpdateLostCount ();
 
   /**
-   * \brief Remove the size specified from the lostOut, retrans, sacked count
+   * \brief Set the flags of a segment sent
    *
-   * Used only in DiscardUpTo
+   * Update the lostOut, retrans and sacked counts and the indexes accordingly.
    *
-   * \param item Item that will be discarded
-   * \param size size to remove (can be different from pktSize because of fragmentation)
+   * \param it the segment
+   * \param lost the new lost flag
+   * \param retrans the new retransmitted flag
+   * \param sacked the new sacked flag
+   */
+  void SetFlags (SentList::iterator it, bool lost, bool retrans, bool sacked);
+
+  /**
+   * \brief Add or remove a segment from the indexes
+   * \param it the segment
+   * \param add true to add it, false to remove it
+   */
+  void IndexItem (SentList::const_iterator it, bool add);
+
+  /**
+   * \brief Remove the bytes of a segment from the lost, retrans and sacked counts
+   * \param item the segment
+   * \param size the number of bytes to remove
+   */
+  void RemoveFromCounts (const TcpTxItem &item, uint32_t size);
+
+  /**
+   * \brief Remove a segment from the sent list, with its counts
+   * \param it the segment
+   */
+  void RemoveItem (SentList::iterator it);
+
+  /**
+   * \brief Get the segment holding a stream offset
+   * \param offset the stream offset, inside the sent list
+   * \return the segment
+   */
+  SentList::iterator FindItem (uint64_t offset);
+
+  /**
+   * \brief Convert a sequence number into a stream offset
+   * \param seq the sequence number, not before the head of the buffer
+   * \return the stream offset
    */
-  void RemoveFromCounts (TcpTxItem *item, uint32_t size);
+  uint64_t GetOffset (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Copy a block of the payload store into a packet
+   * \param offset stream offset of the first byte
+   * \param size number of bytes
+   * \return the packet
+   */
+  Ptr<Packet> CopyData (uint64_t offset, uint32_t size) const;
 
   /**
    * \brief Decide if a segment is lost based on RFC 6675 algorithm.
@@ -448,7 +510,7 @@ private:
    * \param segment Iterator to the sequence
    * \return true if seq is lost per RFC 6675, false otherwise
    */
-  bool IsLostRFC (const SequenceNumber32 &seq, const PacketList::const_iterator &segment) const;
+  bool IsLostRFC (const SequenceNumber32 &seq, const SentList::const_iterator &segment) const;
 
   /**
    * \brief Calculate the number of bytes in flight per RFC 6675
@@ -459,18 +521,14 @@ private:
   /**
    * \brief Get a block of data not transmitted yet and move it into SentList
    *
-   * If the block is not yet transmitted, hopefully, seq is exactly the sequence
-   * number of the first byte of the first packet inside AppList. We extract
-   * the block from AppList and move it into the SentList, before returning the
-   * block itself. We manage possible fragmentation (or merges) inside AppList
-   * through GetPacketFromList.
+   * The block starts at the end of the sent list; a new segment of numBytes
+   * bytes is appended to the scoreboard.
    *
-   * \see GetPacketFromList
    * \param numBytes number of bytes to copy
    *
-   * \return the item that contains the right packet
+   * \return the new segment
    */
-  TcpTxItem* GetNewSegment (uint32_t numBytes);
+  SentList::iterator GetNewSegment (uint32_t numBytes);
 
   /**
    * \brief Get a block of data previously transmitted
@@ -478,21 +536,18 @@ private:
    * This is clearly a retransmission, and if everything is going well,
    * the block requested is matching perfectly with another one requested
    * in the past. If not, fragmentation or merge are required. We manage
-   * both inside GetPacketFromList.
+   * both inside GetSegment.
    *
-   * \see GetPacketFromList
+   * \see GetSegment
    *
    * \param numBytes number of bytes to copy
    * \param seq sequence requested
-   * \returns the item that contains the right packet
+   * \returns the segment
    */
-  TcpTxItem* GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &seq);
+  SentList::iterator GetTransmittedSegment (uint32_t numBytes, const SequenceNumber32 &seq);
 
   /**
-   * \brief Get a block (which is returned as Packet) from a list
-   *
-   * This function extract a block [requestedSeq,numBytes) from the list, which
-   * starts at startingSeq.
+   * \brief Get the segment [seq, seq + numBytes) from the sent list
    *
    * The cases we need to manage are two, and they are depicted in the following
    * image:
@@ -510,81 +565,43 @@ private:
                       seq   seq + numBytes     (2)
    \endverbatim
    *
-   * The case 1 is easy to manage: the requested block is exactly a packet
-   * already stored. If one value (seq or seq + numBytes) does not align
-   * to a packet boundary, or when both values does not align (case 2), it is
-   * a bit more complex.
-   *
-   * Basically, we have two possible operations:
-   *
-   *  - fragment : split an existing packet in two
-   *  - merge    : merge two existing packets in one
-   *
-   * and we reduce case (2) to case (1) through sequentially applying fragment
-   * or merge. For instance:
-   *
-   *\verbatim
-      |------|
-      |      |
-      |------|
-
-      ^ ^  ^ ^
-      | |  | |
-  start |  | |
-        |  | end
-       seq |
-           seq + numBytes
-   \endverbatim
-   *
-   * To reduce to case (1), we need to perform two fragment operations:
-   *
-   * - fragment (start, seq)
-   * - fragment (seq + numBytes, end)
+   * The case 1 is easy to manage: the requested block is exactly a segment
+   * already sent. If one value (seq or seq + numBytes) does not align
+   * to a segment boundary, or when both values does not align (case 2), we
+   * split the segment holding the boundary in two, copying its flags, or
+   * merge the following segments into the first one until the block is
+   * covered. Only the segments of the block are visited.
    *
-   * After these operations, the requested block is exactly the resulting packet.
-   * Merge operation is required when the requested block span over two (or more)
-   * existing packets.
+   * If the sent list ends before seq + numBytes, the returned segment is
+   * shorter than requested.
    *
-   * While this could be extremely slow in the worst possible scenario (one big
-   * packet which is split in small packets for transmission, and merged for
-   * re-transmission) that scenario is unlikely during a TCP transmission (since
-   * MSS can change, but it is stable, and retransmissions do not happen for
-   * each segment).
-   *
-   * \param list List to extract block from
-   * \param startingSeq Starting sequence of the list
-   * \param numBytes Bytes to extract, starting from requestedSeq
-   * \param requestedSeq Requested sequence
-   * \param listEdited output parameter which indicates if the list has been edited
-   * \return the item that contains the right packet
+   * \param numBytes Bytes to extract, starting from seq
+   * \param seq Requested sequence
+   * \return the segment starting at seq
    */
-  TcpTxItem* GetPacketFromList (PacketList &list, const SequenceNumber32 &startingSeq,
-                                uint32_t numBytes, const SequenceNumber32 &requestedSeq,
-                                bool *listEdited = nullptr) const;
+  SentList::iterator GetSegment (uint32_t numBytes, const SequenceNumber32 &seq);
 
   /**
-   * \brief Merge two TcpTxItem
+   * \brief Merge the segment following t1 into t1
    *
-   * Merge t2 in t1. It consists in copying the lastSent field if t2 is more
-   * recent than t1. Retransmitted field is copied only if it set in t2 but not
-   * in t1. Sacked is copied only if it is true in both items.
+   * It consists in copying the lastSent field if t2 is more
+   * recent than t1. Retransmitted field is cleared if it differs between
+   * the two segments. Sacked and lost must be the same in both segments.
    *
-   * \param t1 first item
-   * \param t2 second item
+   * \param t1 first segment
    */
-  void MergeItems (TcpTxItem *t1, TcpTxItem *t2) const;
+  void MergeItems (SentList::iterator t1);
 
   /**
-   * \brief Split one TcpTxItem
+   * \brief Split one segment
    *
-   * Move "size" bytes from t2 into t1, copying all the fields.
-   * Adjust the starting sequence of each item.
+   * Keep the first "size" bytes in t1 and move the others in a new segment,
+   * which follows t1 and has the same flags.
    *
-   * \param t1 first item
-   * \param t2 second item
-   * \param size Size to split
+   * \param t1 segment to split
+   * \param size size of the first part
    */
-  void SplitItems (TcpTxItem *t1, TcpTxItem *t2, uint32_t size) const;
+  void SplitItems (SentList::iterator t1, uint32_t size);
 
   /**
    * \brief Check if the values of sacked, lost, retrans, are in sync
@@ -592,21 +609,23 @@ private:
    */
   void ConsistencyCheck () const;
 
-  /**
-   * \brief Find the highest SACK byte
-   * \return a pair with the highest byte and an iterator inside m_sentList
-   */
-  std::pair <TcpTxBuffer::PacketList::const_iterator, SequenceNumber32>
-  FindHighestSacked () const;
-
-  PacketList m_appList;  //!< Buffer for application data
-  PacketList m_sentList; //!< Buffer for sent (but not acked) data
+  std::deque<Chunk> m_data; //!< Payload store: application data, not yet acknowledged
+  uint64_t m_head;          //!< Stream offset of m_firstByteSeq
+  SentList m_sentList;      //!< Scoreboard of the sent (but not acked) data
   uint32_t m_maxBuffer;  //!< Max number of data bytes in buffer (SND.WND)
   uint32_t m_size;       //!< Size of all data in this buffer
   uint32_t m_sentSize;   //!< Size of sent (and not discarded) segments
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
-  std::pair <PacketList::const_iterator, SequenceNumber32> m_highestSack; //!< Highest SACK byte
+  bool m_highestSackValid {false};        //!< Whether a segment has been sacked
+  uint64_t m_highestSackOffset {0};      //!< Stream offset of the highest sacked segment
+  SequenceNumber32 m_highestSack {0};    //!< First sequence of the highest sacked segment
+
+  ItemIndex m_sackedItems;   //!< Segments sacked
+  ItemIndex m_leftOutItems;  //!< Segments lost or sacked
+  ItemIndex m_rtxItems;      //!< Segments lost, neither retransmitted nor sacked
+  ItemIndex m_pendingItems;  //!< Segments neither retransmitted nor sacked
+  uint64_t m_lostMark {0};   //!< The segments before this stream offset are lost or sacked
 
   uint32_t m_lostOut   {0}; //!< Number of lost bytes
   uint32_t m_sackedOut {0}; //!< Number of sacked bytes
@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv6-end-point-demux.h"
+#include "ns3/ipv6-end-point.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the IPv4 end point demultiplexer.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up a packet and return the single matching end point.
+   * \param demux the demultiplexer
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \return the end point, or 0 if none matches
+   */
+  Ipv4EndPoint * Lookup (Ipv4EndPointDemux &demux, const char *daddr, uint16_t dport,
+                         const char *saddr, uint16_t sport);
+
+  Ptr<Ipv4Interface> m_interface; //!< incoming interface, 10.1.1.1/24
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv4 end point lookups")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4EndPointDemux &demux, const char *daddr, uint16_t dport,
+                                   const char *saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (Ipv4Address (daddr), dport,
+                                                         Ipv4Address (saddr), sport, m_interface);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->AddAddress (Ipv4InterfaceAddress (Ipv4Address ("10.1.1.1"), Ipv4Mask ("255.255.255.0")));
+
+  Ipv4EndPointDemux demux;
+  Ipv4EndPoint *listener = demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Unable to allocate a listening end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 80, "10.1.1.2", 1234), listener, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 81, "10.1.1.2", 1234), 0, "Wrong end point");
+
+  // A connected end point takes precedence over the listener
+  Ipv4EndPoint *connected = demux.Allocate (0, Ipv4Address ("10.1.1.1"), 80, Ipv4Address ("10.1.1.2"), 1234);
+  NS_TEST_ASSERT_MSG_NE (connected, 0, "Unable to allocate a connected end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 80, "10.1.1.2", 1234), connected, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 80, "10.1.1.2", 1235), listener, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, Ipv4Address ("10.1.1.1"), 80, Ipv4Address ("10.1.1.2"), 1234), 0,
+                         "Allocated a duplicate end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, 80), 0, "Allocated a duplicate end point");
+
+  // Many connections on the same port
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint16_t i = 0; i < 1000; ++i)
+    {
+      connections.push_back (demux.Allocate (0, Ipv4Address ("10.1.1.1"), 80, Ipv4Address ("10.2.0.1"), 2000 + i));
+    }
+  bool match = true;
+  for (uint16_t i = 0; i < 1000; ++i)
+    {
+      match = match && Lookup (demux, "10.1.1.1", 80, "10.2.0.1", 2000 + i) == connections[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ (match, true, "Wrong end point for a connection");
+  for (uint16_t i = 0; i < 1000; i += 2)
+    {
+      demux.DeAllocate (connections[i]);
+    }
+  match = true;
+  for (uint16_t i = 0; i < 1000; ++i)
+    {
+      match = match && Lookup (demux, "10.1.1.1", 80, "10.2.0.1", 2000 + i) == (i % 2 ? connections[i] : listener);
+    }
+  NS_TEST_EXPECT_MSG_EQ (match, true, "Wrong end point after deallocation");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 502, "Wrong number of end points");
+
+  // An ephemeral end point connected after its allocation
+  Ipv4EndPoint *client = demux.Allocate ();
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", port, "10.1.1.3", 5000), client, "Wrong end point");
+  client->SetPeer (Ipv4Address ("10.1.1.3"), 5000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", port, "10.1.1.3", 5000), client, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", port, "10.1.1.4", 5000), 0, "Wrong end point");
+  client->SetLocalAddress (Ipv4Address ("10.1.1.1"));
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", port, "10.1.1.3", 5000), client, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.5", port, "10.1.1.3", 5000), 0, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv4Address ("10.1.1.1"), port, Ipv4Address ("10.1.1.3"), 5000),
+                         client, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), true, "Port not in use");
+
+  // An end point bound to the subnet receives the subnet-directed broadcasts
+  Ipv4EndPoint *subnet = demux.Allocate (0, Ipv4Address ("10.1.1.0"), 90, Ipv4Address ("10.1.1.2"), 7);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.255", 90, "10.1.1.2", 7), subnet, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.2.255", 90, "10.1.1.2", 7), 0, "Wrong end point");
+
+  demux.DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Port still in use");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 80, "10.1.1.2", 1235), 0, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.1.1.1", 80, "10.1.1.2", 1234), connected, "Wrong end point");
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the IPv6 end point demultiplexer.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up a packet and return the single matching end point.
+   * \param demux the demultiplexer
+   * \param daddr the destination address
+   * \param dport the destination port
+   * \param saddr the source address
+   * \param sport the source port
+   * \return the end point, or 0 if none matches
+   */
+  Ipv6EndPoint * Lookup (Ipv6EndPointDemux &demux, const char *daddr, uint16_t dport,
+                         const char *saddr, uint16_t sport);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Check the IPv6 end point lookups")
+{
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::Lookup (Ipv6EndPointDemux &demux, const char *daddr, uint16_t dport,
+                                   const char *saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints endPoints = demux.Lookup (Ipv6Address (daddr), dport,
+                                                         Ipv6Address (saddr), sport, 0);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6EndPoint *listener = demux.Allocate (0, 80);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Unable to allocate a listening end point");
+  Ipv6EndPoint *bound = demux.Allocate (0, Ipv6Address ("2001::1"), 80);
+  NS_TEST_ASSERT_MSG_NE (bound, 0, "Unable to allocate a bound end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", 80, "2001::2", 1234), bound, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::3", 80, "2001::2", 1234), listener, "Wrong end point");
+
+  Ipv6EndPoint *connected = demux.Allocate (0, Ipv6Address ("2001::1"), 80, Ipv6Address ("2001::2"), 1234);
+  NS_TEST_ASSERT_MSG_NE (connected, 0, "Unable to allocate a connected end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", 80, "2001::2", 1234), connected, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", 80, "2001::2", 1235), bound, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, Ipv6Address ("2001::1"), 80, Ipv6Address ("2001::2"), 1234), 0,
+                         "Allocated a duplicate end point");
+
+  Ipv6EndPoint *client = demux.Allocate (Ipv6Address ("2001::1"));
+  uint16_t port = client->GetLocalPort ();
+  client->SetPeer (Ipv6Address ("2001::5"), 5000);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", port, "2001::5", 5000), client, "Wrong end point");
+  client->SetLocalPort (port + 1);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", port, "2001::5", 5000), 0, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", port + 1, "2001::5", 5000), client, "Wrong end point");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (Ipv6Address ("2001::1"), port + 1, Ipv6Address ("2001::5"), 5000),
+                         client, "Wrong end point");
+
+  demux.DeAllocate (connected);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", 80, "2001::2", 1234), bound, "Wrong end point");
+  demux.DeAllocate (bound);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "2001::1", 80, "2001::2", 1234), listener, "Wrong end point");
+  demux.DeAllocate (listener);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (80), false, "Port still in use");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetEndPoints ().size (), 1, "Wrong number of end points");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief End point demultiplexer TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite ();
+};
+
+EndPointDemuxTestSuite::EndPointDemuxTestSuite ()
+  : TestSuite ("end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
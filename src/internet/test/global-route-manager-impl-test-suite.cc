@@ -27,6 +27,7 @@
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
 #include <cstdlib> // for rand()
+#include <map>
 
 using namespace ns3;
 
@@ -57,20 +58,36 @@ void
 GlobalRouteManagerImplTestCase::DoRun (void)
 {
   CandidateQueue candidate;
+  std::map<SPFVertex *, int> order;
 
   for (int i = 0; i < 100; ++i)
     {
       SPFVertex *v = new SPFVertex;
-      v->SetDistanceFromRoot (std::rand () % 100);
+      v->SetDistanceFromRoot (std::rand () % 20);
       candidate.Push (v);
+      order[v] = i;
     }
 
+  // Vertices come out by distance, and in order of arrival at equal
+  // distances
+  SPFVertex *previous = 0;
   for (int i = 0; i < 100; ++i)
     {
       SPFVertex *v = candidate.Pop ();
-      delete v;
-      v = 0;
+      if (previous != 0)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((previous->GetDistanceFromRoot () <= v->GetDistanceFromRoot ()), true,
+                                 "Candidates out of order");
+          if (previous->GetDistanceFromRoot () == v->GetDistanceFromRoot ())
+            {
+              NS_TEST_ASSERT_MSG_LT (order[previous], order[v], "Equal candidates out of order");
+            }
+          delete previous;
+        }
+      previous = v;
     }
+  delete previous;
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Candidates left in the queue");
 
   // Build fake link state database; four routers (0-3), 3 point-to-point
   // links
@@ -40,6 +40,7 @@
 #include "ns3/ipv4-routing-helper.h"
 
 #include "ns3/traffic-control-layer.h"
+#include "ns3/config.h"
 
 #include <string>
 #include <limits>
@@ -218,6 +219,189 @@ Ipv4ForwardingTest::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 Forwarding Header Test
+ *
+ * Packets cross two routers. Each router must decrement the TTL and keep
+ * the header checksum valid. The first router must fire its Tx trace with
+ * the forwarded header, and with a priority tag only if the TOS of the
+ * packet gives a non-null priority.
+ */
+class Ipv4ForwardingHeaderTest : public TestCase
+{
+public:
+  virtual void DoRun (void);
+  Ipv4ForwardingHeaderTest ();
+
+private:
+  /**
+   * \brief Add a device to a node and give it an address.
+   * \param node The node.
+   * \param address The address.
+   * \return The device.
+   */
+  Ptr<SimpleNetDevice> AddDevice (Ptr<Node> node, const char *address);
+  /**
+   * \brief Send a packet.
+   * \param socket The sending socket.
+   */
+  void SendPacket (Ptr<Socket> socket);
+  /**
+   * \brief Check a packet transmitted by the first router.
+   * \param p The packet, with its IP header.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface.
+   */
+  void RouterTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Check a packet received by the receiver.
+   * \param p The packet, with its IP header.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface.
+   */
+  void ReceiverRx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+  /**
+   * \brief Check the IP header and the priority tag of a packet.
+   * \param p The packet, with its IP header.
+   * \param ttl The expected TTL.
+   * \param checkTag Whether the priority tag is checked.
+   */
+  void CheckPacket (Ptr<const Packet> p, uint8_t ttl, bool checkTag);
+
+  uint8_t m_tos;       //!< TOS of the packets sent
+  uint32_t m_routerTx; //!< Number of packets transmitted by the first router
+  uint32_t m_received; //!< Number of packets received by the receiver
+};
+
+Ipv4ForwardingHeaderTest::Ipv4ForwardingHeaderTest ()
+  : TestCase ("IPv4 header and priority tag of forwarded packets"),
+    m_tos (0),
+    m_routerTx (0),
+    m_received (0)
+{
+}
+
+Ptr<SimpleNetDevice>
+Ipv4ForwardingHeaderTest::AddDevice (Ptr<Node> node, const char *address)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+  node->AddDevice (device);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t netdev_idx = ipv4->AddInterface (device);
+  ipv4->AddAddress (netdev_idx, Ipv4InterfaceAddress (Ipv4Address (address), Ipv4Mask (0xffff0000U)));
+  ipv4->SetUp (netdev_idx);
+  return device;
+}
+
+void
+Ipv4ForwardingHeaderTest::SendPacket (Ptr<Socket> socket)
+{
+  InetSocketAddress to (Ipv4Address ("10.0.0.2"), 1234);
+  to.SetTos (m_tos);
+  NS_TEST_EXPECT_MSG_EQ (socket->SendTo (Create<Packet> (123), 0, to), 123, "Packet not sent");
+}
+
+void
+Ipv4ForwardingHeaderTest::CheckPacket (Ptr<const Packet> p, uint8_t ttl, bool checkTag)
+{
+  Ipv4Header header;
+  header.EnableChecksum ();
+  p->PeekHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (header.IsChecksumOk (), true, "Wrong checksum");
+  NS_TEST_EXPECT_MSG_EQ (header.GetTtl (), ttl, "Wrong TTL");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (header.GetTos ()), unsigned (m_tos), "Wrong TOS");
+  NS_TEST_EXPECT_MSG_EQ (p->GetSize (), header.GetSerializedSize () + 8 + 123, "Wrong size");
+  if (!checkTag)
+    {
+      return;
+    }
+
+  uint8_t priority = Socket::IpTos2Priority (m_tos);
+  SocketPriorityTag priorityTag;
+  NS_TEST_EXPECT_MSG_EQ (p->PeekPacketTag (priorityTag), (priority != 0), "Wrong priority tag");
+  if (priority)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (priorityTag.GetPriority ()), unsigned (priority), "Wrong priority");
+    }
+}
+
+void
+Ipv4ForwardingHeaderTest::RouterTx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_routerTx++;
+  CheckPacket (p, 63, true);
+}
+
+void
+Ipv4ForwardingHeaderTest::ReceiverRx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_received++;
+  // single queue devices remove the priority tag before sending
+  CheckPacket (p, 62, false);
+}
+
+void
+Ipv4ForwardingHeaderTest::DoRun (void)
+{
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (true));
+
+  // txNode -- fwNode1 -- fwNode2 -- rxNode
+  Ptr<Node> txNode = CreateObject<Node> ();
+  Ptr<Node> fwNode1 = CreateObject<Node> ();
+  Ptr<Node> fwNode2 = CreateObject<Node> ();
+  Ptr<Node> rxNode = CreateObject<Node> ();
+
+  InternetStackHelper internet;
+  internet.SetIpv6StackInstall (false);
+  internet.Install (txNode);
+  internet.Install (fwNode1);
+  internet.Install (fwNode2);
+  internet.Install (rxNode);
+
+  Ptr<SimpleChannel> channel1 = CreateObject<SimpleChannel> ();
+  AddDevice (txNode, "10.1.0.2")->SetChannel (channel1);
+  AddDevice (fwNode1, "10.1.0.1")->SetChannel (channel1);
+  Ptr<SimpleChannel> channel2 = CreateObject<SimpleChannel> ();
+  AddDevice (fwNode1, "10.2.0.1")->SetChannel (channel2);
+  AddDevice (fwNode2, "10.2.0.2")->SetChannel (channel2);
+  Ptr<SimpleChannel> channel3 = CreateObject<SimpleChannel> ();
+  AddDevice (fwNode2, "10.0.0.1")->SetChannel (channel3);
+  AddDevice (rxNode, "10.0.0.2")->SetChannel (channel3);
+
+  Ipv4RoutingHelper::GetRouting <Ipv4StaticRouting> (txNode->GetObject<Ipv4> ()->GetRoutingProtocol ())
+    ->SetDefaultRoute (Ipv4Address ("10.1.0.1"), 1);
+  Ipv4RoutingHelper::GetRouting <Ipv4StaticRouting> (fwNode1->GetObject<Ipv4> ()->GetRoutingProtocol ())
+    ->AddNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask (0xffff0000U), Ipv4Address ("10.2.0.2"), 2);
+
+  fwNode1->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Tx", MakeCallback (&Ipv4ForwardingHeaderTest::RouterTx, this));
+  rxNode->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&Ipv4ForwardingHeaderTest::ReceiverRx, this));
+
+  Ptr<Socket> rxSocket = rxNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+  NS_TEST_EXPECT_MSG_EQ (rxSocket->Bind (InetSocketAddress (Ipv4Address ("10.0.0.2"), 1234)), 0, "trivial");
+  Ptr<Socket> txSocket = txNode->GetObject<UdpSocketFactory> ()->CreateSocket ();
+
+  // A TOS giving a non-null priority, then a null TOS
+  uint8_t tos[] = { 0x10, 0 };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      m_tos = tos[i];
+      Simulator::ScheduleWithContext (txNode->GetId (), Seconds (0),
+                                      &Ipv4ForwardingHeaderTest::SendPacket, this, txSocket);
+      Simulator::Run ();
+      NS_TEST_EXPECT_MSG_EQ (m_routerTx, i + 1, "Packet not forwarded by the first router");
+      NS_TEST_EXPECT_MSG_EQ (m_received, i + 1, "Packet not received");
+    }
+
+  Simulator::Destroy ();
+  Config::SetGlobal ("ChecksumEnabled", BooleanValue (false));
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -235,6 +419,7 @@ Ipv4ForwardingTestSuite::Ipv4ForwardingTestSuite ()
   : TestSuite ("ipv4-forwarding", UNIT)
 {
   AddTestCase (new Ipv4ForwardingTest, TestCase::QUICK);
+  AddTestCase (new Ipv4ForwardingHeaderTest, TestCase::QUICK);
 }
 
 static Ipv4ForwardingTestSuite g_ipv4forwardingTestSuite; //!< Static variable for test initialization
@@ -15,6 +15,9 @@
  */
 
 #include <vector>
+#include <sstream>
+#include <algorithm>
+#include <fstream>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
@@ -41,6 +44,7 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/global-route-manager.h"
 #include "ns3/bridge-helper.h"
 
 using namespace ns3;
@@ -1244,6 +1248,356 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting parallel and incremental SPF test
+ *
+ * Builds a grid of routers with point-to-point links, a LAN, stub
+ * networks and stub nodes, then checks that the routing tables computed
+ * with several threads, and the ones updated incrementally after each
+ * change of the topology, hold the same routes as a full, sequential
+ * calculation.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Get the routes of every node.
+   * \returns the routes of each node, sorted
+   */
+  std::vector<std::vector<std::string> > GetRoutes (void) const;
+  /**
+   * \brief Recompute the routes incrementally, then from scratch, and
+   * compare them.
+   * \param change a description of the change of the topology
+   */
+  void CheckIncremental (std::string change);
+
+  NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Global routing with parallel and incremental SPF calculations")
+{
+}
+
+std::vector<std::vector<std::string> >
+Ipv4GlobalRoutingIncrementalTestCase::GetRoutes (void) const
+{
+  std::vector<std::vector<std::string> > routes;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      std::vector<std::string> table;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << *routing->GetRoute (j);
+          table.push_back (oss.str ());
+        }
+      std::sort (table.begin (), table.end ());
+      routes.push_back (table);
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::CheckIncremental (std::string change)
+{
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (true));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::vector<std::string> > incremental = GetRoutes ();
+  Config::SetGlobal ("GlobalRoutingIncremental", BooleanValue (false));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::vector<std::string> > full = GetRoutes ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (incremental[i].size (), full[i].size (),
+                             "Wrong number of routes on node " << i << " after " << change);
+      for (uint32_t j = 0; j < full[i].size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (incremental[i][j], full[i][j],
+                                 "Wrong route on node " << i << " after " << change);
+        }
+    }
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  // A 4x4 grid of routers (nodes 0-15), two stub nodes (16 and 17)
+  // and a LAN between routers 0, 5 and 10.  Each router also has a
+  // network of its own (a stub network).
+  const uint32_t side = 4;
+  m_nodes.Create (side * side + 2);
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper lan;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.252");
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t i = 0; i < side * side; i++)
+    {
+      if (i % side + 1 < side)
+        {
+          links.push_back (std::make_pair (i, i + 1));
+        }
+      if (i + side < side * side)
+        {
+          links.push_back (std::make_pair (i, i + side));
+        }
+    }
+  links.push_back (std::make_pair (3, side * side));
+  links.push_back (std::make_pair (12, side * side + 1));
+  for (uint32_t l = 0; l < links.size (); l++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices = p2p.Install (m_nodes.Get (links[l].first), channel);
+      devices.Add (p2p.Install (m_nodes.Get (links[l].second), channel));
+      Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+      // Uneven metrics, so that the LAN is reached through a single best
+      // path (equal-cost paths to a transit network are not supported)
+      interfaces.Get (0).first->SetMetric (interfaces.Get (0).second, 1 + (l * 37) % 101);
+      interfaces.Get (1).first->SetMetric (interfaces.Get (1).second, 1 + (l * 37) % 101);
+      ipv4.NewNetwork ();
+    }
+  ipv4.SetBase ("10.2.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < side * side; i++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      ipv4.Assign (lan.Install (m_nodes.Get (i), channel));
+      ipv4.NewNetwork ();
+    }
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer lanDevices = lan.Install (m_nodes.Get (0), channel);
+  lanDevices.Add (lan.Install (m_nodes.Get (5), channel));
+  lanDevices.Add (lan.Install (m_nodes.Get (10), channel));
+  ipv4.SetBase ("10.3.0.0", "255.255.255.0");
+  ipv4.Assign (lanDevices);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::vector<std::string> > sequential = GetRoutes ();
+  NS_TEST_ASSERT_MSG_GT (sequential[0].size (), 0, "No routes computed");
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::vector<std::string> > parallel = GetRoutes ();
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (parallel[i].size (), sequential[i].size (),
+                             "Wrong number of routes on node " << i << " with 4 threads");
+      for (uint32_t j = 0; j < sequential[i].size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (parallel[i][j], sequential[i][j],
+                                 "Wrong route on node " << i << " with 4 threads");
+        }
+    }
+
+  CheckIncremental ("no change");
+
+  // Interfaces: 0 is the loopback, then the point-to-point links, the
+  // stub network and the LAN, in the order of creation.
+  Ptr<Ipv4> ip6 = m_nodes.Get (6)->GetObject<Ipv4> ();
+  uint32_t stub6 = ip6->GetNInterfaces () - 1;
+  ip6->SetDown (stub6);
+  CheckIncremental ("stub network of node 6 down");
+  ip6->SetUp (stub6);
+  CheckIncremental ("stub network of node 6 up");
+  ip6->SetDown (1);
+  CheckIncremental ("link of node 6 down");
+  ip6->SetUp (1);
+  CheckIncremental ("link of node 6 up");
+  ip6->SetMetric (2, 10);
+  CheckIncremental ("metric of node 6 changed");
+  Ptr<Ipv4> ip10 = m_nodes.Get (10)->GetObject<Ipv4> ();
+  ip10->SetDown (ip10->GetNInterfaces () - 1);
+  CheckIncremental ("LAN interface of node 10 down");
+  ip10->SetUp (ip10->GetNInterfaces () - 1);
+  CheckIncremental ("LAN interface of node 10 up");
+  Ptr<Ipv4> ip16 = m_nodes.Get (side * side)->GetObject<Ipv4> ();
+  ip16->AddAddress (1, Ipv4InterfaceAddress (Ipv4Address ("10.4.0.1"), Ipv4Mask ("255.255.255.0")));
+  CheckIncremental ("address added to a stub node");
+  Ptr<Ipv4> ip15 = m_nodes.Get (15)->GetObject<Ipv4> ();
+  ip15->AddAddress (ip15->GetNInterfaces () - 1,
+                    Ipv4InterfaceAddress (Ipv4Address ("10.5.0.1"), Ipv4Mask ("255.255.0.0")));
+  CheckIncremental ("address added to a stub network");
+  ip15->SetDown (ip15->GetNInterfaces () - 1);
+  CheckIncremental ("stub network of node 15 down");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting routing table file test
+ *
+ * Writes the routes of a small topology to a file, deletes them, and
+ * checks that reading the file restores identical routing tables, and
+ * that the file is refused once the topology has changed.
+ */
+class Ipv4GlobalRoutingFileTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Get the routes of every node.
+   * \returns the routes of each node, in the order of the routing tables
+   */
+  std::vector<std::vector<std::string> > GetRoutes (void) const;
+  /**
+   * \brief Compare the routes of every node with expected routes.
+   * \param expected the expected routes
+   * \param step a description of the step of the test
+   */
+  void CheckRoutes (const std::vector<std::vector<std::string> > &expected, std::string step);
+
+  NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingFileTestCase::Ipv4GlobalRoutingFileTestCase ()
+  : TestCase ("Global routing tables written to and read from a file")
+{
+}
+
+std::vector<std::vector<std::string> >
+Ipv4GlobalRoutingFileTestCase::GetRoutes (void) const
+{
+  std::vector<std::vector<std::string> > routes;
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = m_nodes.Get (i)->GetObject<Ipv4L3Protocol> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      std::vector<std::string> table;
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << *routing->GetRoute (j);
+          table.push_back (oss.str ());
+        }
+      routes.push_back (table);
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingFileTestCase::CheckRoutes (const std::vector<std::vector<std::string> > &expected, std::string step)
+{
+  std::vector<std::vector<std::string> > routes = GetRoutes ();
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (routes[i].size (), expected[i].size (),
+                             "Wrong number of routes on node " << i << " " << step);
+      for (uint32_t j = 0; j < expected[i].size () && j < routes[i].size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (routes[i][j], expected[i][j],
+                                 "Wrong route on node " << i << " " << step);
+        }
+    }
+}
+
+void
+Ipv4GlobalRoutingFileTestCase::DoRun (void)
+{
+  // A ring of four routers with point-to-point links, a LAN between
+  // routers 0 and 2, and a stub network on each router
+  m_nodes.Create (4);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (m_nodes);
+
+  SimpleNetDeviceHelper p2p;
+  p2p.SetNetDevicePointToPointMode (true);
+  SimpleNetDeviceHelper lan;
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      NetDeviceContainer devices = p2p.Install (m_nodes.Get (i), channel);
+      devices.Add (p2p.Install (m_nodes.Get ((i + 1) % m_nodes.GetN ()), channel));
+      ipv4.Assign (devices);
+      ipv4.NewNetwork ();
+    }
+  ipv4.SetBase ("10.2.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < m_nodes.GetN (); i++)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      ipv4.Assign (lan.Install (m_nodes.Get (i), channel));
+      ipv4.NewNetwork ();
+    }
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer lanDevices = lan.Install (m_nodes.Get (0), channel);
+  lanDevices.Add (lan.Install (m_nodes.Get (2), channel));
+  ipv4.SetBase ("10.3.0.0", "255.255.255.0");
+  ipv4.Assign (lanDevices);
+
+  std::string filename = CreateTempDirFilename ("ipv4-global-routing.routes");
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRoutingHelper::ReadRoutingTables (filename), false,
+                         "Routes read from a missing file");
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables (filename);
+  std::vector<std::vector<std::string> > computed = GetRoutes ();
+  NS_TEST_ASSERT_MSG_GT (computed[0].size (), 0, "No routes computed");
+
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (GetRoutes ()[0].size (), 0, "Routes not deleted");
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRoutingHelper::ReadRoutingTables (filename), true,
+                         "Routes not read from the file");
+  CheckRoutes (computed, "read from the file");
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables (filename);
+  CheckRoutes (computed, "populated from the file");
+
+  // The routes recomputed after a load are the same
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  CheckRoutes (computed, "recomputed after a load");
+
+  // A change of the topology (the stub network of node 3 goes down)
+  // invalidates the file, and the routes in place are kept
+  Ptr<Ipv4> ip3 = m_nodes.Get (3)->GetObject<Ipv4> ();
+  ip3->SetDown (ip3->GetNInterfaces () - 1);
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRoutingHelper::ReadRoutingTables (filename), false,
+                         "Routes read from the file of another topology");
+  CheckRoutes (computed, "after the file was refused");
+
+  // The file is rewritten for the new topology
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Ipv4GlobalRoutingHelper::WriteRoutingTables (filename);
+  std::vector<std::vector<std::string> > changed = GetRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (changed[0].size (), computed[0].size () - 1, "Route to the stub network of node 3 kept");
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRoutingHelper::ReadRoutingTables (filename), true,
+                         "Routes not read from the rewritten file");
+  CheckRoutes (changed, "read from the rewritten file");
+
+  // A corrupted file is refused
+  std::fstream file (filename.c_str (), std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp (-1, std::ios::end);
+  file.put ('\x5a');
+  file.close ();
+  NS_TEST_ASSERT_MSG_EQ (Ipv4GlobalRoutingHelper::ReadRoutingTables (filename), false,
+                         "Routes read from a corrupted file");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1621,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFileTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
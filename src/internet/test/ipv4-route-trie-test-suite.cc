@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/ipv4-route-trie.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the IPv4 longest prefix match index against a linear scan.
+ */
+class Ipv4RouteTrieTestCase : public TestCase
+{
+public:
+  Ipv4RouteTrieTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// A route of the reference table
+  struct Route
+  {
+    Ipv4Address network;  //!< destination network
+    Ipv4Mask mask;        //!< destination mask
+    uint32_t id;          //!< route identifier
+  };
+
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * \return a destination address close to the prefixes of the table
+   */
+  Ipv4Address RandomAddress (void);
+  /**
+   * \brief Compare lookups in the index with a scan of the reference table.
+   * \param trie the index
+   * \param routes the reference table, in insertion order
+   */
+  void Check (const Ipv4RouteTrie<uint32_t> &trie, const std::vector<Route> &routes);
+
+  uint32_t m_state; //!< state of the pseudo-random generator
+};
+
+Ipv4RouteTrieTestCase::Ipv4RouteTrieTestCase ()
+  : TestCase ("Check that the route index finds the same routes as a linear scan"),
+    m_state (12345)
+{
+}
+
+uint32_t
+Ipv4RouteTrieTestCase::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+Ipv4Address
+Ipv4RouteTrieTestCase::RandomAddress (void)
+{
+  // A few bases so that prefixes nest and share branches
+  static const uint32_t bases[] = { 0x0a000000, 0x0a010100, 0xc0a80000, 0xac100000 };
+  uint32_t base = bases[Random () % 4];
+  return Ipv4Address (base ^ (Random () & (0xffffffffU >> (8 + Random () % 24))));
+}
+
+void
+Ipv4RouteTrieTestCase::Check (const Ipv4RouteTrie<uint32_t> &trie, const std::vector<Route> &routes)
+{
+  NS_TEST_ASSERT_MSG_EQ (trie.GetNRoutes (), routes.size (), "Wrong number of routes");
+  std::vector<uint32_t> found;
+  for (uint32_t n = 0; n < 2000; ++n)
+    {
+      Ipv4Address dest = RandomAddress ();
+      std::vector<uint32_t> expected;
+      for (std::vector<Route>::const_iterator i = routes.begin (); i != routes.end (); ++i)
+        {
+          if (i->mask.IsMatch (dest, i->network))
+            {
+              expected.push_back (i->id);
+            }
+        }
+      trie.Lookup (dest, found);
+      NS_TEST_ASSERT_MSG_EQ (found.size (), expected.size (), "Wrong number of routes to " << dest);
+      for (uint32_t i = 0; i < found.size (); ++i)
+        {
+          NS_TEST_ASSERT_MSG_EQ (found[i], expected[i], "Wrong route to " << dest << " at index " << i);
+        }
+    }
+}
+
+void
+Ipv4RouteTrieTestCase::DoRun (void)
+{
+  Ipv4RouteTrie<uint32_t> trie;
+  std::vector<Route> routes;
+  for (uint32_t id = 0; id < 600; ++id)
+    {
+      Route route;
+      if (id % 50 == 49)
+        {
+          // Non-contiguous mask
+          route.mask = Ipv4Mask (0xff00ff00);
+        }
+      else if (id % 7 == 0)
+        {
+          // Host route
+          route.mask = Ipv4Mask::GetOnes ();
+        }
+      else
+        {
+          route.mask = Ipv4Mask ((uint32_t)(uint64_t (0xffffffffU) << (32 - Random () % 33)));
+        }
+      // Equal-cost routes to the same prefix
+      route.network = (id % 5 == 4) ? routes.back ().network : RandomAddress ();
+      route.mask = (id % 5 == 4) ? routes.back ().mask : route.mask;
+      route.id = id;
+      routes.push_back (route);
+      trie.Insert (route.network, route.mask, route.id);
+    }
+  Check (trie, routes);
+
+  for (uint32_t n = 0; n < 400; ++n)
+    {
+      uint32_t i = Random () % routes.size ();
+      NS_TEST_ASSERT_MSG_EQ (trie.Remove (routes[i].network, routes[i].mask, routes[i].id), true,
+                             "Unable to remove route " << routes[i].id);
+      routes.erase (routes.begin () + i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (trie.Remove (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.0.0"), 1000), false,
+                         "Removed a route which was never inserted");
+  Check (trie, routes);
+
+  for (uint32_t id = 600; id < 700; ++id)
+    {
+      Route route = { RandomAddress (), Ipv4Mask ((uint32_t)(uint64_t (0xffffffffU) << (32 - Random () % 33))), id };
+      routes.push_back (route);
+      trie.Insert (route.network, route.mask, route.id);
+    }
+  Check (trie, routes);
+
+  trie.Clear ();
+  routes.clear ();
+  Check (trie, routes);
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 route index TestSuite
+ */
+class Ipv4RouteTrieTestSuite : public TestSuite
+{
+public:
+  Ipv4RouteTrieTestSuite ();
+};
+
+Ipv4RouteTrieTestSuite::Ipv4RouteTrieTestSuite ()
+  : TestSuite ("ipv4-route-trie", UNIT)
+{
+  AddTestCase (new Ipv4RouteTrieTestCase, TestCase::QUICK);
+}
+
+static Ipv4RouteTrieTestSuite g_ipv4RouteTrieTestSuite; //!< Static variable for test initialization
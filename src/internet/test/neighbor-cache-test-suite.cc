@@ -0,0 +1,252 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+#include <list>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/mac48-address.h"
+#include "ns3/arp-cache.h"
+#include "ns3/ndisc-cache.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the lookups of the ArpCache and the NdiscCache.
+ *
+ * Entries are added, removed and given new MAC addresses at random, and
+ * the lookups by network address and by MAC address are checked against
+ * a reference map, so that the hash tables are exercised through growth,
+ * deletions and reused slots.
+ */
+class NeighborCacheTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param ipv6 true to check the NdiscCache, false to check the ArpCache
+   */
+  NeighborCacheTestCase (bool ipv6);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * \param n the index of an address
+   * \return the IPv4 address of index n
+   */
+  static Ipv4Address GetIpv4 (uint32_t n);
+  /**
+   * \param n the index of an address
+   * \return the IPv6 address of index n
+   */
+  static Ipv6Address GetIpv6 (uint32_t n);
+  /**
+   * \param n the index of an address
+   * \return the MAC address of index n
+   */
+  static Address GetMac (uint32_t n);
+
+  /**
+   * \brief Check a cache against the reference map.
+   * \param cache the cache
+   * \param getAddress the function giving the network address of an index
+   * \param nAddresses the number of network addresses
+   * \param nMacs the number of MAC addresses
+   */
+  template <typename Cache, typename Addr>
+  void Check (Ptr<Cache> cache, Addr (*getAddress)(uint32_t), uint32_t nAddresses, uint32_t nMacs);
+
+  /**
+   * \brief Run random operations on a cache.
+   * \param cache the cache
+   * \param getAddress the function giving the network address of an index
+   */
+  template <typename Cache, typename Addr>
+  void Run (Ptr<Cache> cache, Addr (*getAddress)(uint32_t));
+
+  bool m_ipv6;                              //!< true to check the NdiscCache
+  std::map<uint32_t, uint32_t> m_reference; //!< MAC address index of each network address index
+  uint32_t m_state;                         //!< state of the pseudo-random generator
+};
+
+NeighborCacheTestCase::NeighborCacheTestCase (bool ipv6)
+  : TestCase (ipv6 ? "Check the lookups of the NdiscCache" : "Check the lookups of the ArpCache"),
+    m_ipv6 (ipv6),
+    m_state (2463534242U)
+{
+}
+
+uint32_t
+NeighborCacheTestCase::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+Ipv4Address
+NeighborCacheTestCase::GetIpv4 (uint32_t n)
+{
+  // Consecutive addresses, as in a subnet
+  return Ipv4Address (0x0a000001 + n);
+}
+
+Ipv6Address
+NeighborCacheTestCase::GetIpv6 (uint32_t n)
+{
+  uint8_t buffer[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+  buffer[14] = n >> 8;
+  buffer[15] = n & 0xff;
+  return Ipv6Address (buffer);
+}
+
+Address
+NeighborCacheTestCase::GetMac (uint32_t n)
+{
+  uint8_t buffer[6] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  buffer[4] = n >> 8;
+  buffer[5] = n & 0xff;
+  Mac48Address mac;
+  mac.CopyFrom (buffer);
+  return mac;
+}
+
+template <typename Cache, typename Addr>
+void
+NeighborCacheTestCase::Check (Ptr<Cache> cache, Addr (*getAddress)(uint32_t), uint32_t nAddresses, uint32_t nMacs)
+{
+  for (uint32_t n = 0; n < nAddresses; ++n)
+    {
+      typename Cache::Entry *entry = cache->Lookup (getAddress (n));
+      std::map<uint32_t, uint32_t>::const_iterator it = m_reference.find (n);
+      NS_TEST_ASSERT_MSG_EQ ((entry != 0), (it != m_reference.end ()), "Wrong lookup of address " << n);
+      if (entry != 0 && it != m_reference.end ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (entry->GetMacAddress (), GetMac (it->second), "Wrong MAC address of " << n);
+        }
+    }
+  for (uint32_t m = 0; m < nMacs; ++m)
+    {
+      std::list<typename Cache::Entry *> entries = cache->LookupInverse (GetMac (m));
+      uint32_t expected = 0;
+      for (std::map<uint32_t, uint32_t>::const_iterator it = m_reference.begin (); it != m_reference.end (); ++it)
+        {
+          if (it->second == m)
+            {
+              ++expected;
+              bool found = false;
+              for (typename std::list<typename Cache::Entry *>::const_iterator e = entries.begin (); e != entries.end (); ++e)
+                {
+                  found = found || (*e == cache->Lookup (getAddress (it->first)));
+                }
+              NS_TEST_ASSERT_MSG_EQ (found, true, "Address " << it->first << " not found by MAC address " << m);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (entries.size (), expected, "Wrong number of entries with MAC address " << m);
+    }
+}
+
+template <typename Cache, typename Addr>
+void
+NeighborCacheTestCase::Run (Ptr<Cache> cache, Addr (*getAddress)(uint32_t))
+{
+  const uint32_t nAddresses = 300;
+  const uint32_t nMacs = 20;
+  for (uint32_t i = 0; i < 20000; ++i)
+    {
+      uint32_t n = Random () % nAddresses;
+      typename Cache::Entry *entry = cache->Lookup (getAddress (n));
+      uint32_t action = Random () % 4;
+      if (entry == 0)
+        {
+          if (action < 3)
+            {
+              uint32_t m = Random () % nMacs;
+              entry = cache->Add (getAddress (n));
+              entry->SetMacAddress (GetMac (m));
+              m_reference[n] = m;
+            }
+        }
+      else if (action < 2)
+        {
+          cache->Remove (entry);
+          m_reference.erase (n);
+        }
+      else
+        {
+          uint32_t m = Random () % nMacs;
+          entry->SetMacAddress (GetMac (m));
+          m_reference[n] = m;
+        }
+      if (i % 1000 == 0)
+        {
+          Check (cache, getAddress, nAddresses, nMacs);
+        }
+      if (i == 10000)
+        {
+          cache->Flush ();
+          m_reference.clear ();
+        }
+    }
+  Check (cache, getAddress, nAddresses, nMacs);
+}
+
+void
+NeighborCacheTestCase::DoRun (void)
+{
+  if (m_ipv6)
+    {
+      Ptr<NdiscCache> cache = CreateObject<NdiscCache> ();
+      Run (cache, &NeighborCacheTestCase::GetIpv6);
+      cache->Dispose ();
+    }
+  else
+    {
+      Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+      Run (cache, &NeighborCacheTestCase::GetIpv4);
+      cache->Dispose ();
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Neighbor caches TestSuite
+ */
+class NeighborCacheTestSuite : public TestSuite
+{
+public:
+  NeighborCacheTestSuite ()
+    : TestSuite ("neighbor-cache", UNIT)
+  {
+    AddTestCase (new NeighborCacheTestCase (false), TestCase::QUICK);
+    AddTestCase (new NeighborCacheTestCase (true), TestCase::QUICK);
+  }
+};
+
+static NeighborCacheTestSuite g_neighborCacheTestSuite; //!< Static variable for test initialization
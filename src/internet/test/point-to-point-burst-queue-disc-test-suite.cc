@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/traffic-control-helper.h"
+#include "ns3/queue-disc.h"
+#include "ns3/queue-disc-container.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/socket.h"
+#include "ns3/packet.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * The traces seen on a queue disc installed on a point-to-point device,
+ * with and without transmit bursts.
+ */
+struct BurstQueueDiscTraces
+{
+  std::vector<uint64_t> sent;      //!< the uids of the packets sent, in order
+  std::vector<Time> sojourn;       //!< the sojourn time of each dequeued packet
+  std::vector<uint32_t> dropped;   //!< the indexes of the packets dropped by the queue disc
+  std::vector<Time> rx;            //!< the reception times at the peer
+};
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * Checks how the transmit bursts of PointToPointNetDevice (MaxTxBurst
+ * attribute) change the behaviour of the queue disc installed on the
+ * device. The packets reach the peer at the same times and the queue disc
+ * drops as many of them, but, since the packets of a burst leave the device
+ * queue when the burst starts, the queue disc dequeues some packets earlier:
+ * their sojourn times are shorter, by less than a burst, and the queue disc
+ * drops other packets.
+ */
+class PointToPointBurstQueueDiscTestCase : public TestCase
+{
+public:
+  PointToPointBurstQueueDiscTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Send UDP packets faster than the link rate through a queue disc.
+   * \param maxTxBurst the MaxTxBurst attribute of the sending device
+   * \param traces the traces to fill
+   */
+  void RunOne (uint32_t maxTxBurst, BurstQueueDiscTraces &traces);
+  /**
+   * Send a packet and schedule the next one.
+   * \param traces the traces to fill
+   * \param socket the sending socket
+   * \param left the number of packets left to send
+   */
+  void Send (BurstQueueDiscTraces *traces, Ptr<Socket> socket, uint32_t left);
+  /**
+   * Record the sojourn time of a packet dequeued by the queue disc.
+   * \param traces the traces to fill
+   * \param sojourn the sojourn time
+   */
+  static void Sojourn (BurstQueueDiscTraces *traces, Time sojourn);
+  /**
+   * Record a packet dropped by the queue disc.
+   * \param traces the traces to fill
+   * \param item the dropped item
+   */
+  static void Drop (BurstQueueDiscTraces *traces, Ptr<const QueueDiscItem> item);
+  /**
+   * Record the reception of the packets waiting on a socket.
+   * \param traces the traces to fill
+   * \param socket the receiving socket
+   */
+  static void Receive (BurstQueueDiscTraces *traces, Ptr<Socket> socket);
+
+  static const uint32_t m_packets = 400;      //!< number of packets sent
+  static const uint32_t m_payloadSize = 1000; //!< UDP payload size (bytes)
+  static const uint32_t m_maxTxBurst = 4;     //!< MaxTxBurst of the burst run
+};
+
+PointToPointBurstQueueDiscTestCase::PointToPointBurstQueueDiscTestCase ()
+  : TestCase ("Compare the queue disc traces with and without point-to-point transmit bursts")
+{
+}
+
+void
+PointToPointBurstQueueDiscTestCase::Send (BurstQueueDiscTraces *traces, Ptr<Socket> socket, uint32_t left)
+{
+  Ptr<Packet> packet = Create<Packet> (m_payloadSize);
+  traces->sent.push_back (packet->GetUid ());
+  socket->Send (packet);
+  if (left > 1)
+    {
+      Simulator::Schedule (MicroSeconds (500), &PointToPointBurstQueueDiscTestCase::Send,
+                           this, traces, socket, left - 1);
+    }
+}
+
+void
+PointToPointBurstQueueDiscTestCase::Sojourn (BurstQueueDiscTraces *traces, Time sojourn)
+{
+  traces->sojourn.push_back (sojourn);
+}
+
+void
+PointToPointBurstQueueDiscTestCase::Drop (BurstQueueDiscTraces *traces, Ptr<const QueueDiscItem> item)
+{
+  std::vector<uint64_t>::const_iterator it = std::find (traces->sent.begin (), traces->sent.end (),
+                                                        item->GetPacket ()->GetUid ());
+  NS_ASSERT (it != traces->sent.end ());
+  traces->dropped.push_back (it - traces->sent.begin ());
+}
+
+void
+PointToPointBurstQueueDiscTestCase::Receive (BurstQueueDiscTraces *traces, Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      traces->rx.push_back (Simulator::Now ());
+    }
+}
+
+void
+PointToPointBurstQueueDiscTestCase::RunOne (uint32_t maxTxBurst, BurstQueueDiscTraces &traces)
+{
+  traces.sent.clear ();
+  traces.sojourn.clear ();
+  traces.dropped.clear ();
+  traces.rx.clear ();
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetDeviceAttribute ("MaxTxBurst", UintegerValue (maxTxBurst));
+  p2p.SetChannelAttribute ("Delay", StringValue ("2ms"));
+  p2p.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("8p"));
+  NetDeviceContainer devices = p2p.Install (nodes);
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::FifoQueueDisc", "MaxSize", StringValue ("50p"));
+  QueueDiscContainer qdiscs = tch.Install (devices.Get (0));
+  qdiscs.Get (0)->TraceConnectWithoutContext ("SojournTime",
+    MakeBoundCallback (&PointToPointBurstQueueDiscTestCase::Sojourn, &traces));
+  qdiscs.Get (0)->TraceConnectWithoutContext ("Drop",
+    MakeBoundCallback (&PointToPointBurstQueueDiscTestCase::Drop, &traces));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  Ptr<Socket> rxSocket = Socket::CreateSocket (nodes.Get (1), UdpSocketFactory::GetTypeId ());
+  rxSocket->Bind (InetSocketAddress (Ipv4Address::GetAny (), 9));
+  rxSocket->SetRecvCallback (MakeBoundCallback (&PointToPointBurstQueueDiscTestCase::Receive, &traces));
+
+  Ptr<Socket> txSocket = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  txSocket->Connect (InetSocketAddress (interfaces.GetAddress (1), 9));
+
+  Simulator::Schedule (Seconds (1), &PointToPointBurstQueueDiscTestCase::Send,
+                       this, &traces, txSocket, m_packets);
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+PointToPointBurstQueueDiscTestCase::DoRun (void)
+{
+  BurstQueueDiscTraces reference;
+  RunOne (1, reference);
+  BurstQueueDiscTraces burst;
+  RunOne (m_maxTxBurst, burst);
+
+  // The queue disc backs up and drops packets in both runs
+  NS_TEST_ASSERT_MSG_GT (reference.dropped.size (), 0, "The queue disc should drop packets");
+  NS_TEST_ASSERT_MSG_GT (burst.dropped.size (), 0, "The queue disc should drop packets with bursts");
+  NS_TEST_ASSERT_MSG_EQ (reference.rx.size () + reference.dropped.size (), m_packets, "Packets were lost");
+
+  // The packets reach the peer at the same times and as many are dropped
+  NS_TEST_EXPECT_MSG_EQ (burst.dropped.size (), reference.dropped.size (), "Bursts changed the number of drops");
+  NS_TEST_ASSERT_MSG_EQ (burst.rx.size (), reference.rx.size (), "Bursts changed the number of received packets");
+  for (uint32_t i = 0; i < reference.rx.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (burst.rx[i], reference.rx[i], "Bursts changed the reception time of packet " << i);
+    }
+
+  // The packets of a burst leave the device queue when the burst starts, so
+  // that the queue disc dequeues them earlier, by less than a burst. The
+  // sojourn times are those of the same packets until the first drop.
+  Time slot = Seconds ((m_payloadSize + 30) * 8 / 10e6);
+  uint32_t firstDrop = std::min (reference.dropped.front (), burst.dropped.front ());
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (reference.sojourn.size (), firstDrop, "Too few packets dequeued");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (burst.sojourn.size (), firstDrop, "Too few packets dequeued with bursts");
+  uint32_t earlier = 0;
+  for (uint32_t i = 0; i < firstDrop; i++)
+    {
+      NS_TEST_EXPECT_MSG_LT_OR_EQ (burst.sojourn[i], reference.sojourn[i],
+                                   "Packet " << i << " stayed longer in the queue disc with bursts");
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (burst.sojourn[i], reference.sojourn[i] - slot * (m_maxTxBurst - 1),
+                                   "Packet " << i << " left the queue disc more than a burst earlier");
+      if (burst.sojourn[i] < reference.sojourn[i])
+        {
+          earlier++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_GT (earlier, 0, "Bursts should shorten the sojourn times of the queue disc");
+
+  // Since the queue disc makes room earlier, it drops other packets
+  NS_TEST_EXPECT_MSG_EQ ((burst.dropped != reference.dropped), true, "Bursts should change the dropped packets");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * Point-to-point transmit bursts and queue discs test suite.
+ */
+class PointToPointBurstQueueDiscTestSuite : public TestSuite
+{
+public:
+  PointToPointBurstQueueDiscTestSuite ()
+    : TestSuite ("point-to-point-burst-queue-disc", UNIT)
+  {
+    AddTestCase (new PointToPointBurstQueueDiscTestCase, TestCase::QUICK);
+  }
+};
+
+static PointToPointBurstQueueDiscTestSuite g_pointToPointBurstQueueDiscTestSuite; //!< the test suite
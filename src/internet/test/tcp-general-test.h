@@ -556,7 +556,7 @@ protected:
    * \param who socket where check the parameter
    * \return the persistent event in the selected socket
    */
-  EventId GetPersistentEvent (SocketWho who);
+  const TcpTimer &GetPersistentEvent (SocketWho who);
 
   /**
    * \brief Get the persistent timeout of the selected socket
@@ -0,0 +1,229 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-timer-wheel.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the timers of a TcpTimerWheel fire at their exact expiration time.
+ *
+ * Timers are scheduled, rescheduled and cancelled at random times, with
+ * delays ranging from less than a tick to beyond the span of the wheel.
+ * Each firing is checked against the expected expiration times. As with
+ * an EventId, rescheduling a running timer without cancelling it leaves
+ * the previous event pending.
+ */
+class TcpTimerWheelTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param tick the tick of the wheel, or zero to schedule the timers in the simulator
+   */
+  TcpTimerWheelTestCase (Time tick);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * \return a random timer delay
+   */
+  Time RandomDelay (void);
+  /**
+   * \brief Schedule, reschedule or cancel a random timer.
+   */
+  void Operate (void);
+  /**
+   * \brief Timer expiration.
+   * \param id the timer index
+   * \param generation the number of the scheduling of the timer
+   */
+  void Fire (uint32_t id, uint32_t generation);
+
+  /// Key of an expected firing: timer index and generation
+  typedef std::pair<uint32_t, uint32_t> Key;
+
+  Time m_tick;                        //!< the tick of the wheel
+  std::vector<TcpTimer> m_timers;     //!< the timers
+  std::vector<uint32_t> m_generation; //!< current generation of each timer
+  std::map<Key, Time> m_expected;     //!< expected firings
+  uint32_t m_nOperations;             //!< operations left
+  uint32_t m_nFired;                  //!< number of timers fired
+  uint32_t m_state;                   //!< state of the pseudo-random generator
+};
+
+TcpTimerWheelTestCase::TcpTimerWheelTestCase (Time tick)
+  : TestCase ("Check the timer wheel with a tick of " + std::to_string (tick.GetMicroSeconds ()) + " us"),
+    m_tick (tick),
+    m_nOperations (0),
+    m_nFired (0),
+    m_state (2463534242U)
+{
+}
+
+uint32_t
+TcpTimerWheelTestCase::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+Time
+TcpTimerWheelTestCase::RandomDelay (void)
+{
+  switch (Random () % 8)
+    {
+    case 0:
+      return Time (0);
+    case 1:
+      // Within a tick
+      return NanoSeconds (Random () % 1000000);
+    case 2:
+      // Aligned on ticks
+      return MilliSeconds (Random () % 200);
+    case 3:
+      // Minutes
+      return MilliSeconds (Random () % 300000);
+    case 4:
+      // Beyond the span of a 1 ms wheel
+      return Seconds (17000 + Random () % 10000);
+    default:
+      // Retransmission and delayed ACK timers
+      return MicroSeconds (200000 + Random () % 1000000);
+    }
+}
+
+void
+TcpTimerWheelTestCase::Operate (void)
+{
+  uint32_t id = Random () % m_timers.size ();
+  TcpTimer &timer = m_timers[id];
+  Key key (id, m_generation[id]);
+  std::map<Key, Time>::iterator it = m_expected.find (key);
+  bool running = (it != m_expected.end ());
+  NS_TEST_ASSERT_MSG_EQ (timer.IsRunning (), running, "Wrong state of timer " << id);
+  NS_TEST_ASSERT_MSG_EQ (timer.IsExpired (), !running, "Wrong state of timer " << id);
+  if (running)
+    {
+      NS_TEST_ASSERT_MSG_EQ (timer.GetDelayLeft (), it->second - Simulator::Now (),
+                             "Wrong delay left for timer " << id);
+    }
+
+  uint32_t action = Random () % 8;
+  if (action < 2)
+    {
+      timer.Cancel ();
+      if (running)
+        {
+          m_expected.erase (it);
+        }
+    }
+  else
+    {
+      if (action < 7)
+        {
+          // Reschedule, as a retransmission timer on a new ACK
+          timer.Cancel ();
+          if (running)
+            {
+              m_expected.erase (it);
+            }
+        }
+      Time delay = RandomDelay ();
+      uint32_t generation = ++m_generation[id];
+      timer.Schedule (delay, &TcpTimerWheelTestCase::Fire, this, id, generation);
+      m_expected[Key (id, generation)] = Simulator::Now () + delay;
+    }
+
+  if (--m_nOperations > 0)
+    {
+      Simulator::Schedule (MicroSeconds (Random () % 20000), &TcpTimerWheelTestCase::Operate, this);
+    }
+}
+
+void
+TcpTimerWheelTestCase::Fire (uint32_t id, uint32_t generation)
+{
+  std::map<Key, Time>::iterator it = m_expected.find (Key (id, generation));
+  NS_TEST_ASSERT_MSG_EQ ((it != m_expected.end ()), true,
+                         "Timer " << id << " fired while cancelled");
+  NS_TEST_ASSERT_MSG_EQ (Simulator::Now (), it->second, "Timer " << id << " fired at the wrong time");
+  m_expected.erase (it);
+  ++m_nFired;
+}
+
+void
+TcpTimerWheelTestCase::DoRun (void)
+{
+  Ptr<TcpTimerWheel> wheel;
+  if (m_tick.IsStrictlyPositive ())
+    {
+      wheel = Create<TcpTimerWheel> (m_tick);
+    }
+  m_timers.resize (500);
+  m_generation.assign (m_timers.size (), 0);
+  for (uint32_t i = 0; i < m_timers.size (); ++i)
+    {
+      m_timers[i].SetWheel (wheel);
+    }
+  m_nOperations = 100000;
+  Simulator::Schedule (Seconds (1), &TcpTimerWheelTestCase::Operate, this);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_expected.size (), 0, "Some timers did not fire");
+  NS_TEST_ASSERT_MSG_GT (m_nFired, 1000, "Too few timers fired to be significant");
+  if (wheel != 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (wheel->GetNTimers (), 0, "Timers left in the wheel");
+    }
+  m_timers.clear ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP timer wheel TestSuite
+ */
+class TcpTimerWheelTestSuite : public TestSuite
+{
+public:
+  TcpTimerWheelTestSuite ()
+    : TestSuite ("tcp-timer-wheel", UNIT)
+  {
+    AddTestCase (new TcpTimerWheelTestCase (Time (0)), TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelTestCase (MilliSeconds (1)), TestCase::QUICK);
+    AddTestCase (new TcpTimerWheelTestCase (MicroSeconds (7300)), TestCase::QUICK);
+  }
+};
+
+static TcpTimerWheelTestSuite g_tcpTimerWheelTestSuite; //!< Static variable for test initialization
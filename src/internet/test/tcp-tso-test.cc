@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-header.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpTsoTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the segmentation offload mode of TcpSocketBase.
+ *
+ * The sender writes all its data at once and is allowed to send up to
+ * maxSegments segments as one large segment. The test checks that no large
+ * segment exceeds this limit nor is fragmented on the way, that large
+ * segments are only used when allowed, and that the whole data is delivered.
+ */
+class TcpTsoTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor.
+   * \param desc Test description.
+   * \param maxSegments Value of the TsoMaxSegments attribute of the sender.
+   */
+  TcpTsoTestCase (const std::string &desc, uint32_t maxSegments);
+
+protected:
+  virtual void ConfigureEnvironment (void);
+  virtual void ConfigureProperties (void);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who);
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who);
+  virtual void FinalChecks (void);
+
+  /**
+   * \brief Count the IP fragments received by the receiver.
+   * \param p The packet, with its IP header.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface receiving the packet.
+   */
+  void IpRx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+private:
+  uint32_t m_maxSegments;     //!< Maximum number of segments in a large segment
+  uint32_t m_dataTx;          //!< Number of data packets sent
+  uint32_t m_largeTx;         //!< Number of large segments sent
+  uint32_t m_largeRx;         //!< Number of large segments received
+  uint32_t m_oversizeTx;      //!< Number of large segments longer than the MTU sent
+  uint32_t m_fragmentsRx;     //!< Number of IP fragments received
+  uint32_t m_bytesRx;         //!< Number of bytes received
+};
+
+TcpTsoTestCase::TcpTsoTestCase (const std::string &desc, uint32_t maxSegments)
+  : TcpGeneralTest (desc),
+    m_maxSegments (maxSegments),
+    m_dataTx (0),
+    m_largeTx (0),
+    m_largeRx (0),
+    m_oversizeTx (0),
+    m_fragmentsRx (0),
+    m_bytesRx (0)
+{
+}
+
+void
+TcpTsoTestCase::ConfigureEnvironment (void)
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktSize (500);
+  SetAppPktCount (100);
+  SetAppPktInterval (Time (0));
+  // The large segments are longer than the default MTU of 1500 bytes
+}
+
+void
+TcpTsoTestCase::ConfigureProperties (void)
+{
+  TcpGeneralTest::ConfigureProperties ();
+  SetSegmentSize (SENDER, 500);
+  SetSegmentSize (RECEIVER, 500);
+  SetInitialCwnd (SENDER, 10);
+  SetInitialSsThresh (SENDER, UINT32_MAX);
+  GetSenderSocket ()->SetAttribute ("TsoMaxSegments", UintegerValue (m_maxSegments));
+  // IP packets are traced there before being reassembled
+  GetReceiverSocket ()->GetNode ()->GetObject<Ipv4L3Protocol> ()->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&TcpTsoTestCase::IpRx, this));
+}
+
+void
+TcpTsoTestCase::IpRx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Ipv4Header header;
+  p->PeekHeader (header);
+  if (!header.IsLastFragment () || header.GetFragmentOffset () != 0)
+    {
+      ++m_fragmentsRx;
+    }
+}
+
+void
+TcpTsoTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != SENDER || p->GetSize () == 0)
+    {
+      return;
+    }
+  ++m_dataTx;
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (p->GetSize (), m_maxSegments * 500,
+                               "Large segment longer than TsoMaxSegments segments");
+  if (p->GetSize () > 500)
+    {
+      ++m_largeTx;
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize () % 500, 0, "Large segment made of partial segments");
+      if (p->GetSize () + h.GetSerializedSize () + 20 > 1500)
+        {
+          ++m_oversizeTx;
+        }
+    }
+}
+
+void
+TcpTsoTestCase::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != RECEIVER || p->GetSize () == 0)
+    {
+      return;
+    }
+  m_bytesRx += p->GetSize ();
+  if (p->GetSize () > 500)
+    {
+      ++m_largeRx;
+      SocketLargeSendTag tag;
+      NS_TEST_ASSERT_MSG_EQ (p->PeekPacketTag (tag), true, "Large segment without its tag");
+      NS_TEST_ASSERT_MSG_EQ (tag.GetSegmentSize (), 500, "Wrong segment size in the tag");
+    }
+}
+
+void
+TcpTsoTestCase::FinalChecks (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_bytesRx, 50000, "Data not entirely received");
+  NS_TEST_ASSERT_MSG_EQ (m_largeRx, m_largeTx, "Large segments lost their tag");
+  NS_TEST_ASSERT_MSG_EQ (m_fragmentsRx, 0, "Large segments fragmented on the way");
+  if (m_maxSegments == 1)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_largeTx, 0, "Large segments sent while offload is disabled");
+      NS_TEST_ASSERT_MSG_EQ (m_dataTx, 100, "Wrong number of segments sent");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (m_largeTx, 0, "No large segment sent");
+      NS_TEST_ASSERT_MSG_GT (m_oversizeTx, 0, "No large segment longer than the MTU sent");
+      NS_TEST_ASSERT_MSG_LT (m_dataTx, 100, "Large segments did not reduce the number of packets");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TestSuite: TCP segmentation offload
+ */
+class TcpTsoTestSuite : public TestSuite
+{
+public:
+  TcpTsoTestSuite ()
+    : TestSuite ("tcp-tso", UNIT)
+  {
+    AddTestCase (new TcpTsoTestCase ("Segmentation offload disabled", 1), TestCase::QUICK);
+    AddTestCase (new TcpTsoTestCase ("Large segments of up to 4 segments", 4), TestCase::QUICK);
+    AddTestCase (new TcpTsoTestCase ("Large segments of up to 16 segments", 16), TestCase::QUICK);
+  }
+};
+
+static TcpTsoTestSuite g_tcpTsoTestSuite; //!< Static variable for test initialization
@@ -49,6 +49,8 @@ private:
   void TestTransmittedBlock ();
   /** \brief Test the generation of the "next" block */
   void TestNextSeg ();
+  /** \brief Test the scoreboard and the payload with a large window */
+  void TestLargeWindow ();
 };
 
 TcpTxBufferTestCase::TcpTxBufferTestCase ()
@@ -81,6 +83,8 @@ TcpTxBufferTestCase::DoRun ()
                        &TcpTxBufferTestCase::TestTransmittedBlock, this);
   Simulator::Schedule (Seconds (0.0),
                        &TcpTxBufferTestCase::TestNextSeg, this);
+  Simulator::Schedule (Seconds (0.0),
+                       &TcpTxBufferTestCase::TestLargeWindow, this);
 
   Simulator::Run ();
   Simulator::Destroy ();
@@ -342,6 +346,84 @@ TcpTxBufferTestCase::TestTransmittedBlock ()
 {
 }
 
+void
+TcpTxBufferTestCase::TestLargeWindow ()
+{
+  const uint32_t segSize = 100;
+  const uint32_t nSegments = 5000;
+  TcpTxBuffer txBuf;
+  txBuf.SetHeadSequence (SequenceNumber32 (1));
+  txBuf.SetSegmentSize (segSize);
+  txBuf.SetDupAckThresh (3);
+  txBuf.SetMaxBufferSize (segSize * nSegments);
+
+  // Application writes which do not match the segment boundaries
+  uint8_t data[999];
+  uint32_t written = 0;
+  while (written < segSize * nSegments)
+    {
+      uint32_t size = std::min<uint32_t> (sizeof (data), segSize * nSegments - written);
+      for (uint32_t i = 0; i < size; ++i)
+        {
+          data[i] = (written + i) % 251;
+        }
+      txBuf.Add (Create<Packet> (data, size));
+      written += size;
+    }
+
+  for (uint32_t i = 0; i < nSegments; ++i)
+    {
+      txBuf.CopyFromSequence (segSize, SequenceNumber32 (1 + i * segSize));
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), segSize * nSegments,
+                         "TxBuf miscalculates size of in flight segments");
+
+  // Every tenth segment is lost, the others are SACKed one by one
+  for (uint32_t i = 1; i < nSegments; ++i)
+    {
+      if (i % 10 != 0)
+        {
+          TcpOptionSack::SackList sack;
+          sack.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (1 + i * segSize),
+                                                    SequenceNumber32 (1 + (i + 1) * segSize)));
+          txBuf.Update (sack);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetSacked (), segSize * nSegments * 9 / 10,
+                         "Wrong number of SACKed bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetLost (), segSize * nSegments / 10,
+                         "Wrong number of lost bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+
+  // Retransmit the holes, in order, and check their payload
+  uint8_t buffer[segSize];
+  for (uint32_t i = 0; i < nSegments; i += 10)
+    {
+      SequenceNumber32 seq;
+      NS_TEST_ASSERT_MSG_EQ (txBuf.NextSeg (&seq, true), true, "No segment to retransmit");
+      NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1 + i * segSize), "Wrong segment to retransmit");
+      NS_TEST_ASSERT_MSG_EQ (txBuf.IsLost (seq), true, "Segment should be lost");
+      Ptr<Packet> p = txBuf.CopyFromSequence (segSize, seq);
+      NS_TEST_ASSERT_MSG_EQ (p->GetSize (), segSize, "Wrong retransmission size");
+      p->CopyData (buffer, segSize);
+      for (uint32_t j = 0; j < segSize; ++j)
+        {
+          NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (buffer[j]), (i * segSize + j) % 251,
+                                 "Wrong payload at byte " << i * segSize + j);
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf.GetRetransmitsCount (), segSize * nSegments / 10,
+                         "Wrong number of retransmitted bytes");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), segSize * nSegments / 10,
+                         "TxBuf miscalculates size of in flight segments");
+
+  txBuf.DiscardUpTo (SequenceNumber32 (1 + nSegments * segSize));
+  NS_TEST_ASSERT_MSG_EQ (txBuf.Size (), 0, "Size is different than expected");
+  NS_TEST_ASSERT_MSG_EQ (txBuf.BytesInFlight (), 0,
+                         "TxBuf miscalculates size of in flight segments");
+}
+
 void
 TcpTxBufferTestCase::DoTeardown ()
 {
@@ -24,6 +24,8 @@
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/ptr.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
 #include "ns3/node.h"
 #include "ns3/names.h"
 #include "ns3/net-device.h"
@@ -35,6 +37,26 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 
+/**
+ * \ingroup network
+ * \brief A global switch to gzip the trace files named by the helpers.
+ */
+static GlobalValue g_traceCompression = GlobalValue ("TraceCompression",
+                                                     "A global switch to write helper-generated pcap and ascii trace files gzip-compressed (\".gz\" is appended to the file names)",
+                                                     BooleanValue (false),
+                                                     MakeBooleanChecker ());
+
+/**
+ * \returns the extension to append to helper-generated trace file names
+ */
+static std::string
+GetCompressionSuffix (void)
+{
+  BooleanValue compress;
+  g_traceCompression.GetValue (compress);
+  return compress.Get () ? ".gz" : "";
+}
+
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
@@ -116,7 +138,7 @@ PcapHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bo
       oss << device->GetIfIndex ();
     }
 
-  oss << ".pcap";
+  oss << ".pcap" << GetCompressionSuffix ();
 
   return oss.str ();
 }
@@ -154,7 +176,7 @@ PcapHelper::GetFilenameFromInterfacePair (std::string prefix, Ptr<Object> object
       oss << "n" << node->GetId ();
     }
 
-  oss << "-i" << interface << ".pcap";
+  oss << "-i" << interface << ".pcap" << GetCompressionSuffix ();
 
   return oss.str ();
 }
@@ -248,7 +270,7 @@ AsciiTraceHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> devi
       oss << device->GetIfIndex ();
     }
 
-  oss << ".tr";
+  oss << ".tr" << GetCompressionSuffix ();
 
   return oss.str ();
 }
@@ -290,7 +312,7 @@ AsciiTraceHelper::GetFilenameFromInterfacePair (
       oss << "n" << node->GetId ();
     }
 
-  oss << "-i" << interface << ".tr";
+  oss << "-i" << interface << ".tr" << GetCompressionSuffix ();
 
   return oss.str ();
 }
@@ -33,6 +33,10 @@ namespace ns3 {
  *
  * Handling pcap files is a common operation for ns-3 devices.  It is useful to
  * provide a common base class for dealing with these ops.
+ *
+ * Files whose name ends in ".gz" are written gzip-compressed.  Setting the
+ * "TraceCompression" GlobalValue makes the GetFilenameFrom* methods append
+ * that extension, so every helper-generated trace is compressed.
  */
 
 class PcapHelper
@@ -156,6 +160,9 @@ PcapHelper::HookDefaultSink (Ptr<T> object, std::string tracename, Ptr<PcapFileW
  *
  * Handling ascii trace files is a common operation for ns-3 devices.  It is 
  * useful to provide a common base class for dealing with these ops.
+ *
+ * As with PcapHelper, a ".gz" file name (or the "TraceCompression"
+ * GlobalValue) selects gzip-compressed output.
  */
 
 class AsciiTraceHelper
@@ -22,26 +22,46 @@
 #include <vector>
 #include <cstring>
 #include <limits>
+#include <new>
 
 #define USE_FREE_LIST 1
 #define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (std::numeric_limits<int32_t>::max ())
+#define INDEX_SHIFT 4
+#define INDEX_LEVELS 4
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("ByteTagList");
 
+/**
+ * \ingroup packet
+ *
+ * \brief Summary of a run of consecutive tags stored in a ByteTagListData.
+ */
+struct ByteTagListIndexEntry {
+  int32_t minStart; //!< smallest start offset of the tags of the run
+  int32_t maxEnd;   //!< largest end offset of the tags of the run
+  uint32_t offset;  //!< position of the first tag of the run in the data
+};
+
 /**
  * \ingroup packet
  *
  * \brief Internal representation of the byte tags stored in a packet.
  *
  * This structure is only used by ByteTagList and should not be accessed directly.
+ *
+ * Level l of the index summarizes runs of 2^(INDEX_SHIFT * (l + 1)) tags.
+ * A level is only created once the data holds enough tags to fill its
+ * first run. Tags whose TypeId is zero have been removed by a cut.
  */
 struct ByteTagListData {
   uint32_t size;   //!< size of the data
   uint32_t count;  //!< use counter (for smart deallocation)
   uint32_t dirty;  //!< number of bytes actually in use
+  uint32_t nTags;  //!< number of tags stored in the first dirty bytes
+  std::vector<struct ByteTagListIndexEntry> index[INDEX_LEVELS]; //!< run summaries
   uint8_t data[4]; //!< data
 };
 
@@ -66,12 +86,236 @@ ByteTagListDataFreeList::~ByteTagListDataFreeList ()
   for (ByteTagListDataFreeList::iterator i = begin ();
        i != end (); i++)
     {
+      (*i)->~ByteTagListData ();
       uint8_t *buffer = (uint8_t *)(*i);
       delete [] buffer;
     }
 }
 #endif /* USE_FREE_LIST */
 
+/**
+ * \param level an index level
+ * \returns the number of tags summarized by an entry of this level
+ */
+static uint32_t
+GetRunLength (uint32_t level)
+{
+  return 1U << (INDEX_SHIFT * (level + 1));
+}
+
+/**
+ * \param data the tag data
+ * \param level an index level
+ * \param run an entry of this level
+ * \returns the position in the data following the last tag of the run
+ */
+static uint32_t
+GetRunEnd (const struct ByteTagListData *data, uint32_t level, uint32_t run)
+{
+  const std::vector<struct ByteTagListIndexEntry> &runs = data->index[level];
+  return run + 1 < runs.size () ? runs[run + 1].offset : data->dirty;
+}
+
+/**
+ * \param data the tag data
+ * \param start position of the first tag to summarize
+ * \param end position following the last tag to summarize
+ * \returns the summary of the tags
+ */
+static struct ByteTagListIndexEntry
+SummarizeTags (struct ByteTagListData *data, uint32_t start, uint32_t end)
+{
+  struct ByteTagListIndexEntry entry;
+  entry.minStart = INT32_MAX;
+  entry.maxEnd = INT32_MIN;
+  entry.offset = start;
+  uint32_t current = start;
+  while (current < end)
+    {
+      TagBuffer buf = TagBuffer (&data->data[current], &data->data[end]);
+      uint32_t tid = buf.ReadU32 ();
+      uint32_t size = buf.ReadU32 ();
+      int32_t tagStart = buf.ReadU32 ();
+      int32_t tagEnd = buf.ReadU32 ();
+      if (tid != 0)
+        {
+          entry.minStart = std::min (entry.minStart, tagStart);
+          entry.maxEnd = std::max (entry.maxEnd, tagEnd);
+        }
+      current += 4 + 4 + 4 + 4 + size;
+    }
+  return entry;
+}
+
+/**
+ * \param runs the entries of an index level
+ * \param first the first entry to merge
+ * \param n the number of entries to merge
+ * \returns the summary of the runs
+ */
+static struct ByteTagListIndexEntry
+MergeRuns (const std::vector<struct ByteTagListIndexEntry> &runs, uint32_t first, uint32_t n)
+{
+  struct ByteTagListIndexEntry entry;
+  entry.minStart = INT32_MAX;
+  entry.maxEnd = INT32_MIN;
+  entry.offset = runs[first].offset;
+  for (uint32_t i = first; i < first + n && i < runs.size (); ++i)
+    {
+      entry.minStart = std::min (entry.minStart, runs[i].minStart);
+      entry.maxEnd = std::max (entry.maxEnd, runs[i].maxEnd);
+    }
+  return entry;
+}
+
+/**
+ * Add the tag stored after all the tags of the data to the index.
+ *
+ * \param data the tag data
+ * \param current position of the tag
+ * \param next position following the tag
+ * \param start start offset of the tag
+ * \param end end offset of the tag
+ */
+static void
+IndexTag (struct ByteTagListData *data, uint32_t current, uint32_t next, int32_t start, int32_t end)
+{
+  uint32_t n = data->nTags++;
+  for (uint32_t level = 0; level < INDEX_LEVELS; ++level)
+    {
+      std::vector<struct ByteTagListIndexEntry> &runs = data->index[level];
+      if (runs.empty ())
+        {
+          if (n + 1 == GetRunLength (level))
+            {
+              runs.push_back (level == 0 ? SummarizeTags (data, 0, next)
+                              : MergeRuns (data->index[level - 1], 0, 1U << INDEX_SHIFT));
+            }
+          return;
+        }
+      if ((n >> (INDEX_SHIFT * (level + 1))) == runs.size ())
+        {
+          struct ByteTagListIndexEntry entry;
+          entry.minStart = start;
+          entry.maxEnd = end;
+          entry.offset = current;
+          runs.push_back (entry);
+        }
+      else
+        {
+          runs.back ().minStart = std::min (runs.back ().minStart, start);
+          runs.back ().maxEnd = std::max (runs.back ().maxEnd, end);
+        }
+    }
+}
+
+/**
+ * Rebuild the index of the first dirty bytes of the data.
+ *
+ * \param data the tag data
+ */
+static void
+RebuildIndex (struct ByteTagListData *data)
+{
+  data->nTags = 0;
+  for (uint32_t level = 0; level < INDEX_LEVELS; ++level)
+    {
+      data->index[level].clear ();
+    }
+  uint32_t current = 0;
+  while (current < data->dirty)
+    {
+      TagBuffer buf = TagBuffer (&data->data[current], &data->data[data->dirty]);
+      uint32_t tid = buf.ReadU32 ();
+      uint32_t size = buf.ReadU32 ();
+      int32_t start = buf.ReadU32 ();
+      int32_t end = buf.ReadU32 ();
+      uint32_t next = current + 4 + 4 + 4 + 4 + size;
+      if (tid == 0)
+        {
+          start = INT32_MAX;
+          end = INT32_MIN;
+        }
+      IndexTag (data, current, next, start, end);
+      current = next;
+    }
+}
+
+/**
+ * Cut the tags stored between two positions of the data to a window.
+ *
+ * \param data the tag data
+ * \param start position of the first tag
+ * \param end position following the last tag
+ * \param clipStart start of the window
+ * \param clipEnd end of the window
+ */
+static void
+ClipTags (struct ByteTagListData *data, uint32_t start, uint32_t end, int32_t clipStart, int32_t clipEnd)
+{
+  uint32_t current = start;
+  while (current < end)
+    {
+      TagBuffer buf = TagBuffer (&data->data[current], &data->data[end]);
+      uint32_t tid = buf.ReadU32 ();
+      uint32_t size = buf.ReadU32 ();
+      int32_t tagStart = buf.ReadU32 ();
+      int32_t tagEnd = buf.ReadU32 ();
+      if (tid != 0)
+        {
+          if (tagStart >= clipEnd || tagEnd <= clipStart || clipStart >= clipEnd)
+            {
+              TagBuffer (&data->data[current], &data->data[end]).WriteU32 (0);
+            }
+          else
+            {
+              buf = TagBuffer (&data->data[current + 4 + 4], &data->data[end]);
+              buf.WriteU32 (std::max (tagStart, clipStart));
+              buf.WriteU32 (std::min (tagEnd, clipEnd));
+            }
+        }
+      current += 4 + 4 + 4 + 4 + size;
+    }
+}
+
+/**
+ * Cut the tags of a run which are stored before a position to a window,
+ * visiting only the sub-runs which extend beyond the window, and update
+ * their summaries.
+ *
+ * \param data the tag data
+ * \param level the index level of the run
+ * \param run the run
+ * \param clipUsed position following the last tag to cut
+ * \param clipStart start of the window
+ * \param clipEnd end of the window
+ */
+static void
+ClipRun (struct ByteTagListData *data, uint32_t level, uint32_t run,
+         uint32_t clipUsed, int32_t clipStart, int32_t clipEnd)
+{
+  struct ByteTagListIndexEntry &entry = data->index[level][run];
+  if (entry.offset >= clipUsed
+      || (entry.minStart >= clipStart && entry.maxEnd <= clipEnd))
+    {
+      return;
+    }
+  uint32_t runEnd = GetRunEnd (data, level, run);
+  if (level == 0)
+    {
+      ClipTags (data, entry.offset, std::min (runEnd, clipUsed), clipStart, clipEnd);
+      entry = SummarizeTags (data, entry.offset, runEnd);
+      return;
+    }
+  uint32_t first = run << INDEX_SHIFT;
+  uint32_t n = 1U << INDEX_SHIFT;
+  for (uint32_t i = first; i < first + n && i < data->index[level - 1].size (); ++i)
+    {
+      ClipRun (data, level - 1, i, clipUsed, clipStart, clipEnd);
+    }
+  entry = MergeRuns (data->index[level - 1], first, n);
+}
+
 ByteTagList::Iterator::Item::Item (TagBuffer buf_)
   : buf (buf_)
 {
@@ -94,6 +338,7 @@ ByteTagList::Iterator::Next (void)
   item.start = std::max (m_nextStart, m_offsetStart);
   item.end = std::min (m_nextEnd, m_offsetEnd);
   m_current += 4 + 4 + 4 + 4 + item.size;
+  m_index++;
   item.buf.TrimAtEnd (m_end - m_current);
   PrepareForNext ();
   return item;
@@ -104,14 +349,28 @@ ByteTagList::Iterator::PrepareForNext (void)
   NS_LOG_FUNCTION (this);
   while (m_current < m_end)
     {
+      if (SkipRun ())
+        {
+          continue;
+        }
       TagBuffer buf = TagBuffer (m_current, m_end);
       m_nextTid = buf.ReadU32 ();
       m_nextSize = buf.ReadU32 ();
-      m_nextStart = buf.ReadU32 () + m_adjustment;
-      m_nextEnd = buf.ReadU32 () + m_adjustment;
-      if (m_nextStart >= m_offsetEnd || m_nextEnd <= m_offsetStart)
+      int32_t start = buf.ReadU32 ();
+      int32_t end = buf.ReadU32 ();
+      bool removed = m_nextTid == 0;
+      if (m_current < m_clip)
+        {
+          removed = removed || start >= m_clipEnd || end <= m_clipStart || m_clipStart >= m_clipEnd;
+          start = std::max (start, m_clipStart);
+          end = std::min (end, m_clipEnd);
+        }
+      m_nextStart = start + m_adjustment;
+      m_nextEnd = end + m_adjustment;
+      if (removed || m_nextStart >= m_offsetEnd || m_nextEnd <= m_offsetStart)
         {
           m_current += 4 + 4 + 4 + 4 + m_nextSize;
+          m_index++;
         }
       else
         {
@@ -119,14 +378,53 @@ ByteTagList::Iterator::PrepareForNext (void)
         }
     }
 }
-ByteTagList::Iterator::Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment)
-  : m_current (start),
-    m_end (end),
+bool
+ByteTagList::Iterator::SkipRun (void)
+{
+  if (m_data == 0 || m_data->index[0].empty () || (m_index & ((1U << INDEX_SHIFT) - 1)) != 0)
+    {
+      return false;
+    }
+  for (int32_t level = INDEX_LEVELS - 1; level >= 0; --level)
+    {
+      uint32_t shift = INDEX_SHIFT * (level + 1);
+      uint32_t run = m_index >> shift;
+      if ((m_index & ((1U << shift) - 1)) != 0 || run >= m_data->index[level].size ())
+        {
+          continue;
+        }
+      const struct ByteTagListIndexEntry &entry = m_data->index[level][run];
+      uint8_t *runEnd = std::min (&m_data->data[GetRunEnd (m_data, level, run)], m_end);
+      int64_t start = static_cast<int64_t> (m_offsetStart) - m_adjustment;
+      int64_t end = static_cast<int64_t> (m_offsetEnd) - m_adjustment;
+      if (runEnd <= m_clip)
+        {
+          start = std::max<int64_t> (start, m_clipStart);
+          end = std::min<int64_t> (end, m_clipEnd);
+        }
+      if (entry.minStart >= end || entry.maxEnd <= start)
+        {
+          m_current = runEnd;
+          m_index += GetRunLength (level);
+          return true;
+        }
+    }
+  return false;
+}
+ByteTagList::Iterator::Iterator (struct ByteTagListData *data, uint32_t used, int32_t offsetStart, int32_t offsetEnd,
+                                 int32_t adjustment, uint32_t clipUsed, int32_t clipStart, int32_t clipEnd)
+  : m_data (data),
+    m_current (data == 0 ? 0 : data->data),
+    m_end (data == 0 ? 0 : &data->data[used]),
+    m_clip (data == 0 ? 0 : &data->data[clipUsed]),
+    m_index (0),
+    m_clipStart (clipStart),
+    m_clipEnd (clipEnd),
     m_offsetStart (offsetStart),
     m_offsetEnd (offsetEnd),
     m_adjustment (adjustment)
 {
-  NS_LOG_FUNCTION (this << &start << &end << offsetStart << offsetEnd << adjustment);
+  NS_LOG_FUNCTION (this << data << used << offsetStart << offsetEnd << adjustment);
   PrepareForNext ();
 }
 
@@ -143,6 +441,9 @@ ByteTagList::ByteTagList ()
     m_maxEnd (INT32_MIN),
     m_adjustment (0),
     m_used (0),
+    m_clipUsed (0),
+    m_clipStart (INT32_MIN),
+    m_clipEnd (INT32_MAX),
     m_data (0)
 {
   NS_LOG_FUNCTION (this);
@@ -152,6 +453,9 @@ ByteTagList::ByteTagList (const ByteTagList &o)
     m_maxEnd (o.m_maxEnd),
     m_adjustment (o.m_adjustment),
     m_used (o.m_used),
+    m_clipUsed (o.m_clipUsed),
+    m_clipStart (o.m_clipStart),
+    m_clipEnd (o.m_clipEnd),
     m_data (o.m_data)
 {
   NS_LOG_FUNCTION (this << &o);
@@ -174,6 +478,9 @@ ByteTagList::operator = (const ByteTagList &o)
   m_adjustment = o.m_adjustment;
   m_data = o.m_data;
   m_used = o.m_used;
+  m_clipUsed = o.m_clipUsed;
+  m_clipStart = o.m_clipStart;
+  m_clipEnd = o.m_clipEnd;
   if (m_data != 0)
     {
       m_data->count++;
@@ -202,10 +509,13 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
     {
-      struct ByteTagListData *newData = Allocate (spaceNeeded);
-      std::memcpy (&newData->data, &m_data->data, m_used);
-      Deallocate (m_data);
-      m_data = newData;
+      Reallocate (spaceNeeded);
+    }
+  else if (m_data->dirty != m_used)
+    {
+      // the tags after m_used belonged to a list which shared the data
+      m_data->dirty = m_used;
+      RebuildIndex (m_data);
     }
   TagBuffer tag = TagBuffer (&m_data->data[m_used], 
                              &m_data->data[spaceNeeded]);
@@ -221,6 +531,7 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
     {
       m_maxEnd = end - m_adjustment;
     }
+  IndexTag (m_data, m_used, spaceNeeded, start - m_adjustment, end - m_adjustment);
   m_used = spaceNeeded;
   m_data->dirty = m_used;
   return tag;
@@ -247,6 +558,9 @@ ByteTagList::RemoveAll (void)
   m_minStart = INT32_MAX;
   m_maxEnd = INT32_MIN;
   m_adjustment = 0;
+  m_clipUsed = 0;
+  m_clipStart = INT32_MIN;
+  m_clipEnd = INT32_MAX;
   m_data = 0;
   m_used = 0;
 }
@@ -264,14 +578,8 @@ ByteTagList::Iterator
 ByteTagList::Begin (int32_t offsetStart, int32_t offsetEnd) const
 {
   NS_LOG_FUNCTION (this << offsetStart << offsetEnd);
-  if (m_data == 0)
-    {
-      return Iterator (0, 0, offsetStart, offsetEnd, 0);
-    }
-  else
-    {
-      return Iterator (m_data->data, &m_data->data[m_used], offsetStart, offsetEnd, m_adjustment);
-    }
+  return Iterator (m_data, m_used, offsetStart, offsetEnd, m_adjustment,
+                   m_clipUsed, m_clipStart, m_clipEnd);
 }
 
 void 
@@ -282,28 +590,8 @@ ByteTagList::AddAtEnd (int32_t appendOffset)
     {
       return;
     }
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
-    {
-      ByteTagList::Iterator::Item item = i.Next ();
-
-      if (item.start >= appendOffset)
-        {
-          continue;
-        }
-      if (item.end > appendOffset)
-        {
-          item.end = appendOffset;
-        }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.end > m_maxEnd)
-        {
-          m_maxEnd = item.end;
-        }
-    }
-  *this = list;
+  Clip (INT32_MIN, appendOffset - m_adjustment);
+  m_maxEnd = appendOffset - m_adjustment;
 }
 
 void 
@@ -314,29 +602,80 @@ ByteTagList::AddAtStart (int32_t prependOffset)
     {
       return;
     }
-  m_minStart = INT32_MAX;
-  ByteTagList list;
-  ByteTagList::Iterator i = BeginAll ();
-  while (i.HasNext ())
+  Clip (prependOffset - m_adjustment, INT32_MAX);
+  m_minStart = prependOffset - m_adjustment;
+}
+
+void
+ByteTagList::Clip (int32_t start, int32_t end)
+{
+  NS_LOG_FUNCTION (this << start << end);
+  if (m_clipUsed != 0 && m_clipUsed != m_used)
     {
-      ByteTagList::Iterator::Item item = i.Next ();
+      // The current window does not apply to the tags added since it
+      // was set, so it cannot be merged with the new one.
+      ApplyClip ();
+    }
+  m_clipUsed = m_used;
+  m_clipStart = std::max (m_clipStart, start);
+  m_clipEnd = std::min (m_clipEnd, end);
+}
 
-      if (item.end <= prependOffset)
+void
+ByteTagList::ApplyClip (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_data->count != 1)
+    {
+      Reallocate (m_used);
+    }
+  else if (m_data->dirty != m_used)
+    {
+      m_data->dirty = m_used;
+      RebuildIndex (m_data);
+    }
+  if (m_data->index[0].empty ())
+    {
+      ClipTags (m_data, 0, m_clipUsed, m_clipStart, m_clipEnd);
+    }
+  else
+    {
+      uint32_t top = INDEX_LEVELS - 1;
+      while (m_data->index[top].empty ())
         {
-          continue;
+          top--;
         }
-      if (item.start < prependOffset)
+      for (uint32_t run = 0; run < m_data->index[top].size (); ++run)
         {
-          item.start = prependOffset;
+          ClipRun (m_data, top, run, m_clipUsed, m_clipStart, m_clipEnd);
         }
-      TagBuffer buf = list.Add (item.tid, item.size, item.start, item.end);
-      buf.CopyFrom (item.buf);
-      if (item.start < m_minStart)
+    }
+  m_clipUsed = 0;
+  m_clipStart = INT32_MIN;
+  m_clipEnd = INT32_MAX;
+}
+
+void
+ByteTagList::Reallocate (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  struct ByteTagListData *newData = Allocate (size);
+  std::memcpy (&newData->data, &m_data->data, m_used);
+  newData->dirty = m_used;
+  if (m_data->dirty == m_used)
+    {
+      newData->nTags = m_data->nTags;
+      for (uint32_t level = 0; level < INDEX_LEVELS; ++level)
         {
-          m_minStart = item.start;
+          newData->index[level] = m_data->index[level];
         }
     }
-  *this = list;
+  else
+    {
+      RebuildIndex (newData);
+    }
+  Deallocate (m_data);
+  m_data = newData;
 }
 
 #ifdef USE_FREE_LIST
@@ -354,16 +693,24 @@ ByteTagList::Allocate (uint32_t size)
         {
           data->count = 1;
           data->dirty = 0;
+          data->nTags = 0;
+          for (uint32_t level = 0; level < INDEX_LEVELS; ++level)
+            {
+              data->index[level].clear ();
+            }
           return data;
         }
+      data->~ByteTagListData ();
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  size = std::max (size, g_maxSize);
+  uint8_t *buffer = new uint8_t [size + sizeof (struct ByteTagListData) - 4];
+  struct ByteTagListData *data = new (buffer) ByteTagListData ();
   data->count = 1;
   data->size = size;
   data->dirty = 0;
+  data->nTags = 0;
   return data;
 }
 
@@ -382,6 +729,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
       if (g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
+          data->~ByteTagListData ();
           uint8_t *buffer = (uint8_t *)data;
           delete [] buffer;
         }
@@ -399,10 +747,11 @@ ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   uint8_t *buffer = new uint8_t [size + sizeof (struct ByteTagListData) - 4];
-  struct ByteTagListData *data = (struct ByteTagListData *)buffer;
+  struct ByteTagListData *data = new (buffer) ByteTagListData ();
   data->count = 1;
   data->size = size;
   data->dirty = 0;
+  data->nTags = 0;
   return data;
 }
 
@@ -417,6 +766,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
   data->count--;
   if (data->count == 0)
     {
+      data->~ByteTagListData ();
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
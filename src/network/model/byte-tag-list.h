@@ -59,6 +59,18 @@ struct ByteTagListData;
  *     the boundaries before returning item. However, when packet is extending,
  *     it calls ByteTagList::AddAtStart or ByteTagList::AddAtEnd to cut byte
  *     tags that will otherwise cover new bytes.
+ *
+ *   - Cutting is lazy: the list records a clip window which applies to the
+ *     tags stored before the cut, and the iterator applies it on the fly.
+ *     The stored tags are only rewritten when a second cut is needed after
+ *     new tags were added, and then only where the window actually cuts.
+ *
+ *   - Once a ByteTagListData holds enough tags, it maintains a multi-level
+ *     index summarizing the offsets covered by runs of 16, 256, ...
+ *     consecutive tags. Iterators and cuts use it to skip whole runs of
+ *     tags which are outside of the requested range, so that iterating
+ *     over a fragment of a packet carrying many tags does not visit all
+ *     of them.
  */
 class ByteTagList
 {
@@ -122,20 +134,35 @@ private:
 
     /**
      * \brief Constructor
-     * \param start Starting tag
-     * \param end End tag
+     * \param data the tag data, or zero if the list is empty
+     * \param used number of bytes of data used by the list
      * \param offsetStart offset to the start of the tag from the virtual byte buffer
      * \param offsetEnd offset to the end of the tag from the virtual byte buffer
      * \param adjustment adjustment to byte tag offsets
+     * \param clipUsed number of bytes of data holding tags to which the clip window applies
+     * \param clipStart start of the clip window, before adjustment
+     * \param clipEnd end of the clip window, before adjustment
      */
-    Iterator (uint8_t *start, uint8_t *end, int32_t offsetStart, int32_t offsetEnd, int32_t adjustment);
+    Iterator (struct ByteTagListData *data, uint32_t used, int32_t offsetStart, int32_t offsetEnd,
+              int32_t adjustment, uint32_t clipUsed, int32_t clipStart, int32_t clipEnd);
 
     /**
      * \brief Prepare the iterator for the next tag
      */
     void PrepareForNext (void);
+    /**
+     * \brief Skip the largest run of tags starting at the current tag
+     * which the index proves to be outside of the iteration range.
+     * \returns true if a run was skipped
+     */
+    bool SkipRun (void);
+    struct ByteTagListData *m_data; //!< the tag data
     uint8_t *m_current;     //!< Current tag
     uint8_t *m_end;         //!< End tag
+    uint8_t *m_clip;        //!< Tags before this one are cut to the clip window
+    uint32_t m_index;       //!< Index of the current tag in the tag data
+    int32_t m_clipStart;    //!< Start of the clip window, before adjustment
+    int32_t m_clipEnd;      //!< End of the clip window, before adjustment
     int32_t m_offsetStart;  //!< Offset to the start of the tag from the virtual byte buffer
     int32_t m_offsetEnd;    //!< Offset to the end of the tag from the virtual byte buffer
     int32_t m_adjustment;   //!< Adjustment to byte tag offsets
@@ -239,6 +266,24 @@ private:
    */
   ByteTagList::Iterator BeginAll (void) const;
 
+  /**
+   * \brief Cut the tags to a window, lazily.
+   * \param start the start of the window, before adjustment
+   * \param end the end of the window, before adjustment
+   */
+  void Clip (int32_t start, int32_t end);
+
+  /**
+   * \brief Rewrite the tags covered by the current clip window and reset it.
+   */
+  void ApplyClip (void);
+
+  /**
+   * \brief Copy the used part of the tag data into a new ByteTagListData.
+   * \param size the memory to allocate
+   */
+  void Reallocate (uint32_t size);
+
   /**
    * \brief Allocate the memory for the ByteTagListData
    * \param size the memory to allocate
@@ -256,6 +301,9 @@ private:
   int32_t m_maxEnd; //!< maximal end offset
   int32_t m_adjustment; //!< adjustment to byte tag offsets
   uint32_t m_used; //!< the number of used bytes in the buffer
+  uint32_t m_clipUsed; //!< the number of bytes holding tags to which the clip window applies
+  int32_t m_clipStart; //!< start of the clip window, before adjustment
+  int32_t m_clipEnd; //!< end of the clip window, before adjustment
   struct ByteTagListData *m_data; //!< the ByteTagListData structure
 };
 
@@ -20,6 +20,8 @@
 
 #include "ns3/log.h"
 #include "net-device.h"
+#include "ns3/packet-burst.h"
+#include "ns3/net-device-queue-interface.h"
 
 namespace ns3 {
 
@@ -41,4 +43,26 @@ NetDevice::~NetDevice ()
   NS_LOG_FUNCTION (this);
 }
 
+uint32_t
+NetDevice::SendBatch (Ptr<PacketBurst> burst, const Address& dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << burst << dest << protocolNumber);
+  Ptr<NetDeviceQueue> txq;
+  Ptr<NetDeviceQueueInterface> ndqi = GetObject<NetDeviceQueueInterface> ();
+  if (ndqi && ndqi->GetNTxQueues () == 1)
+    {
+      txq = ndqi->GetTxQueue (0);
+    }
+  uint32_t n = 0;
+  for (std::list<Ptr<Packet> >::const_iterator i = burst->Begin (); i != burst->End (); i++, n++)
+    {
+      if (n > 0 && txq && txq->IsStopped ())
+        {
+          break;
+        }
+      Send (*i, dest, protocolNumber);
+    }
+  return n;
+}
+
 } // namespace ns3
@@ -34,6 +34,7 @@ namespace ns3 {
 
 class Node;
 class Channel;
+class PacketBurst;
 
 /**
  * \ingroup network
@@ -246,6 +247,27 @@ public:
    * \return whether the Send operation succeeded 
    */
   virtual bool Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) = 0;
+  /**
+   * \param burst packets sent from above down to Network Device, in order
+   * \param dest mac address of the destination (already resolved)
+   * \param protocolNumber identifies the type of payload contained in
+   *        these packets. Used to call the right L3Protocol when the packets
+   *        are received.
+   *
+   *  Called from higher layer to send several packets at once into Network
+   *  Device to the specified destination Address. A device can override this
+   *  method to start the transmission of the whole burst in one go; the
+   *  default implementation calls Send for each packet.
+   *
+   *  Like the higher layer would do between two calls to Send, the device
+   *  stops taking packets from the burst as soon as its (single) transmission
+   *  queue is stopped. Packets which were handed to Send count as taken, even
+   *  if Send dropped them.
+   *
+   * \return the number of packets, from the start of the burst, taken by
+   *         the device. The caller keeps ownership of the remaining packets.
+   */
+  virtual uint32_t SendBatch (Ptr<PacketBurst> burst, const Address& dest, uint16_t protocolNumber);
   /**
    * \param packet packet sent from above down to Network Device
    * \param source source mac address (so called "MAC spoofing")
@@ -20,7 +20,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a flat, shared list of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -29,231 +29,187 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
+#include <new>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
-PacketTagList::TagData *
-PacketTagList::CreateTagData (size_t dataSize)
+PacketTagList::TagBlock *
+PacketTagList::CreateTagBlock (uint32_t capacity)
 {
-  NS_ASSERT_MSG (dataSize
-                 < std::numeric_limits<decltype(TagData::size)>::max (),
-                 "Requested TagData size " << dataSize
-                 << " exceeds maximum "
-                 << std::numeric_limits<decltype(TagData::size)>::max () );
-
-  void * p = std::malloc (sizeof (TagData) + dataSize - 1);
-  // The matching frees are in RemoveAll and RemoveWriter
-
-  TagData * tag = new (p) TagData;
-  tag->size = dataSize;
-  return tag;
+  NS_ASSERT (capacity > 0);
+  void * p = std::malloc (sizeof (TagBlock) + (capacity - 1) * sizeof (TagData));
+  // The matching free is in FreeTagBlock
+
+  TagBlock * block = static_cast<TagBlock *> (p);
+  block->count = 1;
+  block->size = 0;
+  block->capacity = capacity;
+  return block;
 }
 
-bool
-PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
+void
+PacketTagList::FreeTagBlock (TagBlock *block)
 {
-  TypeId tid = tag.GetInstanceTypeId ();
-  NS_LOG_FUNCTION (this << tid);
-  NS_LOG_INFO     ("looking for " << tid);
-
-  // trivial case when list is empty
-  if (m_next == 0)
+  for (uint32_t i = 0; i < block->size; ++i)
     {
-      return false;
+      TagData *data = &block->tags[i];
+      if (data->size > TagData::INLINE_SIZE)
+        {
+          std::free (data->heapData);
+        }
+      data->~TagData ();
     }
+  std::free (block);
+}
 
-  bool found = false;
+void
+PacketTagList::SetTagData (TagData *data, Tag const &tag)
+{
+  uint32_t size = tag.GetSerializedSize ();
+  data->tid = tag.GetInstanceTypeId ();
+  data->size = size;
+  if (size > TagData::INLINE_SIZE)
+    {
+      data->heapData = static_cast<uint8_t *> (std::malloc (size));
+    }
+  uint8_t *buffer = data->GetData ();
+  tag.Serialize (TagBuffer (buffer, buffer + size));
+}
 
-  struct TagData ** prevNext = &m_next; // previous node's next pointer
-  struct TagData  * cur      =  m_next; // cursor to current node
-  struct TagData  * it = 0;             // utility
+void
+PacketTagList::CopyTagData (TagData *to, TagData const *from)
+{
+  to->tid = from->tid;
+  to->size = from->size;
+  if (from->size > TagData::INLINE_SIZE)
+    {
+      to->heapData = static_cast<uint8_t *> (std::malloc (from->size));
+      std::memcpy (to->heapData, from->heapData, from->size);
+    }
+  else
+    {
+      std::memcpy (to->inlineData, from->inlineData, from->size);
+    }
+}
 
-  // Search from the head of the list until we find tid or a merge
-  while (cur != 0)
+int32_t
+PacketTagList::Find (TypeId tid) const
+{
+  if (m_block == 0)
     {
-      if (cur->count > 1)
-        {
-          // found merge
-          NS_LOG_INFO ("found initial merge before tid");
-          break;
-        }
-      else if (cur->tid == tid)
-        {
-          NS_LOG_INFO ("found tid before initial merge, calling writer");
-          found = (this->*Writer)(tag, true, cur, prevNext);
-          break;
-        }
-      else
+      return -1;
+    }
+  for (uint32_t i = 0; i < m_block->size; ++i)
+    {
+      if (m_block->tags[i].tid == tid)
         {
-          // no merge or tid found yet, move on
-          prevNext = &cur->next;
-          cur      =  cur->next;
+          return i;
         }
-    }  // while !found && !cow
+    }
+  return -1;
+}
 
-  // did we find it or run out of tags?
-  if (cur == 0 || found)
+void
+PacketTagList::MakeWritable (uint32_t capacity)
+{
+  if (m_block != 0 && m_block->count == 1 && m_block->capacity >= capacity)
     {
-      NS_LOG_INFO ("returning after header with found: " << found);
-      return found;
+      return;
     }
-
-  // From here on out, we have to copy the list
-  // until we find tid, then link past it
-
-  // Before we do all that work, let's make sure tid really exists
-  for (it = cur; it != 0; it = it->next)
+  uint32_t newCapacity = INITIAL_CAPACITY;
+  if (m_block != 0 && m_block->capacity > newCapacity)
     {
-      if (it->tid == tid)
-        {
-          break;
-        }
+      newCapacity = m_block->capacity;
     }
-  if (it == 0)
+  while (newCapacity < capacity)
     {
-      // got to end of list without finding tid
-      NS_LOG_INFO ("tid not found after first merge");
-      return found;
+      newCapacity *= 2;
     }
-
-  // At this point cur is a merge, but untested for tid
-  NS_ASSERT (cur != 0);
-  NS_ASSERT (cur->count > 1);
-
-  /*
-     Walk the remainder of the list, copying, until we find tid
-     As we put a copy of the cur node onto our list,
-     we move the merge point down the list.
-
-     Starting position                  End position
-       T1 is a merge                     T1.count decremented
-                                         T2 is a merge
-                                         T1' is a copy of T1
-
-          other                             other
-               \                                 \
-      Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-           /   /                                         /|
-      pNext cur                         Prev  ->  T1' --/ |
-                                                     /    |
-                                                pNext   cur
-
-     When we reach tid, we link past it, decrement count, and we're done.
-  */
-
-  // Should normally check for null cur pointer,
-  // but since we know tid exists, we'll skip this test
-  while ( /* cur && */ cur->tid != tid)
+  NS_LOG_INFO ("copying the tag block, new capacity " << newCapacity);
+  TagBlock *block = CreateTagBlock (newCapacity);
+  if (m_block != 0)
     {
-      NS_ASSERT (cur != 0);
-      NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
-      struct TagData * copy = CreateTagData (cur->size);
-      copy->tid = cur->tid;
-      copy->count = 1;
-      copy->size = cur->size;
-      memcpy (copy->data, cur->data, copy->size);
-      copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
-      *prevNext = copy;                   // point prior list at copy
-      prevNext = &copy->next;             // advance
-      cur      =  copy->next;
+      for (uint32_t i = 0; i < m_block->size; ++i)
+        {
+          TagData *data = new (&block->tags[i]) TagData;
+          if (m_block->count == 1)
+            {
+              // we own the old block: move the tags, including any
+              // out-of-line data
+              std::memcpy (static_cast<void *> (data), &m_block->tags[i], sizeof (TagData));
+              m_block->tags[i].size = 0;
+            }
+          else
+            {
+              CopyTagData (data, &m_block->tags[i]);
+            }
+        }
+      block->size = m_block->size;
+      RemoveAll ();
     }
-  // Sanity check:
-  NS_ASSERT (cur != 0);                 // cur should be non-zero
-  NS_ASSERT (cur->tid == tid);          // cur->tid should be tid
-  NS_ASSERT (cur->count > 1);           // cur should be a merge
-
-  // link around tid, removing it from our list
-  found = (this->*Writer)(tag, false, cur, prevNext);
-  return found;
-
+  m_block = block;
 }
 
 bool
 PacketTagList::Remove (Tag & tag)
 {
-  return COWTraverse (tag, &PacketTagList::RemoveWriter);
-}
-
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
-                             struct PacketTagList::TagData  * cur,
-                             struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-  *prevNext = cur->next;            // link around cur
-
-  if (preMerge)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  int32_t i = Find (tid);
+  if (i < 0)
     {
-      // found tid before first merge, so delete cur
-      cur->~TagData ();
-      std::free (cur);
+      return false;
     }
-  else
+  TagData const *found = &m_block->tags[i];
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (found->GetData ()),
+                              const_cast<uint8_t *> (found->GetData ()) + found->size));
+  if (m_block->size == 1)
     {
-      // cur is always a merge at this point
-      // unmerge cur, since we linked around it already
-      cur->count--;
-      if (cur->next != 0)
-        {
-          // there's a next, so make it a merge
-          cur->next->count++;
-        }
+      // last tag, nothing to copy
+      RemoveAll ();
+      return true;
+    }
+  MakeWritable (m_block->capacity);
+  TagData *data = &m_block->tags[i];
+  if (data->size > TagData::INLINE_SIZE)
+    {
+      std::free (data->heapData);
     }
-  return found;
+  data->~TagData ();
+  std::memmove (static_cast<void *> (data), data + 1, (m_block->size - i - 1) * sizeof (TagData));
+  m_block->size--;
+  return true;
 }
 
 bool
 PacketTagList::Replace (Tag & tag)
 {
-  bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
-  if (!found)
+  TypeId tid = tag.GetInstanceTypeId ();
+  NS_LOG_FUNCTION (this << tid);
+  int32_t i = Find (tid);
+  if (i < 0)
     {
       Add (tag);
+      return false;
     }
-  return found;
-}
-
-// COWWriter implementing Replace
-bool
-PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
-                              struct PacketTagList::TagData  * cur,
-                              struct PacketTagList::TagData ** prevNext)
-{
-  NS_LOG_FUNCTION_NOARGS ();
-
-  // found tid
-  bool found = true;
-  if (preMerge)
+  MakeWritable (m_block->capacity);
+  TagData *data = &m_block->tags[i];
+  uint32_t size = tag.GetSerializedSize ();
+  if (size == data->size)
     {
-      // found tid before first merge, so just rewrite
-      tag.Serialize (TagBuffer (cur->data, cur->data + cur->size));
+      // common case: rewrite in place
+      uint8_t *buffer = data->GetData ();
+      tag.Serialize (TagBuffer (buffer, buffer + size));
+      return true;
     }
-  else
+  if (data->size > TagData::INLINE_SIZE)
     {
-      // cur is always a merge at this point
-      // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
-      struct TagData * copy = CreateTagData (tag.GetSerializedSize ());
-      copy->tid = tag.GetInstanceTypeId ();
-      copy->count = 1;
-      tag.Serialize (TagBuffer (copy->data, copy->data + copy->size));
-      copy->next = cur->next;           // merge into tail
-      if (copy->next != 0)
-        {
-          copy->next->count++;          // mark new merge
-        }
-      *prevNext = copy;                 // point prior list at copy
+      std::free (data->heapData);
     }
-  return found;
+  SetTagData (data, tag);
+  return true;
 }
 
 void 
@@ -261,44 +217,30 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
-    {
-      NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (),
-                     "Error: cannot add the same kind of tag twice.");
-    }
-  struct TagData * head = CreateTagData (tag.GetSerializedSize ());
-  head->count = 1;
-  head->next = 0;
-  head->tid = tag.GetInstanceTypeId ();
-  head->next = m_next;
-  tag.Serialize (TagBuffer (head->data, head->data + head->size));
-
-  const_cast<PacketTagList *> (this)->m_next = head;
+  NS_ASSERT_MSG (Find (tag.GetInstanceTypeId ()) < 0,
+                 "Error: cannot add the same kind of tag twice.");
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  self->MakeWritable (m_block != 0 ? m_block->size + 1 : 1);
+  TagData *data = new (&m_block->tags[m_block->size]) TagData;
+  SetTagData (data, tag);
+  m_block->size++;
 }
 
 bool
 PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
-  TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  int32_t i = Find (tag.GetInstanceTypeId ());
+  if (i < 0)
     {
-      if (cur->tid == tid) 
-        {
-          /* found tag */
-          tag.Deserialize (TagBuffer (cur->data, cur->data + cur->size));
-          return true;
-        }
+      /* no tag found */
+      return false;
     }
-  /* no tag found */
-  return false;
-}
-
-const struct PacketTagList::TagData *
-PacketTagList::Head (void) const
-{
-  return m_next;
+  /* found tag */
+  TagData const *found = &m_block->tags[i];
+  uint8_t *buffer = const_cast<uint8_t *> (found->GetData ());
+  tag.Deserialize (TagBuffer (buffer, buffer + found->size));
+  return true;
 }
 
 } /* namespace ns3 */
-
@@ -22,10 +22,11 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a flat, shared list of Packet tags, including copy-on-write semantics.
 */
 
 #include <stdint.h>
+#include <cstdlib>
 #include <ostream>
 #include "ns3/type-id.h"
 
@@ -43,110 +44,89 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
+ * Packets rarely carry more than a handful of packet tags, so the tags
+ * of a list are stored back to back in a single heap block, the
+ * TagBlock, together with their serialized data:
  *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
+ * \verbatim
+ *   PacketTagList A --\
+ *                      +--> TagBlock [ count = 2 | size = 3 | capacity = 4 ]
+ *   PacketTagList B --/               [ T1 ][ T2 ][ T3 ][ -- ]
+ * \endverbatim
  *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ *   - Each TagData holds the tag TypeId and, for tags serialized in
+ *     at most TagData::INLINE_SIZE bytes (which covers all the tags of
+ *     the ns-3 models), the serialized tag itself.  Larger tags point to
+ *     a separate allocation.  Adding a tag to a list which has room left
+ *     in its block therefore does not allocate any memory.
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
- *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
- *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
- *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
+ *   - Tags are kept in the order they were added; #Peek, #Remove and
+ *     #Replace scan the (small, contiguous) array, and PacketTagIterator
+ *     walks it from the most recently added tag to the oldest one.
  *
  * \par <b> Copy-on-write </b> is implemented as follows:
  *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
+ *   - The copy constructor and assignment share the block of the
+ *     original list and increment its \c count.
  *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
+ *   - Any modification (#Add, #Remove, #Replace) of a list whose block
+ *     is shared first makes a private copy of the block (one allocation
+ *     for all the tags), decrementing the \c count of the shared one.
  *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - #Add on a private block appends in place, growing the block when
+ *     it is full.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
-   *
-   * See PacketTagList for a discussion of the data structure.
+   * A tag stored in a TagBlock.
    *
    * \internal
    * Unfortunately this has to be public, because
    * PacketTagIterator::Item::GetTag() needs the data and size values.
    * The Item nested class can't be forward declared, so friending isn't
    * possible.
-   *
-   * We use placement new so we can allocate enough room for the Tag
-   * type which will be serialized into data.  See Object::Aggregates
-   * for a similar construction.
    */
   struct TagData
   {
-    struct TagData * next;      /**< Pointer to next in list */
-    uint32_t count;             /**< Number of incoming links */
-    TypeId tid;                 /**< Type of the tag serialized into #data */
-    uint32_t size;              /**< Size of the \c data buffer */
-    uint8_t data[1];            /**< Serialization buffer */
+    /** Serialized tags up to this size are stored in the TagData itself. */
+    static const uint32_t INLINE_SIZE = 24;
+
+    TypeId tid;                 /**< Type of the tag serialized into the data */
+    uint32_t size;              /**< Size of the serialized tag */
+    union
+    {
+      uint8_t inlineData[INLINE_SIZE]; /**< Serialization buffer, if size <= INLINE_SIZE */
+      uint8_t *heapData;               /**< Serialization buffer, if size > INLINE_SIZE */
+    };
+
+    /** \returns the serialization buffer */
+    uint8_t *GetData (void)
+    {
+      return size <= INLINE_SIZE ? inlineData : heapData;
+    }
+    /** \returns the serialization buffer */
+    const uint8_t *GetData (void) const
+    {
+      return size <= INLINE_SIZE ? inlineData : heapData;
+    }
   };  /* struct TagData */
 
+  /**
+   * The block of tags shared by the copies of a PacketTagList.
+   */
+  struct TagBlock
+  {
+    uint32_t count;             /**< Number of PacketTagLists sharing this block */
+    uint32_t size;              /**< Number of tags in use */
+    uint32_t capacity;          /**< Number of tags allocated */
+    TagData tags[1];            /**< The tags, in the order they were added */
+  };  /* struct TagBlock */
+
+  /** Number of tags a block is allocated with, initially. */
+  static const uint32_t INITIAL_CAPACITY = 4;
+
   /**
    * Create a new PacketTagList.
    */
@@ -156,8 +136,8 @@ public:
    *
    * \param [in] o The PacketTagList to copy.
    *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * This makes a light-weight copy, pointing to the same
+   * \ref TagBlock as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
@@ -167,18 +147,18 @@ public:
    * \returns the copied object
    *
    * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
+   * pointing to the same \ref TagBlock as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
    *
-   * #RemoveAll's the tags up to the first merge.
+   * #RemoveAll's the tags.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the list.
    *
    * \param [in] tag The tag to add
    */
@@ -210,78 +190,66 @@ public:
    */
   bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the oldest tag of the list
+   */
+  inline const struct PacketTagList::TagData *Begin (void) const;
+  /**
+   * \returns pointer past the most recent tag of the list
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  inline const struct PacketTagList::TagData *End (void) const;
 
 private:
   /**
-   * Allocate and construct a TagData struct, sizing the data area
-   * large enough to serialize dataSize bytes from a Tag.
+   * Allocate a TagBlock with room for \pname{capacity} tags.
+   *
+   * \param [in] capacity The number of tags.
+   * \returns The new block, with a count of one and no tags.
+   */
+  static TagBlock * CreateTagBlock (uint32_t capacity);
+  /**
+   * Free a TagBlock and the out-of-line data of its tags.
    *
-   * \param [in] dataSize The serialized size of the Tag.
-   * \returns The newly constructed TagData object.
+   * \param [in] block The block to free.
    */
-  static
-  TagData * CreateTagData (size_t dataSize);
-  
+  static void FreeTagBlock (TagBlock *block);
   /**
-   * Typedef of method function pointer for copy-on-write operations
+   * Serialize a tag into a TagData, allocating out-of-line data
+   * if needed.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * \param [in,out] data The TagData to write.
+   * \param [in] tag The tag.
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  static void SetTagData (TagData *data, Tag const &tag);
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
+   * Copy a TagData, duplicating out-of-line data.
    *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [out] to The destination.
+   * \param [in] from The source.
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  static void CopyTagData (TagData *to, TagData const *from);
   /**
-   * Copy-on-write implementing Remove.
+   * Find a tag in the list.
    *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * \param [in] tid The type of the tag.
+   * \returns The index of the tag, or -1 if it is not in the list.
    */
-  bool RemoveWriter  (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  int32_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Replace
+   * Make sure this list owns its block, which has room for at least
+   * \pname{capacity} tags.
    *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * \param [in] capacity The number of tags needed.
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  void MakeWritable (uint32_t capacity);
 
   /**
-   * Pointer to first \ref TagData on the list
+   * The tags of this list, or null if there are none.
    */
-  struct TagData *m_next;
+  struct TagBlock *m_block;
 };
 
 } // namespace ns3
@@ -293,16 +261,16 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_block (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_block (o.m_block)
 {
-  if (m_next != 0)
+  if (m_block != 0)
     {
-      m_next->count++;
+      m_block->count++;
     }
 }
 
@@ -310,15 +278,15 @@ PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (m_block == o.m_block) 
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
+  m_block = o.m_block;
+  if (m_block != 0) 
     {
-      m_next->count++;
+      m_block->count++;
     }
   return *this;
 }
@@ -331,27 +299,27 @@ PacketTagList::~PacketTagList ()
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  if (m_block != 0)
     {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
+      m_block->count--;
+      if (m_block->count == 0)
         {
-          prev->~TagData ();
-          std::free (prev);
+          FreeTagBlock (m_block);
         }
-      prev = cur;
     }
-  if (prev != 0) 
-    {
-      prev->~TagData ();
-      std::free (prev);
-    }
-  m_next = 0;
+  m_block = 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Begin (void) const
+{
+  return m_block != 0 ? m_block->tags : 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::End (void) const
+{
+  return m_block != 0 ? m_block->tags + m_block->size : 0;
 }
 
 } // namespace ns3
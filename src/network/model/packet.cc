@@ -81,22 +81,23 @@ ByteTagIterator::ByteTagIterator (ByteTagList::Iterator i)
 }
 
 
-PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *head)
-  : m_current (head)
+PacketTagIterator::PacketTagIterator (const struct PacketTagList::TagData *begin,
+                                      const struct PacketTagList::TagData *end)
+  : m_begin (begin),
+    m_current (end)
 {
 }
 bool
 PacketTagIterator::HasNext (void) const
 {
-  return m_current != 0;
+  return m_current != m_begin;
 }
 PacketTagIterator::Item
 PacketTagIterator::Next (void)
 {
   NS_ASSERT (HasNext ());
-  const struct PacketTagList::TagData *prev = m_current;
-  m_current = m_current->next;
-  return PacketTagIterator::Item (prev);
+  --m_current;
+  return PacketTagIterator::Item (m_current);
 }
 
 PacketTagIterator::Item::Item (const struct PacketTagList::TagData *data)
@@ -112,8 +113,8 @@ void
 PacketTagIterator::Item::GetTag (Tag &tag) const
 {
   NS_ASSERT (tag.GetInstanceTypeId () == m_data->tid);
-  tag.Deserialize (TagBuffer ((uint8_t*)m_data->data,
-                              (uint8_t*)m_data->data + m_data->size));
+  tag.Deserialize (TagBuffer ((uint8_t*)m_data->GetData (),
+                              (uint8_t*)m_data->GetData () + m_data->size));
 }
 
 
@@ -358,6 +359,7 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
   m_byteTagList.AddAtEnd (GetSize ());
   ByteTagList copy = packet->m_byteTagList;
   copy.AddAtStart (0);
+  copy.AddAtEnd (packet->GetSize ());
   copy.Adjust (GetSize ());
   m_byteTagList.Add (copy);
   m_buffer.AddAtEnd (packet->m_buffer);
@@ -940,7 +942,7 @@ Packet::PrintPacketTags (std::ostream &os) const
 PacketTagIterator 
 Packet::GetPacketTagIterator (void) const
 {
-  return PacketTagIterator (m_packetTagList.Head ());
+  return PacketTagIterator (m_packetTagList.Begin (), m_packetTagList.End ());
 }
 
 std::ostream& operator<< (std::ostream& os, const Packet &packet)
@@ -173,10 +173,13 @@ private:
   friend class Packet;
   /**
    * Constructor
-   * \param head head of the items
+   * \param begin the oldest tag
+   * \param end past the most recent tag
    */
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;  //!< actual position over the set of tags in a packet
+  PacketTagIterator (const struct PacketTagList::TagData *begin,
+                     const struct PacketTagList::TagData *end);
+  const struct PacketTagList::TagData *m_begin;    //!< oldest tag, where the iteration ends
+  const struct PacketTagList::TagData *m_current;  //!< past the next tag to return (tags are visited most recent first)
 };
 
 /**
@@ -948,4 +948,64 @@ SocketIpv6TclassTag::Print (std::ostream &os) const
   os << "IPV6_TCLASS = " << m_ipv6Tclass;
 }
 
+NS_OBJECT_ENSURE_REGISTERED (SocketLargeSendTag);
+
+SocketLargeSendTag::SocketLargeSendTag ()
+  : m_segmentSize (0)
+{
+}
+
+void
+SocketLargeSendTag::SetSegmentSize (uint32_t segmentSize)
+{
+  m_segmentSize = segmentSize;
+}
+
+uint32_t
+SocketLargeSendTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+TypeId
+SocketLargeSendTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SocketLargeSendTag")
+    .SetParent<Tag> ()
+    .SetGroupName("Network")
+    .AddConstructor<SocketLargeSendTag> ()
+    ;
+  return tid;
+}
+
+TypeId
+SocketLargeSendTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+SocketLargeSendTag::GetSerializedSize (void) const
+{
+  return sizeof (uint32_t);
+}
+
+void
+SocketLargeSendTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_segmentSize);
+}
+
+void
+SocketLargeSendTag::Deserialize (TagBuffer i)
+{
+  m_segmentSize = i.ReadU32 ();
+}
+
+void
+SocketLargeSendTag::Print (std::ostream &os) const
+{
+  os << "Large send, segment size = " << m_segmentSize;
+}
+
 } // namespace ns3
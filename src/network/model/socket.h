@@ -1394,6 +1394,59 @@ private:
   uint8_t m_ipv6Tclass; //!< the Tclass carried by the tag
 };
 
+/**
+ * \brief indicates that a packet is a large segment, standing for several
+ * segments of a transport protocol (segmentation offload).
+ *
+ * The IP layer does not fragment packets carrying this tag, even when they
+ * exceed the MTU of the output device, and sends them as a single frame.
+ * The tag stays on the packet along its path, so that routers forward it
+ * unfragmented as well, and the receiver knows how many segments it
+ * stands for.
+ */
+class SocketLargeSendTag : public Tag
+{
+public:
+  SocketLargeSendTag ();
+
+  /**
+   * \brief Set the size of the segments the packet stands for
+   *
+   * \param segmentSize the segment size
+   */
+  void SetSegmentSize (uint32_t segmentSize);
+
+  /**
+   * \brief Get the size of the segments the packet stands for
+   *
+   * \returns the segment size
+   */
+  uint32_t GetSegmentSize (void) const;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  // inherited function, no need to doc.
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  // inherited function, no need to doc.
+  virtual uint32_t GetSerializedSize (void) const;
+
+  // inherited function, no need to doc.
+  virtual void Serialize (TagBuffer i) const;
+
+  // inherited function, no need to doc.
+  virtual void Deserialize (TagBuffer i);
+
+  // inherited function, no need to doc.
+  virtual void Print (std::ostream &os) const;
+private:
+  uint32_t m_segmentSize; //!< the segment size carried by the tag
+};
+
 } // namespace ns3
 
 #endif /* NS3_SOCKET_H */
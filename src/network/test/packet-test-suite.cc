@@ -21,6 +21,7 @@
 #include "ns3/packet-tag-list.h"
 #include "ns3/test.h"
 #include "ns3/unused.h"
+#include "ns3/random-variable-stream.h"
 #include <limits>     // std:numeric_limits
 #include <string>
 #include <cstdarg>
@@ -1035,6 +1036,304 @@ PacketTagListTest::DoRun (void)
     
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Byte tag unit tests: random sequences of packet operations are checked
+ * against a reference model which cuts byte tags eagerly, as ByteTagList
+ * did before it cut them lazily and indexed them.
+ */
+class ByteTagRandomTest : public TestCase
+{
+public:
+  ByteTagRandomTest ();
+private:
+  virtual void DoRun (void);
+
+  /// A byte tag of the reference model
+  struct RefTag
+  {
+    uint32_t n;    //!< the N of the ATestTag<N>
+    uint8_t data;  //!< the tag data
+    int64_t start; //!< the start offset
+    int64_t end;   //!< the end offset
+  };
+  /// A packet and the byte tags it should carry
+  struct RefPacket
+  {
+    Ptr<Packet> packet;        //!< the packet
+    std::vector<RefTag> tags;  //!< the reference tags
+  };
+
+  /**
+   * Add a byte tag to a packet and to its reference tags.
+   * \param ref the packet
+   * \param n the N of the ATestTag<N> to add
+   * \param start the first tagged byte
+   * \param end the byte following the last tagged byte
+   */
+  void AddTag (RefPacket &ref, uint32_t n, uint32_t start, uint32_t end);
+  /**
+   * Cut the reference tags of a packet whose size is going to increase.
+   * \param ref the packet
+   */
+  void CutAtEnd (RefPacket &ref);
+  /**
+   * Check that the byte tags of a packet are its reference tags.
+   * \param ref the packet
+   * \param step the step of the sequence of operations
+   */
+  void Check (RefPacket const &ref, uint32_t step);
+
+  uint8_t m_data; //!< data of the next tag
+};
+
+ByteTagRandomTest::ByteTagRandomTest ()
+  : TestCase ("Check byte tags through random fragmentations and concatenations"),
+    m_data (0)
+{
+}
+
+void
+ByteTagRandomTest::AddTag (RefPacket &ref, uint32_t n, uint32_t start, uint32_t end)
+{
+  RefTag tag = { n, ++m_data, start, end };
+  switch (n)
+    {
+    case 1: ref.packet->AddByteTag (ATestTag<1> (tag.data), start, end); break;
+    case 2: ref.packet->AddByteTag (ATestTag<2> (tag.data), start, end); break;
+    default: ref.packet->AddByteTag (ATestTag<3> (tag.data), start, end); break;
+    }
+  ref.tags.push_back (tag);
+}
+
+void
+ByteTagRandomTest::CutAtEnd (RefPacket &ref)
+{
+  int64_t size = ref.packet->GetSize ();
+  std::vector<RefTag> tags;
+  for (std::vector<RefTag>::const_iterator i = ref.tags.begin (); i != ref.tags.end (); ++i)
+    {
+      if (i->start < size)
+        {
+          RefTag tag = *i;
+          tag.end = std::min (tag.end, size);
+          tags.push_back (tag);
+        }
+    }
+  ref.tags = tags;
+}
+
+void
+ByteTagRandomTest::Check (RefPacket const &ref, uint32_t step)
+{
+  // Empty packets may report empty items for the tags which overlap
+  // offset zero, depending on how the tags were cut: such items are
+  // not compared.
+  int64_t size = ref.packet->GetSize ();
+  std::vector<RefTag> expected;
+  for (std::vector<RefTag>::const_iterator j = ref.tags.begin (); j != ref.tags.end (); ++j)
+    {
+      if (j->start < size && j->end > 0 && size > 0)
+        {
+          RefTag tag = *j;
+          tag.start = std::max<int64_t> (tag.start, 0);
+          tag.end = std::min (tag.end, size);
+          expected.push_back (tag);
+        }
+    }
+
+  ByteTagIterator i = ref.packet->GetByteTagIterator ();
+  uint32_t j = 0;
+  while (i.HasNext () && j < expected.size ())
+    {
+      ByteTagIterator::Item item = i.Next ();
+      std::ostringstream oss;
+      oss << "anon::ATestTag<" << expected[j].n << ">";
+      NS_TEST_EXPECT_MSG_EQ (item.GetTypeId ().GetName (), oss.str (), "Wrong byte tag at step " << step);
+      NS_TEST_EXPECT_MSG_EQ (item.GetStart (), expected[j].start, "Wrong start at step " << step);
+      NS_TEST_EXPECT_MSG_EQ (item.GetEnd (), expected[j].end, "Wrong end at step " << step);
+      ATestTagBase *tag = dynamic_cast<ATestTagBase *> (item.GetTypeId ().GetConstructor () ());
+      item.GetTag (*tag);
+      NS_TEST_EXPECT_MSG_EQ (tag->m_error, false, "Corrupted byte tag at step " << step);
+      NS_TEST_EXPECT_MSG_EQ (tag->GetData (), expected[j].data, "Wrong byte tag data at step " << step);
+      delete tag;
+      j++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (i.HasNext () && size > 0, false, "Unexpected byte tag at step " << step);
+  NS_TEST_EXPECT_MSG_EQ (j, expected.size (), "Missing byte tags at step " << step);
+}
+
+void
+ByteTagRandomTest::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  // One packet carrying many small tags, split and put back together.
+  RefPacket big;
+  big.packet = Create<Packet> (5000);
+  for (uint32_t i = 0; i < 5000; ++i)
+    {
+      AddTag (big, 1 + i % 3, i, i + 1 + i % 7);
+    }
+  Check (big, 0);
+  RefPacket whole;
+  whole.packet = Create<Packet> ();
+  for (uint32_t start = 0; start < 5000; start += 700)
+    {
+      uint32_t length = std::min<uint32_t> (700, 5000 - start);
+      RefPacket fragment;
+      fragment.packet = big.packet->CreateFragment (start, length);
+      for (std::vector<RefTag>::const_iterator j = big.tags.begin (); j != big.tags.end (); ++j)
+        {
+          RefTag tag = *j;
+          tag.start -= start;
+          tag.end -= start;
+          fragment.tags.push_back (tag);
+        }
+      Check (fragment, start);
+      CutAtEnd (whole);
+      int64_t offset = whole.packet->GetSize ();
+      for (std::vector<RefTag>::const_iterator j = fragment.tags.begin (); j != fragment.tags.end (); ++j)
+        {
+          if (j->end > 0)
+            {
+              RefTag tag = *j;
+              tag.start = std::max<int64_t> (tag.start, 0) + offset;
+              tag.end += offset;
+              whole.tags.push_back (tag);
+            }
+        }
+      whole.packet->AddAtEnd (fragment.packet);
+      Check (whole, start);
+    }
+  Check (big, 0);
+
+  // Random operations on a few packets.
+  const uint32_t nPackets = 6;
+  std::vector<RefPacket> packets (nPackets);
+  for (uint32_t i = 0; i < nPackets; ++i)
+    {
+      packets[i].packet = Create<Packet> (rng->GetInteger (0, 200));
+    }
+  for (uint32_t step = 1; step <= 4000; ++step)
+    {
+      RefPacket &ref = packets[rng->GetInteger (0, nPackets - 1)];
+      RefPacket &other = packets[rng->GetInteger (0, nPackets - 1)];
+      uint32_t size = ref.packet->GetSize ();
+      switch (rng->GetInteger (0, 8))
+        {
+        case 0:
+          if (size > 0)
+            {
+              uint32_t start = rng->GetInteger (0, size - 1);
+              AddTag (ref, rng->GetInteger (1, 3), start, rng->GetInteger (start + 1, size));
+            }
+          break;
+        case 1:
+          {
+            ref.packet->AddHeader (ATestHeader<10> ());
+            std::vector<RefTag> tags;
+            for (std::vector<RefTag>::const_iterator i = ref.tags.begin (); i != ref.tags.end (); ++i)
+              {
+                if (i->end > 0)
+                  {
+                    RefTag tag = *i;
+                    tag.start = std::max<int64_t> (tag.start, 0) + 10;
+                    tag.end += 10;
+                    tags.push_back (tag);
+                  }
+              }
+            ref.tags = tags;
+          }
+          break;
+        case 2:
+          {
+            uint32_t n = rng->GetInteger (0, size);
+            ref.packet->RemoveAtStart (n);
+            for (std::vector<RefTag>::iterator i = ref.tags.begin (); i != ref.tags.end (); ++i)
+              {
+                i->start -= n;
+                i->end -= n;
+              }
+          }
+          break;
+        case 3:
+          ref.packet->RemoveAtEnd (rng->GetInteger (0, size));
+          break;
+        case 4:
+          if (size < 2000)
+            {
+              CutAtEnd (ref);
+              ref.packet->AddPaddingAtEnd (rng->GetInteger (1, 100));
+            }
+          break;
+        case 5:
+          if (&ref != &other && size + other.packet->GetSize () < 2000)
+            {
+              CutAtEnd (ref);
+              for (std::vector<RefTag>::const_iterator i = other.tags.begin (); i != other.tags.end (); ++i)
+                {
+                  if (i->end > 0)
+                    {
+                      RefTag tag = *i;
+                      tag.start = std::max<int64_t> (tag.start, 0) + size;
+                      tag.end += size;
+                      ref.tags.push_back (tag);
+                    }
+                }
+              // Buffer::AddAtEnd cannot append a buffer which shares its data
+              Ptr<Packet> tail = Create<Packet> ();
+              tail->AddAtEnd (other.packet);
+              ref.packet->AddAtEnd (tail);
+            }
+          break;
+        case 6:
+          if (&ref != &other)
+            {
+              uint32_t start = rng->GetInteger (0, size);
+              uint32_t length = rng->GetInteger (0, size - start);
+              other.packet = ref.packet->CreateFragment (start, length);
+              other.tags = ref.tags;
+              for (std::vector<RefTag>::iterator i = other.tags.begin (); i != other.tags.end (); ++i)
+                {
+                  i->start -= start;
+                  i->end -= start;
+                }
+            }
+          break;
+        case 7:
+          if (&ref != &other)
+            {
+              other.packet = ref.packet->Copy ();
+              other.tags = ref.tags;
+            }
+          break;
+        default:
+          if (rng->GetInteger (0, 9) == 0)
+            {
+              ref.packet->RemoveAllByteTags ();
+              ref.tags.clear ();
+            }
+          break;
+        }
+      for (uint32_t i = 0; i < nPackets; ++i)
+        {
+          Check (packets[i], step);
+          // Padding the packet reveals the tags which should have been cut.
+          RefPacket padded;
+          padded.packet = Create<Packet> ();
+          padded.packet->AddAtEnd (packets[i].packet);
+          padded.tags = packets[i].tags;
+          CutAtEnd (padded);
+          padded.packet->AddPaddingAtEnd (10);
+          Check (padded, step);
+        }
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1052,6 +1351,7 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new ByteTagRandomTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
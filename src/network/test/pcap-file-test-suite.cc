@@ -17,6 +17,7 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <cstdio>
 #include <cstdlib>
 #include <sstream>
@@ -25,6 +26,8 @@
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/compressed-file-buffer.h"
+#include "ns3/output-stream-wrapper.h"
 
 using namespace ns3;
 
@@ -1144,6 +1147,129 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that gzip-compressed pcap and ascii files
+ * hold exactly what was written to them.
+ */
+class CompressedFileTestCase : public TestCase
+{
+public:
+  CompressedFileTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+CompressedFileTestCase::CompressedFileTestCase ()
+  : TestCase ("Check that compressed pcap and ascii files round-trip")
+{
+}
+
+void
+CompressedFileTestCase::DoRun (void)
+{
+  if (!CompressedFileBuffer::IsEnabled ())
+    {
+      return;
+    }
+
+  //
+  // Copy the known good file into a compressed one through PcapFile.
+  //
+  std::string known = CreateDataDirFilename ("known.pcap");
+  std::string filename = CreateTempDirFilename ("known.pcap.gz");
+  PcapFile in;
+  in.Open (known, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (in.Fail (), false, "Open (" << known << ", \"std::ios::in\") returns error");
+
+  PcapFile out;
+  out.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  out.Init (in.GetDataLinkType (), in.GetSnapLen ());
+  NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Init () of compressed file returns error");
+
+  uint8_t data[2000];
+  uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+  for (uint32_t i = 0; i < N_KNOWN_PACKETS; ++i)
+    {
+      in.Read (data, sizeof(data), tsSec, tsUsec, inclLen, origLen, readLen);
+      NS_TEST_ASSERT_MSG_EQ (in.Fail (), false, "Read() of known good pcap file returns error");
+      out.Write (tsSec, tsUsec, data, origLen);
+      NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Write() to compressed file returns error");
+    }
+  in.Close ();
+  out.Close ();
+  NS_TEST_ASSERT_MSG_EQ (out.Fail (), false, "Close() of compressed file returns error");
+
+  uint32_t sec (0), usec (0), packets (0);
+  bool diff = PcapFile::Diff (known, filename, sec, usec, packets);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Compressed copy differs from " << known);
+  NS_TEST_EXPECT_MSG_EQ (packets, N_KNOWN_PACKETS, "Compressed copy has the wrong number of packets");
+
+  //
+  // The file must really be gzip, not a plain pcap file.
+  //
+  FILE *f = std::fopen (filename.c_str (), "rb");
+  NS_TEST_ASSERT_MSG_NE (f, 0, "Unable to open " << filename);
+  uint8_t magic[2] = { 0, 0 };
+  size_t n = std::fread (magic, 1, 2, f);
+  std::fclose (f);
+  NS_TEST_EXPECT_MSG_EQ (n, 2, "Compressed file is too short");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)magic[0], 0x1f, "Missing gzip magic");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t)magic[1], 0x8b, "Missing gzip magic");
+
+  //
+  // Copy it again with a block size small enough that the copy spans many
+  // more compressor blocks than can be queued for the helper thread.
+  //
+  std::string blocksName = CreateTempDirFilename ("known-blocks.pcap.gz");
+  {
+    std::ifstream raw (known.c_str (), std::ios::in | std::ios::binary);
+    NS_TEST_ASSERT_MSG_EQ (raw.is_open (), true, "Unable to open " << known);
+    CompressedFileBuffer blocks (64);
+    NS_TEST_ASSERT_MSG_EQ (blocks.Open (blocksName, std::ios::out), true, "Unable to open " << blocksName);
+    std::ostream os (&blocks);
+    os << raw.rdbuf ();
+    NS_TEST_EXPECT_MSG_EQ (os.good (), true, "Write to " << blocksName << " failed");
+    NS_TEST_EXPECT_MSG_EQ (blocks.Close (), true, "Close () of " << blocksName << " failed");
+  }
+  packets = 0;
+  diff = PcapFile::Diff (known, blocksName, sec, usec, packets);
+  NS_TEST_EXPECT_MSG_EQ (diff, false, "Compressed copy in small blocks differs from " << known);
+  NS_TEST_EXPECT_MSG_EQ (packets, N_KNOWN_PACKETS, "Compressed copy in small blocks has the wrong number of packets");
+
+  //
+  // Ascii traces go through OutputStreamWrapper; write enough lines to
+  // fill several blocks and read them back.
+  //
+  std::string asciiName = CreateTempDirFilename ("trace.tr.gz");
+  {
+    Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (asciiName, std::ios::out);
+    for (uint32_t i = 0; i < 200000; ++i)
+      {
+        *stream->GetStream () << "+ " << i << " ns3::PppHeader (Point-to-Point Protocol: IP (0x0021))" << std::endl;
+      }
+  }
+  CompressedFileBuffer buffer;
+  NS_TEST_ASSERT_MSG_EQ (buffer.Open (asciiName, std::ios::in), true, "Unable to open " << asciiName);
+  std::istream is (&buffer);
+  std::string line;
+  uint32_t lines = 0;
+  bool match = true;
+  while (std::getline (is, line))
+    {
+      std::ostringstream expected;
+      expected << "+ " << lines << " ns3::PppHeader (Point-to-Point Protocol: IP (0x0021))";
+      match = match && line == expected.str ();
+      ++lines;
+    }
+  NS_TEST_EXPECT_MSG_EQ (lines, 200000, "Wrong number of lines read back from " << asciiName);
+  NS_TEST_EXPECT_MSG_EQ (match, true, "Line read back from " << asciiName << " differs from what was written");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1167,6 +1293,7 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new CompressedFileTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite; //!< Static variable for test initialization
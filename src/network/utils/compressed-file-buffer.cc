@@ -0,0 +1,367 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <cstdio>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/callback.h"
+#include "compressed-file-buffer.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+
+#ifdef NS3_ZLIB
+#include <zlib.h>
+#endif /* NS3_ZLIB */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("CompressedFileBuffer");
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Maximum number of full blocks queued for the compressor before the
+ * simulation thread is made to wait.  This bounds the memory used when
+ * the simulation produces trace data faster than it can be compressed.
+ */
+static const uint32_t MAX_PENDING_BLOCKS = 4;
+#endif /* HAVE_PTHREAD_H */
+
+CompressedFileBuffer::CompressedFileBuffer (uint32_t blockSize)
+  : m_gz (0),
+    m_write (false),
+    m_error (false),
+    m_blockSize (blockSize),
+    m_offset (0)
+{
+  NS_LOG_FUNCTION (this << blockSize);
+  NS_ASSERT (blockSize > 0);
+#ifdef HAVE_PTHREAD_H
+  m_stop = false;
+#endif /* HAVE_PTHREAD_H */
+}
+
+CompressedFileBuffer::~CompressedFileBuffer ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+CompressedFileBuffer::IsCompressedFileName (std::string const &filename)
+{
+  std::string::size_type n = filename.size ();
+  return n > 3 && filename.compare (n - 3, 3, ".gz") == 0;
+}
+
+bool
+CompressedFileBuffer::IsEnabled (void)
+{
+#ifdef NS3_ZLIB
+  return true;
+#else
+  return false;
+#endif /* NS3_ZLIB */
+}
+
+bool
+CompressedFileBuffer::Open (std::string const &filename, std::ios::openmode mode)
+{
+  NS_LOG_FUNCTION (this << filename << mode);
+  if (m_gz != 0)
+    {
+      return false;
+    }
+#ifdef NS3_ZLIB
+  m_write = (mode & (std::ios::out | std::ios::app)) != 0;
+  if (m_write && (mode & std::ios::in))
+    {
+      NS_LOG_WARN ("Compressed files are either read or written, not both");
+      return false;
+    }
+  const char *gzmode = m_write ? ((mode & std::ios::app) ? "ab" : "wb") : "rb";
+  gzFile gz = gzopen (filename.c_str (), gzmode);
+  if (gz == 0)
+    {
+      return false;
+    }
+  gzbuffer (gz, 128 * 1024);
+  m_gz = gz;
+  m_error = false;
+  m_offset = 0;
+  m_block.resize (m_blockSize);
+  if (m_write)
+    {
+      setp (&m_block[0], &m_block[0] + m_blockSize);
+#ifdef HAVE_PTHREAD_H
+      m_stop = false;
+      m_thread = Create<SystemThread> (MakeCallback (&CompressedFileBuffer::WriterThread, this));
+      m_thread->Start ();
+#endif /* HAVE_PTHREAD_H */
+    }
+  else
+    {
+      setg (&m_block[0], &m_block[0], &m_block[0]);
+    }
+  return true;
+#else
+  NS_LOG_WARN ("Unable to open " << filename << ": ns-3 was built without zlib");
+  return false;
+#endif /* NS3_ZLIB */
+}
+
+bool
+CompressedFileBuffer::IsOpen (void) const
+{
+  return m_gz != 0;
+}
+
+bool
+CompressedFileBuffer::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_gz == 0)
+    {
+      return false;
+    }
+#ifdef NS3_ZLIB
+  if (m_write)
+    {
+      HandOff ();
+#ifdef HAVE_PTHREAD_H
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_stop = true;
+      }
+      m_work.notify_one ();
+      m_thread->Join ();
+      m_thread = 0;
+#endif /* HAVE_PTHREAD_H */
+      setp (0, 0);
+    }
+  else
+    {
+      setg (0, 0, 0);
+    }
+  if (gzclose (static_cast<gzFile> (m_gz)) != Z_OK)
+    {
+      m_error = true;
+    }
+#endif /* NS3_ZLIB */
+  m_gz = 0;
+  std::vector<char> ().swap (m_block);
+  return !m_error;
+}
+
+void
+CompressedFileBuffer::HandOff (void)
+{
+  std::size_t size = pptr () - pbase ();
+  if (size == 0)
+    {
+      return;
+    }
+  m_offset += size;
+  m_block.resize (size);
+#ifdef HAVE_PTHREAD_H
+  {
+    std::unique_lock<std::mutex> lock (m_mutex);
+    m_done.wait (lock, [this] { return m_pending.size () < MAX_PENDING_BLOCKS; });
+    m_pending.push_back (std::vector<char> ());
+    m_pending.back ().swap (m_block);
+  }
+  m_work.notify_one ();
+#else
+  WriteBlock (m_block);
+#endif /* HAVE_PTHREAD_H */
+  m_block.resize (m_blockSize);
+  setp (&m_block[0], &m_block[0] + m_blockSize);
+}
+
+void
+CompressedFileBuffer::WriteBlock (std::vector<char> const &block)
+{
+#ifdef NS3_ZLIB
+  if (m_error)
+    {
+      return;
+    }
+  int written = gzwrite (static_cast<gzFile> (m_gz), &block[0], block.size ());
+  if (written != static_cast<int> (block.size ()))
+    {
+      m_error = true;
+    }
+#endif /* NS3_ZLIB */
+}
+
+void
+CompressedFileBuffer::WriterThread (void)
+{
+#ifdef HAVE_PTHREAD_H
+  for (;;)
+    {
+      std::vector<char> block;
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_work.wait (lock, [this] { return m_stop || !m_pending.empty (); });
+        if (m_pending.empty ())
+          {
+            // Stopped, and all the blocks are written
+            return;
+          }
+        block.swap (m_pending.front ());
+        m_pending.pop_front ();
+      }
+      m_done.notify_one ();
+      WriteBlock (block);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+CompressedFileBuffer::int_type
+CompressedFileBuffer::overflow (int_type c)
+{
+  if (m_gz == 0 || !m_write)
+    {
+      return traits_type::eof ();
+    }
+  HandOff ();
+  if (!traits_type::eq_int_type (c, traits_type::eof ()))
+    {
+      *pptr () = traits_type::to_char_type (c);
+      pbump (1);
+    }
+  return traits_type::not_eof (c);
+}
+
+std::streamsize
+CompressedFileBuffer::xsputn (const char *s, std::streamsize n)
+{
+  if (m_gz == 0 || !m_write)
+    {
+      return 0;
+    }
+  std::streamsize left = n;
+  while (left > 0)
+    {
+      std::streamsize room = epptr () - pptr ();
+      if (room == 0)
+        {
+          HandOff ();
+          continue;
+        }
+      std::streamsize chunk = left < room ? left : room;
+      std::memcpy (pptr (), s, chunk);
+      pbump (static_cast<int> (chunk));
+      s += chunk;
+      left -= chunk;
+    }
+  return n;
+}
+
+CompressedFileBuffer::int_type
+CompressedFileBuffer::underflow (void)
+{
+  if (m_gz == 0 || m_write)
+    {
+      return traits_type::eof ();
+    }
+  if (gptr () < egptr ())
+    {
+      return traits_type::to_int_type (*gptr ());
+    }
+#ifdef NS3_ZLIB
+  m_offset += egptr () - eback ();
+  int n = gzread (static_cast<gzFile> (m_gz), &m_block[0], m_blockSize);
+  if (n > 0)
+    {
+      setg (&m_block[0], &m_block[0], &m_block[0] + n);
+      return traits_type::to_int_type (*gptr ());
+    }
+#endif /* NS3_ZLIB */
+  setg (&m_block[0], &m_block[0], &m_block[0]);
+  return traits_type::eof ();
+}
+
+int
+CompressedFileBuffer::sync (void)
+{
+  // Deliberately cheap: see the class documentation.
+  return m_error ? -1 : 0;
+}
+
+CompressedFileBuffer::pos_type
+CompressedFileBuffer::seekoff (off_type off, std::ios::seekdir way,
+                               std::ios::openmode which)
+{
+  if (m_gz == 0)
+    {
+      return pos_type (off_type (-1));
+    }
+  if (m_write)
+    {
+      // Only position queries are possible on a compressed output stream.
+      off_type current = m_offset + (pptr () - pbase ());
+      if ((way == std::ios::cur && off == 0) || (way == std::ios::beg && off == current))
+        {
+          return pos_type (current);
+        }
+      return pos_type (off_type (-1));
+    }
+  off_type current = m_offset + (gptr () - eback ());
+  off_type target;
+  if (way == std::ios::beg)
+    {
+      target = off;
+    }
+  else if (way == std::ios::cur)
+    {
+      target = current + off;
+    }
+  else
+    {
+      return pos_type (off_type (-1));
+    }
+  if (target < 0)
+    {
+      return pos_type (off_type (-1));
+    }
+  if (target >= static_cast<off_type> (m_offset)
+      && target <= static_cast<off_type> (m_offset + (egptr () - eback ())))
+    {
+      setg (eback (), eback () + (target - m_offset), egptr ());
+      return pos_type (target);
+    }
+#ifdef NS3_ZLIB
+  if (gzseek (static_cast<gzFile> (m_gz), target, SEEK_SET) != target)
+    {
+      return pos_type (off_type (-1));
+    }
+#endif /* NS3_ZLIB */
+  m_offset = target;
+  setg (&m_block[0], &m_block[0], &m_block[0]);
+  return pos_type (target);
+}
+
+CompressedFileBuffer::pos_type
+CompressedFileBuffer::seekpos (pos_type pos, std::ios::openmode which)
+{
+  return seekoff (off_type (pos), std::ios::beg, which);
+}
+
+} // namespace ns3
@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPRESSED_FILE_BUFFER_H
+#define COMPRESSED_FILE_BUFFER_H
+
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <list>
+#include <ios>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include "ns3/core-config.h"
+#include "ns3/ptr.h"
+
+/** zlib file handle, kept opaque so that users need not see zlib.h */
+struct gzFile_s;
+
+namespace ns3 {
+
+class SystemThread;
+
+/**
+ * \ingroup network
+ *
+ * \brief A std::streambuf reading or writing a gzip-compressed file.
+ *
+ * This is the backend used by OutputStreamWrapper and PcapFile when the
+ * requested file name ends in ".gz".  The resulting files are ordinary
+ * gzip files: ascii traces can be read with zcat and pcap traces can be
+ * opened directly with Wireshark or tcpdump.
+ *
+ * When writing, characters are accumulated in a large block.  Once a block
+ * is full it is handed to a helper thread which compresses it and writes
+ * it to disk, so the simulation thread only pays for a memcpy per record.
+ * If threading support is not available the block is compressed in the
+ * calling thread instead.
+ *
+ * Since trace sinks commonly flush the stream after every record
+ * (std::endl), sync () does not force the current block out; the file is
+ * only guaranteed to be complete once Close () is called or the buffer is
+ * destroyed.
+ *
+ * Seeking is limited to what the pcap code needs: querying the current
+ * position, and (in read mode) moving to an absolute or relative position.
+ */
+class CompressedFileBuffer : public std::streambuf
+{
+public:
+  /**
+   * \param blockSize size in bytes of the blocks handed to the compressor
+   */
+  CompressedFileBuffer (uint32_t blockSize = 1 << 20);
+  virtual ~CompressedFileBuffer ();
+
+  /**
+   * Open a gzip file.
+   *
+   * \param filename the file name
+   * \param mode either std::ios::in, std::ios::out or std::ios::out |
+   *        std::ios::app; other flags such as std::ios::binary or
+   *        std::ios::trunc are ignored.
+   * \returns true on success
+   */
+  bool Open (std::string const &filename, std::ios::openmode mode);
+
+  /**
+   * Flush all pending blocks, wait for the helper thread to finish and
+   * close the file.
+   *
+   * \returns true if all data made it to disk
+   */
+  bool Close (void);
+
+  /**
+   * \returns true if the file is open
+   */
+  bool IsOpen (void) const;
+
+  /**
+   * \param filename a file name
+   * \returns true if the file name selects compressed output, i.e., it
+   *          ends with ".gz"
+   */
+  static bool IsCompressedFileName (std::string const &filename);
+
+  /**
+   * \returns true if ns-3 was built with zlib and compressed files can
+   *          be used
+   */
+  static bool IsEnabled (void);
+
+protected:
+  virtual int_type overflow (int_type c);
+  virtual int_type underflow (void);
+  virtual int sync (void);
+  virtual std::streamsize xsputn (const char *s, std::streamsize n);
+  virtual pos_type seekoff (off_type off, std::ios::seekdir way,
+                            std::ios::openmode which);
+  virtual pos_type seekpos (pos_type pos, std::ios::openmode which);
+
+private:
+  /**
+   * Hand the current put area over to the compressor and start a new one.
+   */
+  void HandOff (void);
+  /**
+   * Compress and write one block to the file.
+   * \param block the uncompressed data
+   */
+  void WriteBlock (std::vector<char> const &block);
+  /**
+   * Main loop of the helper thread.
+   */
+  void WriterThread (void);
+
+  struct gzFile_s *m_gz;              //!< zlib file handle
+  bool m_write;                       //!< true if opened for writing
+  std::atomic<bool> m_error;          //!< true if a write to disk failed
+  uint32_t m_blockSize;               //!< block size in bytes
+  std::vector<char> m_block;          //!< current get or put area
+  uint64_t m_offset;                  //!< uncompressed offset of m_block
+
+#ifdef HAVE_PTHREAD_H
+  Ptr<SystemThread> m_thread;         //!< compressor thread
+  std::mutex m_mutex;                 //!< protects the fields below
+  std::condition_variable m_work;     //!< signals the compressor thread
+  std::condition_variable m_done;     //!< signals the simulation thread
+  std::list<std::vector<char> > m_pending; //!< blocks waiting for the compressor
+  bool m_stop;                        //!< asks the compressor thread to exit
+#endif /* HAVE_PTHREAD_H */
+};
+
+} // namespace ns3
+
+#endif /* COMPRESSED_FILE_BUFFER_H */
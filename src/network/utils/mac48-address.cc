@@ -246,6 +246,18 @@ Mac48Address Mac48Address::GetMulticast (Ipv6Address addr)
   return etherAddr;
 }
 
+size_t
+Mac48AddressHash::operator() (Mac48Address const &x) const
+{
+  // The 48 bits of the address, which are distinct for allocated addresses
+  uint64_t h = 0;
+  for (uint8_t i = 0; i < 6; i++)
+    {
+      h = (h << 8) | x.m_address[i];
+    }
+  return static_cast<size_t> (h);
+}
+
 std::ostream& operator<< (std::ostream& os, const Mac48Address & address)
 {
   uint8_t ad[6];
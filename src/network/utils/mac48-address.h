@@ -195,9 +195,26 @@ private:
    */
   friend std::istream& operator>> (std::istream& is, Mac48Address & address);
 
+  friend class Mac48AddressHash;
+
   uint8_t m_address[6]; //!< address value
 };
 
+/**
+ * \ingroup address
+ *
+ * \brief Class providing an hash for MAC addresses
+ */
+class Mac48AddressHash {
+public:
+  /**
+   * Returns the hash of the address
+   * \param x the address
+   * \return the hash
+   */
+  size_t operator() (Mac48Address const &x) const;
+};
+
 ATTRIBUTE_HELPER_HEADER (Mac48Address);
 
 inline bool operator == (const Mac48Address &a, const Mac48Address &b)
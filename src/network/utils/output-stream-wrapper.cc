@@ -17,6 +17,7 @@
  */
 
 #include "output-stream-wrapper.h"
+#include "compressed-file-buffer.h"
 #include "ns3/log.h"
 #include "ns3/fatal-impl.h"
 #include "ns3/abort.h"
@@ -27,9 +28,23 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("OutputStreamWrapper");
 
 OutputStreamWrapper::OutputStreamWrapper (std::string filename, std::ios::openmode filemode)
-  : m_destroyable (true)
+  : m_buffer (0),
+    m_destroyable (true)
 {
   NS_LOG_FUNCTION (this << filename << filemode);
+  if (CompressedFileBuffer::IsCompressedFileName (filename))
+    {
+      NS_ABORT_MSG_UNLESS (CompressedFileBuffer::IsEnabled (), "AsciiTraceHelper::CreateFileStream():  " <<
+                           "Unable to Open " << filename << ": compressed output requires zlib");
+      CompressedFileBuffer *buffer = new CompressedFileBuffer ();
+      bool ok = buffer->Open (filename, filemode);
+      m_buffer = buffer;
+      m_ostream = new std::ostream (m_buffer);
+      FatalImpl::RegisterStream (m_ostream);
+      NS_ABORT_MSG_UNLESS (ok, "AsciiTraceHelper::CreateFileStream():  " <<
+                           "Unable to Open " << filename << " for mode " << filemode);
+      return;
+    }
   std::ofstream* os = new std::ofstream ();
   os->open (filename.c_str (), filemode);
   m_ostream = os;
@@ -39,7 +54,7 @@ OutputStreamWrapper::OutputStreamWrapper (std::string filename, std::ios::openmo
 }
 
 OutputStreamWrapper::OutputStreamWrapper (std::ostream* os)
-  : m_ostream (os), m_destroyable (false)
+  : m_ostream (os), m_buffer (0), m_destroyable (false)
 {
   NS_LOG_FUNCTION (this << os);
   FatalImpl::RegisterStream (m_ostream);
@@ -52,6 +67,9 @@ OutputStreamWrapper::~OutputStreamWrapper ()
   FatalImpl::UnregisterStream (m_ostream);
   if (m_destroyable) delete m_ostream;
   m_ostream = 0;
+  // the compressed buffer completes the file when it is destroyed
+  delete m_buffer;
+  m_buffer = 0;
 }
 
 std::ostream *
@@ -64,6 +64,10 @@ namespace ns3 {
  * \endverbatim
  *
  *
+ * If the file name passed to the constructor ends in ".gz", the stream
+ * writes a gzip-compressed file through a CompressedFileBuffer, which
+ * compresses the data in large blocks on a helper thread.
+ *
  * This class uses a basic ns-3 reference counting base class but is not 
  * an ns3::Object with attributes, TypeId, or aggregation.
  */
@@ -94,6 +98,7 @@ public:
 
 private:
   std::ostream *m_ostream; //!< The output stream
+  std::streambuf *m_buffer; //!< Stream buffer owned by the wrapper, if any
   bool m_destroyable; //!< Can be destroyed
 };
 
@@ -27,6 +27,7 @@
 #include "ns3/header.h"
 #include "ns3/buffer.h"
 #include "pcap-file.h"
+#include "compressed-file-buffer.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
 //
@@ -49,6 +50,7 @@ const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pc
 
 PcapFile::PcapFile ()
   : m_file (),
+    m_compressed (0),
     m_swapMode (false),
     m_nanosecMode (false)
 {
@@ -88,7 +90,20 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
-  m_file.close ();
+  if (m_compressed == 0)
+    {
+      m_file.close ();
+      return;
+    }
+  // Give the stream its own (closed) file buffer back.
+  m_file.std::ios::rdbuf (m_file.rdbuf ());
+  bool ok = m_compressed->Close ();
+  delete m_compressed;
+  m_compressed = 0;
+  if (!ok)
+    {
+      m_file.setstate (std::ios::failbit);
+    }
 }
 
 uint32_t
@@ -317,7 +332,8 @@ PcapFile::ReadAndVerifyFileHeader (void)
 
   if (m_file.fail ())
     {
-      m_file.close ();
+      Close ();
+      m_file.setstate (std::ios::failbit);
     }
 }
 
@@ -333,7 +349,19 @@ PcapFile::Open (std::string const &filename, std::ios::openmode mode)
   mode |= std::ios::binary;
 
   m_filename=filename;
-  m_file.open (filename.c_str (), mode);
+  if (CompressedFileBuffer::IsCompressedFileName (filename))
+    {
+      m_compressed = new CompressedFileBuffer ();
+      m_file.std::ios::rdbuf (m_compressed);
+      if (!m_compressed->Open (filename, mode))
+        {
+          m_file.setstate (std::ios::failbit);
+        }
+    }
+  else
+    {
+      m_file.open (filename.c_str (), mode);
+    }
   if (mode & std::ios::in)
     {
       // will set the fail bit if file header is invalid.
@@ -30,6 +30,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class CompressedFileBuffer;
 
 
 /**
@@ -74,6 +75,10 @@ public:
    * selected as a binary file (fstream::binary is automatically ored with the mode
    * field).
    *
+   * If the file name ends in ".gz" the file is read or written in gzip
+   * format (see CompressedFileBuffer); such files can be opened directly
+   * by Wireshark.
+   *
    * \param filename String containing the name of the file.
    *
    * \param mode the access mode for the file.
@@ -368,6 +373,7 @@ private:
 
   std::string    m_filename;    //!< file name
   std::fstream   m_file;        //!< file stream
+  CompressedFileBuffer *m_compressed; //!< gzip stream buffer used in place of the file buffer, if any
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
   bool m_nanosecMode;           //!< nanosecond timestamp mode
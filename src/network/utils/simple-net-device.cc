@@ -28,6 +28,7 @@
 #include "ns3/boolean.h"
 #include "ns3/string.h"
 #include "ns3/tag.h"
+#include "ns3/socket.h"
 #include "ns3/simulator.h"
 #include "ns3/queue.h"
 
@@ -428,7 +429,9 @@ bool
 SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address& dest, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << source << dest << protocolNumber);
-  if (p->GetSize () > GetMtu ())
+  // Large segments (see SocketLargeSendTag) are sent as a single frame
+  SocketLargeSendTag largeSendTag;
+  if (p->GetSize () > GetMtu () && !p->PeekPacketTag (largeSendTag))
     {
       return false;
     }
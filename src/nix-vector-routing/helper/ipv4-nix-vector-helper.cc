@@ -20,6 +20,9 @@
 
 #include "ipv4-nix-vector-helper.h"
 #include "ns3/ipv4-nix-vector-routing.h"
+#include "ns3/routing-table-file.h"
+#include "ns3/node-list.h"
+#include "ns3/abort.h"
 
 namespace ns3 {
 
@@ -47,4 +50,47 @@ Ipv4NixVectorHelper::Create (Ptr<Node> node) const
   node->AggregateObject (agent);
   return agent;
 }
+
+/**
+ * \returns the nix-vector routing of any node, or null if none
+ */
+static Ptr<Ipv4NixVectorRouting>
+GetAnyNixVectorRouting (void)
+{
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<Ipv4NixVectorRouting> routing = (*i)->GetObject<Ipv4NixVectorRouting> ();
+      if (routing)
+        {
+          return routing;
+        }
+    }
+  return 0;
+}
+
+void
+Ipv4NixVectorHelper::WriteNextHopTable (std::string filename)
+{
+  // The table is shared by all the nodes
+  Ptr<Ipv4NixVectorRouting> routing = GetAnyNixVectorRouting ();
+  NS_ABORT_MSG_UNLESS (routing, "No node uses nix-vector routing");
+  Buffer buffer;
+  buffer.AddAtStart (routing->GetNextHopTableSerializedSize ());
+  routing->SerializeNextHopTable (buffer.Begin ());
+  RoutingTableFile::Write (filename, "ipv4-nix-vector-next-hops", buffer);
+}
+
+bool
+Ipv4NixVectorHelper::ReadNextHopTable (std::string filename)
+{
+  Ptr<Ipv4NixVectorRouting> routing = GetAnyNixVectorRouting ();
+  NS_ABORT_MSG_UNLESS (routing, "No node uses nix-vector routing");
+  Buffer buffer;
+  if (!RoutingTableFile::Read (filename, "ipv4-nix-vector-next-hops", buffer))
+    {
+      return false;
+    }
+  routing->DeserializeNextHopTable (buffer.Begin ());
+  return true;
+}
 } // namespace ns3
@@ -21,6 +21,7 @@
 #ifndef IPV4_NIX_VECTOR_HELPER_H
 #define IPV4_NIX_VECTOR_HELPER_H
 
+#include <string>
 #include "ns3/object-factory.h"
 #include "ns3/ipv4-routing-helper.h"
 
@@ -66,6 +67,31 @@ public:
   */
   virtual Ptr<Ipv4RoutingProtocol> Create (Ptr<Node> node) const;
 
+  /**
+   * \brief Write the shared next-hop table to a file, tagged with a hash
+   * of the topology.
+   *
+   * The table is built if needed.  It is used with the
+   * "NixVectorNextHopTable" global value set.
+   *
+   * \param filename the name of the routing table file
+   * \see RoutingTableFile
+   */
+  static void WriteNextHopTable (std::string filename);
+
+  /**
+   * \brief Load the shared next-hop table written by WriteNextHopTable ().
+   *
+   * The file is refused if it was written for another topology.  As after
+   * any topology change, the table is built again if the topology changes
+   * later on.
+   *
+   * \param filename the name of the routing table file
+   * \returns true if the table was read, false if the file does not
+   * exist, is corrupted or does not match the topology
+   */
+  static bool ReadNextHopTable (std::string filename);
+
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
@@ -20,11 +20,21 @@
 
 #include <queue>
 #include <iomanip>
+#include <thread>
+#include <unordered_map>
 
+#include "ns3/core-config.h"
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/names.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/ipv4-list-routing.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif
 
 #include "ipv4-nix-vector-routing.h"
 
@@ -36,6 +46,61 @@ NS_OBJECT_ENSURE_REGISTERED (Ipv4NixVectorRouting);
 
 bool Ipv4NixVectorRouting::g_isCacheDirty = false;
 
+/**
+ * \ingroup nix-vector-routing
+ * Route with the shared next-hop table instead of nix-vectors
+ */
+static GlobalValue g_nixVectorNextHopTable = GlobalValue ("NixVectorNextHopTable",
+                                                          "Forward packets hop by hop with a next-hop table shared "
+                                                          "by all the nodes instead of using nix-vectors.",
+                                                          BooleanValue (false),
+                                                          MakeBooleanChecker ());
+
+/**
+ * \ingroup nix-vector-routing
+ * Number of threads building the shared next-hop table
+ */
+static GlobalValue g_nixVectorThreads = GlobalValue ("NixVectorThreads",
+                                                     "The number of threads building the next-hop table "
+                                                     "(0 for one per processor).",
+                                                     UintegerValue (1),
+                                                     MakeUintegerChecker<uint32_t> ());
+
+namespace {
+
+/**
+ * \ingroup nix-vector-routing
+ * Next hop from every node to every other node
+ *
+ * The topology is stored in compressed sparse row form: the links of node
+ * n are the entries from offsets[n] to offsets[n + 1] - 1 of the link
+ * arrays, in the order of the nix-vector neighbor indexes.  The next hops
+ * are stored as these neighbor indexes, destination by destination.
+ */
+struct NixNextHopTable
+{
+  bool valid;                          //!< true if the table matches the topology
+  uint32_t nNodes;                     //!< number of nodes
+  uint32_t nThreads;                   //!< number of threads building the table
+  std::vector<uint32_t> offsets;       //!< first link of each node
+  std::vector<uint32_t> locals;        //!< node at the local end of each link
+  std::vector<uint32_t> remotes;       //!< node at the other end of each link
+  std::vector<uint32_t> devices;       //!< local device index of each link
+  std::vector<Ipv4Address> gateways;   //!< address of the remote device of each link
+  std::vector<uint32_t> inOffsets;     //!< first incoming link of each node
+  std::vector<uint32_t> inLinks;       //!< index of each incoming, usable link
+  std::vector<uint16_t> nextHops;      //!< neighbor index of the next hop, by destination then node
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> addresses; //!< node owning each address
+};
+
+/// No next hop: the destination is the node itself or cannot be reached
+const uint16_t NIX_NO_NEXT_HOP = 0xffff;
+
+/// The shared next-hop table
+NixNextHopTable g_nextHopTable = { false, 0, 1 };
+
+} // unnamed namespace
+
 TypeId 
 Ipv4NixVectorRouting::GetTypeId (void)
 {
@@ -105,6 +170,7 @@ Ipv4NixVectorRouting::FlushGlobalNixRoutingCache (void) const
       rp->FlushNixCache ();
       rp->FlushIpv4RouteCache ();
     }
+  g_nextHopTable.valid = false;
 }
 
 void
@@ -303,7 +369,7 @@ Ipv4NixVectorRouting::BuildNixVector (const std::vector< Ptr<Node> > & parentVec
 }
 
 void
-Ipv4NixVectorRouting::GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer)
+Ipv4NixVectorRouting::GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer) const
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -497,6 +563,19 @@ Ipv4NixVectorRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<
 
   CheckCacheStateAndFlush ();
 
+  if (IsNextHopTableEnabled ())
+    {
+      rtentry = GetNextHopRoute (header.GetDestination (), oif);
+      if (!rtentry)
+        {
+          NS_LOG_ERROR ("No path to the dest: " << header.GetDestination ());
+          sockerr = Socket::ERROR_NOROUTETOHOST;
+          return 0;
+        }
+      sockerr = Socket::ERROR_NOTERROR;
+      return rtentry;
+    }
+
   NS_LOG_DEBUG ("Dest IP from header: " << header.GetDestination ());
   // check if cache
   nixVectorInCache = GetNixVectorInCache (header.GetDestination ());
@@ -646,6 +725,18 @@ Ipv4NixVectorRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header,
 
   Ptr<Ipv4Route> rtentry;
 
+  if (IsNextHopTableEnabled ())
+    {
+      rtentry = GetNextHopRoute (header.GetDestination (), 0);
+      if (!rtentry)
+        {
+          NS_LOG_LOGIC ("No path to the dest: " << header.GetDestination ());
+          return false;
+        }
+      ucb (rtentry, p, header);
+      return true;
+    }
+
   // Get the nix-vector from the packet
   Ptr<NixVector> nixVector = p->GetNixVector ();
 
@@ -708,6 +799,41 @@ Ipv4NixVectorRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::
       << ", Local time: " << GetObject<Node> ()->GetLocalTime ().As (unit)
       << ", Nix Routing" << std::endl;
 
+  if (IsNextHopTableEnabled ())
+    {
+      BuildNextHopTable ();
+      uint32_t node = m_node->GetId ();
+      *os << "NextHopTable:" << std::endl;
+      *os << "Destination     Gateway           OutputDevice" << std::endl;
+      for (uint32_t d = 0; d < g_nextHopTable.nNodes; d++)
+        {
+          uint16_t k = g_nextHopTable.nextHops[uint64_t (d) * g_nextHopTable.nNodes + node];
+          if (k == NIX_NO_NEXT_HOP)
+            {
+              continue;
+            }
+          uint32_t link = g_nextHopTable.offsets[node] + k;
+          std::ostringstream dest, gw;
+          dest << "Node " << d;
+          *os << std::setiosflags (std::ios::left) << std::setw (16) << dest.str ();
+          gw << g_nextHopTable.gateways[link];
+          *os << std::setiosflags (std::ios::left) << std::setw (16) << gw.str ();
+          *os << "  ";
+          Ptr<NetDevice> device = m_node->GetDevice (g_nextHopTable.devices[link]);
+          if (Names::FindName (device) != "")
+            {
+              *os << Names::FindName (device);
+            }
+          else
+            {
+              *os << device->GetIfIndex ();
+            }
+          *os << std::endl;
+        }
+      *os << std::endl;
+      return;
+    }
+
   *os << "NixCache:" << std::endl;
   if (m_nixCache.size () > 0)
     {
@@ -916,6 +1042,324 @@ Ipv4NixVectorRouting::BFS (uint32_t numberOfNodes, Ptr<Node> source,
   return false;
 }
 
+bool
+Ipv4NixVectorRouting::IsNextHopTableEnabled (void)
+{
+  BooleanValue enabled;
+  g_nixVectorNextHopTable.GetValue (enabled);
+  return enabled.Get ();
+}
+
+void
+Ipv4NixVectorRouting::ClearNextHopTable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_nextHopTable = NixNextHopTable ();
+  g_nextHopTable.valid = false;
+}
+
+void
+Ipv4NixVectorRouting::BuildNextHopTable (void) const
+{
+  if (g_nextHopTable.valid && g_nextHopTable.nNodes == NodeList::GetNNodes ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION_NOARGS ();
+  BuildNextHopLinks ();
+  NixNextHopTable &table = g_nextHopTable;
+  table.nextHops.assign (uint64_t (table.nNodes) * table.nNodes, NIX_NO_NEXT_HOP);
+  UintegerValue threads;
+  g_nixVectorThreads.GetValue (threads);
+  table.nThreads = threads.Get ();
+  if (table.nThreads == 0)
+    {
+      table.nThreads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  table.nThreads = std::max (std::min (table.nThreads, table.nNodes), 1U);
+  NS_LOG_LOGIC ("Building the next-hop table of " << table.nNodes << " nodes and "
+                << table.remotes.size () << " links with " << table.nThreads << " threads");
+#ifdef HAVE_PTHREAD_H
+  if (table.nThreads > 1)
+    {
+      std::vector<Ptr<SystemThread> > threads;
+      for (uint32_t t = 0; t < table.nThreads; t++)
+        {
+          threads.push_back (Create<SystemThread> (MakeBoundCallback (&Ipv4NixVectorRouting::ComputeNextHopsWorker, t)));
+          threads.back ()->Start ();
+        }
+      for (uint32_t t = 0; t < threads.size (); t++)
+        {
+          threads[t]->Join ();
+        }
+    }
+  else
+#endif
+    {
+      table.nThreads = 1;
+      ComputeNextHopsWorker (0);
+    }
+  table.valid = true;
+}
+
+void
+Ipv4NixVectorRouting::BuildNextHopLinks (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (g_nextHopTable.nNodes == 0)
+    {
+      // The table refers to the nodes of this simulation only
+      Simulator::ScheduleDestroy (&Ipv4NixVectorRouting::ClearNextHopTable);
+    }
+  NixNextHopTable &table = g_nextHopTable;
+  table.nNodes = NodeList::GetNNodes ();
+  table.offsets.assign (1, 0);
+  table.locals.clear ();
+  table.remotes.clear ();
+  table.devices.clear ();
+  table.gateways.clear ();
+  table.addresses.clear ();
+  std::vector<bool> usable;
+
+  // Gather the links of each node, in the order of the neighbor indexes
+  // used by nix-vectors, and whether packets can be sent on them
+  for (uint32_t n = 0; n < table.nNodes; n++)
+    {
+      Ptr<Node> node = NodeList::GetNode (n);
+      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+      if (ipv4)
+        {
+          for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+            {
+              for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+                {
+                  table.addresses.insert (std::make_pair (ipv4->GetAddress (i, j).GetLocal (), n));
+                }
+            }
+        }
+      for (uint32_t i = 0; i < node->GetNDevices (); i++)
+        {
+          Ptr<NetDevice> localNetDevice = node->GetDevice (i);
+          if (localNetDevice->IsBridge ())
+            {
+              continue;
+            }
+          Ptr<Channel> channel = localNetDevice->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          bool up = localNetDevice->IsLinkUp ();
+          if (ipv4)
+            {
+              int32_t interfaceIndex = ipv4->GetInterfaceForDevice (localNetDevice);
+              up = up && interfaceIndex >= 0 && ipv4->IsUp (interfaceIndex);
+            }
+          NetDeviceContainer netDeviceContainer;
+          GetAdjacentNetDevices (localNetDevice, channel, netDeviceContainer);
+          for (NetDeviceContainer::Iterator iter = netDeviceContainer.Begin (); iter != netDeviceContainer.End (); iter++)
+            {
+              Ptr<Node> remoteNode = (*iter)->GetNode ();
+              Ptr<Ipv4> remoteIpv4 = remoteNode->GetObject<Ipv4> ();
+              Ipv4Address gateway;
+              if (remoteIpv4)
+                {
+                  int32_t interfaceIndex = remoteIpv4->GetInterfaceForDevice (*iter);
+                  if (interfaceIndex >= 0 && remoteIpv4->GetNAddresses (interfaceIndex) > 0)
+                    {
+                      gateway = remoteIpv4->GetAddress (interfaceIndex, 0).GetLocal ();
+                    }
+                }
+              table.locals.push_back (n);
+              table.remotes.push_back (remoteNode->GetId ());
+              table.devices.push_back (i);
+              table.gateways.push_back (gateway);
+              usable.push_back (up);
+            }
+        }
+      table.offsets.push_back (table.remotes.size ());
+      NS_ABORT_MSG_IF (table.offsets[n + 1] - table.offsets[n] >= NIX_NO_NEXT_HOP,
+                       "Node " << n << " has too many neighbors for the next-hop table");
+    }
+
+  // Index the usable links by the node they lead to
+  table.inOffsets.assign (table.nNodes + 1, 0);
+  for (uint32_t l = 0; l < table.remotes.size (); l++)
+    {
+      if (usable[l])
+        {
+          table.inOffsets[table.remotes[l] + 1]++;
+        }
+    }
+  for (uint32_t n = 0; n < table.nNodes; n++)
+    {
+      table.inOffsets[n + 1] += table.inOffsets[n];
+    }
+  table.inLinks.resize (table.inOffsets[table.nNodes]);
+  std::vector<uint32_t> fill (table.inOffsets.begin (), table.inOffsets.end () - 1);
+  for (uint32_t l = 0; l < table.remotes.size (); l++)
+    {
+      if (usable[l])
+        {
+          table.inLinks[fill[table.remotes[l]]++] = l;
+        }
+    }
+}
+
+uint32_t
+Ipv4NixVectorRouting::GetNextHopTableSerializedSize (void) const
+{
+  BuildNextHopTable ();
+  uint64_t size = 8 + g_nextHopTable.nextHops.size () * 2;
+  NS_ABORT_MSG_IF (size > 0xffffffff, "The next-hop table is too large to be serialized");
+  return size;
+}
+
+void
+Ipv4NixVectorRouting::SerializeNextHopTable (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+  BuildNextHopTable ();
+  const NixNextHopTable &table = g_nextHopTable;
+  Buffer::Iterator i = start;
+  i.WriteU32 (table.nNodes);
+  i.WriteU32 (table.remotes.size ());
+  for (uint64_t k = 0; k < table.nextHops.size (); k++)
+    {
+      i.WriteU16 (table.nextHops[k]);
+    }
+}
+
+uint32_t
+Ipv4NixVectorRouting::DeserializeNextHopTable (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+  BuildNextHopLinks ();
+  NixNextHopTable &table = g_nextHopTable;
+  Buffer::Iterator i = start;
+  uint32_t nNodes = i.ReadU32 ();
+  uint32_t nLinks = i.ReadU32 ();
+  NS_ABORT_MSG_UNLESS (nNodes == table.nNodes && nLinks == table.remotes.size ()
+                       && i.GetRemainingSize () >= uint64_t (nNodes) * nNodes * 2,
+                       "The next-hop table does not match the topology");
+  table.nextHops.resize (uint64_t (nNodes) * nNodes);
+  for (uint32_t d = 0; d < nNodes; d++)
+    {
+      for (uint32_t n = 0; n < nNodes; n++)
+        {
+          uint16_t k = i.ReadU16 ();
+          NS_ABORT_MSG_UNLESS (k == NIX_NO_NEXT_HOP || k < table.offsets[n + 1] - table.offsets[n],
+                               "Invalid next hop from node " << n << " to node " << d);
+          table.nextHops[uint64_t (d) * nNodes + n] = k;
+        }
+    }
+  table.valid = true;
+  return i.GetDistanceFrom (start);
+}
+
+void
+Ipv4NixVectorRouting::ComputeNextHopsWorker (uint32_t first)
+{
+  std::vector<uint32_t> queue;
+  for (uint32_t d = first; d < g_nextHopTable.nNodes; d += g_nextHopTable.nThreads)
+    {
+      ComputeNextHops (d, queue);
+    }
+}
+
+void
+Ipv4NixVectorRouting::ComputeNextHops (uint32_t dest, std::vector<uint32_t> &queue)
+{
+  // Breadth-first search backwards from the destination: the first link
+  // found from a node is its next hop, on a path with the fewest hops.
+  const NixNextHopTable &table = g_nextHopTable;
+  uint16_t *nextHops = &g_nextHopTable.nextHops[uint64_t (dest) * table.nNodes];
+  queue.clear ();
+  queue.push_back (dest);
+  for (uint32_t head = 0; head < queue.size (); head++)
+    {
+      uint32_t node = queue[head];
+      for (uint32_t i = table.inOffsets[node]; i < table.inOffsets[node + 1]; i++)
+        {
+          uint32_t link = table.inLinks[i];
+          uint32_t tail = table.locals[link];
+          if (tail == dest || nextHops[tail] != NIX_NO_NEXT_HOP)
+            {
+              continue;
+            }
+          nextHops[tail] = link - table.offsets[tail];
+          queue.push_back (tail);
+        }
+    }
+}
+
+Ptr<Ipv4Route>
+Ipv4NixVectorRouting::GetNextHopRoute (Ipv4Address dest, Ptr<NetDevice> oif) const
+{
+  NS_LOG_FUNCTION (this << dest << oif);
+  BuildNextHopTable ();
+  const NixNextHopTable &table = g_nextHopTable;
+  std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash>::const_iterator it = table.addresses.find (dest);
+  uint32_t node = m_node->GetId ();
+  /// \internal
+  /// Do not process packets to self (see \bugid{1308})
+  if (it == table.addresses.end () || it->second == node)
+    {
+      return 0;
+    }
+  uint32_t destNode = it->second;
+  const uint16_t *nextHops = &table.nextHops[uint64_t (destNode) * table.nNodes];
+  uint32_t link = table.offsets[node + 1];
+  if (!oif)
+    {
+      if (nextHops[node] != NIX_NO_NEXT_HOP)
+        {
+          link = table.offsets[node] + nextHops[node];
+        }
+    }
+  else
+    {
+      // Go through the given device, to the destination if it is a
+      // neighbor, or else to the first neighbor with a path to it
+      int32_t interfaceIndex = m_ipv4->GetInterfaceForDevice (oif);
+      if (interfaceIndex < 0 || !m_ipv4->IsUp (interfaceIndex) || !oif->IsLinkUp ())
+        {
+          return 0;
+        }
+      for (uint32_t l = table.offsets[node]; l < table.offsets[node + 1]; l++)
+        {
+          uint32_t remote = table.remotes[l];
+          if (m_node->GetDevice (table.devices[l]) != oif)
+            {
+              continue;
+            }
+          if (remote == destNode)
+            {
+              link = l;
+              break;
+            }
+          if (link == table.offsets[node + 1] && nextHops[remote] != NIX_NO_NEXT_HOP)
+            {
+              link = l;
+            }
+        }
+    }
+  if (link == table.offsets[node + 1])
+    {
+      return 0;
+    }
+
+  Ptr<NetDevice> device = m_node->GetDevice (table.devices[link]);
+  int32_t interfaceIndex = m_ipv4->GetInterfaceForDevice (device);
+  NS_ASSERT_MSG (interfaceIndex != -1, "Interface index not found for device");
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetSource (m_ipv4->GetAddress (interfaceIndex, 0).GetLocal ());
+  rtentry->SetGateway (table.gateways[link]);
+  rtentry->SetDestination (dest);
+  rtentry->SetOutputDevice (device);
+  return rtentry;
+}
+
 void 
 Ipv4NixVectorRouting::CheckCacheStateAndFlush (void) const
 {
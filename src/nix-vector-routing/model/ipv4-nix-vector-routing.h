@@ -32,6 +32,7 @@
 #include "ns3/nix-vector.h"
 #include "ns3/bridge-net-device.h"
 #include "ns3/nstime.h"
+#include "ns3/buffer.h"
 
 namespace ns3 {
 
@@ -56,6 +57,20 @@ typedef std::map<Ipv4Address, Ptr<Ipv4Route> > Ipv4RouteMap_t;
 /**
  * \ingroup nix-vector-routing
  * Nix-vector routing protocol
+ *
+ * By default, the path to each destination is found by a breadth-first
+ * search from the source node the first time the destination is used,
+ * and carried by the packets as a nix-vector; the nix-vectors and the
+ * routes are cached on every node.
+ *
+ * With the "NixVectorNextHopTable" global value set, all the nodes share
+ * instead a table of the next hop from every node to every other node,
+ * built once (and after each topology change) from a compact (CSR)
+ * adjacency of the whole topology, with one breadth-first search per
+ * destination run on "NixVectorThreads" threads.  Packets are then
+ * forwarded hop by hop from the table, without nix-vectors nor per-node
+ * caches.  The table uses two bytes per pair of nodes, plus the
+ * adjacency, whose size is proportional to the number of interfaces.
  */
 class Ipv4NixVectorRouting : public Ipv4RoutingProtocol
 {
@@ -88,6 +103,31 @@ public:
    */
   void FlushGlobalNixRoutingCache (void) const;
 
+  /**
+   * @brief Get the size of the shared next-hop table once serialized,
+   * building the table if needed.
+   * @return the number of bytes written by SerializeNextHopTable ()
+   */
+  uint32_t GetNextHopTableSerializedSize (void) const;
+
+  /**
+   * @brief Serialize the next hops of the shared next-hop table,
+   * building the table if needed.
+   * @param start the buffer iterator to write at
+   */
+  void SerializeNextHopTable (Buffer::Iterator start) const;
+
+  /**
+   * @brief Load the shared next-hop table written by SerializeNextHopTable ()
+   *
+   * Only the links of the current topology are gathered: no breadth-first
+   * search is run.  The table must have been written for this topology.
+   *
+   * @param start the buffer iterator to read from
+   * @return the number of bytes read
+   */
+  uint32_t DeserializeNextHopTable (Buffer::Iterator start);
+
 private:
 
   /**
@@ -142,7 +182,7 @@ private:
    * \param [in] channel the channel to check
    * \param [out] netDeviceContainer the NetDeviceContainer of the NetDevices in the channel.
    */
-  void GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer);
+  void GetAdjacentNetDevices (Ptr<NetDevice> netDevice, Ptr<Channel> channel, NetDeviceContainer & netDeviceContainer) const;
 
   /**
    * Iterates through the node list and finds the one
@@ -208,6 +248,49 @@ private:
             std::vector< Ptr<Node> > & parentVector,
             Ptr<NetDevice> oif);
 
+  /**
+   * \returns true if the routes are taken from the shared next-hop table
+   */
+  static bool IsNextHopTableEnabled (void);
+
+  /**
+   * Build the shared next-hop table, if it was not built since the last
+   * topology change
+   */
+  void BuildNextHopTable (void) const;
+
+  /**
+   * Gather the links of the shared next-hop table from the topology,
+   * without computing the next hops
+   */
+  void BuildNextHopLinks (void) const;
+
+  /**
+   * Free the shared next-hop table
+   */
+  static void ClearNextHopTable (void);
+
+  /**
+   * Compute the next hops to one destination
+   * \param dest the destination node index
+   * \param queue scratch space for the breadth-first search
+   */
+  static void ComputeNextHops (uint32_t dest, std::vector<uint32_t> &queue);
+
+  /**
+   * Compute the next hops to the destinations assigned to a thread
+   * \param first the first destination node index of the thread
+   */
+  static void ComputeNextHopsWorker (uint32_t first);
+
+  /**
+   * Build the route to a destination from the shared next-hop table
+   * \param dest the destination address
+   * \param oif the output interface to use, if not null
+   * \returns the route, or null if the destination cannot be reached
+   */
+  Ptr<Ipv4Route> GetNextHopRoute (Ipv4Address dest, Ptr<NetDevice> oif) const;
+
   void DoDispose (void);
 
   /* From Ipv4RoutingProtocol */
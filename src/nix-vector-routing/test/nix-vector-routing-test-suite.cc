@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <map>
+#include <utility>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/csma-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-nix-vector-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/packet.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup nix-vector-routing
+ * \defgroup nix-vector-routing-test Nix-vector routing module tests
+ */
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Check the routes of the shared next-hop table.
+ *
+ * UDP packets are sent between many pairs of nodes of a grid of
+ * point-to-point links with a CSMA LAN joining two opposite corners,
+ * before and after an interface in the middle of the grid is brought
+ * down. The number of hops of each packet, given by its TTL on arrival,
+ * is the same with the next-hop table, built by one or several threads,
+ * as with nix-vectors.
+ */
+class NixVectorNextHopTableTestCase : public TestCase
+{
+public:
+  NixVectorNextHopTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Number of hops of the packets, by phase, source and destination node
+  typedef std::map<std::pair<uint32_t, std::pair<uint32_t, uint32_t> >, uint32_t> HopCounts;
+
+  /**
+   * Run the scenario
+   * \param nextHopTable whether the shared next-hop table is used
+   * \param threads the number of threads building the table
+   * \return the number of hops of the packets received
+   */
+  HopCounts RunOne (bool nextHopTable, uint32_t threads);
+  /**
+   * Send a packet
+   * \param node the index of the source node
+   * \param dest the index of the destination node
+   * \param phase the phase of the scenario
+   */
+  void SendPacket (uint32_t node, uint32_t dest, uint32_t phase);
+  /**
+   * Receive the packets of a socket
+   * \param socket the socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  /**
+   * \param node the index of a node
+   * \return the address of the node
+   */
+  Ipv4Address GetAddress (uint32_t node) const;
+
+  NodeContainer m_nodes;               //!< the nodes
+  std::vector<Ptr<Socket> > m_sockets; //!< the socket of each node
+  HopCounts m_hops;                    //!< the number of hops of the packets received
+  uint32_t m_nSent;                    //!< the number of packets sent
+};
+
+/// Side of the grid
+static const uint32_t GRID_SIZE = 7;
+/// Number of nodes of the grid
+static const uint32_t GRID_NODES = GRID_SIZE * GRID_SIZE;
+/// Number of hosts only attached to the LAN
+static const uint32_t LAN_HOSTS = 3;
+/// UDP port of the sockets
+static const uint16_t PORT = 9;
+
+NixVectorNextHopTableTestCase::NixVectorNextHopTableTestCase ()
+  : TestCase ("Check that the next-hop table gives paths as short as nix-vectors"),
+    m_nSent (0)
+{
+}
+
+Ipv4Address
+NixVectorNextHopTableTestCase::GetAddress (uint32_t node) const
+{
+  return m_nodes.Get (node)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+}
+
+void
+NixVectorNextHopTableTestCase::SendPacket (uint32_t node, uint32_t dest, uint32_t phase)
+{
+  Ptr<Packet> p = Create<Packet> (reinterpret_cast<const uint8_t *> (&phase), sizeof (phase));
+  m_sockets[node]->SendTo (p, 0, InetSocketAddress (GetAddress (dest), PORT));
+  m_nSent++;
+}
+
+void
+NixVectorNextHopTableTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  Address from;
+  while ((p = socket->RecvFrom (from)))
+    {
+      SocketIpTtlTag ttl;
+      NS_TEST_EXPECT_MSG_EQ (p->RemovePacketTag (ttl), true, "No TTL tag");
+      uint32_t phase;
+      p->CopyData (reinterpret_cast<uint8_t *> (&phase), sizeof (phase));
+      Ipv4Address source = InetSocketAddress::ConvertFrom (from).GetIpv4 ();
+      uint32_t src = m_nodes.GetN ();
+      for (uint32_t n = 0; n < m_nodes.GetN (); n++)
+        {
+          if (m_nodes.Get (n)->GetObject<Ipv4> ()->GetInterfaceForAddress (source) >= 0)
+            {
+              src = n;
+            }
+        }
+      NS_TEST_EXPECT_MSG_LT (src, m_nodes.GetN (), "Unknown source " << source);
+      // the TTL is decremented by each router, not by the destination
+      m_hops[std::make_pair (phase, std::make_pair (src, socket->GetNode ()->GetId ()))] = 64 - ttl.GetTtl () + 1;
+    }
+}
+
+NixVectorNextHopTableTestCase::HopCounts
+NixVectorNextHopTableTestCase::RunOne (bool nextHopTable, uint32_t threads)
+{
+  Config::SetGlobal ("NixVectorNextHopTable", BooleanValue (nextHopTable));
+  Config::SetGlobal ("NixVectorThreads", UintegerValue (threads));
+
+  m_nodes = NodeContainer ();
+  m_nodes.Create (GRID_NODES + LAN_HOSTS);
+  Ipv4NixVectorHelper nixRouting;
+  InternetStackHelper stack;
+  stack.SetRoutingHelper (nixRouting);
+  stack.Install (m_nodes);
+
+  // Each node gets the address of its first interface from the first link
+  // it is attached to
+  PointToPointHelper p2p;
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.252");
+  for (uint32_t i = 0; i < GRID_SIZE; i++)
+    {
+      for (uint32_t j = 0; j < GRID_SIZE; j++)
+        {
+          uint32_t n = i * GRID_SIZE + j;
+          if (j + 1 < GRID_SIZE)
+            {
+              address.Assign (p2p.Install (m_nodes.Get (n), m_nodes.Get (n + 1)));
+              address.NewNetwork ();
+            }
+          if (i + 1 < GRID_SIZE)
+            {
+              address.Assign (p2p.Install (m_nodes.Get (n), m_nodes.Get (n + GRID_SIZE)));
+              address.NewNetwork ();
+            }
+        }
+    }
+  NodeContainer lan;
+  lan.Add (m_nodes.Get (0));
+  lan.Add (m_nodes.Get (GRID_NODES - 1));
+  for (uint32_t h = 0; h < LAN_HOSTS; h++)
+    {
+      lan.Add (m_nodes.Get (GRID_NODES + h));
+    }
+  CsmaHelper csma;
+  Ipv4AddressHelper lanAddress ("10.200.0.0", "255.255.255.0");
+  lanAddress.Assign (csma.Install (lan));
+
+  m_sockets.clear ();
+  for (uint32_t n = 0; n < m_nodes.GetN (); n++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (m_nodes.Get (n), UdpSocketFactory::GetTypeId ());
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), PORT));
+      socket->SetIpRecvTtl (true);
+      socket->SetRecvCallback (MakeCallback (&NixVectorNextHopTableTestCase::Receive, this));
+      m_sockets.push_back (socket);
+    }
+
+  m_hops.clear ();
+  m_nSent = 0;
+  // The packets are spread over time, so that none is dropped while the
+  // address of a neighbor is being resolved
+  for (uint32_t n = 0; n < m_nodes.GetN (); n++)
+    {
+      for (uint32_t k = 1; k < m_nodes.GetN (); k += 5)
+        {
+          uint32_t dest = (n + k) % m_nodes.GetN ();
+          Time offset = MilliSeconds (10 * n + k);
+          Simulator::Schedule (Seconds (1) + offset, &NixVectorNextHopTableTestCase::SendPacket, this, n, dest, 0);
+          Simulator::Schedule (Seconds (3) + offset, &NixVectorNextHopTableTestCase::SendPacket, this, n, dest, 1);
+        }
+    }
+  // Cut the grid in the middle, by bringing down both ends of a link of
+  // the node at its center
+  Ptr<Channel> channel = m_nodes.Get (GRID_NODES / 2)->GetDevice (2)->GetChannel ();
+  for (uint32_t d = 0; d < channel->GetNDevices (); d++)
+    {
+      Ptr<NetDevice> device = channel->GetDevice (d);
+      Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+      int32_t down = ipv4->GetInterfaceForDevice (device);
+      NS_TEST_EXPECT_MSG_GT (down, 0, "No interface to bring down");
+      Simulator::Schedule (Seconds (2), &Ipv4::SetDown, ipv4, down);
+    }
+
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_hops.size (), m_nSent, "Some packets were not received");
+  return m_hops;
+}
+
+void
+NixVectorNextHopTableTestCase::DoRun (void)
+{
+  HopCounts reference = RunOne (false, 1);
+  HopCounts single = RunOne (true, 1);
+  HopCounts multiple = RunOne (true, 4);
+  Config::SetGlobal ("NixVectorNextHopTable", BooleanValue (false));
+  Config::SetGlobal ("NixVectorThreads", UintegerValue (1));
+
+  NS_TEST_ASSERT_MSG_EQ (single.size (), reference.size (), "Different packets received with one thread");
+  NS_TEST_ASSERT_MSG_EQ (multiple.size (), reference.size (), "Different packets received with several threads");
+  bool longer = false;
+  for (HopCounts::const_iterator it = reference.begin (); it != reference.end (); ++it)
+    {
+      if (it->first.first == 1)
+        {
+          HopCounts::const_iterator before = reference.find (std::make_pair (0, it->first.second));
+          longer = longer || (before != reference.end () && it->second > before->second);
+        }
+      NS_TEST_EXPECT_MSG_EQ (single[it->first], it->second,
+                             "Wrong number of hops from " << it->first.second.first << " to "
+                             << it->first.second.second << " in phase " << it->first.first
+                             << " with one thread");
+      NS_TEST_EXPECT_MSG_EQ (multiple[it->first], it->second,
+                             "Wrong number of hops from " << it->first.second.first << " to "
+                             << it->first.second.second << " in phase " << it->first.first
+                             << " with several threads");
+    }
+  NS_TEST_EXPECT_MSG_EQ (longer, true, "Bringing the interface down should lengthen some paths");
+}
+
+/**
+ * \ingroup nix-vector-routing-test
+ * \ingroup tests
+ *
+ * \brief Nix-vector routing TestSuite
+ */
+class NixVectorRoutingTestSuite : public TestSuite
+{
+public:
+  NixVectorRoutingTestSuite ()
+    : TestSuite ("nix-vector-routing", UNIT)
+  {
+    AddTestCase (new NixVectorNextHopTableTestCase, TestCase::QUICK);
+  }
+};
+
+static NixVectorRoutingTestSuite g_nixVectorRoutingTestSuite; //!< Static variable for test initialization
@@ -87,7 +87,8 @@ bool
 PointToPointChannel::TransmitStart (
   Ptr<const Packet> p,
   Ptr<PointToPointNetDevice> src,
-  Time txTime)
+  Time txTime,
+  Time offset)
 {
   NS_LOG_FUNCTION (this << p << src);
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
@@ -98,11 +99,11 @@ PointToPointChannel::TransmitStart (
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
-                                  txTime + m_delay, &PointToPointNetDevice::Receive,
+                                  offset + txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p->Copy ());
 
   // Call the tx anim callback on the net device
-  m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
+  m_txrxPointToPoint (p, src, m_link[wire].m_dst, offset + txTime, offset + txTime + m_delay);
   return true;
 }
 
@@ -73,12 +73,19 @@ public:
 
   /**
    * \brief Transmit a packet over this channel
+   *
+   * A device sending a burst of packets back to back passes all of them
+   * when the burst starts, each with the time at which its first bit goes
+   * on the wire.
+   *
    * \param p Packet to transmit
    * \param src Source PointToPointNetDevice
    * \param txTime Transmit time to apply
+   * \param offset Time from now at which the transmission starts
    * \returns true if successful (currently always true)
    */
-  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime);
+  virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime,
+                              Time offset = Seconds (0));
 
   /**
    * \brief Get number of devices on this channel
@@ -135,7 +142,9 @@ protected:
    * \param [in] packet The packet being transmitted.
    * \param [in] txDevice the TransmitTing NetDevice.
    * \param [in] rxDevice the Receiving NetDevice.
-   * \param [in] duration The amount of time to transmit the packet.
+   * \param [in] duration Last bit transmit time (relative to now), i.e.,
+   *            the amount of time to transmit the packet unless it is sent
+   *            behind others in a burst.
    * \param [in] lastBitTime Last bit receive time (relative to now)
    * \deprecated The non-const \c Ptr<NetDevice> argument is deprecated
    * and will be changed to \c Ptr<const NetDevice> in a future release.
@@ -166,7 +175,7 @@ private:
   TracedCallback<Ptr<const Packet>,     // Packet being transmitted
                  Ptr<NetDevice>,  // Transmitting NetDevice
                  Ptr<NetDevice>,  // Receiving NetDevice
-                 Time,                  // Amount of time to transmit the pkt
+                 Time,                  // Last bit transmit time (relative to now)
                  Time                   // Last bit receive time (relative to now)
                  > m_txrxPointToPoint;
 
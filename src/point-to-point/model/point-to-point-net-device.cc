@@ -25,6 +25,8 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/packet-burst.h"
+#include "ns3/net-device-queue-interface.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -67,6 +69,16 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTxBurst",
+                   "The maximum number of packets taken from the transmit queue "
+                   "and sent back to back with a single transmit complete event, "
+                   "when the transmit traces are not connected. The packets of a "
+                   "burst leave the transmit queue when the burst starts, so that "
+                   "a queue disc above the device dequeues earlier than without "
+                   "bursts: its sojourn times and AQM decisions change.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_maxTxBurst),
+                   MakeUintegerChecker<uint32_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -251,6 +263,28 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
   Time txCompleteTime = txTime + m_tInterframeGap;
 
+  //
+  // If nobody watches the packets going on the wire one at a time, send the
+  // packets waiting in the queue right behind this one, so that a single
+  // event is needed for the whole burst.
+  //
+  std::vector<Ptr<Packet> > burst;
+  if (m_maxTxBurst > 1 && m_phyTxBeginTrace.IsEmpty () && m_phyTxEndTrace.IsEmpty ()
+      && m_snifferTrace.IsEmpty () && m_promiscSnifferTrace.IsEmpty ())
+    {
+      while (burst.size () + 1 < m_maxTxBurst)
+        {
+          Ptr<Packet> next = m_queue->Dequeue ();
+          if (next == 0)
+            {
+              break;
+            }
+          burst.push_back (next);
+          txCompleteTime += m_bps.CalculateBytesTxTime (next->GetSize ()) + m_tInterframeGap;
+        }
+      NS_LOG_LOGIC ("Burst of " << burst.size () + 1 << " packets");
+    }
+
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
   Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
 
@@ -259,6 +293,17 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
     {
       m_phyTxDropTrace (p);
     }
+
+  Time offset = txTime + m_tInterframeGap;
+  for (std::vector<Ptr<Packet> >::const_iterator i = burst.begin (); i != burst.end (); i++)
+    {
+      txTime = m_bps.CalculateBytesTxTime ((*i)->GetSize ());
+      if (m_channel->TransmitStart (*i, this, txTime, offset) == false)
+        {
+          m_phyTxDropTrace (*i);
+        }
+      offset += txTime + m_tInterframeGap;
+    }
   return result;
 }
 
@@ -556,6 +601,59 @@ PointToPointNetDevice::Send (
   return false;
 }
 
+uint32_t
+PointToPointNetDevice::SendBatch (Ptr<PacketBurst> burst, const Address &dest, uint16_t protocolNumber)
+{
+  NS_LOG_FUNCTION (this << burst << dest << protocolNumber);
+
+  Ptr<NetDeviceQueue> txq;
+  Ptr<NetDeviceQueueInterface> ndqi = GetObject<NetDeviceQueueInterface> ();
+  if (ndqi)
+    {
+      txq = ndqi->GetTxQueue (0);
+    }
+
+  //
+  // Enqueue the packets as Send would do, but only start transmitting once
+  // all of them are in the queue, so that they can go in a single burst.
+  // Like the upper layers, stop handing packets over once the queue is stopped.
+  //
+  Ptr<Packet> first;
+  uint32_t n = 0;
+  for (std::list<Ptr<Packet> >::const_iterator i = burst->Begin (); i != burst->End (); i++, n++)
+    {
+      if (n > 0 && txq && txq->IsStopped ())
+        {
+          break;
+        }
+      Ptr<Packet> packet = *i;
+      if (IsLinkUp () == false)
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+      AddHeader (packet, protocolNumber);
+      m_macTxTrace (packet);
+      if (!m_queue->Enqueue (packet))
+        {
+          m_macTxDropTrace (packet);
+          continue;
+        }
+      if (first == 0 && m_txMachineState == READY)
+        {
+          first = m_queue->Dequeue ();
+          m_snifferTrace (first);
+          m_promiscSnifferTrace (first);
+        }
+    }
+
+  if (first != 0)
+    {
+      TransmitStart (first);
+    }
+  return n;
+}
+
 bool
 PointToPointNetDevice::SendFrom (Ptr<Packet> packet, 
                                  const Address &source, 
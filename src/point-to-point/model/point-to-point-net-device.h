@@ -58,6 +58,17 @@ class ErrorModel;
  * Key parameters or objects that can be specified for this device 
  * include a queue, data rate, and interframe transmission gap (the 
  * propagation delay is set in the PointToPointChannel).
+ *
+ * The MaxTxBurst attribute lets the device send up to that many packets
+ * waiting in its queue back to back, with a single event scheduled at the end
+ * of the burst instead of one per packet. The packets reach the peer at the
+ * same times, but they all leave the queue when the burst starts, up to a
+ * burst earlier than they would one at a time. The queue disc installed on
+ * the device is then woken earlier, so that its sojourn times, the Byte
+ * Queue Limits and the AQM decisions differ from those without bursts.
+ * Bursts are only sent while the PhyTxBegin, PhyTxEnd, Sniffer and
+ * PromiscSniffer trace sources are not connected, so that these keep
+ * reporting each packet at the time it starts or ends its transmission.
  */
 class PointToPointNetDevice : public NetDevice
 {
@@ -176,6 +187,7 @@ public:
   virtual bool IsBridge (void) const;
 
   virtual bool Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber);
+  virtual uint32_t SendBatch (Ptr<PacketBurst> burst, const Address &dest, uint16_t protocolNumber);
   virtual bool SendFrom (Ptr<Packet> packet, const Address& source, const Address& dest, uint16_t protocolNumber);
 
   virtual Ptr<Node> GetNode (void) const;
@@ -258,7 +270,10 @@ private:
    * the channel.  The corresponding method is called on the channel to let
    * it know that the physical device this class represents has virtually
    * started sending signals.  An event is scheduled for the time at which
-   * the bits have been completely transmitted.
+   * the bits have been completely transmitted.  If bursts are allowed, the
+   * packets waiting in the queue are sent right behind this one and the
+   * event is scheduled at the end of the last of them; this packet remains
+   * the current one, reported by TransmitComplete.
    *
    * \see PointToPointChannel::TransmitStart ()
    * \see TransmitComplete()
@@ -307,6 +322,12 @@ private:
    */
   Time           m_tInterframeGap;
 
+  /**
+   * The maximum number of packets sent back to back with a single
+   * transmit complete event
+   */
+  uint32_t       m_maxTxBurst;
+
   /**
    * The PointToPointChannel to which this PointToPointNetDevice has been
    * attached.
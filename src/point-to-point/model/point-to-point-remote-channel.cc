@@ -57,7 +57,8 @@ bool
 PointToPointRemoteChannel::TransmitStart (
   Ptr<const Packet> p,
   Ptr<PointToPointNetDevice> src,
-  Time txTime)
+  Time txTime,
+  Time offset)
 {
   NS_LOG_FUNCTION (this << p << src);
   NS_LOG_LOGIC ("UID is " << p->GetUid () << ")");
@@ -69,7 +70,7 @@ PointToPointRemoteChannel::TransmitStart (
 
 #ifdef NS3_MPI
   // Calculate the rxTime (absolute)
-  Time rxTime = Simulator::Now () + txTime + GetDelay ();
+  Time rxTime = Simulator::Now () + offset + txTime + GetDelay ();
   MpiInterface::SendPacket (p->Copy (), rxTime, dst->GetNode ()->GetId (), dst->GetIfIndex ());
 #else
   NS_FATAL_ERROR ("Can't use distributed simulator without MPI compiled in");
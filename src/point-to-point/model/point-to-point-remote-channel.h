@@ -64,10 +64,11 @@ public:
    * \param p Packet to transmit
    * \param src Source PointToPointNetDevice
    * \param txTime Transmit time to apply
+   * \param offset Time from now at which the transmission starts
    * \returns true if successful (currently always true)
    */
   virtual bool TransmitStart (Ptr<const Packet> p, Ptr<PointToPointNetDevice> src,
-                              Time txTime);
+                              Time txTime, Time offset = Seconds (0));
 };
 
 } // namespace ns3
@@ -24,6 +24,10 @@
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/packet-burst.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -94,6 +98,153 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the bursts of the PointToPoint model
+ *
+ * It sends the same packets with and without bursts and checks that
+ * they are received at the same times, with fewer events.
+ */
+class PointToPointBurstTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBurstTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets over a link
+   *
+   * \param maxTxBurst the MaxTxBurst attribute of the sending device
+   * \param events set to the number of events executed
+   * \return the times at which the packets are received
+   */
+  std::vector<Time> SendPackets (uint32_t maxTxBurst, uint64_t &events);
+
+  /**
+   * \brief Send a burst of packets to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param n number of packets
+   * \param size size of the first packet, the others being 100 bytes larger each
+   */
+  void SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n, uint32_t size);
+
+  /**
+   * \brief Send one packet to the device specified
+   *
+   * \param device NetDevice to send to
+   */
+  void SendOnePacket (Ptr<PointToPointNetDevice> device);
+
+  /**
+   * \brief Receive a packet
+   *
+   * \param device the receiving NetDevice
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  std::vector<Time> m_rxTimes; //!< times at which the packets are received
+};
+
+PointToPointBurstTest::PointToPointBurstTest ()
+  : TestCase ("PointToPoint bursts")
+{
+}
+
+void
+PointToPointBurstTest::SendBurst (Ptr<PointToPointNetDevice> device, uint32_t n, uint32_t size)
+{
+  Ptr<PacketBurst> burst = CreateObject<PacketBurst> ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      burst->AddPacket (Create<Packet> (size + 100 * i));
+    }
+  uint32_t sent = device->SendBatch (burst, device->GetBroadcast (), 0x800);
+  NS_TEST_EXPECT_MSG_EQ (sent, n, "The device did not take all the packets");
+}
+
+void
+PointToPointBurstTest::SendOnePacket (Ptr<PointToPointNetDevice> device)
+{
+  Ptr<Packet> p = Create<Packet> (300);
+  device->Send (p, device->GetBroadcast (), 0x800);
+}
+
+bool
+PointToPointBurstTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+std::vector<Time>
+PointToPointBurstTest::SendPackets (uint32_t maxTxBurst, uint64_t &events)
+{
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", TimeValue (MilliSeconds (2)));
+
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+  devA->SetDataRate (DataRate ("10Mbps"));
+  devA->SetInterframeGap (MicroSeconds (3));
+  devA->SetAttribute ("MaxTxBurst", UintegerValue (maxTxBurst));
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue<Packet> > ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBurstTest::Receive, this));
+
+  m_rxTimes.clear ();
+  // bursts sent to an idle device and to a device which is sending a burst,
+  // plus single packets in between
+  Simulator::Schedule (Seconds (1.0), &PointToPointBurstTest::SendBurst, this, devA, 20, 500);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (1500), &PointToPointBurstTest::SendBurst, this, devA, 7, 40);
+  Simulator::Schedule (Seconds (1.0) + MicroSeconds (2000), &PointToPointBurstTest::SendOnePacket, this, devA);
+  Simulator::Schedule (Seconds (1.1), &PointToPointBurstTest::SendBurst, this, devA, 1, 1000);
+  Simulator::Schedule (Seconds (1.1), &PointToPointBurstTest::SendOnePacket, this, devA);
+  Simulator::Schedule (Seconds (1.2), &PointToPointBurstTest::SendBurst, this, devA, 50, 64);
+
+  Simulator::Run ();
+  events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  return m_rxTimes;
+}
+
+void
+PointToPointBurstTest::DoRun (void)
+{
+  uint64_t events;
+  uint64_t burstEvents;
+  std::vector<Time> rxTimes = SendPackets (1, events);
+  std::vector<Time> burstRxTimes = SendPackets (8, burstEvents);
+
+  NS_TEST_ASSERT_MSG_EQ (rxTimes.size (), 80, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (burstRxTimes.size (), rxTimes.size (), "Wrong number of packets received with bursts");
+  for (uint32_t i = 0; i < rxTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (burstRxTimes[i], rxTimes[i], "Packet " << i << " received at a different time");
+    }
+  NS_TEST_EXPECT_MSG_LT (burstEvents, events, "Bursts should take fewer events");
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -110,6 +261,7 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBurstTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
@@ -29,6 +29,7 @@
 #include "ns3/string.h"
 #include "ns3/pointer.h"
 #include <cmath>
+#include <limits>
 
 namespace ns3 {
 
@@ -82,6 +83,23 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+double
+PropagationLossModel::GetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_next != 0)
+    {
+      // The chained models may amplify the signal
+      return std::numeric_limits<double>::infinity ();
+    }
+  return DoGetMaxRange (txPowerDbm, rxPowerDbm);
+}
+
+double
+PropagationLossModel::DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  return std::numeric_limits<double>::infinity ();
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -271,6 +289,20 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+double
+FriisPropagationLossModel::DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (txPowerDbm - m_minLoss < rxPowerDbm)
+    {
+      return 0;
+    }
+  // Distance at which the loss is txPowerDbm - rxPowerDbm, with a margin
+  // for the rounding errors
+  double distance = m_lambda / (4 * M_PI * std::sqrt (m_systemLoss))
+    * std::pow (10.0, (txPowerDbm - rxPowerDbm) / 20);
+  return distance * (1 + 1e-6);
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -534,6 +566,22 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+double
+LogDistancePropagationLossModel::DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_exponent <= 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (txPowerDbm - m_referenceLoss < rxPowerDbm)
+    {
+      return 0;
+    }
+  double distance = m_referenceDistance
+    * std::pow (10.0, (txPowerDbm - m_referenceLoss - rxPowerDbm) / (10 * m_exponent));
+  return distance * (1 + 1e-6);
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -636,6 +684,44 @@ ThreeLogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - pathLossDb;
 }
 
+double
+ThreeLogDistancePropagationLossModel::DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (m_exponent0 <= 0 || m_exponent1 <= 0 || m_exponent2 <= 0 || m_referenceLoss < 0
+      || m_distance0 > m_distance1 || m_distance1 > m_distance2)
+    {
+      // The loss may decrease with the distance
+      return std::numeric_limits<double>::infinity ();
+    }
+  // Highest loss at which the signal is received, and losses at the
+  // boundaries of the fields
+  double maxLossDb = txPowerDbm - rxPowerDbm;
+  double loss1 = m_referenceLoss + 10 * m_exponent0 * std::log10 (m_distance1 / m_distance0);
+  double loss2 = loss1 + 10 * m_exponent1 * std::log10 (m_distance2 / m_distance1);
+  double distance;
+  if (maxLossDb < 0)
+    {
+      return 0;
+    }
+  else if (maxLossDb < m_referenceLoss)
+    {
+      distance = m_distance0;
+    }
+  else if (maxLossDb < loss1)
+    {
+      distance = m_distance0 * std::pow (10.0, (maxLossDb - m_referenceLoss) / (10 * m_exponent0));
+    }
+  else if (maxLossDb < loss2)
+    {
+      distance = m_distance1 * std::pow (10.0, (maxLossDb - loss1) / (10 * m_exponent1));
+    }
+  else
+    {
+      distance = m_distance2 * std::pow (10.0, (maxLossDb - loss2) / (10 * m_exponent2));
+    }
+  return distance * (1 + 1e-6);
+}
+
 int64_t
 ThreeLogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -924,6 +1010,20 @@ RangePropagationLossModel::DoCalcRxPower (double txPowerDbm,
     }
 }
 
+double
+RangePropagationLossModel::DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const
+{
+  if (txPowerDbm < rxPowerDbm)
+    {
+      return 0;
+    }
+  if (rxPowerDbm <= -1000)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  return m_range;
+}
+
 int64_t
 RangePropagationLossModel::DoAssignStreams (int64_t stream)
 {
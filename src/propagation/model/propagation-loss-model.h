@@ -93,6 +93,23 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * \brief Get a distance beyond which the reception power is always
+   * lower than a threshold.
+   *
+   * Channels use this bound to skip the receivers which are too far to
+   * receive a signal.  It is only given by deterministic models whose
+   * loss does not decrease with the distance, and only when no other
+   * model is chained to this one.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param rxPowerDbm the reception power threshold (in dBm)
+   * \returns a distance (in meters) such that the reception power is lower
+   * than rxPowerDbm at any larger distance, or infinity if there is no
+   * known bound
+   */
+  double GetMaxRange (double txPowerDbm, double rxPowerDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -134,6 +151,18 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Returns a distance beyond which the reception power given by this
+   * particular PropagationLossModel is lower than a threshold.
+   *
+   * The default implementation gives no bound.
+   *
+   * \param txPowerDbm current transmission power (in dBm)
+   * \param rxPowerDbm the reception power threshold (in dBm)
+   * \returns the distance (in meters), or infinity if there is no known bound
+   */
+  virtual double DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
@@ -321,6 +350,7 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual double DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -529,6 +559,7 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual double DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -612,6 +643,7 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual double DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   double m_distance0; //!< Beginning of the first (near) distance field
@@ -851,6 +883,7 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual double DoGetMaxRange (double txPowerDbm, double rxPowerDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 private:
   double m_range; //!< Maximum Transmission Range (meters)
@@ -16,6 +16,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <limits>
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/test.h"
@@ -436,6 +437,89 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class MaxRangeTestCase : public TestCase
+{
+public:
+  MaxRangeTestCase ();
+  virtual ~MaxRangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Check that the received power is below the threshold beyond the
+   * maximum range, and above it just within the range
+   * \param model the propagation loss model
+   * \param name the name of the model
+   */
+  void CheckModel (Ptr<PropagationLossModel> model, std::string name);
+};
+
+MaxRangeTestCase::MaxRangeTestCase ()
+  : TestCase ("Test the maximum range of the propagation loss models")
+{
+}
+
+MaxRangeTestCase::~MaxRangeTestCase ()
+{
+}
+
+void
+MaxRangeTestCase::CheckModel (Ptr<PropagationLossModel> model, std::string name)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0,0,0));
+  Ptr<MobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  double txPowers[] = { -10.0, 0.0, 16.0206, 30.0 };
+  double thresholds[] = { -101.0, -82.0, -30.0, 10.0 };
+  for (uint32_t i = 0; i < sizeof (txPowers) / sizeof (txPowers[0]); i++)
+    {
+      for (uint32_t j = 0; j < sizeof (thresholds) / sizeof (thresholds[0]); j++)
+        {
+          double range = model->GetMaxRange (txPowers[i], thresholds[j]);
+          NS_TEST_ASSERT_MSG_LT (range, std::numeric_limits<double>::infinity (), name << ": no maximum range");
+          double beyond[] = { range * 1.0001 + 1e-9, range * 2 + 1e-9, range * 10 + 1e-9 };
+          for (uint32_t k = 0; k < sizeof (beyond) / sizeof (beyond[0]); k++)
+            {
+              b->SetPosition (Vector (beyond[k], 0, 0));
+              NS_TEST_EXPECT_MSG_LT (model->CalcRxPower (txPowers[i], a, b), thresholds[j],
+                                     name << ": received beyond " << range << "m, at " << beyond[k] << "m");
+            }
+          if (range > 0)
+            {
+              b->SetPosition (Vector (range * 0.999, 0, 0));
+              NS_TEST_EXPECT_MSG_GT_OR_EQ (model->CalcRxPower (txPowers[i], a, b), thresholds[j],
+                                           name << ": maximum range " << range << "m is not tight");
+            }
+        }
+    }
+}
+
+void
+MaxRangeTestCase::DoRun (void)
+{
+  CheckModel (CreateObject<FriisPropagationLossModel> (), "Friis");
+  CheckModel (CreateObject<LogDistancePropagationLossModel> (), "LogDistance");
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  logDistance->SetPathLossExponent (2.0);
+  logDistance->SetReference (10.0, 60.0);
+  CheckModel (logDistance, "LogDistance with a reference at 10m");
+  CheckModel (CreateObject<ThreeLogDistancePropagationLossModel> (), "ThreeLogDistance");
+  Ptr<RangePropagationLossModel> range = CreateObject<RangePropagationLossModel> ();
+  range->SetAttribute ("MaxRange", DoubleValue (127.2));
+  CheckModel (range, "Range");
+
+  // No bound for chained or random models
+  Ptr<PropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  friis->SetNext (CreateObject<FriisPropagationLossModel> ());
+  NS_TEST_ASSERT_MSG_EQ (friis->GetMaxRange (16.0, -101.0), std::numeric_limits<double>::infinity (),
+                         "Maximum range of chained models");
+  Ptr<PropagationLossModel> random = CreateObject<RandomPropagationLossModel> ();
+  NS_TEST_ASSERT_MSG_EQ (random->GetMaxRange (16.0, -101.0), std::numeric_limits<double>::infinity (),
+                         "Maximum range of a random model");
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +534,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new MaxRangeTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
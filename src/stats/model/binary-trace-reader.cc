@@ -0,0 +1,347 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "binary-trace-reader.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceReader");
+
+/**
+ * Read a value from an unaligned location.
+ * \param p where to read
+ * \returns the value
+ */
+template <typename T>
+static T
+Load (const uint8_t *p)
+{
+  T value;
+  std::memcpy (&value, p, sizeof (T));
+  return value;
+}
+
+BinaryTraceReader::Record::Record (BinaryTraceReader const *reader, const uint8_t *data)
+  : m_reader (reader),
+    m_data (data)
+{
+}
+
+Time
+BinaryTraceReader::Record::GetTime (void) const
+{
+  return NanoSeconds (Load<int64_t> (m_data));
+}
+
+uint32_t
+BinaryTraceReader::Record::GetContextId (void) const
+{
+  return Load<uint32_t> (m_data + sizeof (int64_t));
+}
+
+std::string const &
+BinaryTraceReader::Record::GetContext (void) const
+{
+  NS_ASSERT (GetContextId () < m_reader->m_contexts.size ());
+  return m_reader->m_contexts[GetContextId ()];
+}
+
+double
+BinaryTraceReader::Record::GetDouble (uint32_t column) const
+{
+  NS_ASSERT (column < m_reader->m_types.size ());
+  const uint8_t *p = m_data + m_reader->m_offsets[column];
+  switch (m_reader->m_types[column])
+    {
+    case BinaryTrace::INT8: return Load<int8_t> (p);
+    case BinaryTrace::UINT8: return Load<uint8_t> (p);
+    case BinaryTrace::INT16: return Load<int16_t> (p);
+    case BinaryTrace::UINT16: return Load<uint16_t> (p);
+    case BinaryTrace::INT32: return Load<int32_t> (p);
+    case BinaryTrace::UINT32: return Load<uint32_t> (p);
+    case BinaryTrace::INT64: return Load<int64_t> (p);
+    case BinaryTrace::UINT64: return Load<uint64_t> (p);
+    case BinaryTrace::FLOAT: return Load<float> (p);
+    case BinaryTrace::DOUBLE: return Load<double> (p);
+    default: return 0;
+    }
+}
+
+BinaryTraceReader::Iterator::Iterator (BinaryTraceReader const *reader, const uint8_t *data)
+  : m_record (reader, data)
+{
+}
+
+BinaryTraceReader::Record const &
+BinaryTraceReader::Iterator::operator* (void) const
+{
+  return m_record;
+}
+
+BinaryTraceReader::Record const *
+BinaryTraceReader::Iterator::operator-> (void) const
+{
+  return &m_record;
+}
+
+BinaryTraceReader::Iterator &
+BinaryTraceReader::Iterator::operator++ (void)
+{
+  m_record.m_data += m_record.m_reader->m_recordSize;
+  return *this;
+}
+
+BinaryTraceReader::Iterator &
+BinaryTraceReader::Iterator::operator+= (int64_t n)
+{
+  m_record.m_data += n * m_record.m_reader->m_recordSize;
+  return *this;
+}
+
+int64_t
+BinaryTraceReader::Iterator::operator- (Iterator const &o) const
+{
+  return (m_record.m_data - o.m_record.m_data) / static_cast<int64_t> (m_record.m_reader->m_recordSize);
+}
+
+bool
+BinaryTraceReader::Iterator::operator== (Iterator const &o) const
+{
+  return m_record.m_data == o.m_record.m_data;
+}
+
+bool
+BinaryTraceReader::Iterator::operator!= (Iterator const &o) const
+{
+  return m_record.m_data != o.m_record.m_data;
+}
+
+BinaryTraceReader::BinaryTraceReader ()
+  : m_map (0),
+    m_size (0),
+    m_records (0),
+    m_nRecords (0),
+    m_recordSize (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BinaryTraceReader::~BinaryTraceReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+BinaryTraceReader::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Unable to open " << filename);
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < static_cast<off_t> (BinaryTrace::FIXED_HEADER_SIZE))
+    {
+      close (fd);
+      NS_LOG_WARN (filename << " is too short to be a binary trace file");
+      return false;
+    }
+  void *map = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Unable to map " << filename);
+      return false;
+    }
+  m_map = static_cast<const uint8_t *> (map);
+  m_size = st.st_size;
+  if (!ReadHeader ())
+    {
+      NS_LOG_WARN (filename << " is not a valid binary trace file");
+      Close ();
+      return false;
+    }
+  return true;
+}
+
+bool
+BinaryTraceReader::ReadHeader (void)
+{
+  if (std::memcmp (m_map, BinaryTrace::MAGIC, sizeof (BinaryTrace::MAGIC)) != 0
+      || Load<uint32_t> (m_map + 8) != BinaryTrace::ENDIANNESS
+      || Load<uint32_t> (m_map + 12) != BinaryTrace::VERSION)
+    {
+      return false;
+    }
+  uint32_t headerSize = Load<uint32_t> (m_map + 16);
+  m_recordSize = Load<uint32_t> (m_map + 20);
+  uint32_t nColumns = Load<uint32_t> (m_map + 24);
+  m_nRecords = Load<uint64_t> (m_map + 32);
+  uint64_t contextOffset = Load<uint64_t> (m_map + 40);
+  if (headerSize > m_size || contextOffset < headerSize || contextOffset > m_size - sizeof (uint32_t)
+      || m_recordSize == 0 || (contextOffset - headerSize) % m_recordSize != 0
+      || m_nRecords != (contextOffset - headerSize) / m_recordSize)
+    {
+      // contextOffset is zero if the writer was not closed
+      return false;
+    }
+
+  const uint8_t *p = m_map + BinaryTrace::FIXED_HEADER_SIZE;
+  const uint8_t *end = m_map + headerSize;
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < nColumns; ++i)
+    {
+      if (p + 2 > end || p + 2 + p[1] > end || p[0] >= BinaryTrace::INVALID)
+        {
+          return false;
+        }
+      m_types.push_back (static_cast<BinaryTrace::ColumnType> (p[0]));
+      m_names.push_back (std::string (reinterpret_cast<const char *> (p + 2), p[1]));
+      m_offsets.push_back (offset);
+      offset += BinaryTrace::GetSize (m_types.back ());
+      p += 2 + p[1];
+    }
+  if (offset != m_recordSize || nColumns < 2
+      || m_types[0] != BinaryTrace::INT64 || m_types[1] != BinaryTrace::UINT32)
+    {
+      return false;
+    }
+
+  p = m_map + contextOffset;
+  end = m_map + m_size;
+  uint32_t nContexts = Load<uint32_t> (p);
+  p += sizeof (uint32_t);
+  for (uint32_t i = 0; i < nContexts; ++i)
+    {
+      if (p + sizeof (uint32_t) > end)
+        {
+          return false;
+        }
+      uint32_t length = Load<uint32_t> (p);
+      p += sizeof (uint32_t);
+      if (length > static_cast<std::size_t> (end - p))
+        {
+          return false;
+        }
+      m_contexts.push_back (std::string (reinterpret_cast<const char *> (p), length));
+      p += length;
+    }
+  m_records = m_map + headerSize;
+
+  // check the context ids once, so that Record::GetContext can trust them
+  for (const uint8_t *r = m_records + sizeof (int64_t); r < m_map + contextOffset; r += m_recordSize)
+    {
+      if (Load<uint32_t> (r) >= nContexts)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+BinaryTraceReader::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_map != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_map), m_size);
+    }
+  m_map = 0;
+  m_size = 0;
+  m_records = 0;
+  m_nRecords = 0;
+  m_recordSize = 0;
+  m_types.clear ();
+  m_names.clear ();
+  m_offsets.clear ();
+  m_contexts.clear ();
+}
+
+uint32_t
+BinaryTraceReader::GetNColumns (void) const
+{
+  return m_types.size ();
+}
+
+std::string
+BinaryTraceReader::GetColumnName (uint32_t column) const
+{
+  NS_ASSERT (column < m_names.size ());
+  return m_names[column];
+}
+
+BinaryTrace::ColumnType
+BinaryTraceReader::GetColumnType (uint32_t column) const
+{
+  NS_ASSERT (column < m_types.size ());
+  return m_types[column];
+}
+
+int32_t
+BinaryTraceReader::FindColumn (std::string name) const
+{
+  for (uint32_t i = 0; i < m_names.size (); ++i)
+    {
+      if (m_names[i] == name)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+uint64_t
+BinaryTraceReader::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+BinaryTraceReader::Record
+BinaryTraceReader::GetRecord (uint64_t i) const
+{
+  NS_ASSERT (i < m_nRecords);
+  return Record (this, m_records + i * m_recordSize);
+}
+
+BinaryTraceReader::Iterator
+BinaryTraceReader::Begin (void) const
+{
+  return Iterator (this, m_records);
+}
+
+BinaryTraceReader::Iterator
+BinaryTraceReader::End (void) const
+{
+  return Iterator (this, m_records + m_nRecords * m_recordSize);
+}
+
+std::vector<std::string> const &
+BinaryTraceReader::GetContexts (void) const
+{
+  return m_contexts;
+}
+
+} // namespace ns3
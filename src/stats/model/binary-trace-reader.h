@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_READER_H
+#define BINARY_TRACE_READER_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iterator>
+#include <stdint.h>
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include "binary-trace-writer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup binarytrace
+ * \brief Read a binary trace file written by BinaryTraceWriter.
+ *
+ * The file is memory-mapped; records are accessed in place, without any
+ * parsing or copying beyond the requested field:
+ *
+ * \code
+ *   BinaryTraceReader reader;
+ *   reader.Open ("cwnd.btr");
+ *   int32_t cwnd = reader.FindColumn ("cwnd");
+ *   for (BinaryTraceReader::Iterator i = reader.Begin (); i != reader.End (); ++i)
+ *     {
+ *       std::cout << i->GetTime ().GetSeconds () << " " << i->GetContext ()
+ *                 << " " << i->Get<uint32_t> (cwnd) << std::endl;
+ *     }
+ * \endcode
+ */
+class BinaryTraceReader
+{
+public:
+  /**
+   * \brief A view on one record of the file.
+   */
+  class Record
+  {
+  public:
+    /**
+     * \returns the simulation time of the record
+     */
+    Time GetTime (void) const;
+    /**
+     * \returns the index of the context in the context table
+     */
+    uint32_t GetContextId (void) const;
+    /**
+     * \returns the trace context of the record
+     */
+    std::string const &GetContext (void) const;
+    /**
+     * \tparam T a C++ type with the size of the column
+     * \param column the column index, as returned by FindColumn ()
+     * \returns the value of the column
+     */
+    template <typename T>
+    T Get (uint32_t column) const;
+    /**
+     * \param column the column index
+     * \returns the value of the column, whatever its type, as a double
+     */
+    double GetDouble (uint32_t column) const;
+
+  private:
+    friend class BinaryTraceReader;
+    friend class Iterator;
+    /**
+     * \param reader the reader owning the file
+     * \param data the first byte of the record
+     */
+    Record (BinaryTraceReader const *reader, const uint8_t *data);
+
+    BinaryTraceReader const *m_reader; //!< the reader
+    const uint8_t *m_data;             //!< first byte of the record
+  };
+
+  /**
+   * \brief Iterate over the records of the file.
+   */
+  class Iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category; //!< iterator category
+    typedef Record value_type;                           //!< value type
+    typedef int64_t difference_type;                     //!< difference type
+    typedef Record const *pointer;                       //!< pointer type
+    typedef Record const &reference;                     //!< reference type
+
+    /** \returns the current record */
+    Record const &operator* (void) const;
+    /** \returns the current record */
+    Record const *operator-> (void) const;
+    /** \returns this iterator, advanced by one record */
+    Iterator &operator++ (void);
+    /** \param n number of records \returns this iterator, advanced by n records */
+    Iterator &operator+= (int64_t n);
+    /** \param o another iterator \returns the distance in records */
+    int64_t operator- (Iterator const &o) const;
+    /** \param o another iterator \returns true if equal */
+    bool operator== (Iterator const &o) const;
+    /** \param o another iterator \returns true if different */
+    bool operator!= (Iterator const &o) const;
+
+  private:
+    friend class BinaryTraceReader;
+    /**
+     * \param reader the reader owning the file
+     * \param data the first byte of the record
+     */
+    Iterator (BinaryTraceReader const *reader, const uint8_t *data);
+
+    Record m_record; //!< the current record
+  };
+
+  BinaryTraceReader ();
+  ~BinaryTraceReader ();
+
+  /**
+   * Map a binary trace file and check its header.
+   *
+   * \param filename the file name
+   * \returns true if the file is a valid, complete binary trace file
+   * whose records all refer to a context of its context table
+   */
+  bool Open (std::string filename);
+  /**
+   * Unmap the file.
+   */
+  void Close (void);
+
+  /**
+   * \returns the number of columns, including "time" and "context"
+   */
+  uint32_t GetNColumns (void) const;
+  /**
+   * \param column the column index
+   * \returns the column name
+   */
+  std::string GetColumnName (uint32_t column) const;
+  /**
+   * \param column the column index
+   * \returns the column type
+   */
+  BinaryTrace::ColumnType GetColumnType (uint32_t column) const;
+  /**
+   * \param name a column name
+   * \returns the index of the column, or -1 if there is no such column
+   */
+  int32_t FindColumn (std::string name) const;
+
+  /**
+   * \returns the number of records in the file
+   */
+  uint64_t GetNRecords (void) const;
+  /**
+   * \param i the record index
+   * \returns the record
+   */
+  Record GetRecord (uint64_t i) const;
+  /**
+   * \returns an iterator to the first record
+   */
+  Iterator Begin (void) const;
+  /**
+   * \returns an iterator past the last record
+   */
+  Iterator End (void) const;
+
+  /**
+   * \returns the context table
+   */
+  std::vector<std::string> const &GetContexts (void) const;
+
+private:
+  /**
+   * Parse the header and the context table, and check the context ids
+   * of the records.
+   * \returns true if they are valid
+   */
+  bool ReadHeader (void);
+
+  const uint8_t *m_map;                          //!< mapped file
+  std::size_t m_size;                            //!< size of the mapping
+  const uint8_t *m_records;                      //!< first record
+  uint64_t m_nRecords;                           //!< number of records
+  uint32_t m_recordSize;                         //!< record size in bytes
+  std::vector<BinaryTrace::ColumnType> m_types;  //!< column types
+  std::vector<std::string> m_names;              //!< column names
+  std::vector<uint32_t> m_offsets;               //!< column offsets in a record
+  std::vector<std::string> m_contexts;           //!< context table
+};
+
+template <typename T>
+T
+BinaryTraceReader::Record::Get (uint32_t column) const
+{
+  NS_ASSERT (column < m_reader->m_types.size ());
+  NS_ASSERT (sizeof (T) == BinaryTrace::GetSize (m_reader->m_types[column]));
+  T value;
+  std::memcpy (&value, m_data + m_reader->m_offsets[column], sizeof (T));
+  return value;
+}
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_READER_H */
@@ -0,0 +1,262 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "binary-trace-writer.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("BinaryTraceWriter");
+
+const char BinaryTrace::MAGIC[8] = { 'n', 's', '3', 'b', 't', 'r', 'c', 0 };
+const uint32_t BinaryTrace::ENDIANNESS = 0x01020304;
+const uint32_t BinaryTrace::VERSION = 1;
+const uint32_t BinaryTrace::FIXED_HEADER_SIZE = 48;
+
+/// Size of the in-memory record buffer.
+static const std::size_t BUFFER_SIZE = 1 << 20;
+
+uint32_t
+BinaryTrace::GetSize (ColumnType type)
+{
+  switch (type)
+    {
+    case INT8:
+    case UINT8:
+      return 1;
+    case INT16:
+    case UINT16:
+      return 2;
+    case INT32:
+    case UINT32:
+    case FLOAT:
+      return 4;
+    case INT64:
+    case UINT64:
+    case DOUBLE:
+      return 8;
+    default:
+      return 0;
+    }
+}
+
+std::string
+BinaryTrace::GetName (ColumnType type)
+{
+  switch (type)
+    {
+    case INT8: return "int8";
+    case UINT8: return "uint8";
+    case INT16: return "int16";
+    case UINT16: return "uint16";
+    case INT32: return "int32";
+    case UINT32: return "uint32";
+    case INT64: return "int64";
+    case UINT64: return "uint64";
+    case FLOAT: return "float";
+    case DOUBLE: return "double";
+    default: return "invalid";
+    }
+}
+
+/**
+ * Append a value to a byte string.
+ * \param out the byte string
+ * \param value the value
+ */
+template <typename T>
+static void
+Append (std::string &out, T value)
+{
+  out.append (reinterpret_cast<const char *> (&value), sizeof (value));
+}
+
+BinaryTraceWriter::BinaryTraceWriter (std::string filename)
+  : m_filename (filename),
+    m_hasSchema (false),
+    m_closed (false),
+    m_recordSize (0),
+    m_nRecords (0),
+    m_used (0),
+    m_lastContextId (0)
+{
+  NS_LOG_FUNCTION (this << filename);
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  NS_ABORT_MSG_UNLESS (m_file.is_open (), "BinaryTraceWriter: unable to open " << filename);
+}
+
+BinaryTraceWriter::~BinaryTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+BinaryTraceWriter::SetSchema (std::vector<BinaryTrace::ColumnType> const &types,
+                              std::vector<std::string> const &names)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_UNLESS (types.size () == names.size (),
+                       "BinaryTraceWriter: " << types.size () << " values but " << names.size () << " column names");
+  for (uint32_t i = 0; i < types.size (); ++i)
+    {
+      NS_ABORT_MSG_IF (types[i] == BinaryTrace::INVALID,
+                       "BinaryTraceWriter: column " << names[i] << " has a type which cannot be stored");
+      NS_ABORT_MSG_IF (names[i].size () > 255, "BinaryTraceWriter: column name too long: " << names[i]);
+    }
+  if (m_hasSchema)
+    {
+      NS_ABORT_MSG_UNLESS (types == m_types, "BinaryTraceWriter: trace source does not match the schema of " << m_filename);
+      return;
+    }
+  m_hasSchema = true;
+  m_types = types;
+
+  std::vector<BinaryTrace::ColumnType> allTypes;
+  std::vector<std::string> allNames;
+  allTypes.push_back (BinaryTrace::INT64);
+  allNames.push_back ("time");
+  allTypes.push_back (BinaryTrace::UINT32);
+  allNames.push_back ("context");
+  allTypes.insert (allTypes.end (), types.begin (), types.end ());
+  allNames.insert (allNames.end (), names.begin (), names.end ());
+
+  std::string columns;
+  m_recordSize = 0;
+  for (uint32_t i = 0; i < allTypes.size (); ++i)
+    {
+      Append<uint8_t> (columns, allTypes[i]);
+      Append<uint8_t> (columns, allNames[i].size ());
+      columns += allNames[i];
+      m_recordSize += BinaryTrace::GetSize (allTypes[i]);
+    }
+  uint32_t headerSize = BinaryTrace::FIXED_HEADER_SIZE + columns.size ();
+  headerSize = (headerSize + 7) & ~7U;
+  columns.resize (headerSize - BinaryTrace::FIXED_HEADER_SIZE, 0);
+
+  std::string header (BinaryTrace::MAGIC, sizeof (BinaryTrace::MAGIC));
+  Append<uint32_t> (header, BinaryTrace::ENDIANNESS);
+  Append<uint32_t> (header, BinaryTrace::VERSION);
+  Append<uint32_t> (header, headerSize);
+  Append<uint32_t> (header, m_recordSize);
+  Append<uint32_t> (header, allTypes.size ());
+  Append<uint32_t> (header, 0);
+  // nRecords and contextOffset are filled in by Close ()
+  Append<uint64_t> (header, 0);
+  Append<uint64_t> (header, 0);
+  NS_ASSERT (header.size () == BinaryTrace::FIXED_HEADER_SIZE);
+  header += columns;
+  m_file.write (header.data (), header.size ());
+
+  m_buffer.resize (BUFFER_SIZE > m_recordSize ? BUFFER_SIZE : m_recordSize);
+  m_used = 0;
+}
+
+uint32_t
+BinaryTraceWriter::GetContextId (std::string const &context)
+{
+  // Consecutive records very often come from the same trace source.
+  if (!m_contexts.empty () && context == m_lastContext)
+    {
+      return m_lastContextId;
+    }
+  std::map<std::string, uint32_t>::const_iterator it = m_contextIds.find (context);
+  uint32_t id;
+  if (it == m_contextIds.end ())
+    {
+      id = m_contexts.size ();
+      m_contexts.push_back (context);
+      m_contextIds[context] = id;
+    }
+  else
+    {
+      id = it->second;
+    }
+  m_lastContext = context;
+  m_lastContextId = id;
+  return id;
+}
+
+char *
+BinaryTraceWriter::StartRecord (std::string const &context)
+{
+  if (m_closed)
+    {
+      return 0;
+    }
+  if (m_used + m_recordSize > m_buffer.size ())
+    {
+      FlushBuffer ();
+    }
+  char *record = &m_buffer[m_used];
+  m_used += m_recordSize;
+  ++m_nRecords;
+  int64_t now = Simulator::Now ().GetNanoSeconds ();
+  uint32_t contextId = GetContextId (context);
+  std::memcpy (record, &now, sizeof (now));
+  std::memcpy (record + sizeof (now), &contextId, sizeof (contextId));
+  return record + sizeof (now) + sizeof (contextId);
+}
+
+void
+BinaryTraceWriter::FlushBuffer (void)
+{
+  if (m_used > 0)
+    {
+      m_file.write (&m_buffer[0], m_used);
+      m_used = 0;
+    }
+}
+
+uint64_t
+BinaryTraceWriter::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+void
+BinaryTraceWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  if (!m_hasSchema)
+    {
+      SetSchema (std::vector<BinaryTrace::ColumnType> (), std::vector<std::string> ());
+    }
+  FlushBuffer ();
+  uint64_t contextOffset = m_file.tellp ();
+  std::string trailer;
+  Append<uint32_t> (trailer, m_contexts.size ());
+  for (std::vector<std::string>::const_iterator i = m_contexts.begin (); i != m_contexts.end (); ++i)
+    {
+      Append<uint32_t> (trailer, i->size ());
+      trailer += *i;
+    }
+  m_file.write (trailer.data (), trailer.size ());
+  m_file.seekp (BinaryTrace::FIXED_HEADER_SIZE - 2 * sizeof (uint64_t), std::ios::beg);
+  m_file.write (reinterpret_cast<const char *> (&m_nRecords), sizeof (m_nRecords));
+  m_file.write (reinterpret_cast<const char *> (&contextOffset), sizeof (contextOffset));
+  NS_ABORT_MSG_IF (m_file.fail (), "BinaryTraceWriter: error while writing " << m_filename);
+  m_file.close ();
+  m_closed = true;
+  std::vector<char> ().swap (m_buffer);
+}
+
+} // namespace ns3
@@ -0,0 +1,454 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BINARY_TRACE_WRITER_H
+#define BINARY_TRACE_WRITER_H
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/config.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ * \defgroup binarytrace Binary trace files
+ *
+ * A compact, self-describing binary alternative to ascii traces.
+ *
+ * A binary trace file starts with a header describing its columns,
+ * followed by fixed-size records and, at the end, a table holding the
+ * trace context strings.  The on-disk layout (all fields in host byte
+ * order, which is identified by the endianness marker) is:
+ *
+ * \verbatim
+ *   char     magic[8]          "ns3btrc"
+ *   uint32_t endianness        0x01020304
+ *   uint32_t version           1
+ *   uint32_t headerSize        offset of the first record, multiple of 8
+ *   uint32_t recordSize
+ *   uint32_t nColumns
+ *   uint32_t reserved
+ *   uint64_t nRecords
+ *   uint64_t contextOffset     offset of the context table
+ *   nColumns times:
+ *     uint8_t  type            a BinaryTrace::ColumnType
+ *     uint8_t  nameLength
+ *     char     name[nameLength]
+ *   padding up to headerSize
+ *   nRecords records of recordSize bytes, columns packed back to back
+ *   uint32_t nContexts
+ *   nContexts times:
+ *     uint32_t length
+ *     char     context[length]
+ * \endverbatim
+ *
+ * The first two columns are always "time" (INT64, in nanoseconds) and
+ * "context" (UINT32, an index in the context table).  The remaining
+ * columns hold the arguments of the traced callback.
+ *
+ * BinaryTraceWriter produces these files; BinaryTraceReader memory-maps
+ * them and gives direct access to the records.
+ */
+
+/**
+ * \ingroup binarytrace
+ * \brief Definitions shared by BinaryTraceWriter and BinaryTraceReader.
+ */
+class BinaryTrace
+{
+public:
+  /** The type of a column. */
+  enum ColumnType
+  {
+    INT8 = 0,
+    UINT8,
+    INT16,
+    UINT16,
+    INT32,
+    UINT32,
+    INT64,
+    UINT64,
+    FLOAT,
+    DOUBLE,
+    INVALID
+  };
+
+  /**
+   * \param type a column type
+   * \returns the size in bytes of a value of this type
+   */
+  static uint32_t GetSize (ColumnType type);
+
+  /**
+   * \param type a column type
+   * \returns a printable name for the type
+   */
+  static std::string GetName (ColumnType type);
+
+  static const char MAGIC[8];            //!< File magic
+  static const uint32_t ENDIANNESS;      //!< Endianness marker
+  static const uint32_t VERSION;         //!< File format version
+  static const uint32_t FIXED_HEADER_SIZE; //!< Size of the header before the columns
+};
+
+/**
+ * \ingroup binarytrace
+ * \brief Map a C++ type to the column type used to store it.
+ *
+ * Arithmetic and enumeration types are stored as is; ns3::Time is stored
+ * as an INT64 number of nanoseconds.
+ *
+ * \tparam T the C++ type
+ */
+template <typename T, typename Enable = void>
+struct BinaryTraceColumn
+{
+  /** \returns the column type, INVALID for unsupported types */
+  static BinaryTrace::ColumnType GetType (void)
+  {
+    return BinaryTrace::INVALID;
+  }
+};
+
+/**
+ * \ingroup binarytrace
+ * \brief BinaryTraceColumn specialization for integer and enum types.
+ * \tparam T the C++ type
+ */
+template <typename T>
+struct BinaryTraceColumn<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+  /** \returns the column type */
+  static BinaryTrace::ColumnType GetType (void)
+  {
+    bool isSigned = IsSigned<T>::value;
+    switch (sizeof (T))
+      {
+      case 1: return isSigned ? BinaryTrace::INT8 : BinaryTrace::UINT8;
+      case 2: return isSigned ? BinaryTrace::INT16 : BinaryTrace::UINT16;
+      case 4: return isSigned ? BinaryTrace::INT32 : BinaryTrace::UINT32;
+      case 8: return isSigned ? BinaryTrace::INT64 : BinaryTrace::UINT64;
+      default: return BinaryTrace::INVALID;
+      }
+  }
+  /**
+   * \param buffer where to store the value
+   * \param value the value
+   */
+  static void Write (char *buffer, T value)
+  {
+    std::memcpy (buffer, &value, sizeof (T));
+  }
+
+private:
+  /** Signedness of an integer type, or of the underlying type of an enum */
+  template <typename U, bool IsEnum = std::is_enum<U>::value>
+  struct IsSigned : std::is_signed<U>
+  {
+  };
+  /** Specialization for enums */
+  template <typename U>
+  struct IsSigned<U, true> : std::is_signed<typename std::underlying_type<U>::type>
+  {
+  };
+};
+
+/**
+ * \ingroup binarytrace
+ * \brief BinaryTraceColumn specialization for floating point types.
+ * \tparam T the C++ type
+ */
+template <typename T>
+struct BinaryTraceColumn<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+  /** \returns the column type */
+  static BinaryTrace::ColumnType GetType (void)
+  {
+    return sizeof (T) == sizeof (float) ? BinaryTrace::FLOAT : BinaryTrace::DOUBLE;
+  }
+  /**
+   * \param buffer where to store the value
+   * \param value the value
+   */
+  static void Write (char *buffer, T value)
+  {
+    if (sizeof (T) == sizeof (float))
+      {
+        float v = static_cast<float> (value);
+        std::memcpy (buffer, &v, sizeof (v));
+      }
+    else
+      {
+        double v = static_cast<double> (value);
+        std::memcpy (buffer, &v, sizeof (v));
+      }
+  }
+};
+
+/**
+ * \ingroup binarytrace
+ * \brief BinaryTraceColumn specialization for ns3::Time.
+ */
+template <>
+struct BinaryTraceColumn<Time>
+{
+  /** \returns the column type */
+  static BinaryTrace::ColumnType GetType (void)
+  {
+    return BinaryTrace::INT64;
+  }
+  /**
+   * \param buffer where to store the value
+   * \param value the value
+   */
+  static void Write (char *buffer, Time value)
+  {
+    int64_t ns = value.GetNanoSeconds ();
+    std::memcpy (buffer, &ns, sizeof (ns));
+  }
+};
+
+/**
+ * \ingroup binarytrace
+ * \brief Write trace sources to a binary trace file.
+ *
+ * A writer holds a single schema: the types of the values of every
+ * record must be the same, so all the trace sources connected to one
+ * writer must have the same signature.  The schema is fixed by the
+ * first call to Connect (), ConnectTracedValue () or Write ().
+ *
+ * \code
+ *   Ptr<BinaryTraceWriter> writer = Create<BinaryTraceWriter> ("cwnd.btr");
+ *   writer->ConnectTracedValue<uint32_t> ("/NodeList/[i]/$ns3::TcpL4Protocol/SocketList/[i]/CongestionWindow", "cwnd");
+ *   writer->Connect<double, double> ("/NodeList/[i]/DeviceList/[i]/Phy/...", {"snr", "per"});
+ * \endcode
+ *
+ * The trace sources hold a reference to the writer, so the file is
+ * completed when the trace sources are destroyed (e.g. by
+ * Simulator::Destroy ()) or when Close () is called.
+ *
+ * Records are buffered in memory and written to disk in large blocks.
+ */
+class BinaryTraceWriter : public SimpleRefCount<BinaryTraceWriter>
+{
+public:
+  /**
+   * \param filename name of the file to create
+   */
+  BinaryTraceWriter (std::string filename);
+  ~BinaryTraceWriter ();
+
+  /**
+   * Connect a TracedValue to the file: each change writes one record
+   * holding the new value.
+   *
+   * \tparam T the type of the TracedValue
+   * \param path a Config path matching one or more TracedValue sources
+   * \param name the column name
+   */
+  template <typename T>
+  void ConnectTracedValue (std::string path, std::string name = "value");
+
+  /**
+   * Connect a TracedCallback to the file: each invocation writes one
+   * record holding the callback arguments.
+   *
+   * \tparam Ts the argument types of the TracedCallback
+   * \param path a Config path matching one or more trace sources
+   * \param names the column names, one per argument
+   */
+  template <typename... Ts>
+  void Connect (std::string path, std::vector<std::string> names);
+
+  /**
+   * Write one record stamped with the current simulation time.
+   *
+   * \tparam Ts the value types
+   * \param context the trace context
+   * \param values the column values
+   */
+  template <typename... Ts>
+  void Write (std::string const &context, Ts... values);
+
+  /**
+   * Write any buffered records and the trailer, and close the file.
+   * Records written afterwards are discarded.
+   */
+  void Close (void);
+
+  /**
+   * \returns the number of records written so far
+   */
+  uint64_t GetNRecords (void) const;
+
+private:
+  /**
+   * Set the schema of the file, or check that it matches the one set
+   * before.
+   * \param types the value column types
+   * \param names the value column names
+   */
+  void SetSchema (std::vector<BinaryTrace::ColumnType> const &types,
+                  std::vector<std::string> const &names);
+  /**
+   * \param context a trace context
+   * \returns the index of the context in the context table
+   */
+  uint32_t GetContextId (std::string const &context);
+  /**
+   * Reserve space for one record in the buffer, stamp it with the time
+   * and context and return a pointer to the value area.
+   * \param context the trace context
+   * \returns where to write the values
+   */
+  char *StartRecord (std::string const &context);
+  /**
+   * Write the buffered records to the file.
+   */
+  void FlushBuffer (void);
+
+  /**
+   * Trace sink for TracedValue sources.
+   * \param writer the writer
+   * \param context the trace context
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  template <typename T>
+  static void TracedValueSink (Ptr<BinaryTraceWriter> writer, std::string context,
+                               T oldValue, T newValue);
+  /**
+   * Trace sink for TracedCallback sources.
+   * \param writer the writer
+   * \param context the trace context
+   * \param values the callback arguments
+   */
+  template <typename... Ts>
+  static void TracedCallbackSink (Ptr<BinaryTraceWriter> writer, std::string context,
+                                  Ts... values);
+
+  /** Recursion terminator for WriteValues. \param buffer unused */
+  static void WriteValues (char *buffer)
+  {
+  }
+  /**
+   * Store values one after the other.
+   * \param buffer where to write
+   * \param value the first value
+   * \param rest the remaining values
+   */
+  template <typename T, typename... Ts>
+  static void WriteValues (char *buffer, T value, Ts... rest)
+  {
+    BinaryTraceColumn<T>::Write (buffer, value);
+    WriteValues (buffer + BinaryTrace::GetSize (BinaryTraceColumn<T>::GetType ()), rest...);
+  }
+
+  std::string m_filename;                    //!< file name
+  std::ofstream m_file;                      //!< output file
+  bool m_hasSchema;                          //!< the schema has been set
+  bool m_closed;                             //!< Close () was called
+  std::vector<BinaryTrace::ColumnType> m_types; //!< value column types
+  uint32_t m_recordSize;                     //!< record size in bytes
+  uint64_t m_nRecords;                       //!< number of records written
+  std::vector<char> m_buffer;                //!< records not yet written
+  std::size_t m_used;                        //!< bytes used in m_buffer
+  std::map<std::string, uint32_t> m_contextIds; //!< context string to index
+  std::vector<std::string> m_contexts;       //!< context table
+  std::string m_lastContext;                 //!< last context looked up
+  uint32_t m_lastContextId;                  //!< index of m_lastContext
+};
+
+template <typename T>
+void
+BinaryTraceWriter::ConnectTracedValue (std::string path, std::string name)
+{
+  std::vector<BinaryTrace::ColumnType> types;
+  types.push_back (BinaryTraceColumn<T>::GetType ());
+  SetSchema (types, std::vector<std::string> (1, name));
+  Config::Connect (path, MakeBoundCallback (&BinaryTraceWriter::TracedValueSink<T>,
+                                            Ptr<BinaryTraceWriter> (this)));
+}
+
+template <typename... Ts>
+void
+BinaryTraceWriter::Connect (std::string path, std::vector<std::string> names)
+{
+  std::vector<BinaryTrace::ColumnType> types = { BinaryTraceColumn<Ts>::GetType ()... };
+  SetSchema (types, names);
+  Config::Connect (path, MakeBoundCallback (&BinaryTraceWriter::TracedCallbackSink<Ts...>,
+                                            Ptr<BinaryTraceWriter> (this)));
+}
+
+template <typename... Ts>
+void
+BinaryTraceWriter::Write (std::string const &context, Ts... values)
+{
+  if (!m_hasSchema)
+    {
+      std::vector<BinaryTrace::ColumnType> types = { BinaryTraceColumn<Ts>::GetType ()... };
+      std::vector<std::string> names;
+      for (uint32_t i = 0; i < types.size (); ++i)
+        {
+          names.push_back ("value" + std::to_string (i));
+        }
+      SetSchema (types, names);
+    }
+  static const std::array<BinaryTrace::ColumnType, sizeof... (Ts)> types = {{ BinaryTraceColumn<Ts>::GetType ()... }};
+  NS_ABORT_MSG_UNLESS (types.size () == m_types.size () && std::equal (types.begin (), types.end (), m_types.begin ()),
+                       "BinaryTraceWriter: record does not match the schema of " << m_filename);
+  char *buffer = StartRecord (context);
+  if (buffer != 0)
+    {
+      WriteValues (buffer, values...);
+    }
+}
+
+template <typename T>
+void
+BinaryTraceWriter::TracedValueSink (Ptr<BinaryTraceWriter> writer, std::string context,
+                                    T oldValue, T newValue)
+{
+  writer->Write (context, newValue);
+}
+
+template <typename... Ts>
+void
+BinaryTraceWriter::TracedCallbackSink (Ptr<BinaryTraceWriter> writer, std::string context,
+                                       Ts... values)
+{
+  writer->Write (context, values...);
+}
+
+} // namespace ns3
+
+#endif /* BINARY_TRACE_WRITER_H */
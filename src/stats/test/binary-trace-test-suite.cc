@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/binary-trace-writer.h"
+#include "ns3/binary-trace-reader.h"
+#include "ns3/test.h"
+#include "ns3/object.h"
+#include "ns3/names.h"
+#include "ns3/simulator.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include "ns3/trace-source-accessor.h"
+#include <fstream>
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * \ingroup stats-tests
+ *
+ * Object with a TracedValue and a TracedCallback to connect to.
+ */
+class BinaryTraceTestSource : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Change the traced value and fire the traced callback.
+   * \param i a counter
+   */
+  void Fire (uint32_t i)
+  {
+    m_value = i * 10;
+    m_callback (i * 0.5, -static_cast<int16_t> (i % 1000), Seconds (i));
+  }
+
+private:
+  TracedValue<uint32_t> m_value; //!< the traced value
+  TracedCallback<double, int16_t, Time> m_callback; //!< the traced callback
+};
+
+TypeId
+BinaryTraceTestSource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BinaryTraceTestSource")
+    .SetParent<Object> ()
+    .SetGroupName ("Stats")
+    .AddTraceSource ("Value", "A value",
+                     MakeTraceSourceAccessor (&BinaryTraceTestSource::m_value),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Callback", "A callback",
+                     MakeTraceSourceAccessor (&BinaryTraceTestSource::m_callback),
+                     "ns3::BinaryTraceTestSource::TracedCallback")
+  ;
+  return tid;
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * Write trace sources to binary trace files and read them back.
+ */
+class BinaryTraceTestCase : public TestCase
+{
+public:
+  BinaryTraceTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BinaryTraceTestCase::BinaryTraceTestCase ()
+  : TestCase ("Check that binary trace files read back what was traced")
+{
+}
+
+void
+BinaryTraceTestCase::DoRun (void)
+{
+  std::string valueFile = CreateTempDirFilename ("value.btr");
+  std::string callbackFile = CreateTempDirFilename ("callback.btr");
+
+  Ptr<BinaryTraceTestSource> a = CreateObject<BinaryTraceTestSource> ();
+  Ptr<BinaryTraceTestSource> b = CreateObject<BinaryTraceTestSource> ();
+  Names::Add ("BinaryTraceA", a);
+  Names::Add ("BinaryTraceB", b);
+
+  Ptr<BinaryTraceWriter> valueWriter = Create<BinaryTraceWriter> (valueFile);
+  valueWriter->ConnectTracedValue<uint32_t> ("/Names/BinaryTraceA/Value", "value");
+  Ptr<BinaryTraceWriter> callbackWriter = Create<BinaryTraceWriter> (callbackFile);
+  std::vector<std::string> names = { "half", "minus", "delay" };
+  callbackWriter->Connect<double, int16_t, Time> ("/Names/BinaryTraceA/Callback", names);
+  callbackWriter->Connect<double, int16_t, Time> ("/Names/BinaryTraceB/Callback", names);
+
+  const uint32_t n = 100000;
+  for (uint32_t i = 1; i <= n; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (i), &BinaryTraceTestSource::Fire, a, i);
+      Simulator::Schedule (MicroSeconds (i), &BinaryTraceTestSource::Fire, b, i + n);
+    }
+  Simulator::Run ();
+  valueWriter->Close ();
+  callbackWriter->Close ();
+  Simulator::Destroy ();
+
+  BinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (valueFile), true, "Unable to read " << valueFile);
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNColumns (), 3, "Wrong number of columns");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnName (0), "time", "Wrong column name");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnName (1), "context", "Wrong column name");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnName (2), "value", "Wrong column name");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnType (2), BinaryTrace::UINT32, "Wrong column type");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRecords (), n, "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetContexts ().size (), 1, "Wrong number of contexts");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetContexts ()[0], "/Names/BinaryTraceA/Value", "Wrong context");
+  uint32_t i = 1;
+  bool match = true;
+  for (BinaryTraceReader::Iterator it = reader.Begin (); it != reader.End (); ++it, ++i)
+    {
+      match = match && it->GetTime () == MicroSeconds (i) && it->Get<uint32_t> (2) == i * 10;
+    }
+  NS_TEST_EXPECT_MSG_EQ (match, true, "Records of " << valueFile << " do not match the traced values");
+
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (callbackFile), true, "Unable to read " << callbackFile);
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNColumns (), 5, "Wrong number of columns");
+  int32_t half = reader.FindColumn ("half");
+  int32_t minus = reader.FindColumn ("minus");
+  int32_t delay = reader.FindColumn ("delay");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnType (half), BinaryTrace::DOUBLE, "Wrong column type");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnType (minus), BinaryTrace::INT16, "Wrong column type");
+  NS_TEST_EXPECT_MSG_EQ (reader.GetColumnType (delay), BinaryTrace::INT64, "Wrong column type");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRecords (), 2 * n, "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetContexts ().size (), 2, "Wrong number of contexts");
+  match = true;
+  for (uint64_t r = 0; r < reader.GetNRecords (); ++r)
+    {
+      BinaryTraceReader::Record record = reader.GetRecord (r);
+      uint32_t j = r / 2 + 1 + (r % 2 ? n : 0);
+      std::string context = r % 2 ? "/Names/BinaryTraceB/Callback" : "/Names/BinaryTraceA/Callback";
+      match = match && record.GetContext () == context
+        && record.Get<double> (half) == j * 0.5
+        && record.Get<int16_t> (minus) == -static_cast<int16_t> (j % 1000)
+        && record.GetDouble (delay) == Seconds (j).GetNanoSeconds ();
+    }
+  NS_TEST_EXPECT_MSG_EQ (match, true, "Records of " << callbackFile << " do not match the traced values");
+  reader.Close ();
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * Corrupt a binary trace file and check that the reader rejects it.
+ */
+class BinaryTraceCorruptTestCase : public TestCase
+{
+public:
+  BinaryTraceCorruptTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write a copy of a file with a field overwritten.
+   * \param contents the contents of the file
+   * \param offset the offset of the field
+   * \param value the new value of the field
+   * \returns the name of the copy
+   */
+  template <typename T>
+  std::string WriteCopy (std::string contents, std::size_t offset, T value);
+};
+
+BinaryTraceCorruptTestCase::BinaryTraceCorruptTestCase ()
+  : TestCase ("Check that corrupted binary trace files are rejected")
+{
+}
+
+template <typename T>
+std::string
+BinaryTraceCorruptTestCase::WriteCopy (std::string contents, std::size_t offset, T value)
+{
+  std::string filename = CreateTempDirFilename ("corrupt.btr");
+  std::memcpy (&contents[offset], &value, sizeof (T));
+  std::ofstream os (filename.c_str (), std::ios::binary);
+  os.write (contents.data (), contents.size ());
+  return filename;
+}
+
+void
+BinaryTraceCorruptTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("valid.btr");
+  Ptr<BinaryTraceTestSource> a = CreateObject<BinaryTraceTestSource> ();
+  Names::Add ("BinaryTraceCorrupt", a);
+  Ptr<BinaryTraceWriter> writer = Create<BinaryTraceWriter> (filename);
+  writer->ConnectTracedValue<uint32_t> ("/Names/BinaryTraceCorrupt/Value", "value");
+  const uint32_t n = 10;
+  for (uint32_t i = 1; i <= n; ++i)
+    {
+      Simulator::Schedule (MicroSeconds (i), &BinaryTraceTestSource::Fire, a, i);
+    }
+  Simulator::Run ();
+  writer->Close ();
+  Simulator::Destroy ();
+
+  BinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Unable to read " << filename);
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRecords (), n, "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetContexts ().size (), 1, "Wrong number of contexts");
+  reader.Close ();
+
+  std::ifstream is (filename.c_str (), std::ios::binary);
+  std::ostringstream buffer;
+  buffer << is.rdbuf ();
+  std::string contents = buffer.str ();
+  uint32_t headerSize;
+  uint32_t recordSize;
+  std::memcpy (&headerSize, &contents[16], sizeof (headerSize));
+  std::memcpy (&recordSize, &contents[20], sizeof (recordSize));
+
+  // The context id of the last record refers past the context table
+  std::size_t contextId = headerSize + (n - 1) * recordSize + sizeof (int64_t);
+  NS_TEST_EXPECT_MSG_EQ (reader.Open (WriteCopy<uint32_t> (contents, contextId, 1)), false,
+                         "A record with an invalid context id was accepted");
+  NS_TEST_EXPECT_MSG_EQ (reader.Open (WriteCopy<uint32_t> (contents, contextId, 0xffffffff)), false,
+                         "A record with an invalid context id was accepted");
+
+  // A record count whose size in bytes wraps around to the size of the records
+  uint64_t wrapped = n + (static_cast<uint64_t> (1) << 63) / recordSize * 2;
+  NS_TEST_ASSERT_MSG_EQ (wrapped * recordSize, n * recordSize, "The record count should wrap around");
+  NS_TEST_EXPECT_MSG_EQ (reader.Open (WriteCopy<uint64_t> (contents, 32, wrapped)), false,
+                         "A wrapped around record count was accepted");
+
+  // A context table offset past the end of the file
+  NS_TEST_EXPECT_MSG_EQ (reader.Open (WriteCopy<uint64_t> (contents, 40, ~static_cast<uint64_t> (0))), false,
+                         "A context table offset past the end of the file was accepted");
+}
+
+/**
+ * \ingroup stats-tests
+ *
+ * Binary trace file TestSuite
+ */
+class BinaryTraceTestSuite : public TestSuite
+{
+public:
+  BinaryTraceTestSuite ();
+};
+
+BinaryTraceTestSuite::BinaryTraceTestSuite ()
+  : TestSuite ("binary-trace", UNIT)
+{
+  AddTestCase (new BinaryTraceTestCase, TestCase::QUICK);
+  AddTestCase (new BinaryTraceCorruptTestCase, TestCase::QUICK);
+}
+
+static BinaryTraceTestSuite binaryTraceTestSuite; //!< Static variable for test initialization
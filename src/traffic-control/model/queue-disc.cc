@@ -20,6 +20,7 @@
 #include "ns3/log.h"
 #include "ns3/abort.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
@@ -28,6 +29,7 @@
 #include "ns3/simulator.h"
 #include "queue-disc.h"
 #include "ns3/net-device-queue-interface.h"
+#include "ns3/queue-limits.h"
 #include "ns3/queue.h"
 
 namespace ns3 {
@@ -270,6 +272,12 @@ TypeId QueueDisc::GetTypeId (void)
                    MakeUintegerAccessor (&QueueDisc::SetQuota,
                                          &QueueDisc::GetQuota),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BulkDequeue",
+                   "Whether packets are dequeued in bulk, within the budget of the byte "
+                   "queue limits of a single queue device, and sent to the device at once.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&QueueDisc::m_bulkDequeue),
+                   MakeBooleanChecker ())
     .AddAttribute ("InternalQueueList", "The list of internal queues.",
                    ObjectVectorValue (),
                    MakeObjectVectorAccessor (&QueueDisc::m_queues),
@@ -323,6 +331,7 @@ QueueDisc::QueueDisc (QueueDiscSizePolicy policy)
   :  m_nPackets (0),
      m_nBytes (0),
      m_maxSize (QueueSize ("1p")),         // to avoid that setting the mode at construction time is ignored
+     m_bulkDequeue (false),
      m_running (false),
      m_peeked (false),
      m_sizePolicy (policy),
@@ -383,7 +392,9 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_devQueueIface = 0;
   m_send = nullptr;
-  m_requeued = 0;
+  m_sendBurst = nullptr;
+  m_burst.clear ();
+  m_requeued.clear ();
   m_internalQueueDbeFunctor = nullptr;
   m_internalQueueDadFunctor = nullptr;
   m_childQueueDiscDbeFunctor = nullptr;
@@ -423,9 +434,14 @@ QueueDisc::GetStats (void)
   // the total number of sent packets is only updated here to avoid to increase it
   // after a dequeue and then having to decrease it if the packet is dropped after
   // dequeue or requeued
-  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - (m_requeued ? 1 : 0)
+  uint64_t requeuedBytes = 0;
+  for (auto& item : m_requeued)
+    {
+      requeuedBytes += item->GetSize ();
+    }
+  m_stats.nTotalSentPackets = m_stats.nTotalDequeuedPackets - m_requeued.size ()
                               - m_stats.nTotalDroppedPacketsAfterDequeue;
-  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - (m_requeued ? m_requeued->GetSize () : 0)
+  m_stats.nTotalSentBytes = m_stats.nTotalDequeuedBytes - requeuedBytes
                             - m_stats.nTotalDroppedBytesAfterDequeue;
 
   return m_stats;
@@ -558,6 +574,20 @@ QueueDisc::GetSendCallback (void) const
   return m_send;
 }
 
+void
+QueueDisc::SetSendBurstCallback (SendBurstCallback func)
+{
+  NS_LOG_FUNCTION (this);
+  m_sendBurst = func;
+}
+
+QueueDisc::SendBurstCallback
+QueueDisc::GetSendBurstCallback (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_sendBurst;
+}
+
 void
 QueueDisc::SetQuota (const uint32_t quota)
 {
@@ -892,11 +922,12 @@ QueueDisc::Dequeue (void)
   // The QueueDisc::DoPeek method dequeues a packet and keeps it as a requeued
   // packet. Thus, first check whether a peeked packet exists. Otherwise, call
   // the private DoDequeue method.
-  Ptr<QueueDiscItem> item = m_requeued;
+  Ptr<QueueDiscItem> item;
 
-  if (item)
+  if (!m_requeued.empty ())
     {
-      m_requeued = 0;
+      item = m_requeued.front ();
+      m_requeued.pop_front ();
       if (m_peeked)
         {
           // If the packet was requeued because a peek operation was requested
@@ -930,17 +961,19 @@ QueueDisc::DoPeek (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (!m_requeued)
+  if (m_requeued.empty ())
     {
       m_peeked = true;
-      m_requeued = Dequeue ();
+      Ptr<QueueDiscItem> item = Dequeue ();
       // if no packet is returned, reset the m_peeked flag
-      if (!m_requeued)
+      if (!item)
         {
           m_peeked = false;
+          return 0;
         }
+      m_requeued.push_back (item);
     }
-  return m_requeued;
+  return m_requeued.front ();
 }
 
 void
@@ -951,14 +984,15 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      uint32_t packets = 0;
+      while (Restart (packets))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (packets >= quota)
             {
               /// \todo netif_schedule (q);
               break;
             }
+          quota -= packets;
         }
       RunEnd ();
     }
@@ -985,9 +1019,10 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &packets)
 {
   NS_LOG_FUNCTION (this);
+  packets = 0;
   Ptr<QueueDiscItem> item = DequeuePacket();
   if (item == 0)
     {
@@ -995,6 +1030,13 @@ QueueDisc::Restart (void)
       return false;
     }
 
+  TryBulkDequeue (item);
+  packets = m_burst.size ();
+  if (packets > 1)
+    {
+      return TransmitBurst ();
+    }
+  m_burst.clear ();
   return Transmit (item);
 }
 
@@ -1006,15 +1048,15 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface || !m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface || !m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
             if (m_peeked)
               {
                 // If the packet was requeued because a peek operation was requested
@@ -1041,17 +1083,51 @@ QueueDisc::DequeuePacket ()
             {
               item->AddHeader ();
             }
-          // Here, Linux tries bulk dequeues
         }
     }
   return item;
 }
 
+void
+QueueDisc::TryBulkDequeue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  m_burst.clear ();
+  m_burst.push_back (item);
+
+  // As in Linux, only dequeue in bulk for a single device queue with byte
+  // queue limits, whose budget bounds the number of bytes sent at once
+  if (!m_bulkDequeue || !m_sendBurst || !m_devQueueIface || m_devQueueIface->GetNTxQueues () > 1)
+    {
+      return;
+    }
+  Ptr<QueueLimits> queueLimits = m_devQueueIface->GetTxQueue (0)->GetQueueLimits ();
+  if (!queueLimits)
+    {
+      return;
+    }
+
+  int64_t budget = queueLimits->Available () - static_cast<int64_t> (item->GetSize ());
+  while (budget > 0)
+    {
+      Ptr<QueueDiscItem> next = DequeuePacket ();
+      if (next == 0)
+        {
+          break;
+        }
+      m_burst.push_back (next);
+      budget -= next->GetSize ();
+    }
+  NS_LOG_LOGIC ("Dequeued a burst of " << m_burst.size () << " packets");
+}
+
 void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  // the requeued packet was dequeued before any other requeued packet
+  m_requeued.push_front (item);
   /// \todo netif_schedule (q);
 
   m_stats.nTotalRequeuedPackets++;
@@ -1110,4 +1186,44 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return true;
 }
 
+bool
+QueueDisc::TransmitBurst (void)
+{
+  NS_LOG_FUNCTION (this << m_burst.size ());
+
+  // bursts are only dequeued for single queue devices supporting flow control
+  NS_ASSERT (m_devQueueIface && m_devQueueIface->GetNTxQueues () == 1);
+  uint32_t sent = 0;
+  if (!m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      // a single queue device makes no use of the priority tag
+      for (auto& item : m_burst)
+        {
+          SocketPriorityTag priorityTag;
+          item->GetPacket ()->RemovePacketTag (priorityTag);
+        }
+      // the device takes packets from the burst as long as its queue is not
+      // stopped, i.e., as long as it would accept them one at a time
+      sent = m_sendBurst (m_burst);
+      NS_ASSERT (sent <= m_burst.size ());
+    }
+
+  // put the packets left back in front of the requeued ones, the last one
+  // first to preserve their order. They were only dequeued ahead of time and
+  // would not have been requeued if sent one at a time, hence they are not
+  // counted as requeued packets
+  for (uint32_t i = m_burst.size (); i > sent; i--)
+    {
+      m_requeued.push_front (m_burst[i - 1]);
+    }
+  m_burst.clear ();
+
+  if (sent == 0 || GetNPackets () == 0 || m_devQueueIface->GetTxQueue (0)->IsStopped ())
+    {
+      return false;
+    }
+
+  return true;
+}
+
 } // namespace ns3
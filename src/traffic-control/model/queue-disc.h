@@ -26,6 +26,7 @@
 #include "ns3/queue-item.h"
 #include "ns3/queue-size.h"
 #include <vector>
+#include <deque>
 #include <map>
 #include <functional>
 #include <string>
@@ -160,7 +161,7 @@ enum QueueDiscSizePolicy
  * - dropped = dropped before enqueue + dropped after dequeue
  * - received = dropped before enqueue + enqueued
  * - queued = enqueued - dequeued
- * - sent = dequeued - dropped after dequeue (- 1 if there is a requeued packet)
+ * - sent = dequeued - dropped after dequeue (- requeued packets not sent yet)
  *
  * Separate counters are also kept for each possible reason to drop a packet.
  * When a packet is dropped by an internal queue, e.g., because the queue is full,
@@ -372,6 +373,29 @@ public:
    */
   SendCallback GetSendCallback (void) const;
 
+  /**
+   * Callback invoked to send a burst of packets to the receiving object when Run
+   * is called. It returns the number of packets, from the start of the burst,
+   * taken by the receiving object.
+   */
+  typedef std::function<uint32_t (const std::vector<Ptr<QueueDiscItem> > &)> SendBurstCallback;
+
+  /**
+   * \param func the callback to send a burst of packets to the receiving object.
+   *
+   * Set the callback used by the Transmit method to send the packets dequeued
+   * in bulk to the receiving object. Packets are only dequeued in bulk if the
+   * BulkDequeue attribute is true, this callback is set and the receiving
+   * object has a single transmission queue with byte queue limits, whose
+   * budget bounds the size of the bursts.
+   */
+  void SetSendBurstCallback (SendBurstCallback func);
+
+  /**
+   * \return the callback to send a burst of packets to the receiving object.
+   */
+  SendBurstCallback GetSendBurstCallback (void) const;
+
   /**
    * \brief Set the maximum number of dequeue operations following a packet enqueue
    * \param quota the maximum number of dequeue operations following a packet enqueue.
@@ -639,10 +663,12 @@ private:
 
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
-   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
-   * \return true if a packet is successfully sent to the device.
+   * Dequeue a packet (by calling DequeuePacket), possibly followed by others
+   * (by calling TryBulkDequeue), and send them to the device (by calling Transmit).
+   * \param packets set to the number of packets dequeued
+   * \return true if the packets are successfully sent to the device.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &packets);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -657,6 +683,17 @@ private:
    */
   void Requeue (Ptr<QueueDiscItem> item);
 
+  /**
+   * Modelled after the Linux function try_bulk_dequeue_skb (net/sched/sch_generic.c)
+   * Dequeue packets after the given one (by calling DequeuePacket) and store
+   * them all in m_burst, as long as the byte queue limits of the device queue
+   * leave room for them. Nothing is dequeued if bulk dequeue is disabled, the
+   * send burst callback is not set or the device has no byte queue limits or
+   * multiple queues.
+   * \param item the packet already dequeued
+   */
+  void TryBulkDequeue (Ptr<QueueDiscItem> item);
+
   /**
    * Modelled after the Linux function sch_direct_xmit (net/sched/sch_generic.c)
    * Sends a packet to the device if the device queue is not stopped, and requeues
@@ -666,6 +703,14 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Sends the packets in m_burst to the device if the device queue is not
+   * stopped, and puts the packets not taken by the device back in front of
+   * the requeued packets, without counting them as requeued.
+   * \return true if the device queue is not stopped and the queue disc is not empty
+   */
+  bool TransmitBurst (void);
+
   /**
    *  \brief Perform the actions required when the queue disc is notified of
    *         a packet enqueue
@@ -693,10 +738,13 @@ private:
 
   Stats m_stats;                    //!< The collected statistics
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
+  bool m_bulkDequeue;               //!< Whether packets are dequeued in bulk
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   SendCallback m_send;              //!< Callback used to send a packet to the receiving object
+  SendBurstCallback m_sendBurst;    //!< Callback used to send a burst of packets to the receiving object
+  std::vector<Ptr<QueueDiscItem> > m_burst; //!< Packets dequeued in bulk by the latest restart
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::deque<Ptr<QueueDiscItem> > m_requeued; //!< The packets that failed to be transmitted, in order
   bool m_peeked;                    //!< A packet was dequeued because Peek was called
   std::string m_childQueueDiscDropMsg;  //!< Reason why a packet was dropped by a child queue disc
   QueueDiscSizePolicy m_sizePolicy;     //!< The queue disc size policy
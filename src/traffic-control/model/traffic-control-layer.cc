@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/object-map.h"
 #include "ns3/packet.h"
+#include "ns3/packet-burst.h"
 #include "ns3/socket.h"
 #include "ns3/queue-disc.h"
 #include <tuple>
@@ -32,6 +33,39 @@ NS_LOG_COMPONENT_DEFINE ("TrafficControlLayer");
 
 NS_OBJECT_ENSURE_REGISTERED (TrafficControlLayer);
 
+/**
+ * Send a burst of packets dequeued from a queue disc to a device, by calling
+ * NetDevice::SendBatch on each run of packets sharing destination and protocol.
+ *
+ * \param dev the device
+ * \param items the packets
+ * \return the number of packets taken by the device
+ */
+static uint32_t
+SendBurst (Ptr<NetDevice> dev, const std::vector<Ptr<QueueDiscItem> > &items)
+{
+  uint32_t sent = 0;
+  while (sent < items.size ())
+    {
+      Ptr<PacketBurst> burst = CreateObject<PacketBurst> ();
+      const Address &dest = items[sent]->GetAddress ();
+      uint16_t protocol = items[sent]->GetProtocol ();
+      uint32_t end = sent;
+      while (end < items.size () && items[end]->GetProtocol () == protocol
+             && items[end]->GetAddress () == dest)
+        {
+          burst->AddPacket (items[end++]->GetPacket ());
+        }
+      uint32_t n = dev->SendBatch (burst, dest, protocol);
+      sent += n;
+      if (sent < end)
+        {
+          break;
+        }
+    }
+  return sent;
+}
+
 TypeId
 TrafficControlLayer::GetTypeId (void)
 {
@@ -186,6 +220,8 @@ TrafficControlLayer::ScanDevices (void)
               q->SetNetDeviceQueueInterface (ndqi);
               q->SetSendCallback ([dev] (Ptr<QueueDiscItem> item)
                                   { dev->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ()); });
+              q->SetSendBurstCallback ([dev] (const std::vector<Ptr<QueueDiscItem> > &items)
+                                       { return SendBurst (dev, items); });
             }
         }
     }
@@ -250,6 +286,7 @@ TrafficControlLayer::DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device)
     {
       q->SetNetDeviceQueueInterface (nullptr);
       q->SetSendCallback (nullptr);
+      q->SetSendBurstCallback (nullptr);
     }
   ndi->second.m_queueDiscsToWake.clear ();
 
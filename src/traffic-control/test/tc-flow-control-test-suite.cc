@@ -24,6 +24,7 @@
 #include "ns3/pointer.h"
 #include "ns3/string.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/node-container.h"
@@ -34,6 +35,7 @@
 #include "ns3/net-device-queue-interface.h"
 #include "ns3/queue.h"
 #include "ns3/config.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -363,6 +365,169 @@ TcFlowControlTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Traffic Control Bulk Dequeue Test Case
+ *
+ * Send the same packets through a queue disc on a device with byte queue
+ * limits, with and without bulk dequeue, and check that the packets are
+ * received at the same times.
+ */
+class TcBulkDequeueTestCase : public TestCase
+{
+public:
+  TcBulkDequeueTestCase ();
+  virtual ~TcBulkDequeueTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Send packets through a queue disc
+   * \param bulk whether packets are dequeued in bulk
+   * \param bursts set to the number of bursts sent to the device
+   * \param stats set to the statistics of the queue disc
+   * \return the times at which the packets are received
+   */
+  std::vector<Time> RunScenario (bool bulk, uint32_t &bursts, QueueDisc::Stats &stats);
+  /**
+   * Instruct a node to send a specified number of packets
+   * \param n the node
+   * \param nPackets the number of packets to send
+   */
+  void SendPackets (Ptr<Node> n, uint16_t nPackets);
+  /**
+   * Enable bulk dequeue if requested, and count the bursts sent to the device
+   * \param qdisc the queue disc
+   * \param bulk whether packets are dequeued in bulk
+   * \param bursts the number of bursts sent to the device
+   */
+  void SetBulk (Ptr<QueueDisc> qdisc, bool bulk, uint32_t *bursts);
+  /**
+   * Record the time a packet is received
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \param to the destination address
+   * \param type the packet type
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                const Address &from, const Address &to, NetDevice::PacketType type);
+  std::vector<Time> m_rxTimes;  //!< the times at which the packets are received
+};
+
+TcBulkDequeueTestCase::TcBulkDequeueTestCase ()
+  : TestCase ("Test that bulk dequeues within byte queue limits do not change timing")
+{
+}
+
+TcBulkDequeueTestCase::~TcBulkDequeueTestCase ()
+{
+}
+
+void
+TcBulkDequeueTestCase::SendPackets (Ptr<Node> n, uint16_t nPackets)
+{
+  Ptr<TrafficControlLayer> tc = n->GetObject<TrafficControlLayer> ();
+  for (uint16_t i = 0; i < nPackets; i++)
+    {
+      tc->Send (n->GetDevice (0), Create<QueueDiscTestItem> (Create<Packet> (400 + 100 * (i % 7))));
+    }
+}
+
+void
+TcBulkDequeueTestCase::SetBulk (Ptr<QueueDisc> qdisc, bool bulk, uint32_t *bursts)
+{
+  if (bulk)
+    {
+      qdisc->SetAttribute ("BulkDequeue", BooleanValue (true));
+    }
+  QueueDisc::SendBurstCallback send = qdisc->GetSendBurstCallback ();
+  NS_TEST_ASSERT_MSG_EQ (bool (send), true, "The traffic control layer did not set a send burst callback");
+  qdisc->SetSendBurstCallback ([send, bursts] (const std::vector<Ptr<QueueDiscItem> > &items)
+                               {
+                                 (*bursts)++;
+                                 return send (items);
+                               });
+}
+
+bool
+TcBulkDequeueTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol,
+                                const Address &from, const Address &to, NetDevice::PacketType type)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+std::vector<Time>
+TcBulkDequeueTestCase::RunScenario (bool bulk, uint32_t &bursts, QueueDisc::Stats &stats)
+{
+  NodeContainer n;
+  n.Create (2);
+
+  n.Get (0)->AggregateObject (CreateObject<TrafficControlLayer> ());
+  n.Get (1)->AggregateObject (CreateObject<TrafficControlLayer> ());
+
+  SimpleNetDeviceHelper simple;
+
+  NetDeviceContainer rxDevC = simple.Install (n.Get (1));
+  // the packets are not addressed to the receiving device
+  rxDevC.Get (0)->SetPromiscReceiveCallback (MakeCallback (&TcBulkDequeueTestCase::Receive, this));
+
+  simple.SetDeviceAttribute ("DataRate", DataRateValue (DataRate ("1Mb/s")));
+  simple.SetQueue ("ns3::DropTailQueue", "MaxSize", StringValue ("4p"));
+
+  Ptr<NetDevice> txDev;
+  txDev = simple.Install (n.Get (0), DynamicCast<SimpleChannel> (rxDevC.Get (0)->GetChannel ())).Get (0);
+  txDev->SetMtu (2500);
+
+  TrafficControlHelper tch = TrafficControlHelper::Default ();
+  tch.SetQueueLimits ("ns3::DynamicQueueLimits");
+  QueueDiscContainer qdiscs = tch.Install (txDev);
+
+  m_rxTimes.clear ();
+  bursts = 0;
+  // the queue disc gets its send burst callback when the node is initialized
+  Simulator::Schedule (Seconds (0), &TcBulkDequeueTestCase::SetBulk, this, qdiscs.Get (0), bulk, &bursts);
+  Simulator::Schedule (Seconds (0), &TcBulkDequeueTestCase::SendPackets, this, n.Get (0), 30);
+  Simulator::Schedule (MilliSeconds (50), &TcBulkDequeueTestCase::SendPackets, this, n.Get (0), 10);
+  Simulator::Schedule (MilliSeconds (500), &TcBulkDequeueTestCase::SendPackets, this, n.Get (0), 25);
+
+  Simulator::Run ();
+  stats = qdiscs.Get (0)->GetStats ();
+  Simulator::Destroy ();
+  return m_rxTimes;
+}
+
+void
+TcBulkDequeueTestCase::DoRun (void)
+{
+  uint32_t bursts;
+  QueueDisc::Stats stats;
+  std::vector<Time> rxTimes = RunScenario (false, bursts, stats);
+  NS_TEST_EXPECT_MSG_EQ (bursts, 0, "No burst expected by default");
+
+  uint32_t bulkBursts;
+  QueueDisc::Stats bulkStats;
+  std::vector<Time> bulkRxTimes = RunScenario (true, bulkBursts, bulkStats);
+  NS_TEST_EXPECT_MSG_GT (bulkBursts, 0, "Packets should have been dequeued in bulk");
+  // FqCoDel drops the same packets, as they are dequeued at the same times
+  NS_TEST_EXPECT_MSG_EQ (bulkStats.nTotalSentPackets, stats.nTotalSentPackets, "Different number of packets sent");
+  NS_TEST_EXPECT_MSG_EQ (bulkStats.nTotalDroppedPackets, stats.nTotalDroppedPackets, "Different number of packets dropped");
+  // packets the device did not take from a burst are not counted as requeued
+  NS_TEST_EXPECT_MSG_EQ (bulkStats.nTotalRequeuedPackets, stats.nTotalRequeuedPackets, "Different number of packets requeued");
+  NS_TEST_EXPECT_MSG_EQ (bulkStats.nTotalRequeuedBytes, stats.nTotalRequeuedBytes, "Different number of bytes requeued");
+
+  NS_TEST_ASSERT_MSG_EQ (rxTimes.size (), stats.nTotalSentPackets, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (bulkRxTimes.size (), rxTimes.size (), "Wrong number of packets received with bulk dequeue");
+  for (uint32_t i = 0; i < rxTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (bulkRxTimes[i], rxTimes[i], "Packet " << i << " received at a different time");
+    }
+}
+
 /**
  * \ingroup traffic-control-test
  * \ingroup tests
@@ -377,5 +542,6 @@ public:
   {
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::PACKETS), TestCase::QUICK);
     AddTestCase (new TcFlowControlTestCase (QueueSizeUnit::BYTES), TestCase::QUICK);
+    AddTestCase (new TcBulkDequeueTestCase (), TestCase::QUICK);
   }
 } g_tcFlowControlTestSuite; ///< the test suite
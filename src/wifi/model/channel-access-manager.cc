@@ -20,6 +20,7 @@
 
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
 #include "channel-access-manager.h"
 #include "txop.h"
 #include "wifi-phy-listener.h"
@@ -30,6 +31,8 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("ChannelAccessManager");
 
+NS_OBJECT_ENSURE_REGISTERED (ChannelAccessManager);
+
 /**
  * Listener for PHY events. Forwards to ChannelAccessManager
  */
@@ -98,6 +101,23 @@ private:
  *      Implement the DCF manager of all DCF state holders
  ****************************************************************/
 
+TypeId
+ChannelAccessManager::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ChannelAccessManager")
+    .SetParent<Object> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<ChannelAccessManager> ()
+    .AddAttribute ("CoalescedBackoff",
+                   "If true, the access timeout is only scheduled when it grants access, "
+                   "instead of each time the earliest backoff end is expected.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ChannelAccessManager::m_coalescedBackoff),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
 ChannelAccessManager::ChannelAccessManager ()
   : m_lastAckTimeoutEnd (MicroSeconds (0)),
     m_lastCtsTimeoutEnd (MicroSeconds (0)),
@@ -117,7 +137,12 @@ ChannelAccessManager::ChannelAccessManager ()
     m_off (false),
     m_slot (Seconds (0.0)),
     m_sifs (Seconds (0.0)),
-    m_phyListener (0)
+    m_phyListener (0),
+    m_coalescedBackoff (false),
+    m_accessTimeoutTime (Simulator::GetMaximumSimulationTime ()),
+    m_nextBackoffEnd (Simulator::GetMaximumSimulationTime ()),
+    m_nextRxBackoffEnd (Simulator::GetMaximumSimulationTime ()),
+    m_updateRxEnd (MicroSeconds (0))
 {
   NS_LOG_FUNCTION (this);
 }
@@ -274,7 +299,14 @@ ChannelAccessManager::RequestAccess (Ptr<Txop> state, bool isCfPeriod)
     {
       state->NotifyAccessRequested ();
       Time delay = (MostRecent ({GetAccessGrantStart (true), Simulator::Now ()}) - Simulator::Now ());
-      m_accessTimeout = Simulator::Schedule (delay, &ChannelAccessManager::DoGrantPcfAccess, this, state);
+      if (m_coalescedBackoff)
+        {
+          m_pcfAccessTimeout = Simulator::Schedule (delay, &ChannelAccessManager::DoGrantPcfAccess, this, state);
+        }
+      else
+        {
+          m_accessTimeout = Simulator::Schedule (delay, &ChannelAccessManager::DoGrantPcfAccess, this, state);
+        }
       return;
     }
   UpdateBackoff ();
@@ -381,6 +413,13 @@ void
 ChannelAccessManager::AccessTimeout (void)
 {
   NS_LOG_FUNCTION (this);
+  if (m_coalescedBackoff)
+    {
+      CatchUpAccessTimeout ();
+      NS_ASSERT (m_accessTimeoutTime == Simulator::Now ());
+      // the access timeout is no longer running while it is being handled
+      m_accessTimeoutTime = Simulator::GetMaximumSimulationTime ();
+    }
   UpdateBackoff ();
   DoGrantDcfAccess ();
   DoRestartAccessTimeoutIfNeeded ();
@@ -462,12 +501,15 @@ void
 ChannelAccessManager::UpdateBackoff (void)
 {
   NS_LOG_FUNCTION (this);
+  // The access grant start does not depend on the backoffs
+  Time accessGrantStart = GetAccessGrantStart ();
   uint32_t k = 0;
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++, k++)
     {
       Ptr<Txop> state = *i;
 
-      Time backoffStart = GetBackoffStartFor (state);
+      Time backoffStart = MostRecent ({state->GetBackoffStart (),
+                                       accessGrantStart + (state->GetAifsn () * m_slot)});
       if (backoffStart <= Simulator::Now ())
         {
           uint32_t nIntSlots = ((Simulator::Now () - backoffStart) / m_slot).GetHigh ();
@@ -521,6 +563,13 @@ ChannelAccessManager::DoRestartAccessTimeoutIfNeeded (void)
   if (accessTimeoutNeeded)
     {
       NS_LOG_DEBUG ("expected backoff end=" << expectedBackoffEnd);
+      if (m_coalescedBackoff)
+        {
+          CatchUpAccessTimeout ();
+          m_accessTimeoutTime = std::min (m_accessTimeoutTime, expectedBackoffEnd);
+          UpdateAccessTimeout ();
+          return;
+        }
       Time expectedBackoffDelay = expectedBackoffEnd - Simulator::Now ();
       if (m_accessTimeout.IsRunning ()
           && Simulator::GetDelayLeft (m_accessTimeout) > expectedBackoffDelay)
@@ -533,6 +582,110 @@ ChannelAccessManager::DoRestartAccessTimeoutIfNeeded (void)
                                                  &ChannelAccessManager::AccessTimeout, this);
         }
     }
+  else
+    {
+      UpdateAccessTimeout ();
+    }
+}
+
+void
+ChannelAccessManager::CancelAccessTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_coalescedBackoff)
+    {
+      m_accessTimeoutTime = Simulator::GetMaximumSimulationTime ();
+      m_pcfAccessTimeout.Cancel ();
+      UpdateAccessTimeout ();
+    }
+  else if (m_accessTimeout.IsRunning ())
+    {
+      m_accessTimeout.Cancel ();
+    }
+}
+
+void
+ChannelAccessManager::CatchUpAccessTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_accessTimeoutTime < Simulator::Now ())
+    {
+      // The access timeout expired without granting access, otherwise
+      // m_accessTimeout would have been handled then, and it was scheduled
+      // again at the earliest backoff end, which has not changed since the
+      // last update unless the reception in progress then has ended
+      Time accessTimeoutTime = m_accessTimeoutTime;
+      m_accessTimeoutTime = (accessTimeoutTime < m_updateRxEnd) ? m_nextRxBackoffEnd : m_nextBackoffEnd;
+      NS_ASSERT (m_accessTimeoutTime > accessTimeoutTime);
+    }
+}
+
+void
+ChannelAccessManager::UpdateAccessTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_coalescedBackoff)
+    {
+      return;
+    }
+  CatchUpAccessTimeout ();
+  if (m_accessTimeoutTime == Simulator::GetMaximumSimulationTime ())
+    {
+      // The backoff ends are only needed once the access timeout is
+      // scheduled, which is followed by an update
+      if (m_accessTimeout.IsRunning ())
+        {
+          Simulator::Remove (m_accessTimeout);
+        }
+      return;
+    }
+  Time now = Simulator::Now ();
+  // Same as GetBackoffEndFor, computing the access grant start once
+  Time rxAccessGrantStart = GetAccessGrantStart ();
+  Time accessGrantStart = rxAccessGrantStart;
+  m_updateRxEnd = m_lastRxEnd;
+  if (m_lastRxEnd > now && !m_lastRxReceivedOk)
+    {
+      // The EIFS follows the reception in progress once it has ended, even
+      // if its end is not notified
+      accessGrantStart = std::max (accessGrantStart, m_lastRxEnd + m_sifs + m_eifsNoDifs);
+    }
+  m_nextBackoffEnd = Simulator::GetMaximumSimulationTime ();
+  m_nextRxBackoffEnd = Simulator::GetMaximumSimulationTime ();
+  for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
+    {
+      Ptr<Txop> state = *i;
+      if (state->IsAccessRequested ())
+        {
+          Time aifs = state->GetAifsn () * m_slot;
+          Time backoff = state->GetBackoffSlots () * m_slot;
+          m_nextBackoffEnd = std::min (m_nextBackoffEnd, MostRecent ({state->GetBackoffStart (), accessGrantStart + aifs}) + backoff);
+          m_nextRxBackoffEnd = std::min (m_nextRxBackoffEnd, MostRecent ({state->GetBackoffStart (), rxAccessGrantStart + aifs}) + backoff);
+        }
+    }
+  if (m_nextBackoffEnd == Simulator::GetMaximumSimulationTime ())
+    {
+      // The access timeout will expire without granting access
+      if (m_accessTimeout.IsRunning ())
+        {
+          Simulator::Remove (m_accessTimeout);
+        }
+      return;
+    }
+  // Access is granted when the access timeout expires if a backoff has
+  // ended then, or else at the earliest backoff end, when the access
+  // timeout expires again
+  Time accessTimeoutTime = std::max (m_accessTimeoutTime, m_nextBackoffEnd);
+  if (m_accessTimeout.IsRunning ())
+    {
+      if (m_accessTimeout.GetTs () == static_cast<uint64_t> (accessTimeoutTime.GetTimeStep ()))
+        {
+          return;
+        }
+      Simulator::Remove (m_accessTimeout);
+    }
+  NS_LOG_DEBUG ("access timeout at " << accessTimeoutTime);
+  m_accessTimeout = Simulator::Schedule (accessTimeoutTime - now, &ChannelAccessManager::AccessTimeout, this);
 }
 
 void
@@ -544,6 +697,7 @@ ChannelAccessManager::NotifyRxStartNow (Time duration)
   m_lastRxStart = Simulator::Now ();
   m_lastRxDuration = duration;
   m_lastRxEnd = m_lastRxStart + m_lastRxDuration;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -554,6 +708,7 @@ ChannelAccessManager::NotifyRxEndOkNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxDuration = m_lastRxEnd - m_lastRxStart;
   m_lastRxReceivedOk = true;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -564,6 +719,7 @@ ChannelAccessManager::NotifyRxEndErrorNow (void)
   m_lastRxEnd = Simulator::Now ();
   m_lastRxDuration = m_lastRxEnd - m_lastRxStart;
   m_lastRxReceivedOk = false;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -583,6 +739,7 @@ ChannelAccessManager::NotifyTxStartNow (Time duration)
   UpdateBackoff ();
   m_lastTxStart = Simulator::Now ();
   m_lastTxDuration = duration;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -593,6 +750,7 @@ ChannelAccessManager::NotifyMaybeCcaBusyStartNow (Time duration)
   UpdateBackoff ();
   m_lastBusyStart = Simulator::Now ();
   m_lastBusyDuration = duration;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -628,10 +786,7 @@ ChannelAccessManager::NotifySwitchingStartNow (Time duration)
     }
 
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -660,10 +815,7 @@ ChannelAccessManager::NotifySleepNow (void)
   NS_LOG_FUNCTION (this);
   m_sleeping = true;
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -679,10 +831,7 @@ ChannelAccessManager::NotifyOffNow (void)
   NS_LOG_FUNCTION (this);
   m_off = true;
   //Cancel timeout
-  if (m_accessTimeout.IsRunning ())
-    {
-      m_accessTimeout.Cancel ();
-    }
+  CancelAccessTimeout ();
 
   //Reset backoffs
   for (States::iterator i = m_states.begin (); i != m_states.end (); i++)
@@ -763,6 +912,7 @@ ChannelAccessManager::NotifyNavStartNow (Time duration)
       m_lastNavStart = Simulator::Now ();
       m_lastNavDuration = duration;
     }
+  UpdateAccessTimeout ();
 }
 
 void
@@ -771,6 +921,7 @@ ChannelAccessManager::NotifyAckTimeoutStartNow (Time duration)
   NS_LOG_FUNCTION (this << duration);
   NS_ASSERT (m_lastAckTimeoutEnd < Simulator::Now ());
   m_lastAckTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -786,6 +937,7 @@ ChannelAccessManager::NotifyCtsTimeoutStartNow (Time duration)
 {
   NS_LOG_FUNCTION (this << duration);
   m_lastCtsTimeoutEnd = Simulator::Now () + duration;
+  UpdateAccessTimeout ();
 }
 
 void
@@ -796,4 +948,11 @@ ChannelAccessManager::NotifyCtsTimeoutResetNow (void)
   DoRestartAccessTimeoutIfNeeded ();
 }
 
+void
+ChannelAccessManager::NotifyBackoffStartNow (void)
+{
+  NS_LOG_FUNCTION (this);
+  UpdateAccessTimeout ();
+}
+
 } //namespace ns3
@@ -47,10 +47,25 @@ class MacLow;
  * medium at the same time, the highest priority local Txop wins
  * access to the medium and the other Txop suffers a "internal"
  * collision.
+ *
+ * The ChannelAccessManager schedules an access timeout at the earliest
+ * backoff end of the Txop requesting access. As the medium turns busy,
+ * the backoff ends move later, and the access timeout expires without
+ * granting access before it is scheduled again. With the CoalescedBackoff
+ * attribute, the access timeout is only scheduled when it grants access:
+ * the expirations in between, which only reschedule it, are computed when
+ * the state of the ChannelAccessManager changes. Access is granted at the
+ * same times and to the same Txop as without it.
  */
 class ChannelAccessManager : public Object
 {
 public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
   ChannelAccessManager ();
   virtual ~ChannelAccessManager ();
 
@@ -210,6 +225,11 @@ public:
    * Notify that CTS timer has reset.
    */
   void NotifyCtsTimeoutResetNow (void);
+  /**
+   * Notify that the backoff of a Txop which has requested access has been
+   * started again outside of the ChannelAccessManager.
+   */
+  void NotifyBackoffStartNow (void);
 
   /**
    * Check if the device is busy sending or receiving,
@@ -268,6 +288,22 @@ private:
   Time GetBackoffEndFor (Ptr<Txop> state);
 
   void DoRestartAccessTimeoutIfNeeded (void);
+  /**
+   * Cancel the access timeout.
+   */
+  void CancelAccessTimeout (void);
+  /**
+   * With coalesced backoff, account for the access timeouts which have
+   * expired since the last update without granting access.
+   */
+  void CatchUpAccessTimeout (void);
+  /**
+   * With coalesced backoff, account for the access timeouts which have
+   * expired since the last update, and schedule m_accessTimeout at the
+   * time access is to be granted, if any. To be called whenever the
+   * backoff ends may have changed.
+   */
+  void UpdateAccessTimeout (void);
 
   /**
    * Called when access timeout should occur
@@ -319,6 +355,12 @@ private:
   Time m_sifs;                  //!< the SIFS time
   PhyListener* m_phyListener;   //!< the phy listener
   Ptr<WifiPhy> m_phy;           //!< Ptr to the PHY
+  bool m_coalescedBackoff;      //!< whether the access timeout is only scheduled to grant access
+  Time m_accessTimeoutTime;     //!< with coalesced backoff, the time of the next access timeout
+  Time m_nextBackoffEnd;        //!< with coalesced backoff, the earliest backoff end at the last update
+  Time m_nextRxBackoffEnd;      //!< with coalesced backoff, the earliest backoff end during the reception in progress at the last update
+  Time m_updateRxEnd;           //!< with coalesced backoff, the end of the last reception at the last update
+  EventId m_pcfAccessTimeout;   //!< with coalesced backoff, the PCF access timeout ID
 };
 
 } //namespace ns3
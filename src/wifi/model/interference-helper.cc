@@ -19,6 +19,10 @@
  *          Sébastien Deronne <sebastien.deronne@gmail.com>
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
@@ -123,7 +127,8 @@ InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
     m_numRxAntennas (1),
     m_firstPower (0),
-    m_rxing (false)
+    m_rxing (false),
+    m_version (0)
 {
   // Always have a zero power noise event in the list
   AddNiChangeEvent (Time (0), NiChange (0.0, 0));
@@ -157,12 +162,14 @@ void
 InterferenceHelper::SetNoiseFigure (double value)
 {
   m_noiseFigure = value;
+  m_version++;
 }
 
 void
 InterferenceHelper::SetErrorRateModel (const Ptr<ErrorRateModel> rate)
 {
   m_errorRateModel = rate;
+  m_version++;
 }
 
 Ptr<ErrorRateModel>
@@ -175,6 +182,7 @@ void
 InterferenceHelper::SetNumberOfReceiveAntennas (uint8_t rx)
 {
   m_numRxAntennas = rx;
+  m_version++;
 }
 
 Time
@@ -199,6 +207,7 @@ void
 InterferenceHelper::AppendEvent (Ptr<Event> event)
 {
   NS_LOG_FUNCTION (this);
+  m_version++;
   double previousPowerStart = 0;
   double previousPowerEnd = 0;
   previousPowerStart = GetPreviousPosition (event->GetStartTime ())->second.GetPower ();
@@ -211,11 +220,26 @@ InterferenceHelper::AppendEvent (Ptr<Event> event)
       m_niChanges.erase (++(m_niChanges.begin ()),
                          GetNextPosition (event->GetStartTime ()));
     }
+  else
+    {
+      // Only the changes from the start of the signal being received on are
+      // looked at, along with the last one before it
+      auto start = std::lower_bound (m_niChanges.begin (), m_niChanges.end (), m_rxStart,
+                                     [] (const NiChanges::value_type &change, Time moment)
+                                     { return change.first < moment; });
+      if (start - m_niChanges.begin () > 2)
+        {
+          m_niChanges.erase (++(m_niChanges.begin ()), --start);
+        }
+    }
+  // Inserting into the ring invalidates its iterators, hence the indices
   auto first = AddNiChangeEvent (event->GetStartTime (), NiChange (previousPowerStart, event));
+  std::size_t firstIndex = first - m_niChanges.begin ();
   auto last = AddNiChangeEvent (event->GetEndTime (), NiChange (previousPowerEnd, event));
-  for (auto i = first; i != last; ++i)
+  std::size_t lastIndex = last - m_niChanges.begin ();
+  for (std::size_t i = firstIndex; i != lastIndex; ++i)
     {
-      i->second.AddPower (event->GetRxPowerW ());
+      m_niChanges[i].second.AddPower (event->GetRxPowerW ());
     }
 }
 
@@ -235,22 +259,22 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint1
 }
 
 double
-InterferenceHelper::CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni, Time moment) const
 {
   double noiseInterferenceW = m_firstPower;
-  auto it = m_niChanges.find (event->GetStartTime ());
-  for (; it != m_niChanges.end () && it->first < Simulator::Now (); ++it)
+  auto it = GetFirstPosition (event->GetStartTime ());
+  for (; it != m_niChanges.end () && it->first < moment; ++it)
     {
       noiseInterferenceW = it->second.GetPower () - event->GetRxPowerW ();
     }
-  it = m_niChanges.find (event->GetStartTime ());
+  it = GetFirstPosition (event->GetStartTime ());
   for (; it != m_niChanges.end () && it->second.GetEvent () != event; ++it);
-  ni->emplace (event->GetStartTime (), NiChange (0, event));
+  ni->push_back (std::make_pair (event->GetStartTime (), NiChange (0, event)));
   while (++it != m_niChanges.end () && it->second.GetEvent () != event)
     {
-      ni->insert (*it);
+      ni->push_back (*it);
     }
-  ni->emplace (event->GetEndTime (), NiChange (0, event));
+  ni->push_back (std::make_pair (event->GetEndTime (), NiChange (0, event)));
   NS_ASSERT_MSG (noiseInterferenceW >= 0, "CalculateNoiseInterferenceW returns negative value " << noiseInterferenceW);
   return noiseInterferenceW;
 }
@@ -848,9 +872,15 @@ InterferenceHelper::CalculateNonLegacyPhyHeaderPer (Ptr<const Event> event, NiCh
 
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Time> relativeMpduStartStop) const
+{
+  return CalculatePayloadSnrPer (event, relativeMpduStartStop, Simulator::Now ());
+}
+
+struct InterferenceHelper::SnrPer
+InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Time> relativeMpduStartStop, Time moment) const
 {
   NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni, moment);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -868,9 +898,15 @@ InterferenceHelper::CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Ti
 
 double
 InterferenceHelper::CalculateSnr (Ptr<Event> event) const
+{
+  return CalculateSnr (event, Simulator::Now ());
+}
+
+double
+InterferenceHelper::CalculateSnr (Ptr<Event> event, Time moment) const
 {
   NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni, moment);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -881,7 +917,7 @@ struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateLegacyPhyHeaderSnrPer (Ptr<Event> event) const
 {
   NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni, Simulator::Now ());
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -901,7 +937,7 @@ struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculateNonLegacyPhyHeaderSnrPer (Ptr<Event> event) const
 {
   NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni, Simulator::Now ());
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
@@ -917,6 +953,70 @@ InterferenceHelper::CalculateNonLegacyPhyHeaderSnrPer (Ptr<Event> event) const
   return snrPer;
 }
 
+double
+InterferenceHelper::CalculateEffectiveSnr (Ptr<Event> event) const
+{
+  return CalculateEffectiveSnr (event, Simulator::Now ());
+}
+
+double
+InterferenceHelper::CalculateEffectiveSnr (Ptr<Event> event, Time moment) const
+{
+  NS_LOG_FUNCTION (this << event << moment);
+  NiChanges ni;
+  CalculateNoiseInterferenceW (event, &ni, moment);
+  const WifiTxVector txVector = event->GetTxVector ();
+  WifiMode payloadMode = event->GetPayloadMode ();
+  double beta = 1.0;
+  if (payloadMode.GetModulationClass () != WIFI_MOD_CLASS_DSSS
+      && payloadMode.GetModulationClass () != WIFI_MOD_CLASS_HR_DSSS
+      && payloadMode.GetConstellationSize () > 2)
+    {
+      beta = 2.0 * (payloadMode.GetConstellationSize () - 1) / 3.0;
+    }
+  double powerW = event->GetRxPowerW ();
+  double noiseInterferenceW = m_firstPower;
+  std::vector<std::pair<double, double> > chunks; // duration and SNIR of each chunk
+  double minSnr = std::numeric_limits<double>::max ();
+  auto j = ni.begin ();
+  Time previous = j->first;
+  while (++j != ni.end ())
+    {
+      Time current = j->first;
+      NS_ASSERT (current >= previous);
+      if (current > previous)
+        {
+          double snr = CalculateSnr (powerW, noiseInterferenceW, txVector.GetChannelWidth ());
+          chunks.push_back (std::make_pair ((current - previous).GetSeconds (), snr));
+          minSnr = std::min (minSnr, snr);
+        }
+      noiseInterferenceW = j->second.GetPower () - powerW;
+      previous = current;
+    }
+  if (chunks.empty ())
+    {
+      return CalculateSnr (event, moment);
+    }
+  // The SNIRs are taken relative to the lowest one, so that the
+  // exponentials cannot all underflow
+  double sum = 0;
+  double duration = 0;
+  for (const auto & chunk : chunks)
+    {
+      sum += chunk.first * std::exp (-(chunk.second - minSnr) / beta);
+      duration += chunk.first;
+    }
+  double snr = minSnr - beta * std::log (sum / duration);
+  NS_LOG_DEBUG ("beta=" << beta << ", effective snr(dB)=" << RatioToDb (snr));
+  return snr;
+}
+
+double
+InterferenceHelper::CalculateEffectivePer (Ptr<const Event> event, double snr, WifiMode mode, Time duration) const
+{
+  return 1 - CalculateChunkSuccessRate (snr, duration, mode, event->GetTxVector ());
+}
+
 void
 InterferenceHelper::EraseEvents (void)
 {
@@ -925,12 +1025,42 @@ InterferenceHelper::EraseEvents (void)
   AddNiChangeEvent (Time (0), NiChange (0.0, 0));
   m_rxing = false;
   m_firstPower = 0;
+  m_version++;
+}
+
+uint64_t
+InterferenceHelper::GetVersion (void) const
+{
+  return m_version;
 }
 
 InterferenceHelper::NiChanges::const_iterator
 InterferenceHelper::GetNextPosition (Time moment) const
 {
-  return m_niChanges.upper_bound (moment);
+  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), moment,
+                           [] (Time moment, const NiChanges::value_type &change)
+                           { return moment < change.first; });
+}
+
+InterferenceHelper::NiChanges::iterator
+InterferenceHelper::GetNextPosition (Time moment)
+{
+  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), moment,
+                           [] (Time moment, const NiChanges::value_type &change)
+                           { return moment < change.first; });
+}
+
+InterferenceHelper::NiChanges::const_iterator
+InterferenceHelper::GetFirstPosition (Time moment) const
+{
+  auto it = std::lower_bound (m_niChanges.begin (), m_niChanges.end (), moment,
+                              [] (const NiChanges::value_type &change, Time moment)
+                              { return change.first < moment; });
+  if (it != m_niChanges.end () && it->first != moment)
+    {
+      return m_niChanges.end ();
+    }
+  return it;
 }
 
 InterferenceHelper::NiChanges::const_iterator
@@ -953,6 +1083,12 @@ void
 InterferenceHelper::NotifyRxStart ()
 {
   NS_LOG_FUNCTION (this);
+  // WifiPhy also notifies the packets it drops while detecting the preamble
+  // of another one, whose changes must be kept
+  if (!m_rxing)
+    {
+      m_rxStart = Simulator::Now ();
+    }
   m_rxing = true;
 }
 
@@ -962,9 +1098,10 @@ InterferenceHelper::NotifyRxEnd ()
   NS_LOG_FUNCTION (this);
   m_rxing = false;
   //Update m_firstPower for frame capture
-  auto it = m_niChanges.find (Simulator::Now ());
+  auto it = GetFirstPosition (Simulator::Now ());
   it--;
   m_firstPower = it->second.GetPower ();
+  m_version++;
 }
 
 } //namespace ns3
@@ -23,7 +23,7 @@
 
 #include "ns3/nstime.h"
 #include "wifi-tx-vector.h"
-#include <map>
+#include <deque>
 
 namespace ns3 {
 
@@ -184,6 +184,17 @@ public:
    * \return struct of SNR and PER (with PER being evaluated over the provided time window)
    */
   struct InterferenceHelper::SnrPer CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Time> relativeMpduStartStop) const;
+  /**
+   * Calculate the SNIR at the start of the payload and the PER of a time
+   * window of the payload, as CalculatePayloadSnrPer would at the given time.
+   *
+   * \param event the event corresponding to the first time the corresponding packet arrives
+   * \param relativeMpduStartStop the time window (pair of start and end times) of PLCP payload to focus on
+   * \param moment the time as of which the SNIR is calculated
+   *
+   * \return struct of SNR and PER (with PER being evaluated over the provided time window)
+   */
+  struct InterferenceHelper::SnrPer CalculatePayloadSnrPer (Ptr<Event> event, std::pair<Time, Time> relativeMpduStartStop, Time moment) const;
   /**
    * Calculate the SNIR for the event (starting from now until the event end).
    *
@@ -192,6 +203,15 @@ public:
    * \return the SNR for the packet
    */
   double CalculateSnr (Ptr<Event> event) const;
+  /**
+   * Calculate the SNIR for the event as CalculateSnr would at the given time.
+   *
+   * \param event the event corresponding to the first time the corresponding packet arrives
+   * \param moment the time as of which the SNIR is calculated
+   *
+   * \return the SNR for the packet
+   */
+  double CalculateSnr (Ptr<Event> event, Time moment) const;
   /**
    * Calculate the SNIR at the start of the legacy PHY header and accumulate
    * all SNIR changes in the snir vector.
@@ -210,9 +230,49 @@ public:
    * \return struct of SNR and PER
    */
   struct InterferenceHelper::SnrPer CalculateNonLegacyPhyHeaderSnrPer (Ptr<Event> event) const;
+  /**
+   * Calculate the effective SNIR of the event over its whole duration, by
+   * combining the SNIRs of its chunks with the exponential effective SINR
+   * mapping (EESM):
+   *
+   *   SNIR_eff = -beta ln (sum_i (d_i / d) exp (-SNIR_i / beta))
+   *
+   * where d_i is the duration of chunk i and d the duration of the event.
+   * beta is derived from the constellation of the payload mode: it is 1
+   * for BPSK (and for the DSSS modes) and 2 (M - 1) / 3 for M-QAM, which
+   * follows from the Chernoff bound of the symbol error rate.
+   *
+   * \param event the event corresponding to the first time the corresponding packet arrives
+   *
+   * \return the effective SNIR of the event
+   */
+  double CalculateEffectiveSnr (Ptr<Event> event) const;
+  /**
+   * Calculate the effective SNIR of the event as CalculateEffectiveSnr
+   * would at the given time.
+   *
+   * \param event the event corresponding to the first time the corresponding packet arrives
+   * \param moment the time as of which the SNIR is calculated
+   *
+   * \return the effective SNIR of the event
+   */
+  double CalculateEffectiveSnr (Ptr<Event> event, Time moment) const;
+  /**
+   * Calculate the error rate of a part of the event received with a
+   * constant SNIR, as given by CalculateEffectiveSnr.
+   *
+   * \param event the event corresponding to the first time the corresponding packet arrives
+   * \param snr the SNIR of the part
+   * \param mode the Wi-Fi mode of the part
+   * \param duration the duration of the part
+   *
+   * \return the error rate of the part
+   */
+  double CalculateEffectivePer (Ptr<const Event> event, double snr, WifiMode mode, Time duration) const;
 
   /**
-   * Notify that RX has started.
+   * Notify that RX has started. The changes from the start of the first
+   * signal notified since the end of the last reception are kept.
    */
   void NotifyRxStart ();
   /**
@@ -223,6 +283,14 @@ public:
    * Erase all events.
    */
   void EraseEvents (void);
+  /**
+   * The version is incremented each time the state from which the SNIRs
+   * and error rates are calculated changes, so that the results computed
+   * ahead of time for an event can be checked to still hold.
+   *
+   * \return the version of the state of the interference helper
+   */
+  uint64_t GetVersion (void) const;
 
 
 private:
@@ -265,9 +333,12 @@ private:
   };
 
   /**
-   * typedef for a multimap of NiChanges
+   * typedef for a time-ordered ring of NiChanges. Each change holds the
+   * total power from its time on, so that the power at any time is found
+   * by a binary search. The changes older than the signal being received
+   * are dropped as new signals are added.
    */
-  typedef std::multimap<Time, NiChange> NiChanges;
+  typedef std::deque<std::pair<Time, NiChange> > NiChanges;
 
   /**
    * Append the given Event.
@@ -280,10 +351,11 @@ private:
    *
    * \param event
    * \param ni
+   * \param moment the time as of which the noise and interference are calculated
    *
    * \return noise and interference power
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni, Time moment) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    *
@@ -346,6 +418,8 @@ private:
   NiChanges m_niChanges;
   double m_firstPower; ///< first power
   bool m_rxing; ///< flag whether it is in receiving state
+  Time m_rxStart; ///< start time of the signal being received
+  uint64_t m_version; ///< version of the state, see GetVersion
 
   /**
    * Returns an iterator to the first nichange that is later than moment
@@ -360,7 +434,15 @@ private:
    * \param moment time to check from
    * \returns an iterator to the list of NiChanges
    */
-  //NiChanges::iterator GetNextPosition (Time moment);
+  NiChanges::iterator GetNextPosition (Time moment);
+  /**
+   * Returns an iterator to the first nichange at moment
+   *
+   * \param moment time to check
+   * \returns an iterator to the list of NiChanges, or its end if there is
+   *          no nichange at moment
+   */
+  NiChanges::const_iterator GetFirstPosition (Time moment) const;
   /**
    * Returns an iterator to the last nichange that is before than moment
    *
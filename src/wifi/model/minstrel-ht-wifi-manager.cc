@@ -34,6 +34,7 @@
  * reference: http://lwn.net/Articles/376765/
  */
 
+#include <algorithm>
 #include <iomanip>
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -50,26 +51,6 @@ NS_LOG_COMPONENT_DEFINE ("MinstrelHtWifiManager");
 
 namespace ns3 {
 
-///MinstrelHtWifiRemoteStation structure
-struct MinstrelHtWifiRemoteStation : MinstrelWifiRemoteStation
-{
-  uint8_t m_sampleGroup;     //!< The group that the sample rate belongs to.
-
-  uint32_t m_sampleWait;      //!< How many transmission attempts to wait until a new sample.
-  uint32_t m_sampleTries;     //!< Number of sample tries after waiting sampleWait.
-  uint32_t m_sampleCount;     //!< Max number of samples per update interval.
-  uint32_t m_numSamplesSlow;  //!< Number of times a slow rate was sampled.
-
-  uint32_t m_avgAmpduLen;      //!< Average number of MPDUs in an A-MPDU.
-  uint32_t m_ampduLen;         //!< Number of MPDUs in an A-MPDU.
-  uint32_t m_ampduPacketCount; //!< Number of A-MPDUs transmitted.
-
-  McsGroupData m_groupsTable;  //!< Table of groups with stats.
-  bool m_isHt;                 //!< If the station is HT capable.
-
-  std::ofstream m_statsFile;   //!< File where statistics table is written.
-};
-
 NS_OBJECT_ENSURE_REGISTERED (MinstrelHtWifiManager);
 
 TypeId
@@ -388,6 +369,7 @@ MinstrelHtWifiManager::DoCreateStation (void) const
   station->m_avgAmpduLen = 1;
   station->m_ampduLen = 0;
   station->m_ampduPacketCount = 0;
+  station->m_nStatsUpdates = 0;
 
   // If the device supports HT
   if (GetHtSupported () || GetVhtSupported ())
@@ -513,9 +495,7 @@ MinstrelHtWifiManager::DoReportDataFailed (WifiRemoteStation *st)
     }
   else
     {
-      uint8_t rateId = GetRateId (station->m_txrate);
-      uint8_t groupId = GetGroupId (station->m_txrate);
-      station->m_groupsTable[groupId].m_ratesTable[rateId].numRateAttempt++; // Increment the attempts counter for the rate used.
+      AddRateAttempts (station, 0, 1); // Increment the attempts counter for the rate used.
       UpdateRate (station);
     }
 }
@@ -553,10 +533,7 @@ MinstrelHtWifiManager::DoReportDataOk (WifiRemoteStation *st, double ackSnr, Wif
     }
   else
     {
-      uint8_t rateId = GetRateId (station->m_txrate);
-      uint8_t groupId = GetGroupId (station->m_txrate);
-      station->m_groupsTable[groupId].m_ratesTable[rateId].numRateSuccess++;
-      station->m_groupsTable[groupId].m_ratesTable[rateId].numRateAttempt++;
+      AddRateAttempts (station, 1, 0);
 
       UpdatePacketCounters (station, 1, 0);
 
@@ -649,10 +626,7 @@ MinstrelHtWifiManager::DoReportAmpduTxStatus (WifiRemoteStation *st, uint8_t nSu
 
   UpdatePacketCounters (station, nSuccessfulMpdus, nFailedMpdus);
 
-  uint8_t rateId = GetRateId (station->m_txrate);
-  uint8_t groupId = GetGroupId (station->m_txrate);
-  station->m_groupsTable[groupId].m_ratesTable[rateId].numRateSuccess += nSuccessfulMpdus;
-  station->m_groupsTable[groupId].m_ratesTable[rateId].numRateAttempt += nSuccessfulMpdus + nFailedMpdus;
+  AddRateAttempts (station, nSuccessfulMpdus, nFailedMpdus);
 
   if (nSuccessfulMpdus == 0 && station->m_longRetry < CountRetries (station))
     {
@@ -811,6 +785,19 @@ MinstrelHtWifiManager::UpdatePacketCounters (MinstrelHtWifiRemoteStation *statio
     }
 }
 
+void
+MinstrelHtWifiManager::AddRateAttempts (MinstrelHtWifiRemoteStation *station, uint8_t nSuccessfulMpdus, uint8_t nFailedMpdus)
+{
+  NS_LOG_FUNCTION (this << station << +nSuccessfulMpdus << +nFailedMpdus);
+  HtRateInfo &rate = station->m_groupsTable[GetGroupId (station->m_txrate)].m_ratesTable[GetRateId (station->m_txrate)];
+  if (rate.numRateAttempt == 0 && nSuccessfulMpdus + nFailedMpdus > 0)
+    {
+      station->m_sampledRates.push_back (station->m_txrate);
+    }
+  rate.numRateSuccess += nSuccessfulMpdus;
+  rate.numRateAttempt += nSuccessfulMpdus + nFailedMpdus;
+}
+
 WifiTxVector
 MinstrelHtWifiManager::DoGetDataTxVector (WifiRemoteStation *st)
 {
@@ -1129,7 +1116,7 @@ MinstrelHtWifiManager::FindRate (MinstrelHtWifiRemoteStation *station)
               else
                 {
                   station->m_numSamplesSlow++;
-                  if (sampleRateInfo.numSamplesSkipped >= 20 && station->m_numSamplesSlow <= 2)
+                  if (station->m_nStatsUpdates - sampleRateInfo.lastSampledUpdate >= 20 && station->m_numSamplesSlow <= 2)
                     {
                       /// Set flag that we are currently sampling.
                       station->m_isSampling = true;
@@ -1161,6 +1148,7 @@ MinstrelHtWifiManager::UpdateStats (MinstrelHtWifiRemoteStation *station)
   NS_LOG_FUNCTION (this << station);
 
   station->m_nextStatsUpdate = Simulator::Now () + m_updateStats;
+  station->m_nStatsUpdates++;
 
   station->m_numSamplesSlow = 0;
   station->m_sampleCount = 0;
@@ -1175,12 +1163,27 @@ MinstrelHtWifiManager::UpdateStats (MinstrelHtWifiRemoteStation *station)
       station->m_ampduPacketCount = 0;
     }
 
+  // Only the previous maximum rates had their retries updated, and only the
+  // previously sampled rates have non-zero previous counters
+  for (uint16_t index : {station->m_maxTpRate, station->m_maxTpRate2, station->m_maxProbRate})
+    {
+      if (station->m_groupsTable[GetGroupId (index)].m_supported)
+        {
+          station->m_groupsTable[GetGroupId (index)].m_ratesTable[GetRateId (index)].retryUpdated = false;
+        }
+    }
+  for (uint16_t index : station->m_prevSampledRates)
+    {
+      HtRateInfo &rate = station->m_groupsTable[GetGroupId (index)].m_ratesTable[GetRateId (index)];
+      rate.prevNumRateSuccess = 0;
+      rate.prevNumRateAttempt = 0;
+    }
+
   /* Initialize global rate indexes */
   station->m_maxTpRate = GetLowestIndex (station);
   station->m_maxTpRate2 = GetLowestIndex (station);
   station->m_maxProbRate = GetLowestIndex (station);
 
-  /// Update throughput and EWMA for each rate inside each group.
   for (uint8_t j = 0; j < m_numGroups; j++)
     {
       if (station->m_groupsTable[j].m_supported)
@@ -1191,69 +1194,75 @@ MinstrelHtWifiManager::UpdateStats (MinstrelHtWifiRemoteStation *station)
           station->m_groupsTable[j].m_maxTpRate = GetLowestIndex (station, j);
           station->m_groupsTable[j].m_maxTpRate2 = GetLowestIndex (station, j);
           station->m_groupsTable[j].m_maxProbRate = GetLowestIndex (station, j);
+        }
+    }
 
-          for (uint8_t i = 0; i < m_numRates; i++)
-            {
-              if (station->m_groupsTable[j].m_ratesTable[i].supported)
-                {
-                  station->m_groupsTable[j].m_ratesTable[i].retryUpdated = false;
+  /// Update throughput and EWMA for each rate attempted since the last update.
+  for (uint16_t index : station->m_sampledRates)
+    {
+      uint8_t j = GetGroupId (index);
+      uint8_t i = GetRateId (index);
+      HtRateInfo &rate = station->m_groupsTable[j].m_ratesTable[i];
+      NS_ASSERT (station->m_groupsTable[j].m_supported && rate.supported && rate.numRateAttempt > 0);
 
-                  NS_LOG_DEBUG (+i << " " << GetMcsSupported (station, station->m_groupsTable[j].m_ratesTable[i].mcsIndex) <<
-                                "\t attempt=" << station->m_groupsTable[j].m_ratesTable[i].numRateAttempt <<
-                                "\t success=" << station->m_groupsTable[j].m_ratesTable[i].numRateSuccess);
+      NS_LOG_DEBUG (+i << " " << GetMcsSupported (station, rate.mcsIndex) <<
+                    "\t attempt=" << rate.numRateAttempt <<
+                    "\t success=" << rate.numRateSuccess);
 
-                  /// If we've attempted something.
-                  if (station->m_groupsTable[j].m_ratesTable[i].numRateAttempt > 0)
-                    {
-                      station->m_groupsTable[j].m_ratesTable[i].numSamplesSkipped = 0;
-                      /**
-                       * Calculate the probability of success.
-                       * Assume probability scales from 0 to 100.
-                       */
-                      tempProb = (100 * station->m_groupsTable[j].m_ratesTable[i].numRateSuccess) / station->m_groupsTable[j].m_ratesTable[i].numRateAttempt;
-
-                      /// Bookkeeping.
-                      station->m_groupsTable[j].m_ratesTable[i].prob = tempProb;
+      rate.lastSampledUpdate = station->m_nStatsUpdates;
+      /**
+       * Calculate the probability of success.
+       * Assume probability scales from 0 to 100.
+       */
+      tempProb = (100 * rate.numRateSuccess) / rate.numRateAttempt;
 
-                      if (station->m_groupsTable[j].m_ratesTable[i].successHist == 0)
-                        {
-                          station->m_groupsTable[j].m_ratesTable[i].ewmaProb = tempProb;
-                        }
-                      else
-                        {
-                          station->m_groupsTable[j].m_ratesTable[i].ewmsdProb = CalculateEwmsd (station->m_groupsTable[j].m_ratesTable[i].ewmsdProb,
-                                                                                                tempProb, station->m_groupsTable[j].m_ratesTable[i].ewmaProb,
-                                                                                                m_ewmaLevel);
-                          /// EWMA probability
-                          tempProb = (tempProb * (100 - m_ewmaLevel) + station->m_groupsTable[j].m_ratesTable[i].ewmaProb * m_ewmaLevel)  / 100;
-                          station->m_groupsTable[j].m_ratesTable[i].ewmaProb = tempProb;
-                        }
+      /// Bookkeeping.
+      rate.prob = tempProb;
 
-                      station->m_groupsTable[j].m_ratesTable[i].throughput = CalculateThroughput (station, j, i, tempProb);
+      if (rate.successHist == 0)
+        {
+          rate.ewmaProb = tempProb;
+        }
+      else
+        {
+          rate.ewmsdProb = CalculateEwmsd (rate.ewmsdProb, tempProb, rate.ewmaProb, m_ewmaLevel);
+          /// EWMA probability
+          tempProb = (tempProb * (100 - m_ewmaLevel) + rate.ewmaProb * m_ewmaLevel)  / 100;
+          rate.ewmaProb = tempProb;
+        }
 
-                      station->m_groupsTable[j].m_ratesTable[i].successHist += station->m_groupsTable[j].m_ratesTable[i].numRateSuccess;
-                      station->m_groupsTable[j].m_ratesTable[i].attemptHist += station->m_groupsTable[j].m_ratesTable[i].numRateAttempt;
-                    }
-                  else
-                    {
-                      station->m_groupsTable[j].m_ratesTable[i].numSamplesSkipped++;
-                    }
+      bool candidate = (rate.throughput != 0);
+      rate.throughput = CalculateThroughput (station, j, i, tempProb);
+      if ((rate.throughput != 0) != candidate)
+        {
+          auto it = std::lower_bound (station->m_candidateRates.begin (), station->m_candidateRates.end (), index);
+          if (candidate)
+            {
+              station->m_candidateRates.erase (it);
+            }
+          else
+            {
+              station->m_candidateRates.insert (it, index);
+            }
+        }
 
-                  /// Bookkeeping.
-                  station->m_groupsTable[j].m_ratesTable[i].prevNumRateSuccess = station->m_groupsTable[j].m_ratesTable[i].numRateSuccess;
-                  station->m_groupsTable[j].m_ratesTable[i].prevNumRateAttempt = station->m_groupsTable[j].m_ratesTable[i].numRateAttempt;
-                  station->m_groupsTable[j].m_ratesTable[i].numRateSuccess = 0;
-                  station->m_groupsTable[j].m_ratesTable[i].numRateAttempt = 0;
+      rate.successHist += rate.numRateSuccess;
+      rate.attemptHist += rate.numRateAttempt;
 
-                  if (station->m_groupsTable[j].m_ratesTable[i].throughput != 0)
-                    {
-                      SetBestStationThRates (station, GetIndex (j, i));
-                      SetBestProbabilityRate (station, GetIndex (j, i));
-                    }
+      /// Bookkeeping.
+      rate.prevNumRateSuccess = rate.numRateSuccess;
+      rate.prevNumRateAttempt = rate.numRateAttempt;
+      rate.numRateSuccess = 0;
+      rate.numRateAttempt = 0;
+    }
+  station->m_prevSampledRates.swap (station->m_sampledRates);
+  station->m_sampledRates.clear ();
 
-                }
-            }
-        }
+  /// Find the maximum throughput and probability rates, in increasing order.
+  for (uint16_t index : station->m_candidateRates)
+    {
+      SetBestStationThRates (station, index);
+      SetBestProbabilityRate (station, index);
     }
 
   //Try to sample all available rates during each interval.
@@ -1427,6 +1436,9 @@ MinstrelHtWifiManager::RateInit (MinstrelHtWifiRemoteStation *station)
   NS_LOG_FUNCTION (this << station);
 
   station->m_groupsTable = McsGroupData (m_numGroups);
+  station->m_sampledRates.clear ();
+  station->m_prevSampledRates.clear ();
+  station->m_candidateRates.clear ();
 
   /**
   * Initialize groups supported by the receiver.
@@ -1485,11 +1497,12 @@ MinstrelHtWifiManager::RateInit (MinstrelHtWifiRemoteStation *station)
                       station->m_groupsTable[groupId].m_ratesTable[rateId].ewmaProb = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].prevNumRateAttempt = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].prevNumRateSuccess = 0;
-                      station->m_groupsTable[groupId].m_ratesTable[rateId].numSamplesSkipped = 0;
+                      station->m_groupsTable[groupId].m_ratesTable[rateId].lastSampledUpdate = station->m_nStatsUpdates;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].successHist = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].attemptHist = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].throughput = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].perfectTxTime = GetFirstMpduTxTime (groupId, GetMcsSupported (station, i));
+                      station->m_groupsTable[groupId].m_ratesTable[rateId].mpduTxTime = GetMpduTxTime (groupId, GetMcsSupported (station, i));
                       station->m_groupsTable[groupId].m_ratesTable[rateId].retryCount = 0;
                       station->m_groupsTable[groupId].m_ratesTable[rateId].adjustedRetryCount = 0;
                       CalculateRetransmits (station, groupId, rateId);
@@ -1535,8 +1548,8 @@ MinstrelHtWifiManager::CalculateRetransmits (MinstrelHtWifiRemoteStation *statio
       station->m_groupsTable[groupId].m_ratesTable[rateId].retryCount = 2;
       station->m_groupsTable[groupId].m_ratesTable[rateId].retryUpdated = true;
 
-      dataTxTime = GetFirstMpduTxTime (groupId, GetMcsSupported (station, station->m_groupsTable[groupId].m_ratesTable[rateId].mcsIndex)) +
-        GetMpduTxTime (groupId, GetMcsSupported (station, station->m_groupsTable[groupId].m_ratesTable[rateId].mcsIndex)) * (station->m_avgAmpduLen - 1);
+      dataTxTime = station->m_groupsTable[groupId].m_ratesTable[rateId].perfectTxTime +
+        station->m_groupsTable[groupId].m_ratesTable[rateId].mpduTxTime * (station->m_avgAmpduLen - 1);
 
       /* Contention time for first 2 tries */
       cwTime = (cw / 2) * slotTime;
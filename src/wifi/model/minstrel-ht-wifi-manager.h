@@ -30,6 +30,8 @@
 #include "minstrel-wifi-manager.h"
 #include "wifi-mpdu-type.h"
 
+class MinstrelHtFullScanTestCase;
+
 namespace ns3 {
 
 /**
@@ -62,7 +64,6 @@ struct McsGroup
  */
 typedef std::vector<McsGroup> MinstrelMcsGroups;
 
-struct MinstrelHtWifiRemoteStation;
 /**
  * A struct to contain all statistics information related to a data rate.
  */
@@ -73,6 +74,7 @@ struct HtRateInfo
    * Given a bit rate and a packet length n bytes.
    */
   Time perfectTxTime;
+  Time mpduTxTime;              //!< Transmission time of the MPDUs following the first one in an A-MPDU.
   bool supported;               //!< If the rate is supported.
   uint8_t mcsIndex;             //!< The index in the operationalMcsSet of the WifiRemoteStationManager.
   uint32_t retryCount;          //!< Retry limit.
@@ -90,7 +92,7 @@ struct HtRateInfo
   double ewmsdProb;             //!< Exponential weighted moving standard deviation of probability.
   uint32_t prevNumRateAttempt;  //!< Number of transmission attempts with previous rate.
   uint32_t prevNumRateSuccess;  //!< Number of successful frames transmitted with previous rate.
-  uint32_t numSamplesSkipped;   //!< Number of times this rate statistics were not updated because no attempts have been made.
+  uint32_t lastSampledUpdate;   //!< Number of statistics updates of the station when attempts were last made with this rate.
   uint64_t successHist;         //!< Aggregate of all transmission successes.
   uint64_t attemptHist;         //!< Aggregate of all transmission attempts.
   double throughput;            //!< Throughput of this rate (in pkts per second).
@@ -125,6 +127,36 @@ struct GroupInfo
  */
 typedef std::vector<struct GroupInfo> McsGroupData;
 
+/**
+ * MinstrelHtWifiRemoteStation structure
+ *
+ * This struct extends from MinstrelWifiRemoteStation struct to hold the
+ * per-group statistics required by the Minstrel-HT Wifi manager
+ */
+struct MinstrelHtWifiRemoteStation : MinstrelWifiRemoteStation
+{
+  uint8_t m_sampleGroup;     //!< The group that the sample rate belongs to.
+
+  uint32_t m_sampleWait;      //!< How many transmission attempts to wait until a new sample.
+  uint32_t m_sampleTries;     //!< Number of sample tries after waiting sampleWait.
+  uint32_t m_sampleCount;     //!< Max number of samples per update interval.
+  uint32_t m_numSamplesSlow;  //!< Number of times a slow rate was sampled.
+
+  uint32_t m_avgAmpduLen;      //!< Average number of MPDUs in an A-MPDU.
+  uint32_t m_ampduLen;         //!< Number of MPDUs in an A-MPDU.
+  uint32_t m_ampduPacketCount; //!< Number of A-MPDUs transmitted.
+
+  McsGroupData m_groupsTable;  //!< Table of groups with stats.
+  bool m_isHt;                 //!< If the station is HT capable.
+
+  uint32_t m_nStatsUpdates;                 //!< Number of statistics updates.
+  std::vector<uint16_t> m_sampledRates;     //!< Rates attempted since the last statistics update.
+  std::vector<uint16_t> m_prevSampledRates; //!< Rates attempted before the last statistics update.
+  std::vector<uint16_t> m_candidateRates;   //!< Rates with a non-zero throughput, in increasing order.
+
+  std::ofstream m_statsFile;   //!< File where statistics table is written.
+};
+
 /**
  * Constants for maximum values.
  */
@@ -216,6 +248,12 @@ public:
 
 
 private:
+  /**
+   * \brief MinstrelHtFullScanTestCase test case.
+   * \relates MinstrelHtFullScanTestCase
+   */
+  friend class ::MinstrelHtFullScanTestCase;
+
   // Overridden from base class.
   void DoInitialize (void);
   WifiRemoteStation * DoCreateStation (void) const;
@@ -313,6 +351,16 @@ private:
    */
   void UpdatePacketCounters (MinstrelHtWifiRemoteStation *station, uint8_t nSuccessfulMpdus, uint8_t nFailedMpdus);
 
+  /**
+   * Count the attempts made with the current rate, which is noted as
+   * sampled for the next statistics update.
+   *
+   * \param station the minstrel HT wifi remote station
+   * \param nSuccessfulMpdus the number of successfully transmitted MPDUs
+   * \param nFailedMpdus the number of MPDUs which failed
+   */
+  void AddRateAttempts (MinstrelHtWifiRemoteStation *station, uint8_t nSuccessfulMpdus, uint8_t nFailedMpdus);
+
   /**
    * Getting the next sample from Sample Table.
    *
@@ -339,6 +387,10 @@ private:
   /**
    * Updating the Minstrel Table every 1/10 seconds.
    *
+   * Only the statistics of the rates attempted since the last update are
+   * computed again, and only the rates with a non-zero throughput are
+   * considered for the maximum throughput and probability rates.
+   *
    * \param station the minstrel HT wifi remote station
    */
   void UpdateStats (MinstrelHtWifiRemoteStation *station);
@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+#include "ns3/core-config.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/object-factory.h"
+#include "tabulated-error-rate-model.h"
+#include "nist-error-rate-model.h"
+#include "wifi-tx-vector.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TabulatedErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TabulatedErrorRateModel);
+
+/// The points of an interval are at least 2^-MIN_SHIFT dB apart
+static const uint8_t MIN_SHIFT = 2;
+/// The points of an interval are at most 2^-MAX_SHIFT dB apart
+static const uint8_t MAX_SHIFT = 10;
+/**
+ * Interpolation errors on ln S below this value are accepted whatever the
+ * accuracy: they are of the order of the rounding of 1 - BER in the models.
+ */
+static const double LOG_SUCCESS_RATE_FLOOR = 1e-15;
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \return the mutex protecting the tables shared by the instances, which
+ *         may be used on the threads of the WifiRxThreadPool
+ */
+static SystemMutex &
+GetTablesMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+#endif /* HAVE_PTHREAD_H */
+
+TypeId
+TabulatedErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TabulatedErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TabulatedErrorRateModel> ()
+    .AddAttribute ("Model",
+                   "The type of the error rate model whose success rates are tabulated.",
+                   TypeIdValue (NistErrorRateModel::GetTypeId ()),
+                   MakeTypeIdAccessor (&TabulatedErrorRateModel::SetModelType,
+                                       &TabulatedErrorRateModel::GetModelType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("MinSnr",
+                   "The lowest tabulated SNR (dB).",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_minSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest tabulated SNR (dB).",
+                   DoubleValue (60.0),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_maxSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Accuracy",
+                   "The maximum absolute difference between the tabulated chunk success rates "
+                   "and those of the model.",
+                   DoubleValue (1e-4),
+                   MakeDoubleAccessor (&TabulatedErrorRateModel::m_accuracy),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TabulatedErrorRateModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_model = 0;
+  m_tables.clear ();
+  ErrorRateModel::DoDispose ();
+}
+
+void
+TabulatedErrorRateModel::SetModelType (TypeId modelTypeId)
+{
+  NS_LOG_FUNCTION (this << modelTypeId);
+  // The wrapped model is created here, by the thread configuring this
+  // instance, since creating objects is not thread-safe
+  ObjectFactory factory;
+  factory.SetTypeId (modelTypeId);
+  m_model = factory.Create<ErrorRateModel> ();
+  NS_ABORT_MSG_IF (m_model == 0, modelTypeId.GetName () << " is not an error rate model");
+  m_modelTypeId = modelTypeId;
+  m_tables.clear ();
+}
+
+TypeId
+TabulatedErrorRateModel::GetModelType (void) const
+{
+  return m_modelTypeId;
+}
+
+Ptr<ErrorRateModel>
+TabulatedErrorRateModel::GetModel (void) const
+{
+  return m_model;
+}
+
+double
+TabulatedErrorRateModel::GetLogLogSuccessRate (WifiMode mode, WifiTxVector txVector, double snrDb) const
+{
+  double successRate = m_model->GetChunkSuccessRate (mode, txVector, std::pow (10.0, snrDb / 10.0), 1);
+  return std::log (-std::log (successRate));
+}
+
+const TabulatedErrorRateModel::Table *
+TabulatedErrorRateModel::BuildTable (WifiMode mode, WifiTxVector txVector) const
+{
+  NS_LOG_FUNCTION (this << mode);
+  NS_ABORT_MSG_UNLESS (m_minSnr < m_maxSnr, "The tabulated SNR range is empty");
+  NS_ABORT_MSG_UNLESS (m_accuracy > 0, "The accuracy of the tables must be positive");
+
+  // The tables only depend on the wrapped model, the mode and the attributes.
+  // They are kept until the end of the program, so that the instances only
+  // hold plain pointers to them, whatever the thread they run on.
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetTablesMutex ());
+#endif /* HAVE_PTHREAD_H */
+  typedef std::tuple<uint16_t, uint32_t, double, double, double> Key;
+  static std::map<Key, Table> tables;
+  Key key (m_modelTypeId.GetUid (), mode.GetUid (), m_minSnr, m_maxSnr, m_accuracy);
+  std::pair<std::map<Key, Table>::iterator, bool> inserted = tables.insert (std::make_pair (key, Table ()));
+  Table *table = &inserted.first->second;
+  if (!inserted.second)
+    {
+      return table;
+    }
+
+  uint32_t nIntervals = static_cast<uint32_t> (std::ceil (m_maxSnr - m_minSnr));
+  table->intervals.resize (nIntervals);
+  for (uint32_t k = 0; k < nIntervals; ++k)
+    {
+      Table::Interval &interval = table->intervals[k];
+      double start = m_minSnr + k;
+      std::vector<double> points;
+      for (uint32_t j = 0; j <= (1U << MIN_SHIFT); ++j)
+        {
+          points.push_back (GetLogLogSuccessRate (mode, txVector, start + std::ldexp (j, -MIN_SHIFT)));
+        }
+      for (uint8_t shift = MIN_SHIFT; ; ++shift)
+        {
+          // Check the interpolation at the midpoints, which are the
+          // additional points of the next refinement
+          std::vector<double> refined (2 * points.size () - 1);
+          bool accurate = true;
+          for (uint32_t j = 0; j + 1 < points.size (); ++j)
+            {
+              double midpoint = GetLogLogSuccessRate (mode, txVector, start + std::ldexp (2 * j + 1, -(shift + 1)));
+              refined[2 * j] = points[j];
+              refined[2 * j + 1] = midpoint;
+              if (!std::isfinite (points[j]) || !std::isfinite (points[j + 1]))
+                {
+                  // Not interpolated
+                  continue;
+                }
+              double interpolated = (points[j] + points[j + 1]) / 2;
+              if (std::abs (interpolated - midpoint) > m_accuracy
+                  && std::abs (std::exp (interpolated) - std::exp (midpoint)) > LOG_SUCCESS_RATE_FLOOR)
+                {
+                  accurate = false;
+                }
+            }
+          refined.back () = points.back ();
+          if (accurate)
+            {
+              interval.offset = table->values.size ();
+              interval.shift = shift;
+              interval.exact = false;
+              table->values.insert (table->values.end (), points.begin (), points.end ());
+              break;
+            }
+          if (shift == MAX_SHIFT)
+            {
+              NS_LOG_DEBUG ("Cannot tabulate " << mode << " between " << start << " and " << start + 1 << " dB");
+              interval.offset = 0;
+              interval.shift = 0;
+              interval.exact = true;
+              break;
+            }
+          points.swap (refined);
+        }
+    }
+  NS_LOG_DEBUG ("Tabulated " << mode << " with " << table->values.size () << " points");
+  return table;
+}
+
+double
+TabulatedErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const
+{
+  NS_LOG_FUNCTION (this << mode << txVector.GetMode () << snr << nbits);
+  double snrDb = 10.0 * std::log10 (snr);
+  if (!(snrDb >= m_minSnr && snrDb < m_maxSnr))
+    {
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint32_t uid = mode.GetUid ();
+  if (uid >= m_tables.size ())
+    {
+      m_tables.resize (uid + 1);
+    }
+  if (m_tables[uid] == 0)
+    {
+      m_tables[uid] = BuildTable (mode, txVector);
+    }
+  const Table &table = *m_tables[uid];
+
+  double position = snrDb - m_minSnr;
+  uint32_t k = static_cast<uint32_t> (position);
+  const Table::Interval &interval = table.intervals[k];
+  if (interval.exact)
+    {
+      return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  position = std::ldexp (position - k, interval.shift);
+  uint32_t j = std::min (static_cast<uint32_t> (position), (1U << interval.shift) - 1);
+  double low = table.values[interval.offset + j];
+  double high = table.values[interval.offset + j + 1];
+  if (std::isfinite (low) && std::isfinite (high))
+    {
+      double y = low + (position - j) * (high - low);
+      return std::exp (-std::exp (y) * static_cast<double> (nbits));
+    }
+  // The success rate of a bit is 1 (or 0) at both ends, and therefore in
+  // between, as the model is monotonic in the SNR
+  if (low == high)
+    {
+      return (low < 0 || nbits == 0) ? 1.0 : 0.0;
+    }
+  return m_model->GetChunkSuccessRate (mode, txVector, snr, nbits);
+}
+
+} //namespace ns3
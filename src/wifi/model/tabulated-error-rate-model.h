@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABULATED_ERROR_RATE_MODEL_H
+#define TABULATED_ERROR_RATE_MODEL_H
+
+#include <vector>
+#include "ns3/type-id.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * An error rate model which looks up the success rates of another model
+ * in precomputed tables instead of evaluating them.
+ *
+ * The wrapped model (NistErrorRateModel by default) is expected to give
+ * a chunk success rate of the form S(mode, snr)^nbits, as the Nist, Yans
+ * and DSSS models do. For each mode, ln (-ln S) is tabulated against the
+ * SNR in dB, on a grid whose step is refined in each 1 dB interval until
+ * the linear interpolation between the grid points stays within the
+ * configured accuracy. A lookup then costs a logarithm and two
+ * exponentials, whatever the modulation and the number of bits.
+ *
+ * The tables of a mode are built on its first use and are shared by all
+ * the instances tabulating the same model with the same parameters. SNRs
+ * outside the tabulated range, and the intervals where the wrapped model
+ * saturates or cannot be interpolated accurately enough, are passed to
+ * the wrapped model. The wrapped model is created along with this one, so
+ * that the receptions computed on the threads of the WifiRxThreadPool only
+ * use it.
+ */
+class TabulatedErrorRateModel : public ErrorRateModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TabulatedErrorRateModel ();
+  virtual ~TabulatedErrorRateModel ();
+
+  /**
+   * \return the wrapped error rate model
+   */
+  Ptr<ErrorRateModel> GetModel (void) const;
+
+  double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint64_t nbits) const;
+
+
+private:
+  virtual void DoDispose (void);
+
+  /**
+   * Set the type of the wrapped model, and create it.
+   *
+   * \param modelTypeId the type of the wrapped model
+   */
+  void SetModelType (TypeId modelTypeId);
+  /**
+   * \return the type of the wrapped model
+   */
+  TypeId GetModelType (void) const;
+
+  /**
+   * The table of a mode.
+   */
+  struct Table
+  {
+    /**
+     * A 1 dB interval of the table.
+     */
+    struct Interval
+    {
+      uint32_t offset; //!< index of the first point of the interval
+      uint8_t shift;   //!< the points are 2^-shift dB apart
+      bool exact;      //!< whether the wrapped model is used in this interval
+    };
+    std::vector<Interval> intervals; //!< the intervals, from the minimum SNR
+    std::vector<double> values;      //!< ln (-ln S) at the points of the intervals
+  };
+
+  /**
+   * Get the table of a mode, shared by the instances tabulating the same
+   * model with the same parameters, and build it if needed.
+   *
+   * \param mode the Wi-Fi mode
+   * \param txVector TXVECTOR passed to the wrapped model
+   * \return the table, which is never freed
+   */
+  const Table * BuildTable (WifiMode mode, WifiTxVector txVector) const;
+  /**
+   * \param mode the Wi-Fi mode
+   * \param txVector TXVECTOR passed to the wrapped model
+   * \param snrDb the SNR (dB)
+   * \return ln (-ln S) for the given mode and SNR, where S is the success
+   *         rate of a single bit
+   */
+  double GetLogLogSuccessRate (WifiMode mode, WifiTxVector txVector, double snrDb) const;
+
+  TypeId m_modelTypeId;                            //!< the type of the wrapped model
+  double m_minSnr;                                 //!< lowest tabulated SNR (dB)
+  double m_maxSnr;                                 //!< highest tabulated SNR (dB)
+  double m_accuracy;                               //!< maximum error of the success rates
+  Ptr<ErrorRateModel> m_model;                     //!< the wrapped model
+  mutable std::vector<const Table *> m_tables;     //!< tables indexed by mode UID
+};
+
+} //namespace ns3
+
+#endif /* TABULATED_ERROR_RATE_MODEL_H */
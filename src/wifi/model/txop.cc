@@ -263,6 +263,10 @@ Txop::StartBackoffNow (uint32_t nSlots)
     }
   m_backoffSlots = nSlots;
   m_backoffStart = Simulator::Now ();
+  if (m_channelAccessManager != 0 && IsAccessRequested ())
+    {
+      m_channelAccessManager->NotifyBackoffStartNow ();
+    }
 }
 
 void
@@ -38,6 +38,8 @@
 #include "he-configuration.h"
 #include "mpdu-aggregator.h"
 #include "wifi-phy-header.h"
+#include "wifi-ppdu.h"
+#include "wifi-rx-thread-pool.h"
 
 namespace ns3 {
 
@@ -324,6 +326,20 @@ WifiPhy::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&WifiPhy::m_postReceptionErrorModel),
                    MakePointerChecker<ErrorModel> ())
+    .AddAttribute ("DurationCacheSize",
+                   "The maximum number of frame durations remembered by CalculateTxDuration "
+                   "and GetPayloadDuration. Zero disables the cache.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&WifiPhy::m_durationCacheSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Abstraction",
+                   "If true, the reception of a packet is decided at its end from a single "
+                   "effective SNR (EESM) over its whole duration, instead of going through "
+                   "the preamble, PHY header and payload reception steps. The preamble "
+                   "detection model, if any, is applied when the packet arrives.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&WifiPhy::m_abstraction),
+                   MakeBooleanChecker ())
     .AddTraceSource ("PhyTxBegin",
                      "Trace source indicating a packet "
                      "has begun transmitting over the channel medium",
@@ -396,9 +412,13 @@ WifiPhy::WifiPhy ()
     m_initialChannelNumber (0),
     m_totalAmpduSize (0),
     m_totalAmpduNumSymbols (0),
+    m_durationCacheSize (0),
+    m_durationCacheHits (0),
+    m_durationCacheMisses (0),
     m_currentEvent (0),
     m_wifiRadioEnergyModel (0),
-    m_timeLastPreambleDetected (Seconds (0))
+    m_timeLastPreambleDetected (Seconds (0)),
+    m_abstraction (false)
 {
   NS_LOG_FUNCTION (this);
   m_random = CreateObject<UniformRandomVariable> ();
@@ -421,9 +441,21 @@ WifiPhy::DoDispose (void)
   m_mobility = 0;
   m_state = 0;
   m_wifiRadioEnergyModel = 0;
+  m_rxThresholdChangedCallback = MakeNullCallback<void> ();
   m_postReceptionErrorModel = 0;
   m_deviceRateSet.clear ();
   m_deviceMcsSet.clear ();
+  m_durationCache.clear ();
+  if (m_currentPpdu != 0)
+    {
+      WifiRxThreadPool *pool = WifiRxThreadPool::Get ();
+      if (pool != 0)
+        {
+          pool->RemoveReceiver (m_currentPpdu, this);
+        }
+      m_currentPpdu = 0;
+    }
+  m_rxOutcome.event = 0;
 }
 
 void
@@ -475,6 +507,12 @@ WifiPhy::SetCapabilitiesChangedCallback (Callback<void> callback)
   m_capabilitiesChangedCallback = callback;
 }
 
+void
+WifiPhy::SetRxThresholdChangedCallback (Callback<void> callback)
+{
+  m_rxThresholdChangedCallback = callback;
+}
+
 void
 WifiPhy::InitializeFrequencyChannelNumber (void)
 {
@@ -514,6 +552,10 @@ WifiPhy::SetRxSensitivity (double threshold)
 {
   NS_LOG_FUNCTION (this << threshold);
   m_rxSensitivityW = DbmToW (threshold);
+  if (!m_rxThresholdChangedCallback.IsNull ())
+    {
+      m_rxThresholdChangedCallback ();
+    }
 }
 
 double
@@ -600,6 +642,10 @@ WifiPhy::SetRxGain (double gain)
 {
   NS_LOG_FUNCTION (this << gain);
   m_rxGainDb = gain;
+  if (!m_rxThresholdChangedCallback.IsNull ())
+    {
+      m_rxThresholdChangedCallback ();
+    }
 }
 
 double
@@ -2050,6 +2096,100 @@ WifiPhy::GetPayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t freq
 Time
 WifiPhy::GetPayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t frequency,
                              MpduType mpdutype, uint8_t incFlag)
+{
+  return GetDurations (size, txVector, frequency, mpdutype, incFlag).payload;
+}
+
+bool
+WifiPhy::DurationKey::operator== (const DurationKey &other) const
+{
+  return txVector == other.txVector && frame == other.frame
+         && ampduSize == other.ampduSize && ampduSymbols == other.ampduSymbols;
+}
+
+std::size_t
+WifiPhy::DurationKeyHash::operator() (const DurationKey &key) const
+{
+  uint64_t hash = key.txVector * 0x9e3779b97f4a7c15ULL;
+  hash = (hash ^ (hash >> 29) ^ key.frame) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 31) ^ key.ampduSize) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 32) ^ std::hash<double> () (key.ampduSymbols);
+}
+
+WifiPhy::Durations
+WifiPhy::GetDurations (uint32_t size, WifiTxVector txVector, uint16_t frequency,
+                       MpduType mpdutype, uint8_t incFlag)
+{
+  NS_ASSERT (txVector.GetChannelWidth () < 0x10000 && txVector.GetGuardInterval () < 0x10000);
+  NS_ASSERT (txVector.GetNss () < 0x10 && txVector.GetNess () < 0x10);
+  DurationKey key;
+  key.txVector = (static_cast<uint64_t> (txVector.GetMode ().GetUid ()) << 32)
+    | (static_cast<uint64_t> (txVector.GetChannelWidth ()) << 16)
+    | txVector.GetGuardInterval ();
+  key.frame = (static_cast<uint64_t> (size) << 32)
+    | (static_cast<uint64_t> (frequency) << 16)
+    | (static_cast<uint64_t> (mpdutype) << 13)
+    | (static_cast<uint64_t> (txVector.GetPreambleType ()) << 9)
+    | (static_cast<uint64_t> (txVector.GetNss ()) << 5)
+    | (static_cast<uint64_t> (txVector.GetNess ()) << 1)
+    | (txVector.IsStbc () ? 1 : 0);
+  // Only the duration of the last MPDU of an A-MPDU depends on the previous ones
+  key.ampduSize = (mpdutype == LAST_MPDU_IN_AGGREGATE) ? m_totalAmpduSize : 0;
+  key.ampduSymbols = (mpdutype == LAST_MPDU_IN_AGGREGATE) ? m_totalAmpduNumSymbols : 0;
+
+  Durations durations;
+  auto it = m_durationCache.find (key);
+  if (it != m_durationCache.end ())
+    {
+      m_durationCacheHits++;
+      durations = it->second;
+    }
+  else
+    {
+      m_durationCacheMisses++;
+      durations.preambleAndHeader = CalculatePlcpPreambleAndHeaderDuration (txVector);
+      durations.payload = ComputePayloadDuration (size, txVector, frequency, mpdutype, durations.numSymbols);
+      if (m_durationCacheSize > 0)
+        {
+          if (m_durationCache.size () >= m_durationCacheSize)
+            {
+              m_durationCache.clear ();
+            }
+          m_durationCache.insert (std::make_pair (key, durations));
+        }
+    }
+
+  if (incFlag == 1)
+    {
+      if (mpdutype == FIRST_MPDU_IN_AGGREGATE || mpdutype == MIDDLE_MPDU_IN_AGGREGATE)
+        {
+          m_totalAmpduSize += size;
+          m_totalAmpduNumSymbols += durations.numSymbols;
+        }
+      else if (mpdutype == LAST_MPDU_IN_AGGREGATE)
+        {
+          m_totalAmpduSize = 0;
+          m_totalAmpduNumSymbols = 0;
+        }
+    }
+  return durations;
+}
+
+uint64_t
+WifiPhy::GetDurationCacheHits (void) const
+{
+  return m_durationCacheHits;
+}
+
+uint64_t
+WifiPhy::GetDurationCacheMisses (void) const
+{
+  return m_durationCacheMisses;
+}
+
+Time
+WifiPhy::ComputePayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t frequency,
+                                 MpduType mpdutype, double &numSymbols) const
 {
   WifiMode payloadMode = txVector.GetMode ();
   NS_LOG_FUNCTION (size << payloadMode);
@@ -2222,26 +2362,16 @@ WifiPhy::GetPayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t freq
 
   double numDataBitsPerSymbol = payloadMode.GetDataRate (txVector) * symbolDuration.GetNanoSeconds () / 1e9;
 
-  double numSymbols = 0;
+  numSymbols = 0;
   if (mpdutype == FIRST_MPDU_IN_AGGREGATE)
     {
       //First packet in an A-MPDU
       numSymbols = (stbc * (16 + size * 8.0 + 6 * Nes) / (stbc * numDataBitsPerSymbol));
-      if (incFlag == 1)
-        {
-          m_totalAmpduSize += size;
-          m_totalAmpduNumSymbols += numSymbols;
-        }
     }
   else if (mpdutype == MIDDLE_MPDU_IN_AGGREGATE)
     {
       //consecutive packets in an A-MPDU
       numSymbols = (stbc * size * 8.0) / (stbc * numDataBitsPerSymbol);
-      if (incFlag == 1)
-        {
-          m_totalAmpduSize += size;
-          m_totalAmpduNumSymbols += numSymbols;
-        }
     }
   else if (mpdutype == LAST_MPDU_IN_AGGREGATE)
     {
@@ -2250,11 +2380,6 @@ WifiPhy::GetPayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t freq
       numSymbols = lrint (stbc * ceil ((16 + totalAmpduSize * 8.0 + 6 * Nes) / (stbc * numDataBitsPerSymbol)));
       NS_ASSERT (m_totalAmpduNumSymbols <= numSymbols);
       numSymbols -= m_totalAmpduNumSymbols;
-      if (incFlag == 1)
-        {
-          m_totalAmpduSize = 0;
-          m_totalAmpduNumSymbols = 0;
-        }
     }
   else if (mpdutype == NORMAL_MPDU || mpdutype == SINGLE_MPDU)
     {
@@ -2335,9 +2460,8 @@ Time
 WifiPhy::CalculateTxDuration (uint32_t size, WifiTxVector txVector, uint16_t frequency,
                               MpduType mpdutype, uint8_t incFlag)
 {
-  Time duration = CalculatePlcpPreambleAndHeaderDuration (txVector)
-    + GetPayloadDuration (size, txVector, frequency, mpdutype, incFlag);
-  return duration;
+  Durations durations = GetDurations (size, txVector, frequency, mpdutype, incFlag);
+  return durations.preambleAndHeader + durations.payload;
 }
 
 Time
@@ -2741,30 +2865,19 @@ WifiPhy::ContinueReceiveHeader (Ptr<Event> event)
 }
 
 void
-WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDuration)
-{
-  NS_LOG_FUNCTION (this << packet << rxPowerW << rxDuration);
-  WifiPhyTag tag;
-  bool found = packet->RemovePacketTag (tag);
-  if (!found)
-    {
-      NS_FATAL_ERROR ("Received Wi-Fi Signal with no WifiPhyTag");
-      return;
-    }
-
-  WifiPreamble preamble = tag.GetPreambleType ();
-  WifiModulationClass modulation = tag.GetModulation ();
+WifiPhy::StartReceivePreamble (Ptr<const WifiPpdu> ppdu, double rxPowerW, Time rxDuration)
+{
+  NS_LOG_FUNCTION (this << ppdu << rxPowerW << rxDuration);
+  // The PHY headers were decoded when the PPDU was created; only the
+  // matching with the modes of this PHY is done here
+  Ptr<const Packet> packet = ppdu->GetPsdu ();
+  WifiPreamble preamble = ppdu->GetPreambleType ();
+  WifiModulationClass modulation = ppdu->GetModulation ();
   WifiTxVector txVector;
   txVector.SetPreambleType (preamble);
   if ((modulation == WIFI_MOD_CLASS_DSSS) || (modulation == WIFI_MOD_CLASS_HR_DSSS))
     {
-      DsssSigHeader dsssSigHdr;
-      found = packet->RemoveHeader (dsssSigHdr);
-      if (!found)
-        {
-          NS_FATAL_ERROR ("Received 802.11b signal with no SIG field");
-          return;
-        }
+      const DsssSigHeader &dsssSigHdr = ppdu->GetDsssSigHeader ();
       txVector.SetChannelWidth (22);
       for (uint8_t i = 0; i < GetNModes (); i++)
         {
@@ -2779,13 +2892,7 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
     }
   else if ((modulation != WIFI_MOD_CLASS_HT) || (preamble != WIFI_PREAMBLE_HT_GF))
     {
-      LSigHeader lSigHdr;
-      found = packet->RemoveHeader (lSigHdr);
-      if (!found)
-        {
-          NS_FATAL_ERROR ("Received OFDM 802.11 signal with no SIG field");
-          return;
-        }
+      const LSigHeader &lSigHdr = ppdu->GetLSigHeader ();
       uint16_t channelWidth = GetChannelWidth ();
       txVector.SetChannelWidth (channelWidth > 20 ? 20 : channelWidth);
       for (uint8_t i = 0; i < GetNModes (); i++)
@@ -2800,13 +2907,7 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
     }
   if (modulation == WIFI_MOD_CLASS_HT)
     {
-      HtSigHeader htSigHdr;
-      found = packet->RemoveHeader (htSigHdr);
-      if (!found)
-        {
-          NS_FATAL_ERROR ("Received 802.11n signal with no HT-SIG field");
-          return;
-        }
+      const HtSigHeader &htSigHdr = ppdu->GetHtSigHeader ();
       txVector.SetChannelWidth (htSigHdr.GetChannelWidth ());
       for (uint8_t i = 0; i < GetNMcs (); i++)
         {
@@ -2823,14 +2924,7 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
     }
   else if (modulation == WIFI_MOD_CLASS_VHT)
     {
-      VhtSigHeader vhtSigHdr;
-      vhtSigHdr.SetMuFlag (preamble == WIFI_PREAMBLE_VHT_MU);
-      found = packet->RemoveHeader (vhtSigHdr);
-      if (!found)
-        {
-          NS_FATAL_ERROR ("Received 802.11ac signal with no VHT-SIG field");
-          return;
-        }
+      const VhtSigHeader &vhtSigHdr = ppdu->GetVhtSigHeader ();
       txVector.SetChannelWidth (vhtSigHdr.GetChannelWidth ());
       txVector.SetNss (vhtSigHdr.GetNStreams ());
       for (uint8_t i = 0; i < GetNMcs (); i++)
@@ -2850,14 +2944,7 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
     }
   else if (modulation == WIFI_MOD_CLASS_HE)
     {
-      HeSigHeader heSigHdr;
-      heSigHdr.SetMuFlag (preamble == WIFI_PREAMBLE_HE_MU);
-      found = packet->RemoveHeader (heSigHdr);
-      if (!found)
-        {
-          NS_FATAL_ERROR ("Received 802.11ax signal with no HE-SIG field");
-          return;
-        }
+      const HeSigHeader &heSigHdr = ppdu->GetHeSigHeader ();
       txVector.SetChannelWidth (heSigHdr.GetChannelWidth ());
       txVector.SetNss (heSigHdr.GetNStreams ());
       for (uint8_t i = 0; i < GetNMcs (); i++)
@@ -2889,7 +2976,7 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
       return;
     }
 
-  if (tag.GetFrameComplete () == 0)
+  if (!ppdu->IsFrameComplete ())
     {
       NS_LOG_DEBUG ("Packet reception stopped because transmitter has been switched off");
       return;
@@ -2970,6 +3057,23 @@ WifiPhy::StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDurat
       NS_FATAL_ERROR ("Invalid WifiPhy state.");
       break;
     }
+
+  if (m_currentEvent == event && m_currentPpdu != ppdu)
+    {
+      // Register as a receiver of the PPDU, so that the outcome of this
+      // reception can be computed along with that of the first receiver to
+      // end (see GetRxOutcome)
+      WifiRxThreadPool *pool = WifiRxThreadPool::Get ();
+      if (pool != 0)
+        {
+          if (m_currentPpdu != 0)
+            {
+              pool->RemoveReceiver (m_currentPpdu, this);
+            }
+          pool->AddReceiver (ppdu, this);
+        }
+      m_currentPpdu = ppdu;
+    }
 }
 
 void
@@ -3043,15 +3147,29 @@ WifiPhy::EndReceive (Ptr<Event> event)
   NS_LOG_FUNCTION (this << event->GetPacket () << event->GetTxVector () << event << psduDuration);
   NS_ASSERT (event->GetEndTime () == Simulator::Now ());
 
-  double snr = m_interference.CalculateSnr (event);
+  Ptr<const Packet> packet = event->GetPacket ();
+  WifiTxVector txVector = event->GetTxVector ();
+  RxOutcome outcome = GetRxOutcome (event);
+  double snr = outcome.snr;
+  if (m_abstraction)
+    {
+      // The PHY headers are decoded with the same effective SNR as the payload
+      if (m_random->GetValue () <= outcome.headerPer)
+        {
+          NS_LOG_DEBUG ("Drop packet because PHY header reception failed");
+          NotifyRxDrop (packet, L_SIG_FAILURE);
+          m_state->SwitchFromRxEndError (packet->Copy (), snr);
+          m_interference.NotifyRxEnd ();
+          m_currentEvent = 0;
+          return;
+        }
+    }
   std::vector<bool> statusPerMpdu;
   SignalNoiseDbm signalNoise;
 
-  Ptr<const Packet> packet = event->GetPacket ();
   Time relativeStart = NanoSeconds (0);
   bool receptionOkAtLeastForOneMpdu = true;
   std::pair<bool, SignalNoiseDbm> rxInfo;
-  WifiTxVector txVector = event->GetTxVector ();
   if (txVector.IsAggregation ())
     {
       //Extract all MPDUs of the A-MPDU to compute per-MPDU PER stats
@@ -3069,7 +3187,14 @@ WifiPhy::EndReceive (Ptr<Event> event)
             {
               mpduDuration += remainingAmpduDuration; //apply a correction just in case rounding had induced slight shift
             }
-          rxInfo = GetReceptionStatus (MpduAggregator::PeekMpduInAmpduSubframe (subframe), event, relativeStart, mpduDuration);
+          if (m_abstraction)
+            {
+              rxInfo = GetAbstractionReceptionStatus (MpduAggregator::PeekMpduInAmpduSubframe (subframe), event, snr, mpduDuration);
+            }
+          else
+            {
+              rxInfo = GetReceptionStatus (MpduAggregator::PeekMpduInAmpduSubframe (subframe), event, relativeStart, mpduDuration);
+            }
           NS_LOG_DEBUG ("Extracted MPDU #" << ampduSubframes.size () - nbOfRemainingMpdus - 1 << ": duration: " << mpduDuration.GetNanoSeconds () << "ns" <<
                         ", correct reception: " << rxInfo.first <<
                         ", Signal/Noise: " << rxInfo.second.signal << "/" << rxInfo.second.noise << "dBm");
@@ -3083,7 +3208,10 @@ WifiPhy::EndReceive (Ptr<Event> event)
   else
     {
       //Simple MPDU
-      rxInfo = GetReceptionStatus (packet, event, relativeStart, psduDuration);
+      NS_LOG_DEBUG ("mode=" << (txVector.GetMode ().GetDataRate (txVector)) <<
+                    ", snr(dB)=" << RatioToDb (snr) << ", per=" << outcome.per << ", size=" << packet->GetSize () <<
+                    ", duration = " << outcome.payloadDuration.GetNanoSeconds () << "ns");
+      rxInfo = DrawReceptionStatus (packet, event, snr, outcome.per);
       signalNoise = rxInfo.second; //same information for all MPDUs
       statusPerMpdu.push_back (rxInfo.first);
       receptionOkAtLeastForOneMpdu = rxInfo.first;
@@ -3103,6 +3231,117 @@ WifiPhy::EndReceive (Ptr<Event> event)
   m_currentEvent = 0;
 }
 
+WifiPhy::RxOutcome
+WifiPhy::GetRxOutcome (Ptr<Event> event)
+{
+  NS_LOG_FUNCTION (this << event);
+  if (m_rxOutcome.event != event
+      || m_rxOutcome.version != m_interference.GetVersion ()
+      || m_rxOutcome.abstraction != m_abstraction)
+    {
+      PrepareRxOutcome (event);
+      // The other PHYs receiving the same PPDU end their reception shortly
+      // after this one, so that their outcomes are computed now, as of
+      // their own end, on the threads of the pool
+      WifiRxThreadPool *pool = WifiRxThreadPool::Get ();
+      std::vector<WifiPhy *> phys;
+      if (pool != 0 && m_currentPpdu != 0 && m_currentPpdu->GetPsdu () == event->GetPacket ())
+        {
+          phys = pool->RemoveReceivers (m_currentPpdu);
+        }
+      std::vector<WifiPhy *> receivers;
+      if (phys.size () > 1)
+        {
+          receivers.push_back (this);
+          for (WifiPhy *phy : phys)
+            {
+              if (phy != this && phy->m_currentPpdu == m_currentPpdu
+                  && phy->m_currentEvent != 0 && phy->m_endRxEvent.IsRunning ())
+                {
+                  phy->PrepareRxOutcome (phy->m_currentEvent);
+                  receivers.push_back (phy);
+                }
+            }
+        }
+      if (receivers.size () > 1)
+        {
+          pool->Run (receivers.size (), MakeBoundCallback (&WifiPhy::ComputeRxOutcomeOf, &receivers));
+        }
+      else
+        {
+          ComputeRxOutcome ();
+        }
+    }
+  else
+    {
+      NS_LOG_DEBUG ("The outcome of the reception is already computed");
+    }
+  RxOutcome outcome = m_rxOutcome;
+  m_rxOutcome.event = 0;
+  return outcome;
+}
+
+void
+WifiPhy::PrepareRxOutcome (Ptr<Event> event)
+{
+  WifiTxVector txVector = event->GetTxVector ();
+  m_rxOutcome.event = event;
+  m_rxOutcome.version = m_interference.GetVersion ();
+  m_rxOutcome.abstraction = m_abstraction;
+  Time psduDuration = event->GetEndTime () - event->GetStartTime ();
+  if (m_abstraction)
+    {
+      WifiPreamble preamble = txVector.GetPreambleType ();
+      m_rxOutcome.headerMode = GetPlcpHeaderMode (txVector);
+      m_rxOutcome.headerDuration = GetPlcpHeaderDuration (txVector) + GetPlcpHtSigHeaderDuration (preamble)
+        + GetPlcpSigA1Duration (preamble) + GetPlcpSigA2Duration (preamble) + GetPlcpSigBDuration (preamble);
+      m_rxOutcome.payloadDuration = psduDuration - CalculatePlcpPreambleAndHeaderDuration (txVector);
+    }
+  else
+    {
+      m_rxOutcome.payloadDuration = psduDuration;
+    }
+}
+
+void
+WifiPhy::ComputeRxOutcome (void)
+{
+  // This may run on another thread than the simulation: only the event and
+  // the interference helper of this PHY are used
+  Ptr<Event> event = m_rxOutcome.event;
+  Time end = event->GetEndTime ();
+  bool aggregation = event->GetTxVector ().IsAggregation ();
+  if (m_rxOutcome.abstraction)
+    {
+      m_rxOutcome.snr = m_interference.CalculateEffectiveSnr (event, end);
+      m_rxOutcome.headerPer = m_interference.CalculateEffectivePer (event, m_rxOutcome.snr, m_rxOutcome.headerMode,
+                                                                    m_rxOutcome.headerDuration);
+      m_rxOutcome.per = aggregation ? 0 : m_interference.CalculateEffectivePer (event, m_rxOutcome.snr, event->GetPayloadMode (),
+                                                                                m_rxOutcome.payloadDuration);
+    }
+  else if (aggregation)
+    {
+      // The PERs of the MPDUs are computed as they are drawn
+      m_rxOutcome.snr = m_interference.CalculateSnr (event, end);
+      m_rxOutcome.headerPer = 0;
+      m_rxOutcome.per = 0;
+    }
+  else
+    {
+      InterferenceHelper::SnrPer snrPer;
+      snrPer = m_interference.CalculatePayloadSnrPer (event, std::make_pair (Time (0), m_rxOutcome.payloadDuration), end);
+      m_rxOutcome.snr = snrPer.snr;
+      m_rxOutcome.headerPer = 0;
+      m_rxOutcome.per = snrPer.per;
+    }
+}
+
+void
+WifiPhy::ComputeRxOutcomeOf (std::vector<WifiPhy *> *phys, uint32_t index)
+{
+  (*phys)[index]->ComputeRxOutcome ();
+}
+
 std::pair<bool, SignalNoiseDbm>
 WifiPhy::GetReceptionStatus (Ptr<const Packet> mpdu, Ptr<Event> event, Time relativeMpduStart, Time mpduDuration)
 {
@@ -3113,15 +3352,30 @@ WifiPhy::GetReceptionStatus (Ptr<const Packet> mpdu, Ptr<Event> event, Time rela
   NS_LOG_DEBUG ("mode=" << (event->GetTxVector ().GetMode ().GetDataRate (event->GetTxVector ())) <<
                 ", snr(dB)=" << RatioToDb (snrPer.snr) << ", per=" << snrPer.per << ", size=" << mpdu->GetSize () <<
                 ", relativeStart = " << relativeMpduStart.GetNanoSeconds () << "ns, duration = " << mpduDuration.GetNanoSeconds () << "ns");
+  return DrawReceptionStatus (mpdu, event, snrPer.snr, snrPer.per);
+}
+
+std::pair<bool, SignalNoiseDbm>
+WifiPhy::GetAbstractionReceptionStatus (Ptr<const Packet> mpdu, Ptr<Event> event, double snr, Time mpduDuration)
+{
+  NS_LOG_FUNCTION (this << mpdu << event->GetTxVector () << event << snr << mpduDuration);
+  double per = m_interference.CalculateEffectivePer (event, snr, event->GetPayloadMode (), mpduDuration);
+  NS_LOG_DEBUG ("mode=" << (event->GetTxVector ().GetMode ().GetDataRate (event->GetTxVector ())) <<
+                ", effective snr(dB)=" << RatioToDb (snr) << ", per=" << per << ", size=" << mpdu->GetSize ());
+  return DrawReceptionStatus (mpdu, event, snr, per);
+}
 
+std::pair<bool, SignalNoiseDbm>
+WifiPhy::DrawReceptionStatus (Ptr<const Packet> mpdu, Ptr<Event> event, double snr, double per)
+{
   // There are two error checks: PER and receive error model check.
   // PER check models is typical for Wi-Fi and is based on signal modulation;
   // Receive error model is optional, if we have an error model and
   // it indicates that the packet is corrupt, drop the packet.
   SignalNoiseDbm signalNoise;
   signalNoise.signal = WToDbm (event->GetRxPowerW ());
-  signalNoise.noise = WToDbm (event->GetRxPowerW () / snrPer.snr);
-  if (m_random->GetValue () > snrPer.per &&
+  signalNoise.noise = WToDbm (event->GetRxPowerW () / snr);
+  if (m_random->GetValue () > per &&
       !(m_postReceptionErrorModel && m_postReceptionErrorModel->IsCorrupt (mpdu->Copy ())))
     {
       NS_LOG_DEBUG ("Reception succeeded: " << mpdu->ToString ());
@@ -3136,6 +3390,57 @@ WifiPhy::GetReceptionStatus (Ptr<const Packet> mpdu, Ptr<Event> event, Time rela
     }
 }
 
+void
+WifiPhy::StartReceiveAbstraction (Ptr<Event> event, Time rxDuration)
+{
+  NS_LOG_FUNCTION (this << event->GetPacket () << event->GetTxVector () << event << rxDuration);
+  NS_ASSERT (m_endRxEvent.IsExpired ());
+
+  if (m_preambleDetectionModel
+      && !m_preambleDetectionModel->IsPreambleDetected (event->GetRxPowerW (), m_interference.CalculateSnr (event), m_channelWidth))
+    {
+      NS_LOG_DEBUG ("Drop packet because PHY preamble detection failed");
+      NotifyRxDrop (event->GetPacket (), PREAMBLE_DETECT_FAILURE);
+      m_interference.NotifyRxEnd ();
+      MaybeCcaBusyDuration ();
+      return;
+    }
+
+  m_state->SwitchToRx (rxDuration);
+  NotifyRxBegin (event->GetPacket ());
+  m_timeLastPreambleDetected = Simulator::Now ();
+  m_currentEvent = event;
+
+  WifiTxVector txVector = event->GetTxVector ();
+  WifiMode txMode = txVector.GetMode ();
+  if (txVector.GetNss () > GetMaxSupportedRxSpatialStreams ())
+    {
+      NS_LOG_DEBUG ("Packet reception could not be started because not enough RX antennas");
+      NotifyRxDrop (event->GetPacket (), UNSUPPORTED_SETTINGS);
+    }
+  else if (!IsModeSupported (txMode) && !IsMcsSupported (txMode))
+    {
+      NS_LOG_DEBUG ("Drop packet because it was sent using an unsupported mode (" << txMode << ")");
+      NotifyRxDrop (event->GetPacket (), UNSUPPORTED_SETTINGS);
+    }
+  else
+    {
+      m_endRxEvent = Simulator::Schedule (rxDuration, &WifiPhy::EndReceive, this, event);
+      MaybeCcaBusyDuration ();
+      if (txMode.GetModulationClass () == WIFI_MOD_CLASS_HE)
+        {
+          // There is no event at the end of the HE preamble with the
+          // abstraction: the OBSS PD algorithm is told right away
+          HePreambleParameters params;
+          params.rssiW = event->GetRxPowerW ();
+          params.bssColor = txVector.GetBssColor ();
+          NotifyEndOfHePreamble (params);
+        }
+      return;
+    }
+  MaybeCcaBusyDuration ();
+}
+
 void
 WifiPhy::EndReceiveInterBss (void)
 {
@@ -4227,6 +4532,11 @@ WifiPhy::StartRx (Ptr<Event> event, double rxPowerW, Time rxDuration)
   NS_LOG_DEBUG ("sync to signal (power=" << rxPowerW << "W)");
   m_interference.NotifyRxStart (); //We need to notify it now so that it starts recording events
 
+  if (m_abstraction)
+    {
+      StartReceiveAbstraction (event, rxDuration);
+      return;
+    }
   if (!m_endPreambleDetectionEvent.IsRunning ())
     {
       Time startOfPreambleDuration = GetPreambleDetectionDuration ();
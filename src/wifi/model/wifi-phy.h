@@ -29,6 +29,8 @@
 #include "wifi-phy-standard.h"
 #include "interference-helper.h"
 #include "wifi-phy-state-helper.h"
+#include <map>
+#include <unordered_map>
 
 namespace ns3 {
 
@@ -44,6 +46,7 @@ class FrameCaptureModel;
 class PreambleDetectionModel;
 class WifiRadioEnergyModel;
 class UniformRandomVariable;
+class WifiPpdu;
 
 typedef enum
 {
@@ -135,15 +138,20 @@ public:
    * \param callback the callback to invoke when PHY capabilities have changed.
    */
   void SetCapabilitiesChangedCallback (Callback<void> callback);
+  /**
+   * \param callback the callback to invoke when the receive sensitivity or
+   * the reception gain has changed.
+   */
+  void SetRxThresholdChangedCallback (Callback<void> callback);
 
   /**
-   * Start receiving the PHY preamble of a packet (i.e. the first bit of the preamble has arrived).
+   * Start receiving the PHY preamble of a PPDU (i.e. the first bit of the preamble has arrived).
    *
-   * \param packet the arriving packet
+   * \param ppdu the arriving PPDU, shared with the other receivers
    * \param rxPowerW the receive power in W
    * \param rxDuration the duration needed for the reception of the packet
    */
-  void StartReceivePreamble (Ptr<Packet> packet, double rxPowerW, Time rxDuration);
+  void StartReceivePreamble (Ptr<const WifiPpdu> ppdu, double rxPowerW, Time rxDuration);
 
   /**
    * Start receiving the PHY header of a packet (i.e. after the end of receiving the preamble).
@@ -368,6 +376,18 @@ public:
    * \return the duration of the payload
    */
   Time GetPayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t frequency, MpduType mpdutype, uint8_t incFlag);
+  /**
+   * The durations computed by CalculateTxDuration and GetPayloadDuration
+   * are remembered, for frames of the same size, TXVECTOR, frequency and
+   * MPDU type (and A-MPDU state for the last MPDU of an A-MPDU).
+   *
+   * \return the number of durations found in the cache
+   */
+  uint64_t GetDurationCacheHits (void) const;
+  /**
+   * \return the number of durations computed because they were not in the cache
+   */
+  uint64_t GetDurationCacheMisses (void) const;
   /**
    * \param txVector the transmission parameters used for this packet
    *
@@ -1726,6 +1746,70 @@ private:
    */
   void MaybeCcaBusyDuration (void);
 
+  /**
+   * The durations of a frame
+   */
+  struct Durations
+  {
+    Time preambleAndHeader; //!< duration of the PLCP preamble and header
+    Time payload;           //!< duration of the payload
+    double numSymbols;      //!< number of symbols of the payload
+  };
+  /**
+   * The key of the durations of a frame, packing the fields of the frame
+   * and of its TXVECTOR the durations depend on
+   */
+  struct DurationKey
+  {
+    uint64_t txVector;   //!< mode UID, channel width and guard interval
+    uint64_t frame;      //!< size, frequency, MPDU type, preamble, NSS, NESS and STBC
+    uint32_t ampduSize;  //!< size of the previous MPDUs of the A-MPDU, for its last MPDU
+    double ampduSymbols; //!< number of symbols of the previous MPDUs of the A-MPDU, for its last MPDU
+
+    /**
+     * \param other the other key
+     * \return true if both keys are equal
+     */
+    bool operator== (const DurationKey &other) const;
+  };
+  /**
+   * Hash function of the duration keys
+   */
+  struct DurationKeyHash
+  {
+    /**
+     * \param key the key
+     * \return the hash of the key
+     */
+    std::size_t operator() (const DurationKey &key) const;
+  };
+  /**
+   * Get the durations of a frame, from the cache if possible, and update
+   * the A-MPDU state if requested.
+   *
+   * \param size the number of bytes in the packet to send
+   * \param txVector the TXVECTOR used for the transmission of this packet
+   * \param frequency the channel center frequency (MHz)
+   * \param mpdutype the type of the MPDU as defined in WifiPhy::MpduType.
+   * \param incFlag whether the A-MPDU state is updated
+   *
+   * \return the durations of the frame
+   */
+  Durations GetDurations (uint32_t size, WifiTxVector txVector, uint16_t frequency, MpduType mpdutype, uint8_t incFlag);
+  /**
+   * Compute the duration of the payload of a frame, without updating the
+   * A-MPDU state.
+   *
+   * \param size the number of bytes in the packet to send
+   * \param txVector the TXVECTOR used for the transmission of this packet
+   * \param frequency the channel center frequency (MHz)
+   * \param mpdutype the type of the MPDU as defined in WifiPhy::MpduType.
+   * \param numSymbols the number of symbols of the payload
+   *
+   * \return the duration of the payload
+   */
+  Time ComputePayloadDuration (uint32_t size, WifiTxVector txVector, uint16_t frequency, MpduType mpdutype, double &numSymbols) const;
+
   /**
    * Starting receiving the packet after having detected the medium is idle or after a reception switch.
    *
@@ -1748,6 +1832,91 @@ private:
                                                       Ptr<Event> event,
                                                       Time relativeMpduStart,
                                                       Time mpduDuration);
+  /**
+   * Start receiving a packet with the abstraction: the reception is only
+   * decided by EndReceive, from the effective SNR of the whole packet.
+   *
+   * \param event the corresponding event of the first time the packet arrives (also storing packet and TxVector information)
+   * \param rxDuration the duration needed for the reception of the packet
+   */
+  void StartReceiveAbstraction (Ptr<Event> event, Time rxDuration);
+  /**
+   * Get the reception status for the provided MPDU received with the
+   * abstraction and notify.
+   *
+   * \param mpdu the arriving MPDU
+   * \param event the corresponding event of the first time the packet arrives (also storing packet and TxVector information)
+   * \param snr the effective SNR of the packet
+   * \param mpduDuration the duration of the MPDU
+   *
+   * \return information on MPDU reception: status, signal power (dBm), and noise power (in dBm)
+   */
+  std::pair<bool, SignalNoiseDbm> GetAbstractionReceptionStatus (Ptr<const Packet> mpdu,
+                                                                 Ptr<Event> event,
+                                                                 double snr,
+                                                                 Time mpduDuration);
+  /**
+   * Draw the reception status for the provided MPDU and notify.
+   *
+   * \param mpdu the arriving MPDU
+   * \param event the corresponding event of the first time the packet arrives (also storing packet and TxVector information)
+   * \param snr the SNR of the MPDU
+   * \param per the PER of the MPDU
+   *
+   * \return information on MPDU reception: status, signal power (dBm), and noise power (in dBm)
+   */
+  std::pair<bool, SignalNoiseDbm> DrawReceptionStatus (Ptr<const Packet> mpdu,
+                                                       Ptr<Event> event,
+                                                       double snr,
+                                                       double per);
+
+  /**
+   * The SNR and error rates of a reception, as of its end.
+   */
+  struct RxOutcome
+  {
+    Ptr<Event> event;     //!< the event received, 0 if none
+    uint64_t version;     //!< the version of the interference helper it is computed from
+    bool abstraction;     //!< whether the packet is received with the abstraction
+    WifiMode headerMode;  //!< the mode of the PHY header, with the abstraction
+    Time headerDuration;  //!< the duration of the PHY header, with the abstraction
+    Time payloadDuration; //!< the duration of the payload, or of the PSDU without the abstraction
+    double snr;           //!< the SNR, or the effective SNR with the abstraction
+    double headerPer;     //!< the PER of the PHY header, with the abstraction
+    double per;           //!< the PER of the payload, unless it is an A-MPDU
+  };
+
+  /**
+   * Get the outcome of the reception of an event at its end. It is
+   * computed for all the PHYs receiving the same PPDU on the threads of the
+   * WifiRxThreadPool, if any, unless it has already been computed and the
+   * interference helper of this PHY has not changed since.
+   *
+   * \param event the event whose reception ends
+   *
+   * \return the outcome of the reception
+   */
+  RxOutcome GetRxOutcome (Ptr<Event> event);
+  /**
+   * Set the parameters of the outcome of the reception of an event, before
+   * it is computed.
+   *
+   * \param event the event being received
+   */
+  void PrepareRxOutcome (Ptr<Event> event);
+  /**
+   * Compute the outcome of the reception prepared by PrepareRxOutcome. Only
+   * the interference helper of this PHY is used, so that this can be done
+   * for several PHYs at once.
+   */
+  void ComputeRxOutcome (void);
+  /**
+   * Compute the outcome of the reception of a PHY.
+   *
+   * \param phys the PHYs
+   * \param index the index of the PHY
+   */
+  static void ComputeRxOutcomeOf (std::vector<WifiPhy *> *phys, uint32_t index);
 
   /**
    * The trace source fired when a packet begins the transmission process on
@@ -1913,17 +2082,26 @@ private:
   uint32_t m_totalAmpduSize;     //!< Total size of the previously transmitted MPDUs in an A-MPDU, used for the computation of the number of symbols needed for the last MPDU in the A-MPDU
   double m_totalAmpduNumSymbols; //!< Number of symbols previously transmitted for the MPDUs in an A-MPDU, used for the computation of the number of symbols needed for the last MPDU in the A-MPDU
 
+  std::unordered_map<DurationKey, Durations, DurationKeyHash> m_durationCache; //!< the durations of the recent frames
+  uint32_t m_durationCacheSize;   //!< maximum number of durations in the cache
+  uint64_t m_durationCacheHits;   //!< number of durations found in the cache
+  uint64_t m_durationCacheMisses; //!< number of durations not found in the cache
+
   Ptr<NetDevice>     m_device;   //!< Pointer to the device
   Ptr<MobilityModel> m_mobility; //!< Pointer to the mobility model
 
   Ptr<Event> m_currentEvent; //!< Hold the current event
+  Ptr<const WifiPpdu> m_currentPpdu; //!< the PPDU of the current event
+  RxOutcome m_rxOutcome; //!< the outcome of the current reception, if computed
   Ptr<FrameCaptureModel> m_frameCaptureModel; //!< Frame capture model
   Ptr<PreambleDetectionModel> m_preambleDetectionModel; //!< Preamble detection model
   Ptr<WifiRadioEnergyModel> m_wifiRadioEnergyModel; //!< Wifi radio energy model
   Ptr<ErrorModel> m_postReceptionErrorModel; //!< Error model for receive packet events
   Time m_timeLastPreambleDetected; //!< Record the time the last preamble was detected
+  bool m_abstraction; //!< Whether packets are received with the abstraction
 
   Callback<void> m_capabilitiesChangedCallback; //!< Callback when PHY capabilities changed
+  Callback<void> m_rxThresholdChangedCallback;  //!< Callback when the receive sensitivity or gain changed
 };
 
 /**
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "wifi-ppdu.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WifiPpdu");
+
+WifiPpdu::WifiPpdu (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  Ptr<Packet> psdu = packet->Copy ();
+  if (!psdu->RemovePacketTag (m_tag))
+    {
+      NS_FATAL_ERROR ("Received Wi-Fi Signal with no WifiPhyTag");
+    }
+  WifiPreamble preamble = m_tag.GetPreambleType ();
+  WifiModulationClass modulation = m_tag.GetModulation ();
+  if ((modulation == WIFI_MOD_CLASS_DSSS) || (modulation == WIFI_MOD_CLASS_HR_DSSS))
+    {
+      if (!psdu->RemoveHeader (m_dsssSig))
+        {
+          NS_FATAL_ERROR ("Received 802.11b signal with no SIG field");
+        }
+    }
+  else if ((modulation != WIFI_MOD_CLASS_HT) || (preamble != WIFI_PREAMBLE_HT_GF))
+    {
+      if (!psdu->RemoveHeader (m_lSig))
+        {
+          NS_FATAL_ERROR ("Received OFDM 802.11 signal with no SIG field");
+        }
+    }
+  if (modulation == WIFI_MOD_CLASS_HT)
+    {
+      if (!psdu->RemoveHeader (m_htSig))
+        {
+          NS_FATAL_ERROR ("Received 802.11n signal with no HT-SIG field");
+        }
+    }
+  else if (modulation == WIFI_MOD_CLASS_VHT)
+    {
+      m_vhtSig.SetMuFlag (preamble == WIFI_PREAMBLE_VHT_MU);
+      if (!psdu->RemoveHeader (m_vhtSig))
+        {
+          NS_FATAL_ERROR ("Received 802.11ac signal with no VHT-SIG field");
+        }
+    }
+  else if (modulation == WIFI_MOD_CLASS_HE)
+    {
+      m_heSig.SetMuFlag (preamble == WIFI_PREAMBLE_HE_MU);
+      if (!psdu->RemoveHeader (m_heSig))
+        {
+          NS_FATAL_ERROR ("Received 802.11ax signal with no HE-SIG field");
+        }
+    }
+  m_psdu = psdu;
+}
+
+Ptr<const Packet>
+WifiPpdu::GetPsdu (void) const
+{
+  return m_psdu;
+}
+
+WifiPreamble
+WifiPpdu::GetPreambleType (void) const
+{
+  return m_tag.GetPreambleType ();
+}
+
+WifiModulationClass
+WifiPpdu::GetModulation (void) const
+{
+  return m_tag.GetModulation ();
+}
+
+bool
+WifiPpdu::IsFrameComplete (void) const
+{
+  return m_tag.GetFrameComplete () != 0;
+}
+
+const DsssSigHeader &
+WifiPpdu::GetDsssSigHeader (void) const
+{
+  return m_dsssSig;
+}
+
+const LSigHeader &
+WifiPpdu::GetLSigHeader (void) const
+{
+  return m_lSig;
+}
+
+const HtSigHeader &
+WifiPpdu::GetHtSigHeader (void) const
+{
+  return m_htSig;
+}
+
+const VhtSigHeader &
+WifiPpdu::GetVhtSigHeader (void) const
+{
+  return m_vhtSig;
+}
+
+const HeSigHeader &
+WifiPpdu::GetHeSigHeader (void) const
+{
+  return m_heSig;
+}
+
+} //namespace ns3
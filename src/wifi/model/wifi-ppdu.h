@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WIFI_PPDU_H
+#define WIFI_PPDU_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/packet.h"
+#include "wifi-phy-tag.h"
+#include "wifi-phy-header.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * A PPDU as seen by the receivers of a transmission.
+ *
+ * The PHY headers and the WifiPhyTag of the transmitted packet are
+ * removed and decoded once, when the PPDU is created, and the remaining
+ * PSDU is shared by all the receivers. A PPDU is immutable: a receiver
+ * only copies the PSDU when it hands it up to the MAC.
+ */
+class WifiPpdu : public SimpleRefCount<WifiPpdu>
+{
+public:
+  /**
+   * Create a PPDU from a packet built by WifiPhy::SendPacket, that is a
+   * PSDU with the PHY headers and a WifiPhyTag.
+   *
+   * \param packet the transmitted packet
+   */
+  WifiPpdu (Ptr<const Packet> packet);
+
+  /**
+   * \return the PSDU, without the PHY headers
+   */
+  Ptr<const Packet> GetPsdu (void) const;
+  /**
+   * \return the preamble type
+   */
+  WifiPreamble GetPreambleType (void) const;
+  /**
+   * \return the modulation class
+   */
+  WifiModulationClass GetModulation (void) const;
+  /**
+   * \return true unless the transmitter was switched off during the transmission
+   */
+  bool IsFrameComplete (void) const;
+  /**
+   * \return the SIG header of a DSSS or HR/DSSS PPDU
+   */
+  const DsssSigHeader & GetDsssSigHeader (void) const;
+  /**
+   * \return the L-SIG header of an OFDM PPDU, other than an HT greenfield one
+   */
+  const LSigHeader & GetLSigHeader (void) const;
+  /**
+   * \return the HT-SIG header of an HT PPDU
+   */
+  const HtSigHeader & GetHtSigHeader (void) const;
+  /**
+   * \return the VHT-SIG header of a VHT PPDU
+   */
+  const VhtSigHeader & GetVhtSigHeader (void) const;
+  /**
+   * \return the HE-SIG header of an HE PPDU
+   */
+  const HeSigHeader & GetHeSigHeader (void) const;
+
+private:
+  Ptr<const Packet> m_psdu;     //!< the PSDU
+  WifiPhyTag m_tag;             //!< preamble, modulation and completeness
+  DsssSigHeader m_dsssSig;      //!< SIG header of DSSS PPDUs
+  LSigHeader m_lSig;            //!< L-SIG header of OFDM PPDUs
+  HtSigHeader m_htSig;          //!< HT-SIG header of HT PPDUs
+  VhtSigHeader m_vhtSig;        //!< VHT-SIG header of VHT PPDUs
+  HeSigHeader m_heSig;          //!< HE-SIG header of HE PPDUs
+};
+
+} //namespace ns3
+
+#endif /* WIFI_PPDU_H */
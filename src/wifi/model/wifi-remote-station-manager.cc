@@ -1091,13 +1091,11 @@ WifiRemoteStationState *
 WifiRemoteStationManager::LookupState (Mac48Address address) const
 {
   NS_LOG_FUNCTION (this << address);
-  for (StationStates::const_iterator i = m_states.begin (); i != m_states.end (); i++)
+  StationStates::const_iterator it = m_states.find (address);
+  if (it != m_states.end ())
     {
-      if ((*i)->m_address == address)
-        {
-          NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
-          return (*i);
-        }
+      NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning existing state");
+      return it->second;
     }
   WifiRemoteStationState *state = new WifiRemoteStationState ();
   state->m_state = WifiRemoteStationState::BRAND_NEW;
@@ -1112,7 +1110,7 @@ WifiRemoteStationManager::LookupState (Mac48Address address) const
   state->m_ness = 0;
   state->m_aggregation = false;
   state->m_qosSupported = false;
-  const_cast<WifiRemoteStationManager *> (this)->m_states.push_back (state);
+  const_cast<WifiRemoteStationManager *> (this)->m_states[address] = state;
   NS_LOG_DEBUG ("WifiRemoteStationManager::LookupState returning new state");
   return state;
 }
@@ -1136,10 +1134,11 @@ WifiRemoteStation *
 WifiRemoteStationManager::Lookup (Mac48Address address, uint8_t tid) const
 {
   NS_LOG_FUNCTION (this << address << +tid);
-  for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
+  // The stations of an address are few, one per TID in use
+  std::vector<WifiRemoteStation *> &stations = const_cast<WifiRemoteStationManager *> (this)->m_stations[address];
+  for (std::vector<WifiRemoteStation *>::const_iterator i = stations.begin (); i != stations.end (); i++)
     {
-      if ((*i)->m_tid == tid
-          && (*i)->m_state->m_address == address)
+      if ((*i)->m_tid == tid)
         {
           return (*i);
         }
@@ -1151,7 +1150,7 @@ WifiRemoteStationManager::Lookup (Mac48Address address, uint8_t tid) const
   station->m_tid = tid;
   station->m_ssrc = 0;
   station->m_slrc = 0;
-  const_cast<WifiRemoteStationManager *> (this)->m_stations.push_back (station);
+  stations.push_back (station);
   return station;
 }
 
@@ -1333,12 +1332,15 @@ WifiRemoteStationManager::Reset (void)
   NS_LOG_FUNCTION (this);
   for (StationStates::const_iterator i = m_states.begin (); i != m_states.end (); i++)
     {
-      delete (*i);
+      delete i->second;
     }
   m_states.clear ();
   for (Stations::const_iterator i = m_stations.begin (); i != m_stations.end (); i++)
     {
-      delete (*i);
+      for (std::vector<WifiRemoteStation *>::const_iterator j = i->second.begin (); j != i->second.end (); j++)
+        {
+          delete (*j);
+        }
     }
   m_stations.clear ();
   m_bssBasicRateSet.clear ();
@@ -21,6 +21,7 @@
 #ifndef WIFI_REMOTE_STATION_MANAGER_H
 #define WIFI_REMOTE_STATION_MANAGER_H
 
+#include <unordered_map>
 #include "ns3/traced-callback.h"
 #include "ns3/object.h"
 #include "ns3/data-rate.h"
@@ -130,13 +131,13 @@ public:
   };
 
   /**
-   * A vector of WifiRemoteStations
+   * The WifiRemoteStations of each remote address, one per TID
    */
-  typedef std::vector <WifiRemoteStation *> Stations;
+  typedef std::unordered_map <Mac48Address, std::vector <WifiRemoteStation *>, Mac48AddressHash> Stations;
   /**
-   * A vector of WifiRemoteStationStates
+   * The WifiRemoteStationState of each remote address
    */
-  typedef std::vector <WifiRemoteStationState *> StationStates;
+  typedef std::unordered_map <Mac48Address, WifiRemoteStationState *, Mac48AddressHash> StationStates;
 
   /**
    * Set up PHY associated with this device since it is the object that
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include "ns3/core-config.h"
+#include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "wifi-rx-thread-pool.h"
+#include "wifi-ppdu.h"
+
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("WifiRxThreadPool");
+
+/// Number of threads computing the outcome of the receptions of a PPDU
+static GlobalValue g_wifiRxThreads = GlobalValue ("WifiRxThreads",
+                                                  "The number of threads computing the outcome of the receptions of a wifi PPDU (0 to use one thread per processor)",
+                                                  UintegerValue (1),
+                                                  MakeUintegerChecker<uint32_t> ());
+
+/// The thread pool, if WifiRxThreads is above one
+static std::unique_ptr<WifiRxThreadPool> g_wifiRxThreadPool;
+/// Whether WifiRxThreads has been read since the simulation was last destroyed
+static bool g_wifiRxThreadsRead = false;
+
+WifiRxThreadPool::WifiRxThreadPool (uint32_t nThreads)
+  : m_nJobs (0),
+    m_generation (0),
+    m_nBusy (0),
+    m_stop (false),
+    m_nextJob (0)
+{
+  NS_LOG_FUNCTION (this << nThreads);
+#ifdef HAVE_PTHREAD_H
+  for (uint32_t i = 1; i < nThreads; i++)
+    {
+      m_threads.push_back (Create<SystemThread> (MakeCallback (&WifiRxThreadPool::Worker, this)));
+      m_threads.back ()->Start ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+WifiRxThreadPool::~WifiRxThreadPool ()
+{
+  NS_LOG_FUNCTION (this);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_work.notify_all ();
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); i++)
+    {
+      (*i)->Join ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+WifiRxThreadPool *
+WifiRxThreadPool::Get (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (!g_wifiRxThreadsRead)
+    {
+      Configure ();
+    }
+  return g_wifiRxThreadPool.get ();
+#else
+  return 0;
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+WifiRxThreadPool::Configure (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  UintegerValue threads;
+  g_wifiRxThreads.GetValue (threads);
+  uint32_t nThreads = threads.Get ();
+  if (nThreads == 0)
+    {
+      nThreads = std::max (std::thread::hardware_concurrency (), 1U);
+    }
+  if (nThreads == 1)
+    {
+      g_wifiRxThreadPool.reset ();
+    }
+  else if (g_wifiRxThreadPool == 0 || g_wifiRxThreadPool->GetNThreads () != nThreads)
+    {
+      NS_LOG_LOGIC ("Starting " << nThreads - 1 << " threads");
+      g_wifiRxThreadPool.reset (new WifiRxThreadPool (nThreads));
+    }
+  g_wifiRxThreadsRead = true;
+  // The value may change before the next simulation
+  Simulator::ScheduleDestroy (&WifiRxThreadPool::Forget);
+}
+
+void
+WifiRxThreadPool::Forget (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  g_wifiRxThreadsRead = false;
+  if (g_wifiRxThreadPool != 0)
+    {
+      g_wifiRxThreadPool->m_receivers.clear ();
+    }
+}
+
+uint32_t
+WifiRxThreadPool::GetNThreads (void) const
+{
+  return m_threads.size () + 1;
+}
+
+void
+WifiRxThreadPool::Run (uint32_t n, Callback<void, uint32_t> job)
+{
+  NS_LOG_FUNCTION (this << n);
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_job = job;
+    m_nJobs = n;
+    m_nextJob = 0;
+    m_nBusy = m_threads.size ();
+    m_generation++;
+  }
+  m_work.notify_all ();
+  RunJobs ();
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_done.wait (lock, [this] { return m_nBusy == 0; });
+}
+
+void
+WifiRxThreadPool::RunJobs (void)
+{
+  for (uint32_t i = m_nextJob++; i < m_nJobs; i = m_nextJob++)
+    {
+      m_job (i);
+    }
+}
+
+void
+WifiRxThreadPool::Worker (void)
+{
+  uint64_t generation = 0;
+  for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_work.wait (lock, [this, generation] { return m_stop || m_generation != generation; });
+        if (m_stop)
+          {
+            return;
+          }
+        generation = m_generation;
+      }
+      RunJobs ();
+      std::lock_guard<std::mutex> lock (m_mutex);
+      if (--m_nBusy == 0)
+        {
+          m_done.notify_one ();
+        }
+    }
+}
+
+void
+WifiRxThreadPool::AddReceiver (Ptr<const WifiPpdu> ppdu, WifiPhy *phy)
+{
+  NS_LOG_FUNCTION (this << ppdu << phy);
+  m_receivers[ppdu].push_back (phy);
+}
+
+void
+WifiRxThreadPool::RemoveReceiver (Ptr<const WifiPpdu> ppdu, WifiPhy *phy)
+{
+  NS_LOG_FUNCTION (this << ppdu << phy);
+  std::map<Ptr<const WifiPpdu>, std::vector<WifiPhy *> >::iterator it = m_receivers.find (ppdu);
+  if (it == m_receivers.end ())
+    {
+      return;
+    }
+  it->second.erase (std::remove (it->second.begin (), it->second.end (), phy), it->second.end ());
+  if (it->second.empty ())
+    {
+      m_receivers.erase (it);
+    }
+}
+
+std::vector<WifiPhy *>
+WifiRxThreadPool::RemoveReceivers (Ptr<const WifiPpdu> ppdu)
+{
+  NS_LOG_FUNCTION (this << ppdu);
+  std::vector<WifiPhy *> receivers;
+  std::map<Ptr<const WifiPpdu>, std::vector<WifiPhy *> >::iterator it = m_receivers.find (ppdu);
+  if (it != m_receivers.end ())
+    {
+      receivers.swap (it->second);
+      m_receivers.erase (it);
+    }
+  return receivers;
+}
+
+} //namespace ns3
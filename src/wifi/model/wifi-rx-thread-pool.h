@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef WIFI_RX_THREAD_POOL_H
+#define WIFI_RX_THREAD_POOL_H
+
+#include <vector>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "ns3/ptr.h"
+#include "ns3/callback.h"
+
+namespace ns3 {
+
+class SystemThread;
+class WifiPhy;
+class WifiPpdu;
+
+/**
+ * \ingroup wifi
+ *
+ * \brief The threads computing the outcome of the receptions of a PPDU.
+ *
+ * The receivers of a PPDU decide whether they received it at the end of
+ * the PPDU, within a few nanoseconds of each other, from the state of
+ * their own InterferenceHelper. When the first of them reaches the end of
+ * the PPDU, WifiPhy computes the SNIR and PER of all of them on these
+ * threads, and the others use them at the end of their reception if the
+ * state of their InterferenceHelper has not changed in the meantime. The
+ * random draws are still made at the end of each reception, so that the
+ * outcome of a simulation does not depend on the number of threads. The
+ * pool keeps track of the PHYs which synchronize on each PPDU, from the
+ * simulation thread.
+ *
+ * The number of threads, including the simulation thread, is given by the
+ * "WifiRxThreads" GlobalValue, 1 (the default) to compute each outcome at
+ * the end of its reception. It is read on the first use of the pool in a
+ * simulation, and again after Simulator::Destroy. The error rate models are then used by several
+ * threads at once, for different PHYs: they must not be shared by PHYs.
+ */
+class WifiRxThreadPool
+{
+public:
+  ~WifiRxThreadPool ();
+
+  /**
+   * \return the thread pool, or 0 if the outcome of the receptions is
+   *         computed by the simulation thread only
+   */
+  static WifiRxThreadPool * Get (void);
+
+  /**
+   * \return the number of threads, including the calling thread
+   */
+  uint32_t GetNThreads (void) const;
+
+  /**
+   * Run a job for each index from 0 to n - 1, on the threads of the pool
+   * and the calling thread, and return once all of them are done. The
+   * jobs run concurrently, in any order.
+   *
+   * \param n the number of jobs
+   * \param job the job, called with the index
+   */
+  void Run (uint32_t n, Callback<void, uint32_t> job);
+
+  /**
+   * Note a PHY which has synchronized on a PPDU.
+   *
+   * \param ppdu the PPDU
+   * \param phy the PHY
+   */
+  void AddReceiver (Ptr<const WifiPpdu> ppdu, WifiPhy *phy);
+  /**
+   * Forget a PHY which has synchronized on a PPDU.
+   *
+   * \param ppdu the PPDU
+   * \param phy the PHY
+   */
+  void RemoveReceiver (Ptr<const WifiPpdu> ppdu, WifiPhy *phy);
+  /**
+   * Forget all the PHYs which have synchronized on a PPDU.
+   *
+   * \param ppdu the PPDU
+   * \return the PHYs, in the order they were added
+   */
+  std::vector<WifiPhy *> RemoveReceivers (Ptr<const WifiPpdu> ppdu);
+
+private:
+  /**
+   * Start the worker threads.
+   *
+   * \param nThreads the number of threads, including the calling thread
+   */
+  WifiRxThreadPool (uint32_t nThreads);
+
+  /**
+   * Read WifiRxThreads, and start, replace or stop the thread pool to match.
+   */
+  static void Configure (void);
+  /**
+   * Forget the value of WifiRxThreads and the receivers of the PPDUs, when
+   * the simulation is destroyed.
+   */
+  static void Forget (void);
+
+  /**
+   * Run the jobs which have not been started yet.
+   */
+  void RunJobs (void);
+  /**
+   * Main loop of the worker threads.
+   */
+  void Worker (void);
+
+  std::vector<Ptr<SystemThread> > m_threads; //!< the worker threads
+  // SystemCondition may miss a wakeup which races with its Wait, hence the
+  // standard condition variables, which are waited for with a predicate
+  std::mutex m_mutex;                        //!< protects the fields below
+  std::condition_variable m_work;            //!< signals the worker threads
+  std::condition_variable m_done;            //!< signals the calling thread
+  Callback<void, uint32_t> m_job;            //!< the job being run
+  uint32_t m_nJobs;                          //!< the number of jobs
+  uint64_t m_generation;                     //!< incremented by each run
+  uint32_t m_nBusy;                          //!< the number of busy worker threads
+  bool m_stop;                               //!< asks the worker threads to exit
+  std::atomic<uint32_t> m_nextJob;           //!< the index of the next job to start
+  /// the PHYs which have synchronized on each PPDU, only used by the simulation thread
+  std::map<Ptr<const WifiPpdu>, std::vector<WifiPhy *> > m_receivers;
+};
+
+} //namespace ns3
+
+#endif /* WIFI_RX_THREAD_POOL_H */
@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/packet.h"
 #include "wifi-spectrum-signal-parameters.h"
+#include "wifi-ppdu.h"
 
 namespace ns3 {
 
@@ -37,6 +38,7 @@ WifiSpectrumSignalParameters::WifiSpectrumSignalParameters (const WifiSpectrumSi
 {
   NS_LOG_FUNCTION (this << &p);
   packet = p.packet;
+  ppdu = p.ppdu;
 }
 
 Ptr<SpectrumSignalParameters>
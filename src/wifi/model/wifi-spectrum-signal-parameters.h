@@ -27,6 +27,7 @@
 namespace ns3 {
 
 class Packet;
+class WifiPpdu;
 
 /**
  * \ingroup wifi
@@ -55,6 +56,11 @@ struct WifiSpectrumSignalParameters : public SpectrumSignalParameters
    * The packet being transmitted with this signal
    */
   Ptr<Packet> packet;
+  /**
+   * The PPDU of the packet, shared by all the receivers of the signal.
+   * If not set, each receiver decodes the packet.
+   */
+  Ptr<const WifiPpdu> ppdu;
 };
 
 }  // namespace ns3
@@ -18,17 +18,31 @@
  * Author: Mathieu Lacage, <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
 #include "ns3/net-device.h"
 #include "ns3/node.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/mobility-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/waypoint-mobility-model.h"
+#include "ns3/random-walk-2d-mobility-model.h"
+#include "ns3/random-waypoint-mobility-model.h"
+#include "ns3/random-direction-2d-mobility-model.h"
+#include "ns3/steady-state-random-waypoint-mobility-model.h"
+#include "ns3/gauss-markov-mobility-model.h"
+#include "ns3/abort.h"
 #include "yans-wifi-channel.h"
 #include "yans-wifi-phy.h"
+#include "wifi-ppdu.h"
 #include "wifi-utils.h"
 
 namespace ns3 {
@@ -37,6 +51,31 @@ NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (YansWifiChannel);
 
+/**
+ * \param mobility a mobility model
+ * \return true if the velocity of the model only changes along with a
+ *         course change notification
+ */
+static bool
+NotifiesVelocityChanges (Ptr<MobilityModel> mobility)
+{
+  TypeId tid = mobility->GetInstanceTypeId ();
+  if (tid == WaypointMobilityModel::GetTypeId ())
+    {
+      // Otherwise, the waypoints are only reached when the position is read
+      BooleanValue lazyNotify;
+      mobility->GetAttribute ("LazyNotify", lazyNotify);
+      return !lazyNotify.Get ();
+    }
+  return tid == ConstantPositionMobilityModel::GetTypeId ()
+         || tid == ConstantVelocityMobilityModel::GetTypeId ()
+         || tid == RandomWalk2dMobilityModel::GetTypeId ()
+         || tid == RandomWaypointMobilityModel::GetTypeId ()
+         || tid == RandomDirection2dMobilityModel::GetTypeId ()
+         || tid == SteadyStateRandomWaypointMobilityModel::GetTypeId ()
+         || tid == GaussMarkovMobilityModel::GetTypeId ();
+}
+
 TypeId
 YansWifiChannel::GetTypeId (void)
 {
@@ -52,11 +91,23 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialCulling",
+                   "If true, the PHYs too far to receive a packet are skipped, using a grid "
+                   "of the PHY positions and the range given by the propagation loss model.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&YansWifiChannel::m_spatialCulling),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_spatialCulling (false),
+    m_thresholdValid (false),
+    m_rxThresholdDbm (0),
+    m_cellSize (0),
+    m_maxSpeed (0),
+    m_untrackedMobility (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -67,6 +118,26 @@ YansWifiChannel::~YansWifiChannel ()
   m_phyList.clear ();
 }
 
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  const YansWifiChannel *self = this;
+  for (uint32_t i = 0; i < m_grid.size (); i++)
+    {
+      m_grid[i].mobility->TraceDisconnectWithoutContext ("CourseChange",
+                                                         MakeBoundCallback (&YansWifiChannel::CourseChanged, self, i));
+    }
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      (*i)->SetRxThresholdChangedCallback (MakeNullCallback<void> ());
+    }
+  m_grid.clear ();
+  m_cells.clear ();
+  m_moving.clear ();
+  Channel::DoDispose ();
+}
+
 void
 YansWifiChannel::SetPropagationLossModel (const Ptr<PropagationLossModel> loss)
 {
@@ -87,44 +158,260 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
   Ptr<MobilityModel> senderMobility = sender->GetMobility ();
   NS_ASSERT (senderMobility != 0);
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+  // The PHY headers are decoded once, and the PPDU is shared by the receivers
+  Ptr<const WifiPpdu> ppdu = Create<WifiPpdu> (packet);
+  double range = GetCullingRange (txPowerDbm);
+  if (range == std::numeric_limits<double>::infinity ())
     {
-      if (sender != (*i))
+      for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
         {
-          //For now don't account for inter channel interference nor channel bonding
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
-            {
-              continue;
-            }
+          SendTo (sender, senderMobility, *i, ppdu, txPowerDbm, duration);
+        }
+      return;
+    }
+  // The candidates are in the order of the PHY list, so that the
+  // receptions are scheduled in the same order as without culling
+  FindCandidates (senderMobility->GetPosition (), range);
+  NS_LOG_DEBUG ("range=" << range << "m, " << m_candidates.size () << " candidate receivers out of " << m_phyList.size ());
+  for (std::vector<uint32_t>::const_iterator i = m_candidates.begin (); i != m_candidates.end (); i++)
+    {
+      SendTo (sender, senderMobility, m_phyList[*i], ppdu, txPowerDbm, duration);
+    }
+}
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
-          double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
-          NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<NetDevice> dstNetDevice = (*i)->GetDevice ();
-          uint32_t dstNode;
-          if (dstNetDevice == 0)
+void
+YansWifiChannel::SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+                         Ptr<const WifiPpdu> ppdu, double txPowerDbm, Time duration) const
+{
+  if (sender == receiver)
+    {
+      return;
+    }
+  //For now don't account for inter channel interference nor channel bonding
+  if (receiver->GetChannelNumber () != sender->GetChannelNumber ())
+    {
+      return;
+    }
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive,
+                                  receiver, ppdu, rxPowerDbm, duration);
+}
+
+double
+YansWifiChannel::GetCullingRange (double txPowerDbm) const
+{
+  // Random delay models would draw different numbers
+  if (!m_spatialCulling || m_phyList.empty ()
+      || DynamicCast<ConstantSpeedPropagationDelayModel> (m_delay) == 0)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (!m_thresholdValid)
+    {
+      // A PHY drops the packets received below its sensitivity, once
+      // its reception gain is applied
+      m_rxThresholdDbm = std::numeric_limits<double>::infinity ();
+      for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+        {
+          m_rxThresholdDbm = std::min (m_rxThresholdDbm, (*i)->GetRxSensitivity () - (*i)->GetRxGain ());
+        }
+      m_thresholdValid = true;
+    }
+  double range = m_loss->GetMaxRange (txPowerDbm, m_rxThresholdDbm);
+  if (!(range < std::numeric_limits<double>::infinity ()))
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  if (m_grid.size () < m_phyList.size ())
+    {
+      BuildGrid (std::max (range, 1.0));
+    }
+  if (m_untrackedMobility)
+    {
+      return std::numeric_limits<double>::infinity ();
+    }
+  return range;
+}
+
+void
+YansWifiChannel::BuildGrid (double cellSize) const
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  if (m_grid.empty ())
+    {
+      m_cellSize = cellSize;
+      m_lastUpdate = Simulator::Now ();
+    }
+  // The PHYs added since the grid was built
+  const YansWifiChannel *self = this;
+  for (uint32_t i = m_grid.size (); i < m_phyList.size (); i++)
+    {
+      GridEntry entry;
+      entry.mobility = m_phyList[i]->GetMobility ();
+      NS_ABORT_MSG_UNLESS (entry.mobility != 0, "No mobility model for PHY " << i);
+      if (!NotifiesVelocityChanges (entry.mobility))
+        {
+          // The PHY could not be placed again in time
+          NS_LOG_DEBUG ("No culling with the " << entry.mobility->GetInstanceTypeId ().GetName () << " of PHY " << i);
+          m_untrackedMobility = true;
+        }
+      entry.cell = 0;
+      entry.speed = 0;
+      entry.moving = false;
+      m_grid.push_back (entry);
+      entry.mobility->TraceConnectWithoutContext ("CourseChange",
+                                                  MakeBoundCallback (&YansWifiChannel::CourseChanged, self, i));
+      Place (i);
+    }
+}
+
+uint64_t
+YansWifiChannel::GetCell (const Vector &position) const
+{
+  double limit = std::numeric_limits<int32_t>::max ();
+  int32_t x = std::max (-limit, std::min (limit, std::floor (position.x / m_cellSize)));
+  int32_t y = std::max (-limit, std::min (limit, std::floor (position.y / m_cellSize)));
+  return (uint64_t (uint32_t (x)) << 32) | uint32_t (y);
+}
+
+void
+YansWifiChannel::Place (uint32_t index) const
+{
+  GridEntry &entry = m_grid[index];
+  entry.cell = GetCell (entry.mobility->GetPosition ());
+  m_cells[entry.cell].push_back (index);
+  Vector velocity = entry.mobility->GetVelocity ();
+  entry.speed = std::sqrt (velocity.x * velocity.x + velocity.y * velocity.y + velocity.z * velocity.z);
+  if (entry.speed > 0)
+    {
+      m_maxSpeed = std::max (m_maxSpeed, entry.speed);
+      if (!entry.moving)
+        {
+          entry.moving = true;
+          m_moving.push_back (index);
+        }
+    }
+}
+
+void
+YansWifiChannel::Unplace (uint32_t index) const
+{
+  std::unordered_map<uint64_t, std::vector<uint32_t> >::iterator it = m_cells.find (m_grid[index].cell);
+  NS_ASSERT (it != m_cells.end ());
+  std::vector<uint32_t> &cell = it->second;
+  std::vector<uint32_t>::iterator i = std::find (cell.begin (), cell.end (), index);
+  NS_ASSERT (i != cell.end ());
+  *i = cell.back ();
+  cell.pop_back ();
+  if (cell.empty ())
+    {
+      m_cells.erase (it);
+    }
+}
+
+void
+YansWifiChannel::UpdateMovingPhys (void) const
+{
+  // The PHYs have moved by less than half a cell since they were placed,
+  // unless the moving ones have been moving for too long
+  Time now = Simulator::Now ();
+  if (m_moving.empty () || (now - m_lastUpdate).GetSeconds () * m_maxSpeed <= m_cellSize / 2)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << m_moving.size ());
+  std::vector<uint32_t> moving;
+  moving.swap (m_moving);
+  m_maxSpeed = 0;
+  for (std::vector<uint32_t>::const_iterator i = moving.begin (); i != moving.end (); i++)
+    {
+      m_grid[*i].moving = false;
+      Unplace (*i);
+      Place (*i);
+    }
+  m_lastUpdate = now;
+}
+
+void
+YansWifiChannel::FindCandidates (const Vector &position, double range) const
+{
+  UpdateMovingPhys ();
+  m_candidates.clear ();
+  double radius = range + m_cellSize / 2;
+  Vector low (position.x - radius, position.y - radius, 0);
+  Vector high (position.x + radius, position.y + radius, 0);
+  uint64_t lowCell = GetCell (low);
+  uint64_t highCell = GetCell (high);
+  int32_t x0 = int32_t (lowCell >> 32);
+  int32_t y0 = int32_t (lowCell & 0xffffffff);
+  int32_t x1 = int32_t (highCell >> 32);
+  int32_t y1 = int32_t (highCell & 0xffffffff);
+  if ((double (x1) - x0 + 1) * (double (y1) - y0 + 1) > m_cells.size ())
+    {
+      // Fewer non-empty cells than cells in range
+      for (std::unordered_map<uint64_t, std::vector<uint32_t> >::const_iterator it = m_cells.begin ();
+           it != m_cells.end (); it++)
+        {
+          int32_t x = int32_t (it->first >> 32);
+          int32_t y = int32_t (it->first & 0xffffffff);
+          if (x >= x0 && x <= x1 && y >= y0 && y <= y1)
             {
-              dstNode = 0xffffffff;
+              m_candidates.insert (m_candidates.end (), it->second.begin (), it->second.end ());
             }
-          else
+        }
+    }
+  else
+    {
+      for (int64_t x = x0; x <= x1; x++)
+        {
+          for (int64_t y = y0; y <= y1; y++)
             {
-              dstNode = dstNetDevice->GetNode ()->GetId ();
+              uint64_t cell = (uint64_t (uint32_t (x)) << 32) | uint32_t (y);
+              std::unordered_map<uint64_t, std::vector<uint32_t> >::const_iterator it = m_cells.find (cell);
+              if (it != m_cells.end ())
+                {
+                  m_candidates.insert (m_candidates.end (), it->second.begin (), it->second.end ());
+                }
             }
-
-          Simulator::ScheduleWithContext (dstNode,
-                                          delay, &YansWifiChannel::Receive,
-                                          (*i), copy, rxPowerDbm, duration);
         }
     }
+  std::sort (m_candidates.begin (), m_candidates.end ());
+}
+
+void
+YansWifiChannel::NotifyRxThresholdChanged (void)
+{
+  m_thresholdValid = false;
+}
+
+void
+YansWifiChannel::CourseChanged (const YansWifiChannel *channel, uint32_t index, Ptr<const MobilityModel> mobility)
+{
+  channel->Unplace (index);
+  channel->Place (index);
 }
 
 void
-YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<Packet> packet, double rxPowerDbm, Time duration)
+YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<const WifiPpdu> ppdu, double rxPowerDbm, Time duration)
 {
-  NS_LOG_FUNCTION (phy << packet << rxPowerDbm << duration.GetSeconds ());
+  NS_LOG_FUNCTION (phy << ppdu << rxPowerDbm << duration.GetSeconds ());
   // Do no further processing if signal is too weak
   // Current implementation assumes constant rx power over the packet duration
   if ((rxPowerDbm + phy->GetRxGain ()) < phy->GetRxSensitivity ())
@@ -132,7 +419,7 @@ YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<Packet> packet, double rxPow
       NS_LOG_INFO ("Received signal too weak to process: " << rxPowerDbm << " dBm");
       return;
     }
-  phy->StartReceivePreamble (packet, DbmToW (rxPowerDbm + phy->GetRxGain ()), duration);
+  phy->StartReceivePreamble (ppdu, DbmToW (rxPowerDbm + phy->GetRxGain ()), duration);
 }
 
 std::size_t
@@ -152,6 +439,8 @@ YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
   m_phyList.push_back (phy);
+  phy->SetRxThresholdChangedCallback (MakeCallback (&YansWifiChannel::NotifyRxThresholdChanged, this));
+  m_thresholdValid = false;
 }
 
 int64_t
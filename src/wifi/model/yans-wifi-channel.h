@@ -21,15 +21,21 @@
 #ifndef YANS_WIFI_CHANNEL_H
 #define YANS_WIFI_CHANNEL_H
 
+#include <vector>
+#include <unordered_map>
 #include "ns3/channel.h"
+#include "ns3/vector.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
 class NetDevice;
+class MobilityModel;
 class PropagationLossModel;
 class PropagationDelayModel;
 class YansWifiPhy;
 class Packet;
+class WifiPpdu;
 class Time;
 
 /**
@@ -40,6 +46,26 @@ class Time;
  * class and supports an ns3::PropagationLossModel and an
  * ns3::PropagationDelayModel.  By default, no propagation models are set;
  * it is the caller's responsibility to set them before using the channel.
+ *
+ * With the SpatialCulling attribute set, the channel keeps the PHYs in a
+ * grid indexed by their position, and delivers a packet only to the PHYs
+ * near enough to receive it: those beyond the range at which the
+ * reception power falls below the lowest receive sensitivity of the
+ * channel are skipped, instead of being scheduled a reception which they
+ * would drop.  The range is given by the propagation loss model (see
+ * PropagationLossModel::GetMaxRange), so that the PHYs in range receive
+ * exactly what they would receive without culling.  Culling is only done
+ * with a loss model giving such a range and a constant speed propagation
+ * delay model, since random models would draw different numbers.
+ *
+ * The grid is updated on the course changes of the mobility models; the
+ * PHYs moving between course changes are placed again once they may have
+ * moved by half a cell.  This assumes that the velocity of the mobility
+ * models only changes with a course change notification, so that culling
+ * is only done if all the PHYs follow mobility models known to do so:
+ * the constant position, constant velocity, waypoint (unless its
+ * LazyNotify attribute is set), random walk, random waypoint, random
+ * direction, steady-state random waypoint and Gauss-Markov models.
  */
 class YansWifiChannel : public Channel
 {
@@ -98,27 +124,111 @@ public:
   int64_t AssignStreams (int64_t stream);
 
 
+protected:
+  virtual void DoDispose (void);
+
 private:
   /**
    * A vector of pointers to YansWifiPhy.
    */
   typedef std::vector<Ptr<YansWifiPhy> > PhyList;
 
+  /// A PHY in the grid
+  struct GridEntry
+  {
+    Ptr<MobilityModel> mobility; //!< the mobility model followed
+    uint64_t cell;               //!< the cell of the PHY
+    double speed;                //!< the speed of the PHY when placed (m/s)
+    bool moving;                 //!< true if the PHY is in the list of moving PHYs
+  };
+
+  /**
+   * Deliver a PPDU to a PHY, scheduling its reception
+   *
+   * \param sender the PHY sending the PPDU
+   * \param senderMobility the mobility model of the sender
+   * \param receiver the PHY to deliver to
+   * \param ppdu the PPDU being sent, shared by all the receivers
+   * \param txPowerDbm the tx power associated to the packet being sent (dBm)
+   * \param duration the transmission duration associated with the packet being sent
+   */
+  void SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+               Ptr<const WifiPpdu> ppdu, double txPowerDbm, Time duration) const;
+  /**
+   * \param txPowerDbm the tx power of a packet (dBm)
+   * \return the distance beyond which no PHY can receive the packet, or
+   * infinity if the receivers cannot be culled
+   */
+  double GetCullingRange (double txPowerDbm) const;
+  /**
+   * Build the grid of the PHYs
+   * \param cellSize the size of the cells (m)
+   */
+  void BuildGrid (double cellSize) const;
+  /**
+   * \param position a position
+   * \return the cell containing the position
+   */
+  uint64_t GetCell (const Vector &position) const;
+  /**
+   * Place a PHY in the cell of its current position
+   * \param index the index of the PHY
+   */
+  void Place (uint32_t index) const;
+  /**
+   * Remove a PHY from its cell
+   * \param index the index of the PHY
+   */
+  void Unplace (uint32_t index) const;
+  /**
+   * Place again the moving PHYs, if they may have moved by more than the slack
+   */
+  void UpdateMovingPhys (void) const;
+  /**
+   * Find the PHYs which may be within a distance of a position
+   * \param position the position
+   * \param range the distance (m)
+   */
+  void FindCandidates (const Vector &position, double range) const;
+  /**
+   * Invalidate the lowest receive threshold of the PHYs
+   */
+  void NotifyRxThresholdChanged (void);
+  /**
+   * Place a PHY in the grid again after a course change
+   * \param channel the channel
+   * \param index the index of the PHY
+   * \param mobility the mobility model of the PHY
+   */
+  static void CourseChanged (const YansWifiChannel *channel, uint32_t index, Ptr<const MobilityModel> mobility);
+
   /**
    * This method is scheduled by Send for each associated YansWifiPhy.
    * The method then calls the corresponding YansWifiPhy that the first
    * bit of the packet has arrived.
    *
    * \param receiver the device to which the packet is destined
-   * \param packet the packet being sent
+   * \param ppdu the PPDU being sent
    * \param txPowerDbm the tx power associated to the packet being sent (dBm)
    * \param duration the transmission duration associated with the packet being sent
    */
-  static void Receive (Ptr<YansWifiPhy> receiver, Ptr<Packet> packet, double txPowerDbm, Time duration);
+  static void Receive (Ptr<YansWifiPhy> receiver, Ptr<const WifiPpdu> ppdu, double txPowerDbm, Time duration);
 
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  bool m_spatialCulling;               //!< true to skip the PHYs out of range
+
+  mutable bool m_thresholdValid;                  //!< true if m_rxThresholdDbm is up to date
+  mutable double m_rxThresholdDbm;                //!< lowest receive sensitivity minus reception gain of the PHYs (dBm)
+  mutable std::vector<GridEntry> m_grid;          //!< the PHYs in the grid, by index
+  mutable std::unordered_map<uint64_t, std::vector<uint32_t> > m_cells; //!< the PHYs of each non-empty cell
+  mutable double m_cellSize;                      //!< the size of the cells (m)
+  mutable std::vector<uint32_t> m_moving;         //!< the PHYs moving when last placed
+  mutable double m_maxSpeed;                      //!< upper bound of the speed of the moving PHYs (m/s)
+  mutable Time m_lastUpdate;                      //!< time the moving PHYs were last placed
+  mutable std::vector<uint32_t> m_candidates;     //!< the PHYs found by FindCandidates
+  mutable bool m_untrackedMobility;               //!< true if the velocity of a PHY may change without a course change
 };
 
 } //namespace ns3
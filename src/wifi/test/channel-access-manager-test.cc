@@ -20,6 +20,7 @@
 
 #include "ns3/test.h"
 #include "ns3/simulator.h"
+#include "ns3/boolean.h"
 #include "ns3/channel-access-manager.h"
 #include "ns3/txop.h"
 #include "ns3/mac-low.h"
@@ -115,7 +116,12 @@ public:
 class ChannelAccessManagerTest : public TestCase
 {
 public:
-  ChannelAccessManagerTest ();
+  /**
+   * Constructor
+   *
+   * \param coalescedBackoff whether the access timeouts are coalesced
+   */
+  ChannelAccessManagerTest (bool coalescedBackoff);
   virtual void DoRun (void);
 
   /**
@@ -271,6 +277,7 @@ private:
   Ptr<ChannelAccessManager> m_ChannelAccessManager; //!< the DCF manager
   TxopTests m_txop; //!< the TXOP
   uint32_t m_ackTimeoutValue; //!< the ack timeout value
+  bool m_coalescedBackoff; //!< whether the access timeouts are coalesced
 };
 
 void
@@ -340,8 +347,9 @@ TxopTest::NotifyWakeUp (void)
 {
 }
 
-ChannelAccessManagerTest::ChannelAccessManagerTest ()
-  : TestCase ("ChannelAccessManager")
+ChannelAccessManagerTest::ChannelAccessManagerTest (bool coalescedBackoff)
+  : TestCase (coalescedBackoff ? "ChannelAccessManager with coalesced backoff" : "ChannelAccessManager"),
+    m_coalescedBackoff (coalescedBackoff)
 {
 }
 
@@ -433,6 +441,7 @@ void
 ChannelAccessManagerTest::StartTest (uint64_t slotTime, uint64_t sifs, uint64_t eifsNoDifsNoSifs, uint32_t ackTimeoutValue)
 {
   m_ChannelAccessManager = CreateObject<ChannelAccessManager> ();
+  m_ChannelAccessManager->SetAttribute ("CoalescedBackoff", BooleanValue (m_coalescedBackoff));
   m_low = CreateObject<MacLowStub> ();
   m_ChannelAccessManager->SetupLow (m_low);
   m_ChannelAccessManager->SetSlot (MicroSeconds (slotTime));
@@ -940,7 +949,8 @@ public:
 DcfTestSuite::DcfTestSuite ()
   : TestSuite ("devices-wifi-dcf", UNIT)
 {
-  AddTestCase (new ChannelAccessManagerTest, TestCase::QUICK);
+  AddTestCase (new ChannelAccessManagerTest (false), TestCase::QUICK);
+  AddTestCase (new ChannelAccessManagerTest (true), TestCase::QUICK);
 }
 
 static DcfTestSuite g_dcfTestSuite;
@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/yans-wifi-phy.h"
+#include "ns3/uinteger.h"
 
 using namespace ns3;
 
@@ -426,6 +427,152 @@ TxDurationTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (retval, true, "an 802.11ax duration failed");
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Tx Duration Cache Test
+ *
+ * Frames and A-MPDUs of various sizes and TXVECTORs are timed by a PHY
+ * with a duration cache and by a PHY without, and both durations must be
+ * equal. The A-MPDUs are timed as MacLow does, interleaving the subframes
+ * that update the A-MPDU state with lookups that do not.
+ */
+class TxDurationCacheTest : public TestCase
+{
+public:
+  TxDurationCacheTest ();
+  virtual ~TxDurationCacheTest ();
+  virtual void DoRun (void);
+
+
+private:
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * Check that both PHYs give the same durations for a frame.
+   *
+   * \param size the size of the frame
+   * \param txVector the TXVECTOR of the frame
+   * \param frequency the channel center frequency (MHz)
+   * \param mpdutype the type of the MPDU
+   * \param incFlag whether the A-MPDU state is updated
+   */
+  void Check (uint32_t size, WifiTxVector txVector, uint16_t frequency, MpduType mpdutype, uint8_t incFlag);
+
+  Ptr<YansWifiPhy> m_cached;   ///< the PHY with a duration cache
+  Ptr<YansWifiPhy> m_uncached; ///< the PHY without a duration cache
+  uint64_t m_nCalls;           ///< number of calls to the cached PHY
+  uint32_t m_state;            ///< state of the pseudo-random generator
+};
+
+TxDurationCacheTest::TxDurationCacheTest ()
+  : TestCase ("Wifi TX Duration cache"),
+    m_nCalls (0),
+    m_state (2463534242U)
+{
+}
+
+TxDurationCacheTest::~TxDurationCacheTest ()
+{
+}
+
+uint32_t
+TxDurationCacheTest::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+void
+TxDurationCacheTest::Check (uint32_t size, WifiTxVector txVector, uint16_t frequency, MpduType mpdutype, uint8_t incFlag)
+{
+  Time expected = m_uncached->CalculateTxDuration (size, txVector, frequency, mpdutype, incFlag);
+  Time duration = m_cached->CalculateTxDuration (size, txVector, frequency, mpdutype, incFlag);
+  NS_TEST_ASSERT_MSG_EQ (duration, expected, "Wrong duration for size=" << size << " " << txVector
+                         << " mpdutype=" << mpdutype << " incFlag=" << +incFlag);
+  m_nCalls++;
+  if (incFlag == 0)
+    {
+      expected = m_uncached->GetPayloadDuration (size, txVector, frequency, mpdutype, 0);
+      duration = m_cached->GetPayloadDuration (size, txVector, frequency, mpdutype, 0);
+      NS_TEST_ASSERT_MSG_EQ (duration, expected, "Wrong payload duration for size=" << size << " " << txVector
+                             << " mpdutype=" << mpdutype);
+      m_nCalls++;
+    }
+}
+
+void
+TxDurationCacheTest::DoRun (void)
+{
+  m_cached = CreateObject<YansWifiPhy> ();
+  m_uncached = CreateObject<YansWifiPhy> ();
+  m_uncached->SetAttribute ("DurationCacheSize", UintegerValue (0));
+
+  std::vector<WifiTxVector> txVectors;
+  WifiTxVector txVector;
+  txVector.SetNss (1);
+  txVector.SetNess (0);
+  txVector.SetStbc (0);
+  txVector.SetMode (WifiPhy::GetDsssRate11Mbps ());
+  txVector.SetPreambleType (WIFI_PREAMBLE_LONG);
+  txVector.SetChannelWidth (22);
+  txVector.SetGuardInterval (800);
+  txVectors.push_back (txVector);
+  txVector.SetMode (WifiPhy::GetOfdmRate54Mbps ());
+  txVector.SetChannelWidth (20);
+  txVectors.push_back (txVector);
+  txVector.SetMode (WifiPhy::GetHtMcs7 ());
+  txVector.SetPreambleType (WIFI_PREAMBLE_HT_MF);
+  txVector.SetGuardInterval (400);
+  txVectors.push_back (txVector);
+  txVector.SetGuardInterval (800);
+  txVectors.push_back (txVector);
+  txVector.SetMode (WifiPhy::GetVhtMcs9 ());
+  txVector.SetPreambleType (WIFI_PREAMBLE_VHT_SU);
+  txVector.SetChannelWidth (80);
+  txVectors.push_back (txVector);
+  txVector.SetMode (WifiPhy::GetHeMcs11 ());
+  txVector.SetPreambleType (WIFI_PREAMBLE_HE_SU);
+  txVectors.push_back (txVector);
+  uint32_t sizes[] = {14, 20, 32, 1500, 1538};
+  uint16_t frequencies[] = {CHANNEL_1_MHZ, CHANNEL_36_MHZ};
+
+  for (uint32_t i = 0; i < 5000; i++)
+    {
+      txVector = txVectors[Random () % txVectors.size ()];
+      uint16_t frequency = frequencies[Random () % 2];
+      if (txVector.GetMode ().GetModulationClass () < WIFI_MOD_CLASS_HT || Random () % 2 == 0)
+        {
+          Check (sizes[Random () % 5], txVector, frequency, NORMAL_MPDU, 0);
+          continue;
+        }
+      uint32_t nMpdus = 1 + Random () % 8;
+      for (uint32_t j = 0; j < nMpdus; j++)
+        {
+          MpduType mpdutype = (nMpdus == 1) ? SINGLE_MPDU
+            : (j == 0) ? FIRST_MPDU_IN_AGGREGATE
+            : (j + 1 == nMpdus) ? LAST_MPDU_IN_AGGREGATE : MIDDLE_MPDU_IN_AGGREGATE;
+          uint32_t size = sizes[Random () % 5];
+          // Duration lookups without updating the A-MPDU state
+          Check (size, txVector, frequency, mpdutype, 0);
+          Check (size, txVector, frequency, mpdutype, 1);
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (m_cached->GetDurationCacheHits () + m_cached->GetDurationCacheMisses (), m_nCalls,
+                         "Wrong number of cache lookups");
+  NS_TEST_ASSERT_MSG_GT (m_cached->GetDurationCacheHits (), m_nCalls / 2, "Too few durations found in the cache");
+  NS_TEST_ASSERT_MSG_EQ (m_uncached->GetDurationCacheHits (), 0, "Durations found in a disabled cache");
+  m_cached->Dispose ();
+  m_uncached->Dispose ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -442,6 +589,7 @@ TxDurationTestSuite::TxDurationTestSuite ()
   : TestSuite ("devices-wifi-tx-duration", UNIT)
 {
   AddTestCase (new TxDurationTest, TestCase::QUICK);
+  AddTestCase (new TxDurationCacheTest, TestCase::QUICK);
 }
 
 static TxDurationTestSuite g_txDurationTestSuite; ///< the test suite
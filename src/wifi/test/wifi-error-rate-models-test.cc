@@ -22,6 +22,10 @@
 #include "ns3/test.h"
 #include "ns3/nist-error-rate-model.h"
 #include "ns3/dsss-error-rate-model.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+#include "ns3/double.h"
 #include "ns3/wifi-tx-vector.h"
 
 using namespace ns3;
@@ -291,6 +295,87 @@ WifiErrorRateModelsTestCaseNist::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (ps, 0.999, 0.001, "Not equal within tolerance");
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Wifi Error Rate Models Test Case Tabulated
+ *
+ * The success rates of a TabulatedErrorRateModel are compared with those of
+ * the model it tabulates, for DSSS, OFDM, HT, VHT and HE modes, over the
+ * tabulated SNR range and beyond, and for chunks of a few bits up to large
+ * A-MPDUs.
+ */
+class WifiErrorRateModelsTestCaseTabulated : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param model the type of the tabulated error rate model
+   * \param accuracy the accuracy of the tables
+   */
+  WifiErrorRateModelsTestCaseTabulated (TypeId model, double accuracy);
+  virtual ~WifiErrorRateModelsTestCaseTabulated ();
+
+private:
+  virtual void DoRun (void);
+
+  TypeId m_model;    ///< the type of the tabulated error rate model
+  double m_accuracy; ///< the accuracy of the tables
+};
+
+WifiErrorRateModelsTestCaseTabulated::WifiErrorRateModelsTestCaseTabulated (TypeId model, double accuracy)
+  : TestCase ("WifiErrorRateModel test case tabulated " + model.GetName ()),
+    m_model (model),
+    m_accuracy (accuracy)
+{
+}
+
+WifiErrorRateModelsTestCaseTabulated::~WifiErrorRateModelsTestCaseTabulated ()
+{
+}
+
+void
+WifiErrorRateModelsTestCaseTabulated::DoRun (void)
+{
+  Ptr<TabulatedErrorRateModel> tabulated = CreateObject<TabulatedErrorRateModel> ();
+  tabulated->SetAttribute ("Model", TypeIdValue (m_model));
+  tabulated->SetAttribute ("Accuracy", DoubleValue (m_accuracy));
+  Ptr<ErrorRateModel> model = tabulated->GetModel ();
+  NS_TEST_ASSERT_MSG_EQ (model->GetInstanceTypeId (), m_model, "Wrong tabulated model");
+
+  std::vector<WifiMode> modes;
+  modes.push_back (WifiPhy::GetDsssRate1Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate11Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate6Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate54Mbps ());
+  modes.push_back (WifiPhy::GetHtMcs7 ());
+  modes.push_back (WifiPhy::GetVhtMcs9 ());
+  modes.push_back (WifiPhy::GetHeMcs11 ());
+  uint64_t sizes[] = {1, 100, 12000, 1000000};
+
+  for (std::vector<WifiMode>::const_iterator mode = modes.begin (); mode != modes.end (); ++mode)
+    {
+      WifiTxVector txVector;
+      txVector.SetMode (*mode);
+      txVector.SetChannelWidth (40);
+      // An irregular step, so that the SNRs fall anywhere between the points of the tables
+      for (double snr = -12.0; snr < 62.0; snr += 0.0137)
+        {
+          for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i)
+            {
+              double ratio = std::pow (10.0, snr / 10.0);
+              double expected = model->GetChunkSuccessRate (*mode, txVector, ratio, sizes[i]);
+              double ps = tabulated->GetChunkSuccessRate (*mode, txVector, ratio, sizes[i]);
+              NS_TEST_ASSERT_MSG_EQ_TOL (ps, expected, m_accuracy,
+                                         "Wrong success rate for " << *mode << " at " << snr << " dB for " << sizes[i] << " bits");
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (tabulated->GetChunkSuccessRate (*mode, txVector, 1000.0, 0), 1.0, "Wrong success rate of an empty chunk");
+    }
+  tabulated->Dispose ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -308,6 +393,8 @@ WifiErrorRateModelsTestSuite::WifiErrorRateModelsTestSuite ()
 {
   AddTestCase (new WifiErrorRateModelsTestCaseDsss, TestCase::QUICK);
   AddTestCase (new WifiErrorRateModelsTestCaseNist, TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTabulated (NistErrorRateModel::GetTypeId (), 1e-4), TestCase::QUICK);
+  AddTestCase (new WifiErrorRateModelsTestCaseTabulated (YansErrorRateModel::GetTypeId (), 1e-6), TestCase::QUICK);
 }
 
 static WifiErrorRateModelsTestSuite wifiErrorRateModelsTestSuite; ///< the test suite
@@ -21,6 +21,7 @@
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/rng-seed-manager.h"
 #include "ns3/spectrum-wifi-helper.h"
@@ -2175,6 +2176,226 @@ TestAmpduReception::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Reception with the abstraction
+ *
+ * With the abstraction, the PHY moves to RX as soon as a preamble is
+ * detected, and the packet is only decided at its end, from the
+ * effective SNR over its whole duration.
+ */
+class TestAbstractionReception : public TestCase
+{
+public:
+  TestAbstractionReception ();
+  virtual ~TestAbstractionReception ();
+
+private:
+  virtual void DoSetup (void);
+  virtual void DoRun (void);
+
+  /**
+   * Send packet function
+   * \param rxPowerDbm the transmit power in dBm
+   */
+  void SendPacket (double rxPowerDbm);
+  /**
+   * Spectrum wifi receive success function
+   * \param p the packet
+   * \param snr the SNR
+   * \param txVector the transmit vector
+   * \param statusPerMpdu reception status per MPDU
+   */
+  void RxSuccess (Ptr<Packet> p, double snr, WifiTxVector txVector, std::vector<bool> statusPerMpdu);
+  /**
+   * Spectrum wifi receive failure function
+   * \param p the packet
+   */
+  void RxFailure (Ptr<Packet> p);
+  /**
+   * Check the PHY state
+   * \param expectedState the expected PHY state
+   */
+  void CheckPhyState (WifiPhyState expectedState);
+  /**
+   * Check the PHY state now
+   * \param expectedState the expected PHY state
+   */
+  void DoCheckPhyState (WifiPhyState expectedState);
+  /**
+   * Check the number of received packets
+   * \param expectedSuccessCount the number of successfully received packets
+   * \param expectedFailureCount the number of unsuccessfully received packets
+   */
+  void CheckRxPacketCount (uint32_t expectedSuccessCount, uint32_t expectedFailureCount);
+
+  Ptr<SpectrumWifiPhy> m_phy; ///< Phy
+  uint32_t m_countRxSuccess;  ///< count RX success
+  uint32_t m_countRxFailure;  ///< count RX failure
+};
+
+TestAbstractionReception::TestAbstractionReception ()
+  : TestCase ("Reception with the abstraction"),
+    m_countRxSuccess (0),
+    m_countRxFailure (0)
+{
+}
+
+TestAbstractionReception::~TestAbstractionReception ()
+{
+  m_phy = 0;
+}
+
+void
+TestAbstractionReception::SendPacket (double rxPowerDbm)
+{
+  WifiTxVector txVector = WifiTxVector (WifiPhy::GetHeMcs7 (), 0, WIFI_PREAMBLE_HE_SU, 800, 1, 1, 0, 20, false, false);
+
+  Ptr<Packet> pkt = Create<Packet> (1000);
+  WifiMacHeader hdr;
+  WifiMacTrailer trailer;
+
+  hdr.SetType (WIFI_MAC_QOSDATA);
+  hdr.SetQosTid (0);
+  uint32_t size = pkt->GetSize () + hdr.GetSize () + trailer.GetSerializedSize ();
+  Time txDuration = m_phy->CalculateTxDuration (size, txVector, m_phy->GetFrequency ());
+  hdr.SetDuration (txDuration);
+
+  pkt->AddHeader (hdr);
+  pkt->AddTrailer (trailer);
+
+  HeSigHeader heSig;
+  heSig.SetMcs (txVector.GetMode ().GetMcsValue ());
+  heSig.SetBssColor (txVector.GetBssColor ());
+  heSig.SetChannelWidth (txVector.GetChannelWidth ());
+  heSig.SetGuardIntervalAndLtfSize (txVector.GetGuardInterval (), 2);
+  pkt->AddHeader (heSig);
+
+  LSigHeader sig;
+  pkt->AddHeader (sig);
+
+  WifiPhyTag tag (txVector.GetPreambleType (), txVector.GetMode ().GetModulationClass (), 1);
+  pkt->AddPacketTag (tag);
+
+  Ptr<SpectrumValue> txPowerSpectrum = WifiSpectrumValueHelper::CreateHeOfdmTxPowerSpectralDensity (FREQUENCY, CHANNEL_WIDTH, DbmToW (rxPowerDbm), GUARD_WIDTH);
+  Ptr<WifiSpectrumSignalParameters> txParams = Create<WifiSpectrumSignalParameters> ();
+  txParams->psd = txPowerSpectrum;
+  txParams->txPhy = 0;
+  txParams->duration = txDuration;
+  txParams->packet = pkt;
+
+  m_phy->StartRx (txParams);
+}
+
+void
+TestAbstractionReception::CheckPhyState (WifiPhyState expectedState)
+{
+  //This is needed to make sure PHY state will be checked as the last event if a state change occured at the exact same time as the check
+  Simulator::ScheduleNow (&TestAbstractionReception::DoCheckPhyState, this, expectedState);
+}
+
+void
+TestAbstractionReception::DoCheckPhyState (WifiPhyState expectedState)
+{
+  PointerValue ptr;
+  m_phy->GetAttribute ("State", ptr);
+  Ptr <WifiPhyStateHelper> state = DynamicCast <WifiPhyStateHelper> (ptr.Get<WifiPhyStateHelper> ());
+  WifiPhyState currentState = state->GetState ();
+  NS_TEST_ASSERT_MSG_EQ (currentState, expectedState, "PHY State " << currentState << " does not match expected state " << expectedState << " at " << Simulator::Now ());
+}
+
+void
+TestAbstractionReception::CheckRxPacketCount (uint32_t expectedSuccessCount, uint32_t expectedFailureCount)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_countRxSuccess, expectedSuccessCount, "Didn't receive right number of successful packets");
+  NS_TEST_ASSERT_MSG_EQ (m_countRxFailure, expectedFailureCount, "Didn't receive right number of unsuccessful packets");
+}
+
+void
+TestAbstractionReception::RxSuccess (Ptr<Packet> p, double snr, WifiTxVector txVector, std::vector<bool> statusPerMpdu)
+{
+  NS_LOG_FUNCTION (this << p << snr << txVector);
+  m_countRxSuccess++;
+}
+
+void
+TestAbstractionReception::RxFailure (Ptr<Packet> p)
+{
+  NS_LOG_FUNCTION (this << p);
+  m_countRxFailure++;
+}
+
+void
+TestAbstractionReception::DoSetup (void)
+{
+  m_phy = CreateObject<SpectrumWifiPhy> ();
+  m_phy->SetAttribute ("Abstraction", BooleanValue (true));
+  m_phy->ConfigureStandard (WIFI_PHY_STANDARD_80211ax_5GHZ);
+  Ptr<ErrorRateModel> error = CreateObject<NistErrorRateModel> ();
+  m_phy->SetErrorRateModel (error);
+  m_phy->SetChannelNumber (CHANNEL_NUMBER);
+  m_phy->SetFrequency (FREQUENCY);
+  m_phy->SetReceiveOkCallback (MakeCallback (&TestAbstractionReception::RxSuccess, this));
+  m_phy->SetReceiveErrorCallback (MakeCallback (&TestAbstractionReception::RxFailure, this));
+
+  Ptr<ThresholdPreambleDetectionModel> preambleDetectionModel = CreateObject<ThresholdPreambleDetectionModel> ();
+  preambleDetectionModel->SetAttribute ("Threshold", DoubleValue (4));
+  preambleDetectionModel->SetAttribute ("MinimumRssi", DoubleValue (-82));
+  m_phy->SetPreambleDetectionModel (preambleDetectionModel);
+}
+
+void
+TestAbstractionReception::DoRun (void)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  int64_t streamNumber = 0;
+  m_phy->AssignStreams (streamNumber);
+
+  double rxPowerDbm = -50;
+
+  // CASE 1: send one packet: PHY state should be RX from the arrival of the
+  // packet until its end 152.8us later, and the packet should be received.
+  Simulator::Schedule (Seconds (1.0), &TestAbstractionReception::SendPacket, this, rxPowerDbm);
+  Simulator::Schedule (Seconds (1.0) + NanoSeconds (1), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::RX);
+  Simulator::Schedule (Seconds (1.0) + NanoSeconds (152799), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::RX);
+  Simulator::Schedule (Seconds (1.0) + NanoSeconds (152800), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::IDLE);
+  Simulator::Schedule (Seconds (1.1), &TestAbstractionReception::CheckRxPacketCount, this, 1, 0);
+
+  // CASE 2: send two packets with the same power 2us apart: the preamble of
+  // the first one is detected before the second one arrives, but the
+  // effective SNR of the first one (around 0 dB) is too low to decode it.
+  // The second one keeps the PHY in CCA_BUSY for 2us, as it is above CCA-ED.
+  Simulator::Schedule (Seconds (2.0), &TestAbstractionReception::SendPacket, this, rxPowerDbm);
+  Simulator::Schedule (Seconds (2.0) + MicroSeconds (2.0), &TestAbstractionReception::SendPacket, this, rxPowerDbm);
+  Simulator::Schedule (Seconds (2.0) + NanoSeconds (1), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::RX);
+  Simulator::Schedule (Seconds (2.0) + NanoSeconds (152799), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::RX);
+  Simulator::Schedule (Seconds (2.0) + NanoSeconds (152800), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::CCA_BUSY);
+  Simulator::Schedule (Seconds (2.0) + NanoSeconds (154799), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::CCA_BUSY);
+  Simulator::Schedule (Seconds (2.0) + NanoSeconds (154800), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::IDLE);
+  Simulator::Schedule (Seconds (2.1), &TestAbstractionReception::CheckRxPacketCount, this, 1, 1);
+
+  // CASE 3: send two packets with the second one 25 dB weaker 2us apart:
+  // the effective SNR of the first one (around 25 dB) is high enough to
+  // decode it, and the second one is below CCA-ED.
+  Simulator::Schedule (Seconds (3.0), &TestAbstractionReception::SendPacket, this, rxPowerDbm);
+  Simulator::Schedule (Seconds (3.0) + MicroSeconds (2.0), &TestAbstractionReception::SendPacket, this, rxPowerDbm - 25);
+  Simulator::Schedule (Seconds (3.0) + NanoSeconds (152799), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::RX);
+  Simulator::Schedule (Seconds (3.0) + NanoSeconds (152800), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::IDLE);
+  Simulator::Schedule (Seconds (3.1), &TestAbstractionReception::CheckRxPacketCount, this, 2, 1);
+
+  // CASE 4: send one packet below the minimum RSSI of the preamble detection
+  // (-82 dBm): the preamble should not be detected and PHY should stay IDLE.
+  Simulator::Schedule (Seconds (4.0), &TestAbstractionReception::SendPacket, this, -83);
+  Simulator::Schedule (Seconds (4.0) + NanoSeconds (1), &TestAbstractionReception::CheckPhyState, this, WifiPhyState::IDLE);
+  Simulator::Schedule (Seconds (4.1), &TestAbstractionReception::CheckRxPacketCount, this, 2, 1);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -2195,6 +2416,7 @@ WifiPhyReceptionTestSuite::WifiPhyReceptionTestSuite ()
   AddTestCase (new TestSimpleFrameCaptureModel, TestCase::QUICK);
   AddTestCase (new TestPhyHeadersReception, TestCase::QUICK);
   AddTestCase (new TestAmpduReception, TestCase::QUICK);
+  AddTestCase (new TestAbstractionReception, TestCase::QUICK);
 }
 
 static WifiPhyReceptionTestSuite wifiPhyReceptionTestSuite; ///< the test suite
@@ -46,6 +46,20 @@
 #include "ns3/mgt-headers.h"
 #include "ns3/ht-configuration.h"
 #include "ns3/wifi-phy-header.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/constant-acceleration-mobility-model.h"
+#include "ns3/interference-helper.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/tabulated-error-rate-model.h"
+#include "ns3/minstrel-ht-wifi-manager.h"
+#include "ns3/random-variable-stream.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <set>
 
 using namespace ns3;
 
@@ -2174,6 +2188,1198 @@ Bug2470TestCase::DoRun (void)
   // but before it does not enter RESET state. More tests should be written to verify all possible scenarios.
 }
 
+//-----------------------------------------------------------------------------
+/**
+ * Base class of the test cases which make sure that an option does not
+ * change the outcome of a simulation.
+ *
+ * Adhoc stations laid out on a grid send frames. The traces of a run with
+ * the option are compared with those of a reference run without it.
+ */
+class WifiGridComparisonTestCase : public TestCase
+{
+protected:
+  /**
+   * Constructor
+   * \param name the name of the test case
+   */
+  WifiGridComparisonTestCase (std::string name);
+
+  /**
+   * Start a new simulation with adhoc stations laid out on a grid, whose
+   * random variables are assigned fixed streams
+   *
+   * \param nNodes the number of stations
+   * \param gridWidth the number of stations in a row of the grid
+   * \param delta the distance between neighbouring stations (m)
+   * \param mobilityModel the type of the mobility models
+   * \param phy the PHY helper, with its channel set
+   * \param mac the MAC helper
+   * \param dataMode the mode of the data frames
+   * \return the devices of the stations
+   */
+  NetDeviceContainer CreateGrid (uint32_t nNodes, uint32_t gridWidth, double delta, std::string mobilityModel,
+                                 const YansWifiPhyHelper &phy, const WifiMacHelper &mac, std::string dataMode);
+  /**
+   * Send one packet function
+   * \param dev the device
+   * \param dest the destination
+   * \param size the size of the packet
+   */
+  void SendOnePacket (Ptr<WifiNetDevice> dev, Address dest, uint32_t size);
+  /**
+   * Run the simulation, then destroy it
+   * \param stop the end of the simulation
+   * \param traces where to record the traces of the run
+   * \return the number of events processed by the simulator
+   */
+  uint64_t Run (Time stop, std::vector<std::string> *traces);
+  /**
+   * Check that a run gives the same traces as the reference run
+   * \param reference the traces of the reference run
+   * \param traces the traces of the run with the option
+   * \param minTraces the number of traces above which the comparison is significant
+   * \param option the option, for the messages
+   */
+  void CheckTraces (const std::vector<std::string> &reference, const std::vector<std::string> &traces,
+                    uint32_t minTraces, std::string option);
+
+  /**
+   * Record a PHY trace
+   * \param context the context
+   * \param p the packet
+   */
+  void RecordPacket (std::string context, Ptr<const Packet> p);
+  /**
+   * Record a PHY transmission trace
+   * \param context the context
+   * \param p the packet
+   * \param txPowerW the transmit power (W)
+   */
+  void RecordTx (std::string context, Ptr<const Packet> p, double txPowerW);
+  /**
+   * Record a PHY drop trace
+   * \param context the context
+   * \param p the packet
+   * \param reason the reason of the drop
+   */
+  void RecordDrop (std::string context, Ptr<const Packet> p, WifiPhyRxfailureReason reason);
+  /**
+   * Record a successful reception, with its SNR
+   * \param context the context
+   * \param p the packet
+   * \param snr the SNR
+   * \param mode the mode
+   * \param preamble the preamble
+   */
+  void RecordRxOk (std::string context, Ptr<const Packet> p, double snr, WifiMode mode, WifiPreamble preamble);
+  /**
+   * Record a failed reception, with its SNR
+   * \param context the context
+   * \param p the packet
+   * \param snr the SNR
+   */
+  void RecordRxError (std::string context, Ptr<const Packet> p, double snr);
+
+private:
+  /**
+   * Record an event of the current run
+   * \param context the context
+   * \param event the description of the event
+   */
+  void Record (std::string context, std::string event);
+
+  std::vector<std::string> *m_traces; ///< the traces of the current run
+};
+
+WifiGridComparisonTestCase::WifiGridComparisonTestCase (std::string name)
+  : TestCase (name),
+    m_traces (0)
+{
+}
+
+NetDeviceContainer
+WifiGridComparisonTestCase::CreateGrid (uint32_t nNodes, uint32_t gridWidth, double delta, std::string mobilityModel,
+                                        const YansWifiPhyHelper &phy, const WifiMacHelper &mac, std::string dataMode)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  NodeContainer nodes;
+  nodes.Create (nNodes);
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue (dataMode));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  wifi.AssignStreams (devices, 1);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (delta),
+                                 "DeltaY", DoubleValue (delta),
+                                 "GridWidth", UintegerValue (gridWidth),
+                                 "LayoutType", StringValue ("RowFirst"));
+  mobility.SetMobilityModel (mobilityModel);
+  mobility.Install (nodes);
+  return devices;
+}
+
+void
+WifiGridComparisonTestCase::SendOnePacket (Ptr<WifiNetDevice> dev, Address dest, uint32_t size)
+{
+  Ptr<Packet> p = Create<Packet> (size);
+  dev->Send (p, dest, 1);
+}
+
+uint64_t
+WifiGridComparisonTestCase::Run (Time stop, std::vector<std::string> *traces)
+{
+  m_traces = traces;
+  Simulator::Stop (stop);
+  Simulator::Run ();
+  uint64_t nEvents = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  m_traces = 0;
+  return nEvents;
+}
+
+void
+WifiGridComparisonTestCase::CheckTraces (const std::vector<std::string> &reference, const std::vector<std::string> &traces,
+                                         uint32_t minTraces, std::string option)
+{
+  NS_TEST_ASSERT_MSG_GT (reference.size (), minTraces, "Too few traces to be significant");
+  NS_TEST_ASSERT_MSG_EQ (traces.size (), reference.size (), "Different number of traces with " << option);
+  for (uint32_t i = 0; i < std::min (traces.size (), reference.size ()); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (traces[i], reference[i], "Different trace " << i << " with " << option);
+    }
+}
+
+void
+WifiGridComparisonTestCase::Record (std::string context, std::string event)
+{
+  std::ostringstream os;
+  os << Simulator::Now ().GetTimeStep () << " " << context << " " << event;
+  m_traces->push_back (os.str ());
+}
+
+void
+WifiGridComparisonTestCase::RecordPacket (std::string context, Ptr<const Packet> p)
+{
+  std::ostringstream os;
+  os << p->GetSize ();
+  Record (context, os.str ());
+}
+
+void
+WifiGridComparisonTestCase::RecordTx (std::string context, Ptr<const Packet> p, double txPowerW)
+{
+  std::ostringstream os;
+  os << p->GetSize ();
+  Record (context, os.str ());
+}
+
+void
+WifiGridComparisonTestCase::RecordDrop (std::string context, Ptr<const Packet> p, WifiPhyRxfailureReason reason)
+{
+  std::ostringstream os;
+  os << p->GetSize () << " " << reason;
+  Record (context, os.str ());
+}
+
+void
+WifiGridComparisonTestCase::RecordRxOk (std::string context, Ptr<const Packet> p, double snr, WifiMode mode, WifiPreamble preamble)
+{
+  std::ostringstream os;
+  os.precision (17);
+  os << p->GetSize () << " " << snr;
+  Record (context, os.str ());
+}
+
+void
+WifiGridComparisonTestCase::RecordRxError (std::string context, Ptr<const Packet> p, double snr)
+{
+  std::ostringstream os;
+  os.precision (17);
+  os << p->GetSize () << " " << snr << " error";
+  Record (context, os.str ());
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the spatial culling of the YansWifiChannel does not change
+ * the outcome of a simulation.
+ *
+ * Adhoc nodes laid out on a grid larger than the transmission range send
+ * broadcast frames, while some of them move, change course, or stop, and the
+ * gain of one PHY is raised during the simulation. The receptions are the
+ * same with and without culling, and fewer events are processed with it.
+ * The receptions are also the same when some nodes accelerate from rest,
+ * since their velocity changes without a course change notification.
+ */
+class SpatialCullingTestCase : public WifiGridComparisonTestCase
+{
+public:
+  SpatialCullingTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the scenario
+   * \param culling whether the spatial culling is enabled
+   * \param accelerating whether some nodes accelerate instead of moving at constant velocities
+   * \param traces where to record the traces of the run
+   * \return the number of events processed by the simulator
+   */
+  uint64_t RunOne (bool culling, bool accelerating, std::vector<std::string> *traces);
+};
+
+SpatialCullingTestCase::SpatialCullingTestCase ()
+  : WifiGridComparisonTestCase ("Test case for the spatial culling of the YansWifiChannel")
+{
+}
+
+uint64_t
+SpatialCullingTestCase::RunOne (bool culling, bool accelerating, std::vector<std::string> *traces)
+{
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  Ptr<YansWifiChannel> channel = channelHelper.Create ();
+  channel->SetAttribute ("SpatialCulling", BooleanValue (culling));
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel);
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  // A 500 m square, about twice the range of the default propagation
+  // loss model at the default transmit power
+  NetDeviceContainer devices = CreateGrid (36, 6, 100.0,
+                                           accelerating ? "ns3::ConstantAccelerationMobilityModel" : "ns3::ConstantVelocityMobilityModel",
+                                           phy, mac, "OfdmRate6Mbps");
+
+  for (uint32_t i = 0; accelerating && i < devices.GetN (); i += 3)
+    {
+      // From rest, once the first frames are sent, through the center of
+      // the grid to the opposite position in 4 s
+      Ptr<ConstantAccelerationMobilityModel> model = devices.Get (i)->GetNode ()->GetObject<ConstantAccelerationMobilityModel> ();
+      Vector position = model->GetPosition ();
+      Simulator::Schedule (Seconds (2.0), &ConstantAccelerationMobilityModel::SetVelocityAndAcceleration, model,
+                           Vector (0.0, 0.0, 0.0),
+                           Vector (0.25 * (250.0 - position.x), 0.25 * (250.0 - position.y), 0.0));
+    }
+  for (uint32_t i = 0; !accelerating && i < devices.GetN (); i += 3)
+    {
+      Ptr<ConstantVelocityMobilityModel> model = devices.Get (i)->GetNode ()->GetObject<ConstantVelocityMobilityModel> ();
+      model->SetVelocity (Vector (i % 2 ? 60.0 : -40.0, i % 4 ? 30.0 : -80.0, 0.0));
+      Simulator::Schedule (Seconds (2.5), &ConstantVelocityMobilityModel::SetVelocity, model,
+                           Vector (i % 2 ? -50.0 : 0.0, i % 4 ? 0.0 : 70.0, 0.0));
+    }
+  Ptr<WifiPhy> lastPhy = DynamicCast<WifiNetDevice> (devices.Get (devices.GetN () - 1))->GetPhy ();
+  if (!accelerating)
+    {
+      Simulator::Schedule (Seconds (3.0), &WifiPhy::SetRxGain, lastPhy, 10.0);
+    }
+
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (devices.Get (i));
+      for (uint32_t k = 0; k < 40; k++)
+        {
+          Simulator::Schedule (Seconds (1.0) + MilliSeconds (3 * i + 100 * k),
+                               &SpatialCullingTestCase::SendOnePacket, this, dev, dev->GetBroadcast (), 500);
+        }
+    }
+
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxBegin",
+                   MakeCallback (&SpatialCullingTestCase::RecordPacket, this));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxEnd",
+                   MakeCallback (&SpatialCullingTestCase::RecordPacket, this));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxDrop",
+                   MakeCallback (&SpatialCullingTestCase::RecordDrop, this));
+
+  return Run (Seconds (6.0), traces);
+}
+
+void
+SpatialCullingTestCase::DoRun (void)
+{
+  std::vector<std::string> reference;
+  uint64_t nReferenceEvents = RunOne (false, false, &reference);
+  std::vector<std::string> culled;
+  uint64_t nCulledEvents = RunOne (true, false, &culled);
+
+  CheckTraces (reference, culled, 1000, "spatial culling");
+  NS_TEST_ASSERT_MSG_LT (nCulledEvents, nReferenceEvents, "No receiver was culled");
+
+  reference.clear ();
+  RunOne (false, true, &reference);
+  culled.clear ();
+  RunOne (true, true, &culled);
+  CheckTraces (reference, culled, 1000, "spatial culling of accelerating nodes");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that a frame sent to many receivers is not copied for each of
+ * them, and that each receiver decoding it gets its own copy.
+ *
+ * A broadcast frame is sent to several receivers. The PSDU traced at the
+ * end of the reception is the same packet for all the receivers, while
+ * the packets handed up to the MAC are distinct copies of it.
+ */
+class SharedPpduTestCase : public TestCase
+{
+public:
+  SharedPpduTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send one packet function
+   * \param dev the device
+   */
+  void SendOnePacket (Ptr<WifiNetDevice> dev);
+  /**
+   * Notify the end of a successful reception by the PHY
+   * \param p the packet
+   */
+  void NotifyPhyRxEnd (Ptr<const Packet> p);
+  /**
+   * Notify a packet handed up to the MAC
+   * \param p the packet
+   * \param snr the SNR
+   * \param mode the mode
+   * \param preamble the preamble
+   */
+  void NotifyRxOk (Ptr<const Packet> p, double snr, WifiMode mode, WifiPreamble preamble);
+
+  std::vector<const Packet *> m_psdus;   ///< the packets traced at the end of the receptions
+  std::vector<Ptr<const Packet> > m_rxOk; ///< the packets handed up to the MAC
+};
+
+SharedPpduTestCase::SharedPpduTestCase ()
+  : TestCase ("Test case for the sharing of a PPDU by its receivers")
+{
+}
+
+void
+SharedPpduTestCase::SendOnePacket (Ptr<WifiNetDevice> dev)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  dev->Send (p, dev->GetBroadcast (), 1);
+}
+
+void
+SharedPpduTestCase::NotifyPhyRxEnd (Ptr<const Packet> p)
+{
+  m_psdus.push_back (PeekPointer (p));
+}
+
+void
+SharedPpduTestCase::NotifyRxOk (Ptr<const Packet> p, double snr, WifiMode mode, WifiPreamble preamble)
+{
+  m_rxOk.push_back (p);
+}
+
+void
+SharedPpduTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (6);
+
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "DeltaX", DoubleValue (5.0),
+                                 "GridWidth", UintegerValue (6));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (nodes);
+
+  for (uint32_t i = 1; i < devices.GetN (); i++)
+    {
+      Ptr<WifiPhy> rxPhy = DynamicCast<WifiNetDevice> (devices.Get (i))->GetPhy ();
+      rxPhy->TraceConnectWithoutContext ("PhyRxEnd", MakeCallback (&SharedPpduTestCase::NotifyPhyRxEnd, this));
+      PointerValue state;
+      rxPhy->GetAttribute ("State", state);
+      state.Get<WifiPhyStateHelper> ()->TraceConnectWithoutContext ("RxOk", MakeCallback (&SharedPpduTestCase::NotifyRxOk, this));
+    }
+
+  Simulator::Schedule (Seconds (1.0), &SharedPpduTestCase::SendOnePacket, this,
+                       DynamicCast<WifiNetDevice> (devices.Get (0)));
+  Simulator::Stop (Seconds (2.0));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_psdus.size (), devices.GetN () - 1, "The frame was not received by all the receivers");
+  NS_TEST_ASSERT_MSG_EQ (m_rxOk.size (), devices.GetN () - 1, "The frame was not handed up by all the receivers");
+  for (uint32_t i = 1; i < m_psdus.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_psdus[i], m_psdus[0], "The PSDU was copied for receiver " << i);
+    }
+  for (uint32_t i = 0; i < m_rxOk.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_NE (PeekPointer (m_rxOk[i]), m_psdus[0], "The PSDU was handed up without a copy");
+      for (uint32_t j = 0; j < i; j++)
+        {
+          NS_TEST_EXPECT_MSG_NE (m_rxOk[i], m_rxOk[j], "The same copy was handed up twice");
+        }
+    }
+  m_rxOk.clear ();
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that the WifiRemoteStationManager keeps the state of each remote
+ * address, and the station of each address and TID, apart.
+ *
+ * The association state and the QoS support of many remote addresses are
+ * changed at random, along with the retry counts of the stations of several
+ * TIDs, and checked against reference values, before and after a reset.
+ */
+class StationLookupTestCase : public TestCase
+{
+public:
+  StationLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * Check the manager against the reference values
+   * \param manager the remote station manager
+   */
+  void Check (Ptr<WifiRemoteStationManager> manager);
+
+  std::vector<Mac48Address> m_addresses; ///< the remote addresses
+  std::vector<bool> m_associated;        ///< whether each address is associated
+  std::vector<bool> m_qos;               ///< whether each address supports QoS
+  std::vector<uint32_t> m_retries;       ///< retry count of each address and TID
+  uint32_t m_state;                      ///< state of the pseudo-random generator
+};
+
+StationLookupTestCase::StationLookupTestCase ()
+  : TestCase ("Test case for the lookup of the remote stations"),
+    m_state (2463534242U)
+{
+}
+
+uint32_t
+StationLookupTestCase::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+void
+StationLookupTestCase::Check (Ptr<WifiRemoteStationManager> manager)
+{
+  Ptr<Packet> packet = Create<Packet> (100);
+  for (uint32_t i = 0; i < m_addresses.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (manager->IsAssociated (m_addresses[i]), m_associated[i],
+                             "Wrong association state of " << m_addresses[i]);
+      NS_TEST_ASSERT_MSG_EQ (manager->GetQosSupported (m_addresses[i]), m_qos[i],
+                             "Wrong QoS support of " << m_addresses[i]);
+      for (uint8_t tid = 0; tid < 4; tid++)
+        {
+          WifiMacHeader header;
+          header.SetType (WIFI_MAC_QOSDATA);
+          header.SetQosTid (tid);
+          NS_TEST_ASSERT_MSG_EQ (manager->NeedRetransmission (m_addresses[i], &header, packet),
+                                 (m_retries[i * 4 + tid] < 7),
+                                 "Wrong retry count of " << m_addresses[i] << " for TID " << +tid);
+        }
+    }
+}
+
+void
+StationLookupTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (1);
+  YansWifiChannelHelper channel = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel.Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "MaxSsrc", UintegerValue (7));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+  Ptr<WifiRemoteStationManager> manager = DynamicCast<WifiNetDevice> (devices.Get (0))->GetRemoteStationManager ();
+
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      m_addresses.push_back (Mac48Address::Allocate ());
+    }
+  m_associated.assign (m_addresses.size (), false);
+  m_qos.assign (m_addresses.size (), false);
+  m_retries.assign (m_addresses.size () * 4, 0);
+
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      for (uint32_t k = 0; k < 20000; k++)
+        {
+          uint32_t i = Random () % m_addresses.size ();
+          switch (Random () % 4)
+            {
+            case 0:
+              m_associated[i] = !m_associated[i];
+              if (m_associated[i])
+                {
+                  manager->RecordGotAssocTxOk (m_addresses[i]);
+                }
+              else
+                {
+                  manager->RecordDisassociated (m_addresses[i]);
+                }
+              break;
+            case 1:
+              m_qos[i] = !m_qos[i];
+              manager->SetQosSupport (m_addresses[i], m_qos[i]);
+              break;
+            default:
+              {
+                uint8_t tid = Random () % 4;
+                WifiMacHeader header;
+                header.SetType (WIFI_MAC_QOSDATA);
+                header.SetQosTid (tid);
+                if (m_retries[i * 4 + tid] < 7)
+                  {
+                    manager->ReportDataFailed (m_addresses[i], &header, 100);
+                    m_retries[i * 4 + tid]++;
+                  }
+                else
+                  {
+                    manager->ReportFinalDataFailed (m_addresses[i], &header, 100);
+                    m_retries[i * 4 + tid] = 0;
+                  }
+              }
+              break;
+            }
+          if (k % 5000 == 0)
+            {
+              Check (manager);
+            }
+        }
+      Check (manager);
+
+      // A reset forgets all the remote stations
+      manager->Reset ();
+      m_associated.assign (m_addresses.size (), false);
+      m_qos.assign (m_addresses.size (), false);
+      m_retries.assign (m_addresses.size () * 4, 0);
+      Check (manager);
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Check the interference of overlapping signals under saturation.
+ *
+ * Signals overlap continuously, and one of them is always being received,
+ * so that the noise and interference changes are only pruned while
+ * receiving. The SNR of the received signals and the energy durations are
+ * checked against the sums of the powers of the signals.
+ */
+class InterferencePruningTestCase : public TestCase
+{
+public:
+  InterferencePruningTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \return a pseudo-random number
+   */
+  uint32_t Random (void);
+  /**
+   * \param moment the time
+   * \param except the power of a signal not to count (W)
+   * \return the total power of the signals at the given time (W)
+   */
+  double GetPower (Time moment, double except) const;
+  /**
+   * Add a signal, and start receiving it if nothing is being received.
+   */
+  void AddSignal (void);
+  /**
+   * Check the SNR of the signal being received.
+   */
+  void CheckSnr (void);
+  /**
+   * Check the energy duration for a threshold.
+   * \param energyW the threshold (W)
+   */
+  void CheckEnergyDuration (double energyW);
+  /**
+   * End the reception of the signal being received.
+   */
+  void EndRx (void);
+
+  /// A signal
+  struct Signal
+  {
+    Time start;   ///< start time
+    Time end;     ///< end time
+    double power; ///< power (W)
+  };
+
+  InterferenceHelper m_interference; ///< the interference helper
+  std::deque<Signal> m_signals;      ///< the recent signals
+  Ptr<Event> m_rxEvent;              ///< the event being received
+  double m_noiseFloor;               ///< the noise floor (W)
+  uint32_t m_nSignals;               ///< signals left to add
+  uint32_t m_nChecks;                ///< number of SNR checks
+  uint32_t m_state;                  ///< state of the pseudo-random generator
+};
+
+InterferencePruningTestCase::InterferencePruningTestCase ()
+  : TestCase ("Test case for the interference of signals under saturation"),
+    m_noiseFloor (0),
+    m_nSignals (0),
+    m_nChecks (0),
+    m_state (2463534242U)
+{
+}
+
+uint32_t
+InterferencePruningTestCase::Random (void)
+{
+  // xorshift32
+  m_state ^= m_state << 13;
+  m_state ^= m_state >> 17;
+  m_state ^= m_state << 5;
+  return m_state;
+}
+
+double
+InterferencePruningTestCase::GetPower (Time moment, double except) const
+{
+  double power = 0;
+  for (std::deque<Signal>::const_iterator it = m_signals.begin (); it != m_signals.end (); ++it)
+    {
+      if (it->start <= moment && moment < it->end)
+        {
+          power += it->power;
+        }
+    }
+  return power - except;
+}
+
+void
+InterferencePruningTestCase::AddSignal (void)
+{
+  CheckEnergyDuration (1e-10 * (Random () % 4000));
+
+  Signal signal;
+  signal.start = Simulator::Now ();
+  signal.end = signal.start + NanoSeconds (20000 + Random () % 200000);
+  signal.power = 1e-10 * (1 + Random () % 1000);
+  while (!m_signals.empty () && m_signals.front ().end < signal.start - MilliSeconds (1))
+    {
+      m_signals.pop_front ();
+    }
+  m_signals.push_back (signal);
+  Ptr<Event> event = m_interference.Add (Ptr<const Packet> (), WifiTxVector (), signal.end - signal.start, signal.power);
+  if (m_rxEvent == 0)
+    {
+      m_interference.NotifyRxStart ();
+      m_rxEvent = event;
+      Simulator::Schedule ((signal.end - signal.start) / 2, &InterferencePruningTestCase::CheckSnr, this);
+      Simulator::Schedule (signal.end - signal.start - NanoSeconds (1), &InterferencePruningTestCase::CheckSnr, this);
+      Simulator::Schedule (signal.end - signal.start, &InterferencePruningTestCase::EndRx, this);
+    }
+  else if (Random () % 4 == 0)
+    {
+      // As WifiPhy does for a signal dropped while detecting a preamble
+      m_interference.NotifyRxStart ();
+    }
+  if (--m_nSignals > 0)
+    {
+      Simulator::Schedule (NanoSeconds (1000 + Random () % 20000), &InterferencePruningTestCase::AddSignal, this);
+    }
+}
+
+void
+InterferencePruningTestCase::CheckSnr (void)
+{
+  double interference = GetPower (Simulator::Now (), m_rxEvent->GetRxPowerW ());
+  double expected = m_rxEvent->GetRxPowerW () / (m_noiseFloor + interference);
+  NS_TEST_ASSERT_MSG_EQ_TOL (m_interference.CalculateSnr (m_rxEvent), expected, expected * 1e-9,
+                             "Wrong SNR at " << Simulator::Now ());
+  ++m_nChecks;
+}
+
+void
+InterferencePruningTestCase::CheckEnergyDuration (double energyW)
+{
+  // The energy stays above the threshold until the first change below it,
+  // looking from the last change
+  Time now = Simulator::Now ();
+  std::set<Time> changes;
+  Time previous (0);
+  for (std::deque<Signal>::const_iterator it = m_signals.begin (); it != m_signals.end (); ++it)
+    {
+      changes.insert (it->start);
+      changes.insert (it->end);
+      if (it->start <= now)
+        {
+          previous = std::max (previous, it->start);
+        }
+      if (it->end <= now)
+        {
+          previous = std::max (previous, it->end);
+        }
+    }
+  Time end = previous;
+  for (std::set<Time>::const_iterator it = changes.lower_bound (previous); it != changes.end (); ++it)
+    {
+      end = *it;
+      if (GetPower (*it, 0) < energyW)
+        {
+          break;
+        }
+    }
+  Time expected = end > now ? end - now : Time (0);
+  NS_TEST_ASSERT_MSG_EQ (m_interference.GetEnergyDuration (energyW), expected,
+                         "Wrong energy duration for " << energyW << " W at " << now);
+}
+
+void
+InterferencePruningTestCase::EndRx (void)
+{
+  m_interference.NotifyRxEnd ();
+  m_rxEvent = 0;
+}
+
+void
+InterferencePruningTestCase::DoRun (void)
+{
+  m_interference.SetNoiseFigure (5.0);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  // Thermal noise in 20 MHz at 290K, as computed by the interference helper
+  m_noiseFloor = 5.0 * 1.3803e-23 * 290 * 20e6;
+  m_nSignals = 20000;
+  Simulator::Schedule (MicroSeconds (1), &InterferencePruningTestCase::AddSignal, this);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_GT (m_nChecks, 1000, "Too few receptions to be significant");
+  m_rxEvent = 0;
+  m_interference.EraseEvents ();
+  Simulator::Destroy ();
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that coalescing the access timeouts of the ChannelAccessManager
+ * does not change the outcome of a simulation.
+ *
+ * Adhoc QoS stations in range of each other keep sending unicast frames to
+ * their neighbour, so that the backoffs are often interrupted by the
+ * transmissions of the other stations. The same frames are sent at the same
+ * times with and without coalescing, and fewer events are processed with it.
+ * See also the wifi-coalesced-backoff example.
+ */
+class CoalescedBackoffTestCase : public WifiGridComparisonTestCase
+{
+public:
+  CoalescedBackoffTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the scenario
+   * \param coalesced whether the access timeouts are coalesced
+   * \param traces where to record the traces of the run
+   * \return the number of events processed by the simulator
+   */
+  uint64_t RunOne (bool coalesced, std::vector<std::string> *traces);
+};
+
+CoalescedBackoffTestCase::CoalescedBackoffTestCase ()
+  : WifiGridComparisonTestCase ("Test case for the coalesced access timeouts of the ChannelAccessManager")
+{
+}
+
+uint64_t
+CoalescedBackoffTestCase::RunOne (bool coalesced, std::vector<std::string> *traces)
+{
+  Config::SetDefault ("ns3::ChannelAccessManager::CoalescedBackoff", BooleanValue (coalesced));
+
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac",
+               "QosSupported", BooleanValue (true));
+  NetDeviceContainer devices = CreateGrid (10, 5, 5.0, "ns3::ConstantPositionMobilityModel",
+                                           phy, mac, "OfdmRate54Mbps");
+
+  // About twice as many frames as the channel can carry
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (devices.Get (i));
+      Address dest = devices.Get ((i + 1) % devices.GetN ())->GetAddress ();
+      for (uint32_t k = 0; k < 200; k++)
+        {
+          Simulator::Schedule (Seconds (1.0) + MicroSeconds (37 * i + 2000 * k),
+                               &CoalescedBackoffTestCase::SendOnePacket, this, dev, dest, 1000);
+        }
+    }
+
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxBegin",
+                   MakeCallback (&CoalescedBackoffTestCase::RecordTx, this));
+
+  uint64_t nEvents = Run (Seconds (2.0), traces);
+  Config::SetDefault ("ns3::ChannelAccessManager::CoalescedBackoff", BooleanValue (false));
+  return nEvents;
+}
+
+void
+CoalescedBackoffTestCase::DoRun (void)
+{
+  std::vector<std::string> reference;
+  uint64_t nReferenceEvents = RunOne (false, &reference);
+  std::vector<std::string> coalesced;
+  uint64_t nCoalescedEvents = RunOne (true, &coalesced);
+
+  // Simultaneous transmissions may be traced in another order
+  std::sort (reference.begin (), reference.end ());
+  std::sort (coalesced.begin (), coalesced.end ());
+  CheckTraces (reference, coalesced, 2000, "coalesced access timeouts");
+  NS_TEST_ASSERT_MSG_LT (nCoalescedEvents, nReferenceEvents, "No access timeout was coalesced");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * Make sure that computing the outcome of the receptions of a PPDU on
+ * several threads does not change the outcome of a simulation.
+ *
+ * Adhoc stations close to each other broadcast frames, so that each PPDU is
+ * received by many PHYs, often with the interference of another one. The
+ * same traces, including the SNRs, are expected with one and four threads,
+ * with and without the abstraction, and with the TabulatedErrorRateModel,
+ * whose tables are shared by the PHYs. The TabulatedErrorRateModel is also
+ * run with a range of tabulated SNRs above those of the receptions, which
+ * are then all passed to the wrapped model from the first one on.
+ */
+class ParallelRxTestCase : public WifiGridComparisonTestCase
+{
+public:
+  ParallelRxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the scenario
+   * \param nThreads the number of threads computing the reception outcomes
+   * \param abstraction whether the PHYs use the abstraction
+   * \param errorRateModel the type of the error rate models
+   * \param minSnr the lowest SNR tabulated by the TabulatedErrorRateModel (dB)
+   * \param traces where to record the traces of the run
+   */
+  void RunOne (uint32_t nThreads, bool abstraction, std::string errorRateModel, double minSnr,
+               std::vector<std::string> *traces);
+};
+
+ParallelRxTestCase::ParallelRxTestCase ()
+  : WifiGridComparisonTestCase ("Test case for the computation of the reception outcomes on several threads")
+{
+}
+
+void
+ParallelRxTestCase::RunOne (uint32_t nThreads, bool abstraction, std::string errorRateModel, double minSnr,
+                            std::vector<std::string> *traces)
+{
+  Config::SetGlobal ("WifiRxThreads", UintegerValue (nThreads));
+
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  phy.Set ("Abstraction", BooleanValue (abstraction));
+  if (errorRateModel == "ns3::TabulatedErrorRateModel")
+    {
+      phy.SetErrorRateModel (errorRateModel, "MinSnr", DoubleValue (minSnr));
+    }
+  else
+    {
+      phy.SetErrorRateModel (errorRateModel);
+    }
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  // The stations at the edges of the grid receive with a low SNR
+  NetDeviceContainer devices = CreateGrid (30, 6, 25.0, "ns3::ConstantPositionMobilityModel",
+                                           phy, mac, "OfdmRate54Mbps");
+
+  // One station in five starts its transmissions along with the previous
+  // one, so that they collide
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (devices.Get (i));
+      uint32_t start = (i % 5 == 1) ? 1000 * (i - 1) + 2 : 1000 * i;
+      for (uint32_t k = 0; k < 30; k++)
+        {
+          Simulator::Schedule (Seconds (1.0) + MicroSeconds (start + 50000 * k),
+                               &ParallelRxTestCase::SendOnePacket, this, dev, dev->GetBroadcast (), 1000);
+        }
+    }
+
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/State/RxOk",
+                   MakeCallback (&ParallelRxTestCase::RecordRxOk, this));
+  Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/State/RxError",
+                   MakeCallback (&ParallelRxTestCase::RecordRxError, this));
+
+  Run (Seconds (3.0), traces);
+  Config::SetGlobal ("WifiRxThreads", UintegerValue (1));
+}
+
+void
+ParallelRxTestCase::DoRun (void)
+{
+  // The wrapped model is created by the simulation thread, not by the
+  // first reception which uses it
+  Ptr<TabulatedErrorRateModel> tabulated = CreateObject<TabulatedErrorRateModel> ();
+  NS_TEST_EXPECT_MSG_NE (tabulated->GetModel (), 0, "The wrapped model should be created with the tabulated one");
+
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      bool abstraction = (i == 1);
+      std::string errorRateModel = (i >= 2) ? "ns3::TabulatedErrorRateModel" : "ns3::NistErrorRateModel";
+      // The SNRs of the receptions are all below 40 dB
+      double minSnr = (i == 3) ? 40.0 : -10.0;
+      std::vector<std::string> reference;
+      RunOne (1, abstraction, errorRateModel, minSnr, &reference);
+      std::vector<std::string> parallel;
+      RunOne (4, abstraction, errorRateModel, minSnr, &parallel);
+      CheckTraces (reference, parallel, 5000, "several threads");
+    }
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief Check the rates selected by the Minstrel-HT statistics updates.
+ *
+ * The statistics of a station supporting two streams and the short guard
+ * interval on an 80 MHz channel, hence 12 VHT groups, are updated after
+ * attempts made with random rates, while the quality of the channel varies
+ * so that rates gain and lose a non-zero throughput. After each update, the
+ * maximum throughput and probability rates, of the station and of each
+ * group, must be those found by scanning all the supported rates.
+ */
+class MinstrelHtFullScanTestCase : public TestCase
+{
+public:
+  MinstrelHtFullScanTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Check the maximum rates of a station against a scan of all its
+   * supported rates, then restore them.
+   * \param manager the Minstrel-HT manager
+   * \param station the station
+   * \param update the number of the statistics update
+   */
+  void CheckBestRates (Ptr<MinstrelHtWifiManager> manager, MinstrelHtWifiRemoteStation *station, uint32_t update);
+};
+
+MinstrelHtFullScanTestCase::MinstrelHtFullScanTestCase ()
+  : TestCase ("Test case for the rates selected by the incremental Minstrel-HT statistics updates")
+{
+}
+
+void
+MinstrelHtFullScanTestCase::CheckBestRates (Ptr<MinstrelHtWifiManager> manager, MinstrelHtWifiRemoteStation *station, uint32_t update)
+{
+  uint16_t maxTpRate = station->m_maxTpRate;
+  uint16_t maxTpRate2 = station->m_maxTpRate2;
+  uint16_t maxProbRate = station->m_maxProbRate;
+  McsGroupData groupsTable = station->m_groupsTable;
+
+  // Scan the rates in increasing order, as all of them used to be
+  station->m_maxTpRate = manager->GetLowestIndex (station);
+  station->m_maxTpRate2 = manager->GetLowestIndex (station);
+  station->m_maxProbRate = manager->GetLowestIndex (station);
+  std::vector<uint16_t> candidates;
+  for (uint8_t j = 0; j < manager->m_numGroups; j++)
+    {
+      GroupInfo &group = station->m_groupsTable[j];
+      if (!group.m_supported)
+        {
+          continue;
+        }
+      group.m_maxTpRate = manager->GetLowestIndex (station, j);
+      group.m_maxTpRate2 = manager->GetLowestIndex (station, j);
+      group.m_maxProbRate = manager->GetLowestIndex (station, j);
+      for (uint8_t i = 0; i < manager->m_numRates; i++)
+        {
+          if (group.m_ratesTable[i].supported && group.m_ratesTable[i].throughput != 0)
+            {
+              candidates.push_back (manager->GetIndex (j, i));
+              manager->SetBestStationThRates (station, manager->GetIndex (j, i));
+              manager->SetBestProbabilityRate (station, manager->GetIndex (j, i));
+            }
+        }
+    }
+
+  NS_TEST_EXPECT_MSG_EQ ((station->m_candidateRates == candidates), true, "Wrong candidate rates at update " << update);
+  NS_TEST_EXPECT_MSG_EQ (maxTpRate, station->m_maxTpRate, "Wrong max throughput rate at update " << update);
+  NS_TEST_EXPECT_MSG_EQ (maxTpRate2, station->m_maxTpRate2, "Wrong second max throughput rate at update " << update);
+  NS_TEST_EXPECT_MSG_EQ (maxProbRate, station->m_maxProbRate, "Wrong max probability rate at update " << update);
+  for (uint8_t j = 0; j < manager->m_numGroups; j++)
+    {
+      if (station->m_groupsTable[j].m_supported)
+        {
+          NS_TEST_EXPECT_MSG_EQ (groupsTable[j].m_maxTpRate, station->m_groupsTable[j].m_maxTpRate,
+                                 "Wrong max throughput rate of group " << +j << " at update " << update);
+          NS_TEST_EXPECT_MSG_EQ (groupsTable[j].m_maxTpRate2, station->m_groupsTable[j].m_maxTpRate2,
+                                 "Wrong second max throughput rate of group " << +j << " at update " << update);
+          NS_TEST_EXPECT_MSG_EQ (groupsTable[j].m_maxProbRate, station->m_groupsTable[j].m_maxProbRate,
+                                 "Wrong max probability rate of group " << +j << " at update " << update);
+        }
+    }
+
+  station->m_maxTpRate = maxTpRate;
+  station->m_maxTpRate2 = maxTpRate2;
+  station->m_maxProbRate = maxProbRate;
+  station->m_groupsTable = groupsTable;
+}
+
+void
+MinstrelHtFullScanTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (1);
+  YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default ();
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channelHelper.Create ());
+  phy.Set ("Antennas", UintegerValue (2));
+  phy.Set ("MaxSupportedTxSpatialStreams", UintegerValue (2));
+  phy.Set ("MaxSupportedRxSpatialStreams", UintegerValue (2));
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211ac);
+  wifi.SetRemoteStationManager ("ns3::MinstrelHtWifiManager");
+  Ptr<WifiNetDevice> dev = DynamicCast<WifiNetDevice> (wifi.Install (phy, mac, nodes).Get (0));
+  dev->GetHtConfiguration ()->SetShortGuardIntervalSupported (true);
+  Ptr<MinstrelHtWifiManager> manager = DynamicCast<MinstrelHtWifiManager> (dev->GetRemoteStationManager ());
+  manager->Initialize ();
+
+  // The remote station has the same capabilities as the device
+  Ptr<RegularWifiMac> wifiMac = DynamicCast<RegularWifiMac> (dev->GetMac ());
+  WifiRemoteStationState state;
+  state.m_state = WifiRemoteStationState::BRAND_NEW;
+  state.m_address = Mac48Address ("00:00:00:00:00:01");
+  state.m_htCapabilities = Create<const HtCapabilities> (wifiMac->GetHtCapabilities ());
+  state.m_vhtCapabilities = Create<const VhtCapabilities> (wifiMac->GetVhtCapabilities ());
+  state.m_channelWidth = dev->GetPhy ()->GetChannelWidth ();
+  state.m_guardInterval = 800;
+  state.m_ness = 0;
+  state.m_aggregation = true;
+  state.m_shortPreamble = false;
+  state.m_shortSlotTime = false;
+  state.m_qosSupported = true;
+  for (uint8_t i = 0; i < dev->GetPhy ()->GetNMcs (); i++)
+    {
+      state.m_operationalMcsSet.push_back (dev->GetPhy ()->GetMcs (i));
+    }
+
+  // Initialize the station as CheckInit does, without the statistics file
+  MinstrelHtWifiRemoteStation *station = static_cast<MinstrelHtWifiRemoteStation *> (manager->DoCreateStation ());
+  station->m_state = &state;
+  station->m_nModes = static_cast<uint8_t> (state.m_operationalMcsSet.size ());
+  station->m_minstrelTable = MinstrelRate (station->m_nModes);
+  station->m_sampleTable = SampleRate (manager->m_numRates, std::vector<uint8_t> (manager->m_nSampleCol));
+  manager->InitSampleTable (station);
+  manager->RateInit (station);
+  station->m_initialized = true;
+
+  std::vector<uint16_t> rates;
+  uint32_t nGroups = 0;
+  for (uint8_t j = 0; j < manager->m_numGroups; j++)
+    {
+      if (!station->m_groupsTable[j].m_supported)
+        {
+          continue;
+        }
+      nGroups++;
+      for (uint8_t i = 0; i < manager->m_numRates; i++)
+        {
+          if (station->m_groupsTable[j].m_ratesTable[i].supported)
+            {
+              rates.push_back (manager->GetIndex (j, i));
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (nGroups, 12, "Unexpected number of supported groups");
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  std::set<uint8_t> maxTpGroups;
+  bool candidateRemoved = false;
+  for (uint32_t update = 0; update < 400; update++)
+    {
+      // The higher rates only succeed when the quality of the channel is high
+      double quality = 0.5 + 0.5 * std::sin (2 * M_PI * update / 100);
+      for (uint32_t k = 0; k < 16; k++)
+        {
+          station->m_txrate = rates[random->GetInteger (0, rates.size () - 1)];
+          const McsGroup &group = manager->m_minstrelGroups[manager->GetGroupId (station->m_txrate)];
+          double successProbability = 1.6 * quality + 0.4 - 0.12 * manager->GetRateId (station->m_txrate)
+            - 0.2 * (group.streams - 1) - 0.05 * (group.chWidth / 40) + 0.03 * group.sgi;
+          uint8_t nMpdus = static_cast<uint8_t> (random->GetInteger (1, 16));
+          uint8_t nSuccessfulMpdus = 0;
+          for (uint8_t m = 0; m < nMpdus; m++)
+            {
+              nSuccessfulMpdus += (random->GetValue () < successProbability) ? 1 : 0;
+            }
+          manager->AddRateAttempts (station, nSuccessfulMpdus, nMpdus - nSuccessfulMpdus);
+        }
+      std::size_t nCandidates = station->m_candidateRates.size ();
+      manager->UpdateStats (station);
+      candidateRemoved = candidateRemoved || station->m_candidateRates.size () < nCandidates;
+      maxTpGroups.insert (manager->GetGroupId (station->m_maxTpRate));
+      CheckBestRates (manager, station, update);
+    }
+  NS_TEST_EXPECT_MSG_GT (maxTpGroups.size (), 1, "The max throughput rate should change groups");
+  NS_TEST_EXPECT_MSG_EQ (candidateRemoved, true, "Some rates should lose their throughput");
+
+  delete station;
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup wifi-test
  * \ingroup tests
@@ -2201,6 +3407,13 @@ WifiTestSuite::WifiTestSuite ()
   AddTestCase (new Bug2831TestCase, TestCase::QUICK); //Bug 2831
   AddTestCase (new StaWifiMacScanningTestCase, TestCase::QUICK); //Bug 2399
   AddTestCase (new Bug2470TestCase, TestCase::QUICK); //Bug 2470
+  AddTestCase (new SpatialCullingTestCase, TestCase::QUICK);
+  AddTestCase (new SharedPpduTestCase, TestCase::QUICK);
+  AddTestCase (new StationLookupTestCase, TestCase::QUICK);
+  AddTestCase (new InterferencePruningTestCase, TestCase::QUICK);
+  AddTestCase (new CoalescedBackoffTestCase, TestCase::QUICK);
+  AddTestCase (new ParallelRxTestCase, TestCase::QUICK);
+  AddTestCase (new MinstrelHtFullScanTestCase, TestCase::QUICK);
 }
 
 static WifiTestSuite g_wifiTestSuite; ///< the test suite
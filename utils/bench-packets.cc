@@ -328,6 +328,61 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchByteTagFragments (uint32_t n)
+{
+  // A send buffer: small writes, each with its own byte tag, are
+  // concatenated and then cut into segments whose tags are looked at.
+  BenchTag<4> tag;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> buffer = Create<Packet> ();
+      for (uint32_t j = 0; j < 256; j++)
+        {
+          Ptr<Packet> write = Create<Packet> (100);
+          write->AddByteTag (tag);
+          buffer->AddAtEnd (write);
+        }
+      for (uint32_t start = 0; start < buffer->GetSize (); start += 536)
+        {
+          uint32_t length = std::min<uint32_t> (536, buffer->GetSize () - start);
+          Ptr<Packet> segment = buffer->CreateFragment (start, length);
+          ByteTagIterator it = segment->GetByteTagIterator ();
+          while (it.HasNext ())
+            {
+              it.Next ();
+            }
+        }
+    }
+}
+
+static void
+benchPacketTags (uint32_t n)
+{
+  // A typical stack: a few small tags attached along the way, looked up
+  // and removed again on the other side, with copies in between.
+  BenchTag<4> flowId;
+  BenchTag<1> priority;
+  BenchTag<2> qos;
+  BenchTag<9> bearer;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (2000);
+      p->AddPacketTag (flowId);
+      p->AddPacketTag (priority);
+      p->AddPacketTag (qos);
+      p->AddPacketTag (bearer);
+      Ptr<Packet> copy = p->Copy ();
+      copy->PeekPacketTag (flowId);
+      copy->PeekPacketTag (qos);
+      copy->RemovePacketTag (priority);
+      copy->ReplacePacketTag (bearer);
+      p->PeekPacketTag (bearer);
+      p->RemovePacketTag (qos);
+      p->RemovePacketTag (flowId);
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -385,6 +440,8 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchByteTagFragments, n, minIterations, "Concatenate and fragment byte-tagged packets");
+  runBench (&benchPacketTags, n, minIterations, "Add, peek, remove and copy packet tags");
 
   return 0;
 }